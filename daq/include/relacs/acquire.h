@@ -24,6 +24,7 @@
 
 #include <string>
 #include <ctime>
+#include <chrono>
 #include <vector>
 #include <deque>
 #include <QReadWriteLock>
@@ -389,6 +390,11 @@ public:
         \return \c 1 if the input traces got new data,
 	\c 0 if no more data are available, or \c -1 on error. */
   int waitForData( double &signaltime );
+    /*! The time on the monotonic clock at which the most recent sample
+        of the data signaled by the last call of waitForData() was acquired.
+	It is estimated from the time analog input was started
+	and the time of the sample in the input traces. */
+  chrono::steady_clock::time_point dataClock( void ) const;
     /*! Lock the input data for reading. \sa unlockRead(), lockWrite() */
   void lockRead( void );
     /*! Unlock the input data. \sa lockRead(), unlockWrite() */
@@ -670,6 +676,13 @@ protected:
   double PreviousTime;
     /*! Count the successive calls of updateRawData() that did not get more data. */
   int NumEmptyData;
+    /*! The time on the monotonic clock when analog input was started last. */
+  chrono::steady_clock::time_point StartClock;
+    /*! The time of the first sample in the input traces after analog input was started last. */
+  double StartTime;
+    /*! The estimated time on the monotonic clock of the most recent sample
+        at the last call of waitForData(). */
+  chrono::steady_clock::time_point DataClock;
 
     /*! The flag that is used to mark adjusted traces in InData. */
   int AdjustFlag;
@@ -660,6 +660,13 @@ public:
     /*! Returns the value of the data element where the iterator + \a n points to. */
   inline double operator[]( int n ) const
     { assert( ID != 0 && Index+n >= ID->minIndex() && Index+n < ID->size() ); return (*ID)[Index+n]; };
+
+    /*! Sets \a data to the data element where the iterator points to
+        and returns the number of data elements up to \a last
+        that are stored contiguously in memory.
+        Returns zero if the iterator or \a last are invalid. */
+  inline int span( const InDataIterator &last, const float* &data ) const
+    { if ( ID == 0 || last.ID != ID ) return 0; return ID->span( Index, last.Index - Index, data ); };
     
     
 protected:
@@ -961,6 +968,13 @@ class InDataTimeIterator
         the iterator + \a n points to. */
   inline double operator[]( int n ) const
     { assert( ID != 0 && Index+n >= ID->minIndex() && Index+n < ID->size() ); return ID->pos( Index+n ); };
+
+    /*! Sets \a offset, \a stepsize, and \a index such that
+        the time of the data element where the iterator + \a n points to
+        is \a offset + (\a index + \a n) * \a stepsize.
+        Returns \c false if the iterator is invalid. */
+  inline bool timeBase( double &offset, double &stepsize, int &index ) const
+    { if ( ID == 0 ) return false; offset = ID->offset(); stepsize = ID->stepsize(); index = Index; return true; };
     
     
 protected:
@@ -990,6 +1004,23 @@ inline double InDataDiffIterator::operator[]( int n ) const
 }
 
 
+  /*! Direct access to contiguous data elements of an InData
+      for the Detector algorithms. */
+inline int detectorSpan( const InDataIterator &first, const InDataIterator &last,
+			 const float* &data )
+{
+  return first.span( last, data );
+}
+
+
+  /*! The time base of an InData for the Detector algorithms. */
+inline bool detectorTimes( const InDataTimeIterator &first, double &offset,
+			   double &stepsize, int &index )
+{
+  return first.timeBase( offset, stepsize, index );
+}
+
+
 }; /* namespace relacs */
 
 #endif /* ! _RELACS_INDATA_H_ */
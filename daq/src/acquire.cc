@@ -46,6 +46,11 @@ Acquire::Acquire( void )
 {
   AI.clear();
   AdjustFlag = 0;
+  PreviousTime = 0.0;
+  NumEmptyData = 0;
+  StartClock = chrono::steady_clock::now();
+  StartTime = 0.0;
+  DataClock = StartClock;
 
   AO.clear();
   LastDevice = -1;
@@ -781,6 +786,8 @@ int Acquire::read( InList &data )
     RestartEvents->push( InTraces[0].restartTime() );
 
   // start reading from daq boards:
+  StartClock = chrono::steady_clock::now();
+  StartTime = PreviousTime;
   vector< int > aistarted;
   aistarted.reserve( AI.size() );
   QWaitCondition *readwait = &ReadWait;
@@ -921,6 +928,8 @@ int Acquire::restartRead( void )
       AISemaphore.acquire( AISemaphore.available() );
 
     // start reading from daq boards:
+    StartClock = chrono::steady_clock::now();
+    StartTime = PreviousTime;
     QWaitCondition *readwait = &ReadWait;
     for ( unsigned int i=0; i<AI.size(); i++ ) {
       if ( AI[i].Traces.size() > 0 ) {
@@ -1076,6 +1085,8 @@ int Acquire::restartRead( vector< AOData* > &aod, bool directao,
     aos = 0;
 
   // start reading from daq boards:
+  StartClock = chrono::steady_clock::now();
+  StartTime = PreviousTime;
   vector< int > aistarted;
   aistarted.reserve( AI.size() );
   QWaitCondition *readwait = &ReadWait;
@@ -1280,6 +1291,9 @@ int Acquire::waitForData( double &signaltime )
       RestartEvents->setSignalTime( SignalTime );
   }
   PreviousTime = InTraces.currentTimeRaw();
+  // acquisition time of the most recent sample:
+  DataClock = StartClock + chrono::duration_cast< chrono::steady_clock::duration >
+    ( chrono::duration< double >( PreviousTime - StartTime ) );
   // check data:
   bool failed = InTraces.failed();
   ReadMutex.unlock();
@@ -1287,6 +1301,13 @@ int Acquire::waitForData( double &signaltime )
 }
 
 
+chrono::steady_clock::time_point Acquire::dataClock( void ) const
+{
+  QReadLocker locker( &ReadMutex );
+  return DataClock;
+}
+
+
 void Acquire::lockRead( void )
 {
   ReadMutex.lockForRead();
@@ -0,0 +1,115 @@
+/*
+  xcolumnformat.cc
+  Benchmark for writing a table with a TableKey.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <relacs/str.h>
+#include <relacs/tablekey.h>
+#include <relacs/tabledata.h>
+using namespace std;
+using namespace relacs;
+
+
+double seconds( clock_t start )
+{
+  return double( clock() - start )/CLOCKS_PER_SEC;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  int rows = 1000000;
+  if ( argc > 1 )
+    rows = atoi( argv[1] );
+
+  TableKey key;
+  key.addNumber( "t", "sec", "%0.5f" );
+  key.addNumber( "size", "mV", "%6.3f" );
+  key.addNumber( "width", "ms", "%6.3f" );
+  key.addNumber( "rate", "Hz", "%5.1f" );
+  key.addNumber( "x", "", "%g" );
+  key.addNumber( "y", "", "%10.3e" );
+
+  TableData table( key, rows );
+  srand48( 1 );
+  for ( int r=0; r<rows; r++ ) {
+    table.push( 0, 0.001*r + 0.0001*drand48() );
+    table.push( 1, 10.0*( drand48() - 0.5 ) );
+    table.push( 2, 2.0*drand48() );
+    table.push( 3, 300.0*drand48() );
+    table.push( 4, ( drand48() - 0.5 )*::pow( 10.0, 20.0*drand48() - 10.0 ) );
+    table.push( 5, ( drand48() - 0.5 )*::pow( 10.0, 20.0*drand48() - 10.0 ) );
+    ++table;
+  }
+
+  // formatting each number with Str, as TableKey used to do:
+  vector< int > widths;
+  for ( int c=0; c<key.columns(); c++ ) {
+    int w = key.formatWidth( c );
+    if ( w < (int)key[c].name().size() )
+      w = key[c].name().size();
+    if ( w < (int)key[c].unit().size() )
+      w = key[c].unit().size();
+    widths.push_back( w );
+  }
+  ostringstream strout;
+  clock_t start = clock();
+  for ( int r=0; r<rows; r++ ) {
+    for ( int c=0; c<key.columns(); c++ ) {
+      strout << ( c > 0 ? key.separator() : key.dataStart() );
+      Str s( table( c, r ), key.format( c ) );
+      if ( (int)s.size() >= widths[c] )
+	strout << s;
+      else
+	strout << Str( s, widths[c] );
+    }
+    strout << '\n';
+  }
+  double strtime = seconds( start );
+
+  // number by number, as SaveFiles writes events:
+  ostringstream numout;
+  start = clock();
+  for ( int r=0; r<rows; r++ ) {
+    for ( int c=0; c<key.columns(); c++ )
+      key.save( numout, table( c, r ), c );
+    numout << '\n';
+  }
+  double numtime = seconds( start );
+
+  // whole table:
+  ostringstream tableout;
+  start = clock();
+  key.save( tableout, table );
+  double tabletime = seconds( start );
+
+  cout << "rows: " << rows << '\n';
+  cout << "Str:                 " << Str( strtime, 0, 3, 'f' ) << "s\n";
+  cout << "TableKey::save( v ): " << Str( numtime, 0, 3, 'f' ) << "s, "
+       << ( numout.str() == strout.str() ? "identical" : "DIFFERENT" ) << '\n';
+  cout << "TableKey::save( t ): " << Str( tabletime, 0, 3, 'f' ) << "s, "
+       << ( tableout.str() == strout.str() ? "identical" : "DIFFERENT" ) << '\n';
+
+  return numout.str() == strout.str() && tableout.str() == strout.str() ? 0 : 1;
+}
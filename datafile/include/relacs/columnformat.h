@@ -0,0 +1,105 @@
+/*
+  columnformat.h
+  A printf-style format for numbers in table columns that is parsed only once.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_COLUMNFORMAT_H_
+#define _RELACS_COLUMNFORMAT_H_ 1
+
+
+#include <string>
+using namespace std;
+
+namespace relacs {
+
+
+/*!
+\class ColumnFormat
+\author Jan Benda
+\brief A printf-style format for numbers in table columns that is parsed only once.
+
+The format string is interpreted exactly like Str( double, const string& ) does:
+A missing conversion character or any conversion character other than
+\c f, \c F, \c e, \c E, \c g, \c G, \c a, or \c A is replaced by \c g,
+and a format without any conversion specification is replaced by \c %g.
+
+The format is parsed once by setFormat() into flags, width, precision,
+conversion, and the literal text before and after the conversion.
+append() then writes the formatted number into a string buffer without
+any further parsing and without allocating memory once the buffer is large enough.
+The digits of \c f, \c e, and \c g conversions are computed exactly from
+an integer scaled by a power of ten. Whenever the correct rounding
+of the last digit cannot be guaranteed this way, and for unusual formats,
+infinities, and NaNs, snprintf() is used instead.
+The result is always identical to the one of Str( double, const string& ).
+
+\sa TableKey
+*/
+
+class ColumnFormat
+{
+
+public:
+
+    /*! Constructs a ColumnFormat for the default format \c %g. */
+  ColumnFormat( void );
+    /*! Constructs a ColumnFormat for the format \a format. */
+  ColumnFormat( const string &format );
+
+    /*! The format string as passed to setFormat(). */
+  const string &format( void ) const { return Format; };
+    /*! Parse the printf-style format string \a format. */
+  void setFormat( const string &format );
+
+    /*! Append the number \a v formatted according to format()
+        to \a s. If the resulting string is shorter than \a width,
+	it is right aligned by inserting \a pad characters in front of it. */
+  void append( string &s, double v, int width=0, char pad=' ' ) const;
+
+
+private:
+
+  int fastFormat( char *buf, double v ) const;
+  void appendFallback( string &s, double v ) const;
+
+  string Format;
+    /*! The format as it is passed to snprintf(). */
+  string PrintfFormat;
+    /*! Text in front of the conversion, with %% replaced by %. */
+  string Prefix;
+    /*! Text after the conversion. */
+  string Suffix;
+    /*! The number can be formatted without snprintf(). */
+  bool Fast;
+  char Conversion;
+  bool Upper;
+  bool Left;
+  bool Plus;
+  bool Space;
+  bool Zero;
+  int Width;
+  int Precision;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_COLUMNFORMAT_H_ */
+
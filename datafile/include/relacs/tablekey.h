@@ -27,6 +27,7 @@
 #include <vector>
 #include <relacs/array.h>
 #include <relacs/options.h>
+#include <relacs/columnformat.h>
 using namespace std;
 
 namespace relacs {
@@ -558,12 +559,25 @@ public:
 
   template < typename T >
   ostream &saveVector( ostream &str, const vector< T > &vec, int c=-1 ) const;
+    /*! Reparse the formats of the columns \a cbegin to \a cend (exclusively)
+        in case they have been changed via the Parameters of the columns. */
+  void updateFormats( int cbegin, int cend ) const;
+    /*! Append the number \a v formatted for column \a c to Buffer.
+        The format of the column needs to be updated by updateFormats() before. */
+  void appendNumber( double v, int c ) const;
+  void appendNumber( float v, int c ) const { appendNumber( double( v ), c ); };
+  template < typename T >
+  void appendNumber( const T &v, int c ) const;
 
   Options Opt;
 
   deque< deque < Options::section_iterator > > Sections;
   deque < Options::iterator > Columns;
   vector < int > Width;
+    /*! The parsed formats of the columns. */
+  mutable vector < ColumnFormat > Formats;
+    /*! The line that is currently written. */
+  mutable string Buffer;
   mutable int PrevCol;
 
   mutable Parameter Dummy;
@@ -587,23 +601,18 @@ ostream &TableKey::save( ostream &str, const T *v, int n, int c ) const
   if ( c < 0 )
     return str;
 
+  updateFormats( c, c+n );
+  Buffer.clear();
   const T *vp = v;
   for ( int k=0; k < n; k++, ++vp ) {
     if ( c >= (int)Columns.size() )
-      return str;
-    if ( c > 0 )
-      str << Separator;
-    else
-      str << DataStart;
-    Str s( *vp, format( c ) );
-    if ( s.size() >= Width[c] )
-      str << s;
-    else
-      str << Str( s, Width[c] );
+      break;
+    Buffer += c > 0 ? Separator : DataStart;
+    appendNumber( *vp, c );
     PrevCol = c;
     c++;
   }
-  return str;  
+  return str.write( Buffer.data(), Buffer.size() );
 }
 
 
@@ -616,24 +625,19 @@ ostream &TableKey::saveVector( ostream &str, const vector< T > &vec, int c ) con
   if ( c < 0 )
     return str;
 
+  updateFormats( c, c+vec.size() );
+  Buffer.clear();
   for ( typename vector< T >::const_iterator vp = vec.begin();
 	vp != vec.end();
 	++vp ) {
     if ( c >= (int)Columns.size() )
-      return str;
-    if ( c > 0 )
-      str << Separator;
-    else
-      str << DataStart;
-    Str s( *vp, format( c ) );
-    if ( s.size() >= Width[c] )
-      str << s;
-    else
-      str << Str( s, Width[c] );
+      break;
+    Buffer += c > 0 ? Separator : DataStart;
+    appendNumber( *vp, c );
     PrevCol = c;
     c++;
   }
-  return str;  
+  return str.write( Buffer.data(), Buffer.size() );
 }
 
 
@@ -646,24 +650,19 @@ ostream &TableKey::save( ostream &str, const Array< T > &vec, int c ) const
   if ( c < 0 )
     return str;
 
+  updateFormats( c, c+vec.size() );
+  Buffer.clear();
   for ( typename Array< T >::const_iterator vp = vec.begin();
 	vp != vec.end();
 	++vp ) {
     if ( c >= (int)Columns.size() )
-      return str;
-    if ( c > 0 )
-      str << Separator;
-    else
-      str << DataStart;
-    Str s( *vp, format( c ) );
-    if ( s.size() >= Width[c] )
-      str << s;
-    else
-      str << Str( s, Width[c] );
+      break;
+    Buffer += c > 0 ? Separator : DataStart;
+    appendNumber( *vp, c );
     PrevCol = c;
     c++;
   }
-  return str;  
+  return str.write( Buffer.data(), Buffer.size() );
 }
 
 
@@ -677,22 +676,17 @@ ostream &TableKey::save( ostream &str, const vector< vector< T > > &v,
   if ( c < 0 )
     return str;
 
+  updateFormats( c, c+v.size() );
+  Buffer.clear();
   for ( unsigned int k=0; k<v.size(); k++ ) {
     if ( c >= (int)Columns.size() )
-      return str;
-    if ( c > 0 )
-      str << Separator;
-    else
-      str << DataStart;
-    Str s( r < (int)v[k].size() ? v[k][r] : 0.0, format( c ) );
-    if ( s.size() >= Width[c] )
-      str << s;
-    else
-      str << Str( s, Width[c] );
+      break;
+    Buffer += c > 0 ? Separator : DataStart;
+    appendNumber( r < (int)v[k].size() ? v[k][r] : 0.0, c );
     PrevCol = c;
     c++;
   }
-  return str;  
+  return str.write( Buffer.data(), Buffer.size() );
 }
 
 
@@ -706,22 +700,28 @@ ostream &TableKey::save( ostream &str, const vector< Array< T > > &v,
   if ( c < 0 )
     return str;
 
+  updateFormats( c, c+v.size() );
+  Buffer.clear();
   for ( unsigned int k=0; k<v.size(); k++ ) {
     if ( c >= (int)Columns.size() )
-      return str;
-    if ( c > 0 )
-      str << Separator;
-    else
-      str << DataStart;
-    Str s( r < (int)v[k].size() ? v[k][r] : 0.0, format( c ) );
-    if ( s.size() >= Width[c] )
-      str << s;
-    else
-      str << Str( s, Width[c] );
+      break;
+    Buffer += c > 0 ? Separator : DataStart;
+    appendNumber( r < (int)v[k].size() ? v[k][r] : 0.0, c );
     PrevCol = c;
     c++;
   }
-  return str;  
+  return str.write( Buffer.data(), Buffer.size() );
+}
+
+
+template < typename T >
+void TableKey::appendNumber( const T &v, int c ) const
+{
+  Str s( v, format( c ) );
+  if ( s.size() >= Width[c] )
+    Buffer += s;
+  else
+    Buffer += Str( s, Width[c] );
 }
 
 
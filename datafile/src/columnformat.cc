@@ -0,0 +1,368 @@
+/*
+  columnformat.cc
+  A printf-style format for numbers in table columns that is parsed only once.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <relacs/columnformat.h>
+
+namespace relacs {
+
+
+  /*! Powers of ten that are exactly representable as doubles. */
+static const double Pow10[23] = {
+  1.0e0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7,
+  1.0e8, 1.0e9, 1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15,
+  1.0e16, 1.0e17, 1.0e18, 1.0e19, 1.0e20, 1.0e21, 1.0e22
+};
+
+  /*! Powers of ten as integers. */
+static const unsigned long long IPow10[20] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+  10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+  100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+  100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+  100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+
+  /*! Rounds \a x times ten to the power of \a s to the nearest integer \a m.
+      \a x times the power of ten is computed with a single rounding error
+      of at most half a unit in the last place. Therefore the rounded integer
+      is the one printf() would compute from the exact value,
+      unless the scaled value is too close to half way between two integers.
+      \return \c false if the result is not guaranteed to be exact. */
+static inline bool scaledRound( double x, int s, unsigned long long &m )
+{
+  double y;
+  if ( s >= 0 ) {
+    if ( s > 22 )
+      return false;
+    y = x*Pow10[s];
+  }
+  else {
+    if ( -s > 22 )
+      return false;
+    y = x/Pow10[-s];
+  }
+  if ( y >= 1.0e15 )
+    return false;
+  double fl = ::floor( y );
+  double frac = y - fl;
+  if ( ::fabs( frac - 0.5 ) <= y*4.0e-16 )
+    return false;
+  m = (unsigned long long)fl;
+  if ( frac > 0.5 )
+    m++;
+  return true;
+}
+
+
+  /*! Writes the \a n least significant digits of \a m to \a p. */
+static inline int writeDigits( char *p, unsigned long long m, int n )
+{
+  for ( int k=n-1; k>=0; k-- ) {
+    p[k] = '0' + m%10;
+    m /= 10;
+  }
+  return n;
+}
+
+
+  /*! The number of decimal digits of \a m. */
+static inline int numDigits( unsigned long long m )
+{
+  int n = 1;
+  while ( m >= 10 ) {
+    m /= 10;
+    n++;
+  }
+  return n;
+}
+
+
+ColumnFormat::ColumnFormat( void )
+{
+  setFormat( "%g" );
+}
+
+
+ColumnFormat::ColumnFormat( const string &format )
+{
+  setFormat( format );
+}
+
+
+void ColumnFormat::setFormat( const string &format )
+{
+  Format = format;
+
+  // complete the format like Str( double, const string& ) does:
+  const char *fs = format.c_str();
+  const char *fp = fs;
+  for ( fp = strchr( fp, '%' ); fp != 0; fp = strchr( fp, '%' ) ) {
+    if ( *(fp+1) == '%' )
+      fp += 2;
+    else
+      break;
+  }
+  if ( fp == 0 )
+    PrintfFormat = "%g";
+  else {
+    char *ep;
+    ++fp;
+    strtol( fp, &ep, 10 );
+    fp = ep;
+    if ( *fp == '.' ) {
+      strtol( fp+1, &ep, 10 );
+      fp = ep;
+    }
+    int findex = fp - fs;
+    PrintfFormat = format;
+    if ( findex == (int)format.size() )
+      PrintfFormat += 'g';
+    else if ( strchr( "aAfFgGeE", format[findex] ) == 0 )
+      PrintfFormat[findex] = 'g';
+  }
+
+  // parse the completed format:
+  Fast = false;
+  Prefix.clear();
+  Suffix.clear();
+  Conversion = 'g';
+  Upper = false;
+  Left = false;
+  Plus = false;
+  Space = false;
+  Zero = false;
+  Width = 0;
+  Precision = -1;
+  const char *cp = PrintfFormat.c_str();
+  while ( *cp != '\0' ) {
+    if ( *cp == '%' ) {
+      if ( *(cp+1) != '%' )
+	break;
+      cp++;
+    }
+    Prefix += *cp;
+    cp++;
+  }
+  if ( *cp != '%' )
+    return;
+  cp++;
+  // flags:
+  for ( ; *cp != '\0' && strchr( "-+ #0", *cp ) != 0; cp++ ) {
+    switch ( *cp ) {
+    case '-': Left = true; break;
+    case '+': Plus = true; break;
+    case ' ': Space = true; break;
+    case '0': Zero = true; break;
+    default: return;
+    }
+  }
+  // width:
+  for ( ; *cp >= '0' && *cp <= '9'; cp++ ) {
+    Width = 10*Width + *cp - '0';
+    if ( Width > 64 )
+      return;
+  }
+  // precision:
+  if ( *cp == '.' ) {
+    cp++;
+    Precision = 0;
+    for ( ; *cp >= '0' && *cp <= '9'; cp++ ) {
+      Precision = 10*Precision + *cp - '0';
+      if ( Precision > 22 )
+	return;
+    }
+  }
+  // conversion:
+  if ( *cp == '\0' || strchr( "fFeEgG", *cp ) == 0 )
+    return;
+  Upper = ( *cp == 'F' || *cp == 'E' || *cp == 'G' );
+  Conversion = Upper ? *cp - 'A' + 'a' : *cp;
+  cp++;
+  Suffix = cp;
+  if ( Suffix.find( '%' ) != string::npos )
+    return;
+  Fast = true;
+}
+
+
+int ColumnFormat::fastFormat( char *buf, double v ) const
+{
+  if ( ! std::isfinite( v ) )
+    return -1;
+
+  bool neg = std::signbit( v );
+  double x = ::fabs( v );
+  int p = Precision < 0 ? 6 : Precision;
+  char body[64];
+  int n = 0;
+
+  if ( Conversion == 'f' ) {
+    unsigned long long m;
+    if ( ! scaledRound( x, p, m ) )
+      return -1;
+    unsigned long long ip = p < 20 ? m / IPow10[p] : 0;
+    unsigned long long fp = p < 20 ? m % IPow10[p] : m;
+    n += writeDigits( body+n, ip, numDigits( ip ) );
+    if ( p > 0 ) {
+      body[n++] = '.';
+      n += writeDigits( body+n, fp, p );
+    }
+  }
+  else {
+    // significant digits m and decimal exponent e:
+    if ( Conversion == 'g' && p == 0 )
+      p = 1;
+    int pe = Conversion == 'g' ? p - 1 : p;
+    if ( pe > 14 )
+      return -1;
+    unsigned long long m = 0;
+    int e = 0;
+    if ( x != 0.0 ) {
+      e = (int)::floor( ::log10( x ) );
+      int k = 0;
+      for ( k=0; k<4; k++ ) {
+	if ( ! scaledRound( x, pe - e, m ) )
+	  return -1;
+	if ( m >= IPow10[pe+1] )
+	  e++;
+	else if ( m < IPow10[pe] )
+	  e--;
+	else
+	  break;
+      }
+      if ( k >= 4 )
+	return -1;
+    }
+    char digits[20];
+    writeDigits( digits, m, pe+1 );
+
+    if ( Conversion == 'g' && e < p && e >= -4 ) {
+      // fixed notation with p-1-e digits after the decimal point:
+      int nf = p - 1 - e;
+      const char *fd = digits;
+      if ( e >= 0 ) {
+	memcpy( body+n, digits, e+1 );
+	n += e+1;
+	fd = digits + e + 1;
+      }
+      else
+	body[n++] = '0';
+      int nz = e < 0 ? -e - 1 : 0;
+      int nd = nf - nz;
+      // strip trailing zeros:
+      while ( nd > 0 && fd[nd-1] == '0' )
+	nd--;
+      if ( nd > 0 ) {
+	body[n++] = '.';
+	for ( int k=0; k<nz; k++ )
+	  body[n++] = '0';
+	memcpy( body+n, fd, nd );
+	n += nd;
+      }
+    }
+    else {
+      // exponential notation:
+      body[n++] = digits[0];
+      int nd = pe;
+      if ( Conversion == 'g' ) {
+	// strip trailing zeros:
+	while ( nd > 0 && digits[nd] == '0' )
+	  nd--;
+      }
+      if ( nd > 0 ) {
+	body[n++] = '.';
+	memcpy( body+n, digits+1, nd );
+	n += nd;
+      }
+      body[n++] = Upper ? 'E' : 'e';
+      body[n++] = e < 0 ? '-' : '+';
+      int ae = e < 0 ? -e : e;
+      n += writeDigits( body+n, ae, ae < 100 ? 2 : 3 );
+    }
+  }
+
+  // sign and padding:
+  char sign = neg ? '-' : ( Plus ? '+' : ( Space ? ' ' : '\0' ) );
+  int len = n + ( sign != '\0' ? 1 : 0 );
+  int pad = Width > len ? Width - len : 0;
+  int k = 0;
+  if ( pad > 0 && ! Left && ! Zero ) {
+    memset( buf, ' ', pad );
+    k += pad;
+  }
+  if ( sign != '\0' )
+    buf[k++] = sign;
+  if ( pad > 0 && ! Left && Zero ) {
+    memset( buf+k, '0', pad );
+    k += pad;
+  }
+  memcpy( buf+k, body, n );
+  k += n;
+  if ( pad > 0 && Left ) {
+    memset( buf+k, ' ', pad );
+    k += pad;
+  }
+  return k;
+}
+
+
+void ColumnFormat::appendFallback( string &s, double v ) const
+{
+  char ss[512];
+  int n = snprintf( ss, sizeof( ss ), PrintfFormat.c_str(), v );
+  if ( n < 0 )
+    return;
+  if ( n < (int)sizeof( ss ) )
+    s.append( ss, n );
+  else {
+    string::size_type start = s.size();
+    s.resize( start + n + 1 );
+    snprintf( &s[start], n + 1, PrintfFormat.c_str(), v );
+    s.resize( start + n );
+  }
+}
+
+
+void ColumnFormat::append( string &s, double v, int width, char pad ) const
+{
+  string::size_type start = s.size();
+  char buf[128];
+  int n = Fast ? fastFormat( buf, v ) : -1;
+  if ( n >= 0 ) {
+    s += Prefix;
+    s.append( buf, n );
+    s += Suffix;
+  }
+  else
+    appendFallback( s, v );
+  int len = s.size() - start;
+  if ( len < width )
+    s.insert( start, width - len, pad );
+}
+
+
+}; /* namespace relacs */
+
@@ -32,6 +32,8 @@ TableKey::TableKey( void )
     Sections(),
     Columns(),
     Width(),
+    Formats(),
+    Buffer(),
     PrevCol( -1 ),
     Comment( "#" ),
     KeyStart( "# " ),
@@ -47,6 +49,8 @@ TableKey::TableKey( const TableKey &key )
     Sections( key.Sections ),
     Columns( key.Columns ),
     Width( key.Width ),
+    Formats( key.Formats ),
+    Buffer(),
     PrevCol( key.PrevCol ),
     Comment( key.Comment ),
     KeyStart( key.KeyStart ),
@@ -62,6 +66,8 @@ TableKey::TableKey( const Options &o )
     Sections(),
     Columns(),
     Width(),
+    Formats(),
+    Buffer(),
     PrevCol( -1 ),
     Comment( "#" ),
     KeyStart( "# " ),
@@ -600,6 +606,7 @@ void TableKey::clear( void )
   Sections.clear();
   Columns.clear();
   Width.clear();
+  Formats.clear();
 }
 
 
@@ -1097,16 +1104,11 @@ ostream &TableKey::save( ostream &str, double v, int c ) const
 
   PrevCol = c;
 
-  if ( c > 0 )
-    str << Separator;
-  else
-    str << DataStart;
-  Str s( v, format( c ) );
-  if ( s.size() >= Width[c] )
-    str << s;
-  else
-    str << Str( s, Width[c] );
-  return str;  
+  updateFormats( c, c+1 );
+  Buffer.clear();
+  Buffer += c > 0 ? Separator : DataStart;
+  appendNumber( v, c );
+  return str.write( Buffer.data(), Buffer.size() );
 }
 
 
@@ -1119,22 +1121,17 @@ ostream &TableKey::save( ostream &str, const TableData &table,
   if ( c < 0 )
     return str;
 
+  updateFormats( c, c+table.columns() );
+  Buffer.clear();
   for ( int k=0; k<table.columns(); k++ ) {
     if ( c >= (int)Columns.size() )
-      return str;
-    if ( c > 0 )
-      str << Separator;
-    else
-      str << DataStart;
-    Str s( r < (int)table.rows() ? table( k, r ) : 0.0, format( c ) );
-    if ( s.size() >= Width[c] )
-      str << s;
-    else
-      str << Str( s, Width[c] );
+      break;
+    Buffer += c > 0 ? Separator : DataStart;
+    appendNumber( r < (int)table.rows() ? table( k, r ) : 0.0, c );
     PrevCol = c;
     c++;
   }
-  return str;  
+  return str.write( Buffer.data(), Buffer.size() );
 }
 
 
@@ -1152,40 +1149,31 @@ ostream &TableKey::save( ostream &str, const TableData &table,
   if ( cend >= table.columns() || cend < 0 )
     cend = table.columns();
 
+  updateFormats( c, c+cend-cbegin );
+  Buffer.clear();
   for ( int k=cbegin; k<cend; k++ ) {
     if ( c >= (int)Columns.size() )
-      return str;
-    if ( c > 0 )
-      str << Separator;
-    else
-      str << DataStart;
-    Str s( r < (int)table.rows() ? table( k, r ) : 0.0, format( c ) );
-    if ( s.size() >= Width[c] )
-      str << s;
-    else
-      str << Str( s, Width[c] );
+      break;
+    Buffer += c > 0 ? Separator : DataStart;
+    appendNumber( r < (int)table.rows() ? table( k, r ) : 0.0, c );
     PrevCol = c;
     c++;
   }
-  return str;  
+  return str.write( Buffer.data(), Buffer.size() );
 }
 
 
 ostream &TableKey::save( ostream &str, const TableData &table ) const
 {
+  updateFormats( 0, table.columns() );
   for ( int r=0; r<table.rows(); r++ ) {
+    Buffer.clear();
     for ( int c=0; c<table.columns() && c<columns(); c++ ) {
-      if ( c > 0 )
-	str << Separator;
-      else
-	str << DataStart;
-      Str s( table( c, r ), format( c ) );
-      if ( s.size() >= Width[c] )
-	str << s;
-      else
-	str << Str( s, Width[c] );
+      Buffer += c > 0 ? Separator : DataStart;
+      appendNumber( table( c, r ), c );
     }
-    str << '\n';
+    Buffer += '\n';
+    str.write( Buffer.data(), Buffer.size() );
   }
   PrevCol = -1;
   return str;  
@@ -1261,6 +1249,25 @@ ostream &TableKey::save( ostream &str, const Parameter &param, int c ) const
 }
 
 
+void TableKey::updateFormats( int cbegin, int cend ) const
+{
+  if ( cend > (int)Formats.size() )
+    cend = Formats.size();
+  // the formats might have been changed via the Parameters of the columns:
+  for ( int c=cbegin; c<cend; c++ ) {
+    Str f = Columns[c]->format();
+    if ( f != Formats[c].format() )
+      Formats[c].setFormat( f );
+  }
+}
+
+
+void TableKey::appendNumber( double v, int c ) const
+{
+  Formats[c].append( Buffer, v, Width[c], Str::pad() );
+}
+
+
 void TableKey::setSaveColumn( int col )
 {
   if ( col < -1 )
@@ -1332,6 +1339,11 @@ void TableKey::init( void )
     Width[c] = uw > w ? uw : w;
   }
 
+  // parse the formats:
+  Formats.resize( Columns.size() );
+  for ( unsigned int c=0; c<Formats.size(); c++ )
+    Formats[c].setFormat( Columns[c]->format() );
+
 }
 
 
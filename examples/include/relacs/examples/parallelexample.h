@@ -0,0 +1,83 @@
+/*
+  examples/parallelexample.h
+  Analyzes recorded trials in parallel on the thread pool.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+  
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_EXAMPLES_PARALLELEXAMPLE_H_
+#define _RELACS_EXAMPLES_PARALLELEXAMPLE_H_
+
+
+#include <vector>
+#include <relacs/array.h>
+#include <relacs/sampledata.h>
+#include <relacs/threadpool.h>
+#include <relacs/repro.h>
+using namespace relacs;
+
+namespace examples {
+
+
+/*!
+\class ParallelExample
+\author Jan Benda
+\brief An example showing how to analyze trials in parallel.
+
+The RePro records \c trials trials of \c duration seconds of the first
+input trace. Then the mean and the standard deviation of each trial
+are computed by parallelFor() on the threadPool(). Stopping the
+RePro cancels the analysis via cancelTasks(), and parallelFor()
+returns \c false.
+*/
+
+
+class ParallelExample : public RePro
+{
+  Q_OBJECT
+
+public:
+
+    /*! Constructs a ParallelExample-RePro: create options. */
+  ParallelExample( void );
+    /*! Deconstructs a ParallelExample-RePro. */
+  ~ParallelExample( void );
+
+    /*! Run the RePro */
+  virtual int main( void );
+
+
+private:
+
+    /*! Computes the mean and the standard deviation of a range of trials. */
+  class TrialStats : public ThreadPool::Loop
+  {
+  public:
+    TrialStats( const vector< SampleDataF > &trials, ArrayD &means, ArrayD &stdevs );
+    virtual void run( int first, int last, const ThreadPool::Group &group );
+  private:
+    const vector< SampleDataF > &Trials;
+    ArrayD &Means;
+    ArrayD &StDevs;
+  };
+
+};
+
+
+}; /* namespace examples */
+
+#endif /* ! _RELACS_EXAMPLES_PARALLELEXAMPLE_H_ */
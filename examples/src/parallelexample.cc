@@ -0,0 +1,112 @@
+/*
+  examples/parallelexample.cc
+  Analyzes recorded trials in parallel on the thread pool.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+  
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <relacs/stats.h>
+#include <relacs/examples/parallelexample.h>
+using namespace relacs;
+
+namespace examples {
+
+
+ParallelExample::ParallelExample( void )
+  : RePro( "ParallelExample", "examples",
+	   "Jan Benda", "1.0", "Oct 19, 2026" )
+{
+  // add some parameter as options:
+  addInteger( "trials", "Number of trials", 20, 1, 10000, 1 );
+  addNumber( "duration", "Duration of a trial", 0.1, 0.01, 1000.0, 0.02, "sec", "ms" );
+}
+
+
+ParallelExample::~ParallelExample( void )
+{
+}
+
+
+int ParallelExample::main( void )
+{
+  // get options:
+  int ntrials = integer( "trials" );
+  double duration = number( "duration" );
+
+  // don't print repro message:
+  noMessage();
+
+  // plot trace:
+  tracePlotContinuous( duration );
+
+  // record trials:
+  vector< SampleDataF > trials;
+  trials.reserve( ntrials );
+  for ( int k=0; k<ntrials; k++ ) {
+    sleep( duration );
+    if ( interrupt() )
+      return Aborted;
+    trials.push_back( SampleDataF( 0.0, duration, trace( 0 ).stepsize() ) );
+    trace( 0 ).copy( currentTime() - duration, trials.back() );
+  }
+
+  // analyze trials in parallel:
+  ArrayD means( ntrials, 0.0 );
+  ArrayD stdevs( ntrials, 0.0 );
+  TrialStats stats( trials, means, stdevs );
+  if ( ! parallelFor( 0, ntrials, stats ) ) {
+    // the RePro was stopped while the trials were analyzed:
+    message( "Analysis canceled" );
+    return Aborted;
+  }
+
+  message( "Mean over " + Str( ntrials ) + " trials: " + Str( means.mean(), "%.3g" ) +
+	   ", standard deviation: " + Str( stdevs.mean(), "%.3g" ) );
+  return Completed;
+}
+
+
+ParallelExample::TrialStats::TrialStats( const vector< SampleDataF > &trials,
+					 ArrayD &means, ArrayD &stdevs )
+  : Trials( trials ),
+    Means( means ),
+    StDevs( stdevs )
+{
+}
+
+
+void ParallelExample::TrialStats::run( int first, int last,
+				       const ThreadPool::Group &group )
+{
+  // each call processes its own range of trials, so no locking is needed:
+  for ( int k=first; k<last; k++ ) {
+    if ( group.canceled() )
+      return;
+    double stdev = 0.0;
+    Means[k] = meanStdev( stdev, Trials[k].array() );
+    StDevs[k] = stdev;
+  }
+}
+
+
+addRePro( ParallelExample, examples );
+
+
+}; /* namespace examples */
+
+
+#include "moc_parallelexample.cc"
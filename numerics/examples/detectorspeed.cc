@@ -0,0 +1,157 @@
+/*
+  detectorspeed.cc
+  Measures the speed of the Detector algorithms with and without direct access to the data.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Usage: detectorspeed [<file> [<threshold>]]
+
+<file> is a recorded voltage trace, e.g. a trace-1.raw file of a P-unit
+or an intracellular recording converted to two columns of
+time and voltage. Without a file a spike train with a rate of 100Hz
+on top of noise is simulated. The data are passed to the detectors
+in chunks of 10ms like the update intervals of the data acquisition.
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <relacs/random.h>
+#include <relacs/sampledata.h>
+#include <relacs/eventdata.h>
+#include <relacs/detector.h>
+using namespace std;
+using namespace relacs;
+
+
+  // An iterator over floats that hides the contiguous memory,
+  // i.e. the Detector steps through each data element.
+class FloatIterator
+{
+
+public:
+
+  FloatIterator( void ) : P( 0 ) {};
+  FloatIterator( const float *p ) : P( p ) {};
+
+  bool operator==( const FloatIterator &p ) const { return P == p.P; };
+  bool operator!=( const FloatIterator &p ) const { return P != p.P; };
+  bool operator<( const FloatIterator &p ) const { return P < p.P; };
+  bool operator>( const FloatIterator &p ) const { return P > p.P; };
+  bool operator<=( const FloatIterator &p ) const { return P <= p.P; };
+  bool operator>=( const FloatIterator &p ) const { return P >= p.P; };
+  const FloatIterator &operator++( void ) { P++; return *this; };
+  const FloatIterator &operator--( void ) { P--; return *this; };
+  const FloatIterator &operator+=( int incr ) { P += incr; return *this; };
+  FloatIterator operator+( int incr ) const { return FloatIterator( P+incr ); };
+  FloatIterator operator-( int decr ) const { return FloatIterator( P-decr ); };
+  int operator-( const FloatIterator &p ) const { return P - p.P; };
+  double operator*( void ) const { return *P; };
+
+private:
+
+  const float *P;
+
+};
+
+
+template < typename DataIter >
+double detect( const SampleDataF &data, DataIter first, int algo,
+	       double threshold, int &nevents )
+{
+  typedef SampleDataF::const_range_iterator TimeIter;
+  Detector< DataIter, TimeIter > D;
+  AcceptEvent< DataIter, TimeIter > check;
+  EventData events( data.size(), 0.0, data.length(), data.stepsize() );
+  int chunk = data.indices( 0.01 );
+  if ( chunk < 1 )
+    chunk = 1;
+  double thresh = threshold;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  D.init( first, first, data.range().begin() );
+  for ( int k=chunk; k<data.size()+chunk; k+=chunk ) {
+    DataIter last = first + ( k < data.size() ? k : data.size() );
+    if ( algo == 0 )
+      D.peak( first, last, events, thresh, threshold, threshold, check );
+    else if ( algo == 1 )
+      D.trough( first, last, events, thresh, threshold, threshold, check );
+    else
+      D.rising( first, last, events, thresh, threshold, threshold, check );
+  }
+  chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+  nevents = events.size();
+  return chrono::duration_cast< chrono::nanoseconds >( stop - start ).count();
+}
+
+
+int main( int argc, char **argv )
+{
+  SampleDataF data;
+  double threshold = 1.0;
+  if ( argc > 1 ) {
+    data.load( argv[1] );
+    if ( data.empty() ) {
+      cerr << "failed to read data from file " << argv[1] << '\n';
+      return 1;
+    }
+    if ( argc > 2 )
+      threshold = atof( argv[2] );
+  }
+  else {
+    // simulated spike train:
+    double stepsize = 0.00005;
+    data.resize( 0.0, 100.0, stepsize, 0.0f );
+    for ( int k=0; k<data.size(); k++ )
+      data[k] = 0.1*rnd.gaussian();
+    double rate = 100.0;
+    int spikewidth = data.indices( 0.001 );
+    for ( int k=0; k<data.size(); k++ ) {
+      if ( rnd.uniform() < rate*stepsize ) {
+	for ( int j=0; j<spikewidth && k+j<data.size(); j++ )
+	  data[k+j] += 2.0*::sin( 6.28318*j/spikewidth );
+      }
+    }
+  }
+
+  const char *names[3] = { "peak", "trough", "rising" };
+  for ( int algo=0; algo<3; algo++ ) {
+    // minimum time of several repetitions:
+    int n1 = 0;
+    int n2 = 0;
+    double t1 = 0.0;
+    double t2 = 0.0;
+    for ( int r=0; r<5; r++ ) {
+      double t = detect( data, FloatIterator( data.begin() ), algo, threshold, n1 );
+      if ( r == 0 || t < t1 )
+	t1 = t;
+      t = detect( data, data.begin(), algo, threshold, n2 );
+      if ( r == 0 || t < t2 )
+	t2 = t;
+    }
+    cout << names[algo] << ": " << n1 << " events, "
+	 << t1/data.size() << "ns per sample with iterator, "
+	 << t2/data.size() << "ns per sample with direct access";
+    if ( n1 != n2 )
+      cout << " FAILED: " << n2 << " events";
+    cout << '\n';
+  }
+
+  return 0;
+}
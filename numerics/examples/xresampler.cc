@@ -0,0 +1,82 @@
+/*
+  xresampler.cc
+  Tests the Resampler with sine waves.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <relacs/array.h>
+#include <relacs/resampler.h>
+using namespace std;
+using namespace relacs;
+
+
+  // Resamples a sine wave of frequency f from inrate to outrate
+  // in chunks of varying size and returns the amplitude
+  // and the maximum deviation from the expected sine wave.
+double resample( double inrate, double outrate, double f, double &maxerror )
+{
+  Resampler rs( inrate, outrate );
+  ArrayF in( (int)inrate );
+  for ( int k=0; k<in.size(); k++ )
+    in[k] = ::sin( 2.0*M_PI*f*k/inrate );
+  ArrayF out;
+  out.reserve( (int)outrate + 1 );
+  int chunk = 1;
+  for ( int k=0; k<in.size(); k+=chunk, chunk = 1 + ( chunk*7 )%313 )
+    rs.process( in.data() + k, k+chunk < in.size() ? chunk : in.size() - k, out );
+
+  // skip the start, where the filter sees the zero initial buffer:
+  int k0 = 4*rs.width()*outrate/inrate + 1;
+  double amplitude = 0.0;
+  maxerror = 0.0;
+  for ( int k=k0; k<out.size(); k++ ) {
+    if ( ::fabs( out[k] ) > amplitude )
+      amplitude = ::fabs( out[k] );
+    double e = ::fabs( out[k] - ::sin( 2.0*M_PI*f*k/outrate ) );
+    if ( e > maxerror )
+      maxerror = e;
+  }
+  return amplitude;
+}
+
+
+int main( void )
+{
+  const double rates[4][2] = { { 20000.0, 44100.0 }, { 44100.0, 44100.0 },
+			       { 50000.0, 48000.0 }, { 100000.0, 44100.0 } };
+  for ( int r=0; r<4; r++ ) {
+    double inrate = rates[r][0];
+    double outrate = rates[r][1];
+    double nyquist = 0.5*( inrate < outrate ? inrate : outrate );
+    const double freqs[4] = { 0.01*nyquist, 0.1*nyquist, 0.5*nyquist, 1.3*nyquist };
+    for ( int f=0; f<4; f++ ) {
+      if ( freqs[f] >= 0.5*inrate )
+	continue;
+      double maxerror = 0.0;
+      double amplitude = resample( inrate, outrate, freqs[f], maxerror );
+      cout << inrate << "Hz -> " << outrate << "Hz, " << freqs[f] << "Hz: "
+	   << "amplitude=" << amplitude;
+      if ( freqs[f] < nyquist )
+	cout << ", maximum error=" << maxerror;
+      cout << '\n';
+    }
+  }
+  return 0;
+}
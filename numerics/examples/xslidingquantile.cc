@@ -0,0 +1,80 @@
+/*
+  xslidingquantile.cc
+  
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <relacs/array.h>
+#include <relacs/random.h>
+#include <relacs/stats.h>
+#include <relacs/slidingquantile.h>
+using namespace std;
+using namespace relacs;
+
+
+int main( void )
+{
+  const int window = 501;
+  const int n = 20000;
+  const double fracs[3] = { 0.1, 0.5, 0.9 };
+
+  // Gaussian noise with spikes in a cyclic buffer:
+  CyclicArray<double> data( 4096 );
+  ArrayD x( n );
+  for ( int k=0; k<n; k++ )
+    x[k] = rnd.gaussian() + ( k%97 == 0 ? 20.0 : 0.0 );
+
+  for ( int f=0; f<3; f++ ) {
+    // compare sliding quantile with quantile of sorted window:
+    SlidingQuantile<double> sq( window, fracs[f] );
+    double maxerror = 0.0;
+    data.clear();
+    for ( int k=0; k<n; k+=37 ) {
+      int m = k+37 < n ? 37 : n-k;
+      for ( int j=0; j<m; j++ )
+	data.push( x[k+j] );
+      sq.push( data, k, k+m );
+      int k0 = k+m-window < 0 ? 0 : k+m-window;
+      ArrayD w( x.data()+k0, k+m-k0 );
+      sort( w.begin(), w.end() );
+      double e = ::fabs( sq.quantile() - quantile( fracs[f], w ) );
+      if ( e > maxerror )
+	maxerror = e;
+    }
+    cout << "SlidingQuantile " << fracs[f] << ": maximum error=" << maxerror << '\n';
+
+    // P-square estimate of all data:
+    P2Quantile<double> pq( fracs[f] );
+    pq.push( x.begin(), x.end() );
+    ArrayD w( x );
+    sort( w.begin(), w.end() );
+    cout << "P2Quantile " << fracs[f] << ": estimate=" << pq.quantile()
+	 << ", true=" << quantile( fracs[f], w ) << '\n';
+  }
+
+  // robust noise estimate:
+  SlidingMAD<double> mad( 5000 );
+  mad.push( x.begin(), x.end() );
+  cout << "SlidingMAD: median=" << mad.median() << ", stdev=" << mad.stdev()
+       << ", standard deviation=" << stdev( x ) << '\n';
+
+  return 0;
+}
@@ -118,6 +118,8 @@ public:
 	equals exactly \a n.
         The last \a n data elements are preserved. */
   virtual void free( int n );
+    /*! The buffer holding the capacity() data elements. */
+  const T *buffer( void ) const;
 
     /*! Copy the data indices from \a a to this. */
   void update( const CyclicArray<T> *a );
@@ -136,6 +138,12 @@ public:
         If \a i is an invalid index
 	a reference to a variable set to zero is returned. */
   T &at( int i );
+    /*! Sets \a data to the data element at index \a i and returns
+        the number of elements, at most \a n, that follow \a data
+        in contiguous memory, i.e. up to the end of the array
+        or the end of the cyclic buffer, whichever comes first.
+        Returns zero if \a i is an invalid index. */
+  int span( int i, int n, const T* &data ) const;
 
     /*! Returns a const reference to the first data element.
         If the array is empty or the first element is 
@@ -523,6 +531,13 @@ int CyclicArray<T>::capacity( void ) const
 }
 
 
+template < typename T >
+const T *CyclicArray<T>::buffer( void ) const
+{
+  return Buffer;
+}
+
+
 template < typename T >
 void CyclicArray<T>::reserve( int n )
 {
@@ -636,6 +651,21 @@ T &CyclicArray<T>::operator[]( int i )
 }
 
 
+template < typename T > 
+int CyclicArray<T>::span( int i, int n, const T* &data ) const
+{
+  if ( Buffer == 0 || i < minIndex() || i >= size() )
+    return 0;
+  if ( n > size() - i )
+    n = size() - i;
+  int j = i % NBuffer;
+  if ( n > NBuffer - j )
+    n = NBuffer - j;
+  data = Buffer + j;
+  return n;
+}
+
+
 template < typename T > 
 const T &CyclicArray<T>::at( int i ) const
 {
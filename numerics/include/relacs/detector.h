@@ -24,10 +24,58 @@
 
 #include <relacs/eventdata.h>
 #include <relacs/eventlist.h>
+#include <relacs/prescan.h>
 
 namespace relacs {
 
 
+  /*! Direct access to the data elements a Detector operates on.
+      If the data elements starting at \a first are stored
+      contiguously in memory, \a data is set to the element \a first points to
+      and the number of contiguous elements up to \a last is returned.
+      This default implementation returns zero,
+      i.e. the data are only accessible via the iterators.
+      Overload this function for iterators of your own data types
+      (see InDataIterator) to speed up the Detector algorithms. */
+template < typename DataIter >
+inline int detectorSpan( const DataIter &first, const DataIter &last,
+			 const float* &data )
+{
+  return 0;
+}
+
+
+  /*! Direct access to arrays of floats for the Detector algorithms. */
+inline int detectorSpan( const float* const &first, const float* const &last,
+			 const float* &data )
+{
+  data = first;
+  return last > first ? last - first : 0;
+}
+
+
+  /*! Direct access to arrays of floats for the Detector algorithms. */
+inline int detectorSpan( float* const &first, float* const &last,
+			 const float* &data )
+{
+  data = first;
+  return last > first ? last - first : 0;
+}
+
+
+  /*! The time base of the times a Detector operates on.
+      If the time of the element \a first + \a n is given by
+      \a offset + (\a index + \a n) * \a stepsize,
+      then set these variables and return \c true.
+      This default implementation returns \c false. */
+template < typename TimeIter >
+inline bool detectorTimes( const TimeIter &first, double &offset,
+			   double &stepsize, int &index )
+{
+  return false;
+}
+
+
 /*!
 \class Detector
 \author Jan Benda
@@ -41,6 +89,15 @@ The input data are traversed by two iterators.
 One of type \a DataIter returning the data values on which the events are to be detected,
 the other of \a  TimeIter returning the corresponding times.
 Usually, you should provide const types for both \a DataIter and \a TimeIter.
+
+Most of the data do not contain any events. The peak, trough, and
+threshold detectors therefore skip over such data by directly scanning
+contiguous segments of the data as provided by detectorSpan()
+(and detectorTimes() for the dynamic and the histogram variants).
+The peak(), trough(), peakTrough(), rising(), and falling() detectors
+in addition skip whole blocks of data by their minimum and maximum
+(see prescanRising(), prescanFalling(), and prescanCrossing()).
+The detected events are exactly the same as without these shortcuts.
 */
 
 template < typename DataIter, typename TimeIter >
@@ -213,6 +270,24 @@ public:
         \a minthresh can also be greater than \a maxthresh. */
   void checkThresh( double &threshold,
 		    double minthresh, double maxthresh );
+    /*! Advances Index and IndexTime over the data up to \a last
+        that do not change the direction of a peak and trough detector
+        with known direction, as long as these data are accessible
+        via detectorSpan(). Maxima and minima are updated accordingly.
+	Local minima in rising phases (\a localminima) and
+	local maxima in falling phases (\a localmaxima)
+	are added to BadEvents.
+	If \a dynamic is \c true, \a threshold is decayed to \a minthresh
+	like in the dynamic detectors with \a delay and \a decay. */
+  void skipPeakTrough( DataIter first, DataIter last, double &threshold,
+		       bool localminima=false, bool localmaxima=false,
+		       bool dynamic=false, double minthresh=0.0,
+		       double delay=0.0, double decay=0.0 );
+    /*! Advances Index and IndexTime over the data up to \a last
+        that do not cross \a threshold upwards (\a up = \c true)
+        or downwards (\a up = \c false), as long as these data
+	are accessible via detectorSpan(). */
+  void skipCrossing( DataIter last, double threshold, bool up );
 
   int Dir;
   DataIter Index;
@@ -381,6 +456,160 @@ void Detector< DataIter, TimeIter >::checkThresh( double &threshold,
 }
 
 
+template < typename DataIter, typename TimeIter >
+void Detector< DataIter, TimeIter >::skipPeakTrough( DataIter first,
+						     DataIter last,
+						     double &threshold,
+						     bool localminima,
+						     bool localmaxima,
+						     bool dynamic,
+						     double minthresh,
+						     double delay,
+						     double decay )
+{
+  if ( Dir == 0 )
+    return;
+
+  const float *data = 0;
+  int n = detectorSpan( Index, last, data );
+  if ( n <= 0 )
+    return;
+
+  double offset = 0.0;
+  double stepsize = 0.0;
+  int index = 0;
+  if ( ( dynamic || localminima || localmaxima ) &&
+       ! detectorTimes( IndexTime, offset, stepsize, index ) )
+    return;
+
+  // the two preceding data elements for local extrema:
+  int firstlocal = 2;
+  double prev1 = 0.0;
+  double prev2 = 0.0;
+  if ( localminima || localmaxima ) {
+    if ( Index > first + 1 ) {
+      firstlocal = 0;
+      prev1 = *(Index-1);
+      prev2 = *(Index-2);
+    }
+    else if ( Index > first ) {
+      firstlocal = 1;
+      prev1 = *(Index-1);
+    }
+  }
+
+  double maxvalue = MaxValue;
+  double minvalue = MinValue;
+  int maxk = -1;
+  int mink = -1;
+  double previoustime = PreviousTime;
+  int k = 0;
+  if ( ! dynamic && ! localminima && ! localmaxima ) {
+    // skip blocks of data without change of direction:
+    if ( Dir > 0 )
+      k = prescanRising( data, n, threshold, maxvalue, maxk );
+    else
+      k = prescanFalling( data, n, threshold, minvalue, mink );
+  }
+  for ( ; k < n; k++ ) {
+    double value = data[k];
+    double thresh = threshold;
+    double currenttime = 0.0;
+
+    if ( dynamic ) {
+      // update threshold, see dynamicPeakTrough():
+      currenttime = offset + (index+k) * stepsize;
+      if ( currenttime - PreviousEvent > delay
+	   && ( k > 0 || Index > first ) ) {
+	double dt = currenttime - previoustime;
+	double tau = 1.0;
+	if ( decay > 0.0 ) {
+	  if ( dt > 0.01 * decay )
+	    dt /= ceil( dt / ( 0.01 * decay ) );
+	  tau = dt / decay;
+	}
+	for ( double t = previoustime; t < currenttime; t += dt )
+	  thresh += ( minthresh - thresh ) * tau;
+      }
+    }
+
+    if ( Dir > 0 ) {
+      if ( maxvalue < value ) {
+	maxvalue = value;
+	maxk = k;
+      }
+      else if ( maxvalue >= value + thresh )
+	break;
+      else if ( localminima && k >= firstlocal &&
+		value > prev1 && prev1 < prev2 )
+	BadEvents.push( offset + (index+k-1) * stepsize, prev1 - minvalue );
+    }
+    else {
+      if ( value < minvalue ) {
+	minvalue = value;
+	mink = k;
+      }
+      else if ( value >= minvalue + thresh )
+	break;
+      else if ( localmaxima && k >= firstlocal &&
+		value < prev1 && prev1 > prev2 )
+	BadEvents.push( offset + (index+k-1) * stepsize, prev1 - minvalue );
+    }
+
+    threshold = thresh;
+    previoustime = currenttime;
+    prev2 = prev1;
+    prev1 = value;
+  }
+
+  if ( maxk >= 0 ) {
+    MaxIndex = Index;
+    MaxIndex += maxk;
+    MaxTime = IndexTime;
+    MaxTime += maxk;
+    MaxValue = maxvalue;
+  }
+  if ( mink >= 0 ) {
+    MinIndex = Index;
+    MinIndex += mink;
+    MinTime = IndexTime;
+    MinTime += mink;
+    MinValue = minvalue;
+  }
+  if ( dynamic && k > 0 )
+    PreviousTime = previoustime;
+  Index += k;
+  IndexTime += k;
+}
+
+
+template < typename DataIter, typename TimeIter >
+void Detector< DataIter, TimeIter >::skipCrossing( DataIter last,
+						   double threshold, bool up )
+{
+  const float *data = 0;
+  int n = detectorSpan( Index, last, data );
+  // the last element is needed for checking a crossing:
+  int k = n > 0 ? prescanCrossing( data, n, threshold, up ) : 0;
+  if ( up ) {
+    for ( ; k < n-1; k++ ) {
+      if ( data[k] <= threshold && data[k+1] > threshold )
+	break;
+    }
+  }
+  else {
+    for ( ; k < n-1; k++ ) {
+      if ( data[k] >= threshold && data[k+1] < threshold )
+	break;
+    }
+  }
+  if ( k > 0 ) {
+    Index += k;
+    IndexTime += k;
+  }
+}
+
+
 template < typename DataIter, typename TimeIter >
 template < class Check >
 void Detector< DataIter, TimeIter >::peakTrough( DataIter first,
@@ -453,6 +682,11 @@ void Detector< DataIter, TimeIter >::peakTrough( DataIter first,
 
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
+    // skip data without events:
+    skipPeakTrough( first, last, threshold );
+    if ( Index >= last )
+      break;
+
     // rising?
     if ( Dir > 0 ) {
       if ( MaxValue < *Index ) {
@@ -648,6 +882,11 @@ void Detector< DataIter, TimeIter >::peakTroughHist( DataIter first,
 
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, true, true );
+    if ( Index >= last )
+      break;
+
     // rising?
     if ( Dir > 0 ) {
       if ( MaxValue < *Index ) {
@@ -836,6 +1075,11 @@ void Detector< DataIter, TimeIter >::peak( DataIter first,
 
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
+    // skip data without events:
+    skipPeakTrough( first, last, threshold );
+    if ( Index >= last )
+      break;
+
     // rising?
     if ( Dir > 0 ) {
       if ( MaxValue < *Index ) {
@@ -972,6 +1216,11 @@ void Detector< DataIter, TimeIter >::peakHist( DataIter first,
 
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, false, true );
+    if ( Index >= last )
+      break;
+
     // rising?
     if ( Dir > 0 ) {
       if ( MaxValue < *Index ) {
@@ -1117,6 +1366,11 @@ void Detector< DataIter, TimeIter >::trough( DataIter first,
 
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
+    // skip data without events:
+    skipPeakTrough( first, last, threshold );
+    if ( Index >= last )
+      break;
+
     // rising?
     if ( Dir > 0 ) {
       if ( MaxValue < *Index ) {
@@ -1252,6 +1506,11 @@ void Detector< DataIter, TimeIter >::troughHist( DataIter first,
 
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, true, false );
+    if ( Index >= last )
+      break;
+
     // rising?
     if ( Dir > 0 ) {
       if ( MaxValue < *Index ) {
@@ -1432,6 +1691,12 @@ void Detector< DataIter, TimeIter >::dynamicPeakTrough( DataIter first,
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
 
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, false, false,
+		    true, minthresh, delay, decay );
+    if ( Index >= last )
+      break;
+
     currenttime = *IndexTime;
     // no recent events?
     if ( currenttime - PreviousEvent > delay
@@ -1656,6 +1921,12 @@ void Detector< DataIter, TimeIter >::dynamicPeakTroughHist( DataIter first,
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
 
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, true, true,
+		    true, minthresh, delay, decay );
+    if ( Index >= last )
+      break;
+
     currenttime = *IndexTime;
     // no recent events?
     if ( currenttime - PreviousEvent > delay
@@ -1872,6 +2143,12 @@ void Detector< DataIter, TimeIter >::dynamicPeak( DataIter first,
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
 
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, false, false,
+		    true, minthresh, delay, decay );
+    if ( Index >= last )
+      break;
+
     currenttime = *IndexTime;
     // no recent events?
     if ( currenttime - PreviousEvent > delay
@@ -2034,6 +2311,12 @@ void Detector< DataIter, TimeIter >::dynamicPeakHist( DataIter first,
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
 
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, false, true,
+		    true, minthresh, delay, decay );
+    if ( Index >= last )
+      break;
+
     // update threshold:
     currenttime = *IndexTime;
     // no recent events?
@@ -2206,6 +2489,12 @@ void Detector< DataIter, TimeIter >::dynamicTrough( DataIter first,
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
 
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, false, false,
+		    true, minthresh, delay, decay );
+    if ( Index >= last )
+      break;
+
     currenttime = *IndexTime;
     // no recent events?
     if ( currenttime - PreviousEvent > delay
@@ -2367,6 +2656,12 @@ void Detector< DataIter, TimeIter >::dynamicTroughHist( DataIter first,
   // loop through the new read data:
   for ( ; Index < last; ++Index, ++IndexTime ) {
 
+    // skip data without events:
+    skipPeakTrough( first, last, threshold, true, false,
+		    true, minthresh, delay, decay );
+    if ( Index >= last )
+      break;
+
     currenttime = *IndexTime;
     // no recent events?
     if ( currenttime - PreviousEvent > delay
@@ -2536,6 +2831,11 @@ void Detector< DataIter, TimeIter >::rising( DataIter first,
   // loop through the new read data:
   for ( ; Index < lastindex; ++Index, ++IndexTime ) {
 
+    // skip data without threshold crossings:
+    skipCrossing( last, threshold, true );
+    if ( Index >= lastindex )
+      break;
+
     // threshold crossed?
     if ( *Index <= threshold &&
 	 *(Index+1) > threshold ) {
@@ -2625,6 +2925,11 @@ void Detector< DataIter, TimeIter >::falling( DataIter first,
   // loop through the new read data:
   for ( ; Index < lastindex; ++Index, ++IndexTime ) {
 
+    // skip data without threshold crossings:
+    skipCrossing( last, threshold, false );
+    if ( Index >= lastindex )
+      break;
+
     // threshold crossed?
     if ( *Index >= threshold &&
 	 *(Index+1) < threshold ) {
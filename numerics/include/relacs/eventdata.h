@@ -509,6 +509,34 @@ public:
     /*! Returns a pointer to the buffer with the event times. */
   inline double *data( void ) { return TimeBuffer; };
 
+    /*! The times of the events with indices \a first
+        to \a last-1 as contiguous segments of the buffer.
+	In a cyclic buffer the events may wrap around the end of the buffer.
+	Then the first \a n1 event times start at \a times1
+	and the remaining \a n2 event times at \a times2.
+	Otherwise \a n2 is zero.
+	\a first and \a last are clipped to minEvent() and size().
+	Loops over these segments are much faster than
+	calling operator[]() for each event.
+	\return the number of events \a n1 + \a n2.
+	\sa sizeSpans(), widthSpans(), next(), previous() */
+  int timeSpans( int first, int last, const double *&times1, int &n1,
+		 const double *&times2, int &n2 ) const;
+    /*! The sizes of the events with indices \a first
+        to \a last-1 as contiguous segments of the buffer,
+	see timeSpans() for details.
+	\return the number of events \a n1 + \a n2,
+	zero if there is no size buffer. */
+  int sizeSpans( int first, int last, const double *&sizes1, int &n1,
+		 const double *&sizes2, int &n2 ) const;
+    /*! The widths of the events with indices \a first
+        to \a last-1 as contiguous segments of the buffer,
+	see timeSpans() for details.
+	\return the number of events \a n1 + \a n2,
+	zero if there is no width buffer. */
+  int widthSpans( int first, int last, const double *&widths1, int &n1,
+		  const double *&widths2, int &n2 ) const;
+
     /*! Return in \a all the event times merged (summed up)
         with the ones of \a e. */
   void sum( const EventData &e, EventData &all ) const;
@@ -1252,6 +1280,12 @@ public:
 
 private:
 
+    /*! The elements \a first to \a last-1 of \a buffer
+        as one or two contiguous segments. \sa timeSpans() */
+  int spans( const double *buffer, int first, int last,
+	     const double *&data1, int &n1,
+	     const double *&data2, int &n2 ) const;
+
     /*! \c true in case this owns the buffers. */
   bool Own;
     /*! Buffer for the times of events measured in seconds. */
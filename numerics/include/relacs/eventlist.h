@@ -710,6 +710,32 @@ public:
   double reliability( double tbegin, double tend, 
 		      const Kernel &kernel, double dt=0.001 ) const;
 
+    /*! Computes the matrix \a corr of the correlation coefficients
+        between all pairs of EventData convolved with \a kernel
+        between time \a tbegin and time \a tend seconds
+	using a temporal resolution of \a dt seconds.
+	\a corr[i][j] is the correlation between the i-th and the j-th EventData.
+	Returns the mean over all pairs \a i < \a j
+        and the corresponding standard deviation in \a sd.
+        The convolved EventData are stored in a single matrix
+        and all pairwise products are computed in one pass
+        over blocks of this matrix. */
+  double correlation( double tbegin, double tend,
+		      const Kernel &kernel, double dt,
+		      vector< ArrayD > &corr, double &sd ) const;
+    /*! Computes the matrix \a rel of the reliabilities
+        between all pairs of EventData convolved with \a kernel
+        between time \a tbegin and time \a tend seconds
+	using a temporal resolution of \a dt seconds,
+	i.e. their correlation without removing the average
+	(Schreiber et al.).
+	\a rel[i][j] is the reliability of the i-th and the j-th EventData.
+	Returns the mean over all pairs \a i < \a j
+        and the corresponding standard deviation in \a sd. */
+  double reliability( double tbegin, double tend,
+		      const Kernel &kernel, double dt,
+		      vector< ArrayD > &rel, double &sd ) const;
+
     /*! Convolves each spiketrain with the kernel \a kernel.
         The resulting firing rates are pairwise multiplied.
         Returns the square root of the mean over all pairs in \a rate
@@ -754,7 +780,8 @@ public:
 	The data chunks are windowed by the \a window function and
 	may overlap by half if \a overlap is set to \c true.
 	The bin width for discretizing the events is set to \a step.
-        The frequency axis of the spectrum \a psd is set to the appropriate values. */
+        The frequency axis of the spectrum \a psd is set to the appropriate values.
+	Use TrialSpectra for updating the spectrum trial by trial. */
   void spectrum( double tbegin, double tend, double step,
 		 SampleDataD &psd,
 		 bool overlap=true, double (*window)( int j, int n )=bartlett ) const;
@@ -786,11 +813,13 @@ public:
 	\param[in] stimulus the stimulus that evoked the response
 	\param[out] g the gain between \a stimlus and response
 	\param[out] c the coherence between \a stimulus and response (the S-R coherence \f$\gamma^2_{SR}\f$).
-        \param[out] cs the cross-spectrum between \a stimulus and the events.
+        \param[out] cs the magnitude squared of the cross-spectrum between \a stimulus
+	and the events. It gets the size of \a g.
         \param[out] ss the power-spectrum of the \a stimulus.
         \param[out] rs the power-spectrum of the events.
 	\param[in] overlap if \c true overlap the fft windows by 50%.
-	\param[in] window the fft window to be used.  */
+	\param[in] window the fft window to be used.
+	\sa TrialSpectra */
   void spectra( const SampleDataD &stimulus, SampleDataD &g, SampleDataD &c,
 		SampleDataD &cs, SampleDataD &ss, SampleDataD &rs,
 		bool overlap=true, double (*window)( int j, int n )=bartlett ) const;
@@ -812,13 +841,15 @@ public:
 	\param[out] gsd the standard deviation of the gain.
 	\param[out] c the coherence between \a stimulus and response (the S-R coherence \f$\gamma^2_{SR}\f$).
 	\param[out] csd the standard deviation of the coherence.
-        \param[out] cs the cross-spectrum between \a stimulus and the events.
-	\param[out] cssd the standard deviation of the cross spectrum.
+        \param[out] cs the magnitude squared of the cross-spectrum between \a stimulus
+	and the events. It gets the size of \a g.
+	\param[out] cssd the standard deviation of \a cs.
         \param[out] ss the power-spectrum of the \a stimulus.
         \param[out] rs the power-spectrum of the events.
 	\param[out] rssd the standard deviation of the response spectrum.
 	\param[in] overlap if \c true overlap the fft windows by 50%.
-	\param[in] window the fft window to be used. */
+	\param[in] window the fft window to be used.
+	\sa TrialSpectra */
   void spectra( const SampleDataD &stimulus, SampleDataD &g, SampleDataD &gsd,
 		SampleDataD &c, SampleDataD &csd, SampleDataD &cs, SampleDataD &cssd,
 		SampleDataD &ss, SampleDataD &rs, SampleDataD &rssd,
@@ -836,7 +867,8 @@ public:
 	The sampling interval of the stimulus (stimulus.stepsize())
 	is used as the bin width for discretizing the events.
         The frequency axis of the coherence \a c is set to the appropriate values.
-        \return The error code of the crossSpectra() function. */
+        \return \c 0 on success, \c -1 if \a c is too small.
+	\sa TrialSpectra::coherence() */
   int coherence( const SampleDataD &stimulus, SampleDataD &c,
 		 bool overlap=true, double (*window)( int j, int n )=bartlett ) const;
     /*! Returns in \a c the square-root of the coherence between pairs of event trials
@@ -848,7 +880,8 @@ public:
 	Only events during the \a tbegin and \a tend are considered.
 	The bin width for discretizing the events is set to \a step.
         The frequency axis of the coherence \a c is set to the appropriate values.
-        \return The error code of the crossSpectra() function. */
+        \return \c 0 on success, \c -1 if \a c is too small.
+	\sa TrialSpectra::responseCoherence() */
   int coherence( double tbegin, double tend, double step,
 		 SampleDataD &c,
 		 bool overlap=true, double (*window)( int j, int n )=bartlett ) const;
@@ -30,7 +30,9 @@ using namespace std;
 namespace relacs {
 
 
-static bool FitFlag = true;
+  /*! Set to \c true whenever the fit parameters changed.
+      One flag per thread, since marquardtFits() may run concurrently. */
+static thread_local bool FitFlag = true;
 
   /*! 
     \a funcs is a function object with the signature
@@ -188,6 +190,43 @@ int simplexFit( const ContainerX &x, const ContainerY &y, const ContainerS &s,
 		double chieps=0.01, int maxiter=300 );
 
 
+/*!
+\class FitWorkspace
+\brief Matrices and vectors used by marquardtFit()
+\author Jan Benda
+
+Passing the same FitWorkspace to successive calls of marquardtFit()
+avoids allocating the working memory for each fit.
+This is useful when many data sets are fitted, see marquardtFits().
+*/
+
+class FitWorkspace
+{
+
+public:
+
+    /*! Constructs an empty workspace. */
+  FitWorkspace( void ) : N( 0 ) {};
+    /*! Constructs a workspace for fitting \a n parameters. */
+  FitWorkspace( int n ) : N( 0 ) { resize( n ); };
+    /*! Makes sure the workspace can hold \a n parameters.
+        The memory is only reallocated if \a n differs from size(). */
+  void resize( int n );
+    /*! The number of parameters the workspace was allocated for. */
+  int size( void ) const { return N; };
+
+  int N;
+  vector< ArrayD > Alpha;
+  vector< ArrayD > Covar;
+  ArrayD Beta;
+  ArrayD OneDa;
+  ArrayD Da;
+  ArrayD ATry;
+  ArrayD DyDa;
+
+};
+
+
   /*! Fit the function \a f with parameter \a params
       to the data in array \a firsty through \a lasty at x-position
       \a firstx through \a lastx with corresponding 
@@ -217,6 +256,17 @@ int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
 		   ArrayD &uncert, double &chi,
 		   int *iter=NULL, ostream *os=NULL,
 		   double chieps=0.0005, int maxiter=300 );
+  /*! Same as the function above, but uses the working memory
+      provided by \a ws. */
+template < typename ForwardIterX, typename ForwardIterY,
+  typename ForwardIterS, typename FitFunc >
+int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
+		   ForwardIterY firsty, ForwardIterY lasty,
+		   ForwardIterS firsts, ForwardIterS lasts,
+		   FitFunc &f, ArrayD &params, const ArrayI &paramfit,
+		   ArrayD &uncert, double &chi, FitWorkspace &ws,
+		   int *iter=NULL, ostream *os=NULL,
+		   double chieps=0.0005, int maxiter=300 );
   /*! Fit the function \a f with parameter \a params
       to the data in container \a y at x-position \a x with corresponding 
       measurement errors \a s using the Levenberg-Marquardt method.
@@ -237,6 +287,58 @@ int marquardtFit( const ContainerX &x, const ContainerY &y, const ContainerS &s,
 		  ArrayD &uncert, double &chisq,
 		  int *iter=NULL, ostream *os=NULL,
 		  double chieps=0.0005, int maxiter=300 );
+  /*! Same as the function above, but uses the working memory
+      provided by \a ws. */
+template < typename ContainerX, typename ContainerY, 
+  typename ContainerS, typename FitFunc >
+int marquardtFit( const ContainerX &x, const ContainerY &y, const ContainerS &s,
+		  FitFunc &f, ArrayD &params, const ArrayI &paramfit,
+		  ArrayD &uncert, double &chisq, FitWorkspace &ws,
+		  int *iter=NULL, ostream *os=NULL,
+		  double chieps=0.0005, int maxiter=300 );
+  /*! Fit the function \a f to each of the data sets \a first to
+      \a last (exclusively) given by \a x[i], \a y[i], and \a s[i]
+      using the Levenberg-Marquardt method.
+      \a params[i] contains the initial values of the parameters for
+      the i-th data set and returns the fitted parameter values.
+      All fits use the working memory provided by \a ws.
+      The results are written to the elements \a first to \a last
+      of \a uncert, \a chisq, and \a results, which therefore need
+      to be at least as large as \a x.
+      Different ranges of data sets can be fitted concurrently with different
+      workspaces, as long as \a f can be called concurrently.
+      \param[in] x the x-positions of each data set.
+      \param[in] y the y-values of each data set.
+      \param[in] s the measurement errors of each data set.
+      \param[in] f the fit function, see marquardtFit().
+      \param[in,out] params the parameter values for each data set.
+      \param[in] paramfit which parameters are fitted.
+      \param[out] uncert the uncertainties of the parameters of each data set.
+      \param[out] chisq the chi squared of each data set.
+      \param[out] results the return values of marquardtFit() for each data set.
+      \param[in] first the index of the first data set to be fitted.
+      \param[in] last the index behind the last data set to be fitted.
+      \param[in] ws the working memory used for all fits.
+      \return the number of data sets that were fitted successfully. */
+template < typename ContainerX, typename ContainerY, 
+  typename ContainerS, typename FitFunc >
+int marquardtFits( const vector< ContainerX > &x, const vector< ContainerY > &y,
+		   const vector< ContainerS > &s,
+		   FitFunc &f, vector< ArrayD > &params, const ArrayI &paramfit,
+		   vector< ArrayD > &uncert, ArrayD &chisq, ArrayI &results,
+		   int first, int last, FitWorkspace &ws,
+		   double chieps=0.0005, int maxiter=300 );
+  /*! Fit the function \a f to all the data sets given by \a x[i],
+      \a y[i], and \a s[i] one after the other, see the function above.
+      \a uncert, \a chisq, and \a results are resized to the number of
+      data sets. */
+template < typename ContainerX, typename ContainerY, 
+  typename ContainerS, typename FitFunc >
+int marquardtFits( const vector< ContainerX > &x, const vector< ContainerY > &y,
+		   const vector< ContainerS > &s,
+		   FitFunc &f, vector< ArrayD > &params, const ArrayI &paramfit,
+		   vector< ArrayD > &uncert, ArrayD &chisq, ArrayI &results,
+		   double chieps=0.0005, int maxiter=300 );
 
   /*! Returns \f[ p_0 \exp( x / p_1 ) + p_2 \f] */
 double expFunc( double x, const ArrayD &p );
@@ -266,6 +368,24 @@ double sineFuncDerivs( double x, const ArrayD &p, ArrayD &dfdp );
       2: singular matrix 2 */
 int gaussJordan( vector< ArrayD > &a, int n, ArrayD &b );
 
+  /*! Solves the linear equations \a a x = \a b for the
+      symmetric positive definite \a n x \a n matrix \a a
+      by a Cholesky decomposition.
+      On return, the lower triangle of \a a contains the Cholesky factor
+      and \a b the solution x. If \a b is empty, only the decomposition
+      is computed.
+      Only the lower triangle of \a a is used.
+      This requires about a sixth of the operations of gaussJordan().
+      \return 0: everything o.k.
+      \return 1: \a a is not positive definite */
+int cholesky( vector< ArrayD > &a, int n, ArrayD &b );
+  /*! Replaces the symmetric positive definite \a n x \a n matrix \a a
+      by its inverse using a Cholesky decomposition.
+      Only the lower triangle of \a a is used.
+      \return 0: everything o.k.
+      \return 1: \a a is not positive definite */
+int choleskyInverse( vector< ArrayD > &a, int n );
+
 void covarSort( vector< ArrayD > &covar, const ArrayI &paramfit, int mfit );
 
 
@@ -1120,7 +1240,7 @@ void marquardtCof( ForwardIterX firstx, ForwardIterX lastx,
 		   ForwardIterS firsts, ForwardIterS lasts,
 		   FitFunc &f, ArrayD &params, const ArrayI &paramfit,
 		   int mfit, double &chisq,
-		   vector< ArrayD > &alpha, ArrayD &beta )
+		   vector< ArrayD > &alpha, ArrayD &beta, ArrayD &dyda )
 {
   // initialize:
   for ( int j=0; j<mfit; j++ ) {
@@ -1128,7 +1248,6 @@ void marquardtCof( ForwardIterX firstx, ForwardIterX lastx,
     beta[j] = 0.0;
   }
   chisq = 0.0;
-  ArrayD dyda( params.size() );
 
   FitFlag = true;   // new parameters
   while ( (firstx != lastx) && (firsty != lasty) && (firsts != lasts) ) {
@@ -1166,6 +1285,23 @@ int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
 		   ArrayD &uncert, double &chi,
 		   int *iter, ostream *os,
 		   double chieps, int maxiter )
+{
+  FitWorkspace ws( params.size() );
+  return marquardtFit( firstx, lastx, firsty, lasty, firsts, lasts,
+		       f, params, paramfit, uncert, chi, ws,
+		       iter, os, chieps, maxiter );
+}
+
+
+template < typename ForwardIterX, typename ForwardIterY,
+  typename ForwardIterS, typename FitFunc >
+int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
+		   ForwardIterY firsty, ForwardIterY lasty,
+		   ForwardIterS firsts, ForwardIterS lasts,
+		   FitFunc &f, ArrayD &params, const ArrayI &paramfit,
+		   ArrayD &uncert, double &chi, FitWorkspace &ws,
+		   int *iter, ostream *os,
+		   double chieps, int maxiter )
 {
   const double chigood = 1.0e-8;
   const int maxsearch = 4;
@@ -1199,15 +1335,16 @@ int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
 
   double alambda = lambdastart;
   double chisq = 0.0;
-  vector< ArrayD > alpha( params.size(), ArrayD( params.size(), 0 ) );
-  vector< ArrayD > covar( params.size(), ArrayD( params.size(), 0 ) );
-  ArrayD beta( params.size() );
-  ArrayD oneda( params.size() );
-  ArrayD da( params.size() );
-  ArrayD atry( params );
-  ArrayD emptyb( 0 );
+  ws.resize( params.size() );
+  vector< ArrayD > &alpha = ws.Alpha;
+  vector< ArrayD > &covar = ws.Covar;
+  ArrayD &beta = ws.Beta;
+  ArrayD &oneda = ws.OneDa;
+  ArrayD &da = ws.Da;
+  ArrayD &atry = ws.ATry;
+  atry = params;
   marquardtCof( firstx, lastx, firsty, lasty, firsts, lasts, 
-		f, params, paramfit, mfit, chisq, alpha, beta );
+		f, params, paramfit, mfit, chisq, alpha, beta, ws.DyDa );
   double ochisq = chisq;
 
   // report start values:
@@ -1241,14 +1378,23 @@ int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
       covar[j][j] = alpha[j][j]*(1.0+alambda);
       oneda[j] = beta[j];
     }
-    // solve marix:
-    int gjr = gaussJordan( covar, mfit, oneda );
-    if ( gjr ) {
-      if ( iter != NULL )
-	*iter = iteration;
-      if ( os != NULL )
-	*os << "exit from gaussJordan: " << gjr << "\n\n";
-      return 16*gjr;
+    // solve matrix:
+    if ( cholesky( covar, mfit, oneda ) ) {
+      // not positive definite, fall back to gaussJordan:
+      for ( int j=0; j<mfit; j++ ) {
+	for ( int k=0; k<mfit; k++ )
+	  covar[j][k] = alpha[j][k];
+	covar[j][j] = alpha[j][j]*(1.0+alambda);
+	oneda[j] = beta[j];
+      }
+      int gjr = gaussJordan( covar, mfit, oneda );
+      if ( gjr ) {
+	if ( iter != NULL )
+	  *iter = iteration;
+	if ( os != NULL )
+	  *os << "exit from gaussJordan: " << gjr << "\n\n";
+	return 16*gjr;
+      }
     }
 
     for ( int j=0; j<mfit; j++ )
@@ -1258,7 +1404,7 @@ int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
 	atry[l] = params[l] + da[j++];
     }
     marquardtCof( firstx, lastx, firsty, lasty, firsts, lasts,
-		  f, atry, paramfit, mfit, chisq, covar, da );
+		  f, atry, paramfit, mfit, chisq, covar, da, ws.DyDa );
 
     // report current iteration step:
     if ( os != NULL )	{
@@ -1305,11 +1451,17 @@ int marquardtFit ( ForwardIterX firstx, ForwardIterX lastx,
   // calculate uncertainties:
   for ( int j=0; j<mfit; j++ )
     covar[j] = alpha[j];
-  int gjr = gaussJordan( covar, mfit, emptyb );
-  if ( gjr ) {
-    if ( os != NULL )
-      *os << "exit from final gaussJordan: " << gjr << "\n\n";
-    return 64 * gjr;
+  if ( choleskyInverse( covar, mfit ) ) {
+    // not positive definite, fall back to gaussJordan:
+    for ( int j=0; j<mfit; j++ )
+      covar[j] = alpha[j];
+    ArrayD emptyb( 0 );
+    int gjr = gaussJordan( covar, mfit, emptyb );
+    if ( gjr ) {
+      if ( os != NULL )
+	*os << "exit from final gaussJordan: " << gjr << "\n\n";
+      return 64 * gjr;
+    }
   }
   covarSort( covar, paramfit, mfit );
   for ( int j=0; j<params.size(); j++ )
@@ -1337,6 +1489,67 @@ int marquardtFit( const ContainerX &x, const ContainerY &y, const ContainerS &s,
 }
 
 
+template < typename ContainerX, typename ContainerY, 
+  typename ContainerS, typename FitFunc >
+int marquardtFit( const ContainerX &x, const ContainerY &y, const ContainerS &s,
+		  FitFunc &f, ArrayD &params, const ArrayI &paramfit,
+		  ArrayD &uncert, double &chisq, FitWorkspace &ws,
+		  int *iter, ostream *os,
+		  double chieps, int maxiter )
+{
+  return marquardtFit( x.begin(), x.end(), y.begin(), y.end(), s.begin(), s.end(),
+		       f, params, paramfit, uncert, chisq, ws,
+		       iter, os, chieps, maxiter );
+}
+
+
+template < typename ContainerX, typename ContainerY, 
+  typename ContainerS, typename FitFunc >
+int marquardtFits( const vector< ContainerX > &x, const vector< ContainerY > &y,
+		   const vector< ContainerS > &s,
+		   FitFunc &f, vector< ArrayD > &params, const ArrayI &paramfit,
+		   vector< ArrayD > &uncert, ArrayD &chisq, ArrayI &results,
+		   int first, int last, FitWorkspace &ws,
+		   double chieps, int maxiter )
+{
+  int success = 0;
+  for ( int i=first; i<last; i++ ) {
+    uncert[i].resize( params[i].size() );
+    results[i] = marquardtFit( x[i], y[i], s[i], f, params[i], paramfit,
+			       uncert[i], chisq[i], ws, NULL, NULL,
+			       chieps, maxiter );
+    if ( results[i] == 0 )
+      success++;
+  }
+  return success;
+}
+
+
+template < typename ContainerX, typename ContainerY, 
+  typename ContainerS, typename FitFunc >
+int marquardtFits( const vector< ContainerX > &x, const vector< ContainerY > &y,
+		   const vector< ContainerS > &s,
+		   FitFunc &f, vector< ArrayD > &params, const ArrayI &paramfit,
+		   vector< ArrayD > &uncert, ArrayD &chisq, ArrayI &results,
+		   double chieps, int maxiter )
+{
+  int n = x.size();
+  if ( (int)y.size() < n )
+    n = y.size();
+  if ( (int)s.size() < n )
+    n = s.size();
+  if ( (int)params.size() < n )
+    n = params.size();
+  uncert.resize( n );
+  chisq.resize( n );
+  results.resize( n );
+
+  FitWorkspace ws( paramfit.size() );
+  return marquardtFits( x, y, s, f, params, paramfit, uncert, chisq, results,
+			0, n, ws, chieps, maxiter );
+}
+
+
 }; /* namespace relacs */
 
 #endif /* ! _RELACS_FITALGORITHM_H_ */
@@ -0,0 +1,75 @@
+/*
+  prescan.h
+  Fast block-wise scanning of data for regions without events.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_PRESCAN_H_
+#define _RELACS_PRESCAN_H_ 1
+
+namespace relacs {
+
+
+  /*! The number of data elements that are scanned at once by
+      prescanRising(), prescanFalling(), and prescanCrossing(). */
+static const int PrescanBlock = 32;
+
+  /*! Compute the minimum \a min and the maximum \a max of the
+      \a n data elements \a data. NaNs are ignored.
+      If there are no data elements (or only NaNs),
+      \a min is set to +infinity and \a max to -infinity.
+      Uses SIMD instructions if available. */
+void minMax( const float *data, int n, float &min, float &max );
+
+  /*! Scans the \a n data elements \a data in blocks of PrescanBlock
+      elements for the rising phase of a peak detector with
+      threshold \a threshold. That is, the leading blocks are skipped
+      as long as no data element falls by \a threshold or more below
+      the running maximum that is initialized by \a maxvalue.
+      \a maxvalue is updated accordingly. If the maximum changed,
+      \a maxindex is set to the index of its first occurence.
+      \return the number of skipped data elements, a multiple of PrescanBlock. */
+int prescanRising( const float *data, int n, double threshold,
+		   double &maxvalue, int &maxindex );
+  /*! Scans the \a n data elements \a data in blocks of PrescanBlock
+      elements for the falling phase of a trough detector with
+      threshold \a threshold. That is, the leading blocks are skipped
+      as long as no data element rises by \a threshold or more above
+      the running minimum that is initialized by \a minvalue.
+      \a minvalue is updated accordingly. If the minimum changed,
+      \a minindex is set to the index of its first occurence.
+      \return the number of skipped data elements, a multiple of PrescanBlock. */
+int prescanFalling( const float *data, int n, double threshold,
+		    double &minvalue, int &minindex );
+  /*! Scans the \a n data elements \a data in blocks of PrescanBlock
+      elements for crossings of \a threshold.
+      If \a up is \c true, these are pairs of succeeding data elements
+      with the first one less than or equal to \a threshold
+      and the second one larger than \a threshold.
+      If \a up is \c false, these are pairs with the first one larger
+      than or equal to \a threshold and the second one less than \a threshold.
+      The last element of each block is compared with the first one
+      of the next block.
+      \return the number of leading data elements
+      that do not start a crossing, a multiple of PrescanBlock. */
+int prescanCrossing( const float *data, int n, double threshold, bool up );
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_PRESCAN_H_ */
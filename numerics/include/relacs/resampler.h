@@ -0,0 +1,119 @@
+/*
+  resampler.h
+  Streaming conversion of the sampling rate with a windowed-sinc filter.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_RESAMPLER_H_
+#define _RELACS_RESAMPLER_H_ 1
+
+#include <relacs/array.h>
+
+namespace relacs {
+
+
+/*!
+\class Resampler
+\author Jan Benda
+\version 1.0
+\brief Streaming conversion of the sampling rate with a windowed-sinc filter.
+
+A Resampler converts a stream of data sampled with the input rate
+into a stream with the output rate, both set by init().
+Successive chunks of input data are passed to process(),
+which appends all output data that can be computed so far.
+
+Each output sample is the input data convolved with a sinc function
+at the fractional position of the output sample in the input data.
+The sinc function is windowed with a Blackman window
+of \a halfwidth zero crossings on each side.
+If the output rate is lower than the input rate, the cutoff frequency
+of the sinc function is lowered to 90% of the Nyquist frequency
+of the output rate and the filter widened accordingly.
+The filter is tabulated for \a phases fractional positions
+(a polyphase filter). Filter coefficients for positions between
+two phases are interpolated linearly.
+An output sample is computed as soon as width() input samples
+following its position are available.
+
+The ratio between output and input rate can be fine tuned with setRatio(),
+for example for compensating the drift between two clocks.
+*/
+
+class Resampler
+{
+
+public:
+
+    /*! Constructs an empty Resampler. Call init() before using it. */
+  Resampler( void );
+    /*! Constructs a Resampler for data of sampling rate \a inrate
+        into data of sampling rate \a outrate. \sa init() */
+  Resampler( double inrate, double outrate, int halfwidth=16, int phases=256 );
+
+    /*! Initializes the Resampler for data of sampling rate \a inrate
+        into data of sampling rate \a outrate.
+	The filter extends over \a halfwidth zero crossings on
+	each side and is tabulated for \a phases positions between
+	two input samples. Calls reset(). */
+  void init( double inrate, double outrate, int halfwidth=16, int phases=256 );
+    /*! Discards all buffered input data. The next output sample
+        is at the first input sample passed to process(). */
+  void reset( void );
+
+    /*! The sampling rate of the input data. */
+  double inRate( void ) const { return InRate; };
+    /*! The sampling rate of the output data. */
+  double outRate( void ) const { return OutRate; };
+    /*! The factor by which the sampling rate of the output data
+        is modified. */
+  double ratio( void ) const { return Ratio; };
+    /*! Modifies the sampling rate of the output data by the factor
+        \a ratio. A \a ratio larger than one produces more output
+	samples than expected from outRate(). */
+  void setRatio( double ratio );
+    /*! The number of input samples the filter extends to each side. */
+  int width( void ) const { return Width; };
+    /*! The number of input samples buffered from previous calls
+        of process(). */
+  int buffered( void ) const { return Buffer.size(); };
+
+    /*! Resamples the \a n input data \a in and appends
+        the resulting output data to \a out.
+	\return the number of data elements appended to \a out. */
+  int process( const float *in, int n, ArrayF &out );
+
+
+private:
+
+  double InRate;
+  double OutRate;
+  double Ratio;
+  double Step;
+  int Phases;
+  int Width;
+  ArrayF Filter;
+  ArrayF Buffer;
+  double Pos;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_RESAMPLER_H_ */
@@ -0,0 +1,562 @@
+/*
+  slidingquantile.h
+  Quantiles of streaming data over a sliding window or over all data.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_SLIDINGQUANTILE_H_
+#define _RELACS_SLIDINGQUANTILE_H_ 1
+
+#include <cmath>
+#include <deque>
+#include <set>
+#include <relacs/cyclicarray.h>
+using namespace std;
+
+namespace relacs {
+
+
+/*!
+\class SlidingQuantile
+\brief The quantile of the most recent data elements of a stream.
+\author Jan Benda
+
+The last window() data elements passed to push() are kept
+in two sorted sets, one with the elements below
+and one with the elements above the quantile.
+Adding a data element and removing the oldest one therefore
+takes O(log n) operations only, where n is the size of the window.
+quantile() returns the same value as quantile( double, const Container& )
+from stats.h applied to the sorted data of the window, i.e.
+it interpolates linearly between the two enclosing data elements.
+*/
+
+template < typename T = double >
+class SlidingQuantile
+{
+
+public:
+
+    /*! Constructs a SlidingQuantile for the quantile \a f
+        of the last \a window data elements. */
+  SlidingQuantile( int window=1000, double f=0.5 );
+
+    /*! The quantile that is computed, a number between 0 and 1. */
+  double fraction( void ) const { return F; };
+    /*! Set the quantile to be computed to \a f. */
+  void setFraction( double f );
+    /*! The maximum number of data elements the quantile is computed from. */
+  int window( void ) const { return Window; };
+    /*! Set the maximum number of data elements to \a window.
+        Removes the oldest data elements if necessary. */
+  void setWindow( int window );
+
+    /*! The number of data elements the quantile is currently computed from. */
+  int size( void ) const { return Data.size(); };
+    /*! \c true if no data elements have been added. */
+  bool empty( void ) const { return Data.empty(); };
+    /*! Removes all data elements. */
+  void clear( void );
+
+    /*! Adds \a x and removes the oldest data element
+        if more than window() elements are stored. */
+  void push( const T &x );
+    /*! Adds the data elements of the range \a first, \a last. */
+  template < typename ForwardIter >
+  void push( ForwardIter first, ForwardIter last );
+    /*! Adds the data elements of \a a from index \a from
+        up to but not including index \a to.
+	\a a can be any CyclicArray, in particular an InData. */
+  void push( const CyclicArray<T> &a, int from, int to );
+
+    /*! The quantile fraction() of the data elements in the window.
+        \c 0 if no data have been added. */
+  T quantile( void ) const;
+
+
+private:
+
+    /*! The number of data elements that belong into Low. */
+  int lowSize( void ) const;
+  void balance( void );
+
+  double F;
+  int Window;
+  deque< T > Data;
+  multiset< T > Low;
+  multiset< T > High;
+
+};
+
+
+/*!
+\class SlidingMAD
+\brief A running estimate of the median and the median absolute deviation
+       of the most recent data elements of a stream.
+\author Jan Benda
+
+Each data element is added to a SlidingQuantile for the median.
+Its absolute deviation from the current median is added to another
+SlidingQuantile that yields the median absolute deviation (MAD).
+For stationary data this equals the MAD of the window,
+if the median changes, the deviations of the older elements
+refer to the median at the time they were added.
+For Gaussian noise, 1.4826 times the MAD is an estimate of the
+standard deviation that is insensitive to outliers like spikes.
+*/
+
+template < typename T = double >
+class SlidingMAD
+{
+
+public:
+
+    /*! Constructs a SlidingMAD for the last \a window data elements. */
+  SlidingMAD( int window=1000 );
+
+    /*! The maximum number of data elements used. */
+  int window( void ) const { return Median.window(); };
+    /*! Set the maximum number of data elements to \a window. */
+  void setWindow( int window );
+    /*! The number of data elements currently used. */
+  int size( void ) const { return Median.size(); };
+    /*! Removes all data elements. */
+  void clear( void );
+
+    /*! Adds \a x. */
+  void push( const T &x );
+    /*! Adds the data elements of the range \a first, \a last. */
+  template < typename ForwardIter >
+  void push( ForwardIter first, ForwardIter last );
+    /*! Adds the data elements of \a a from index \a from
+        up to but not including index \a to. */
+  void push( const CyclicArray<T> &a, int from, int to );
+
+    /*! The median of the data elements. */
+  T median( void ) const { return Median.quantile(); };
+    /*! The median absolute deviation of the data elements from the median. */
+  T mad( void ) const { return Deviation.quantile(); };
+    /*! The standard deviation of Gaussian noise estimated from the mad(). */
+  T stdev( void ) const { return 1.4826*mad(); };
+
+
+private:
+
+  SlidingQuantile<T> Median;
+  SlidingQuantile<T> Deviation;
+
+};
+
+
+/*!
+\class P2Quantile
+\brief An estimate of a quantile of all data of a stream
+       with constant memory and time.
+\author Jan Benda
+
+The P-square algorithm (Jain & Chlamtac, 1985, Commun ACM 28: 1076-1085)
+keeps track of five markers: the minimum, the maximum, the quantile,
+and two quantiles halfway in between. With each data element
+the positions of the markers are adjusted by a piecewise-parabolic
+interpolation. This is much faster than a SlidingQuantile, but the
+quantile is estimated from all data added since the last clear().
+*/
+
+template < typename T = double >
+class P2Quantile
+{
+
+public:
+
+    /*! Constructs a P2Quantile for the quantile \a f. */
+  P2Quantile( double f=0.5 );
+
+    /*! The quantile that is estimated, a number between 0 and 1. */
+  double fraction( void ) const { return F; };
+    /*! Set the quantile to be estimated to \a f and call clear(). */
+  void setFraction( double f );
+
+    /*! The number of data elements added so far. */
+  long size( void ) const { return N; };
+    /*! Removes all data elements. */
+  void clear( void );
+
+    /*! Adds \a x. */
+  void push( const T &x );
+    /*! Adds the data elements of the range \a first, \a last. */
+  template < typename ForwardIter >
+  void push( ForwardIter first, ForwardIter last );
+    /*! Adds the data elements of \a a from index \a from
+        up to but not including index \a to. */
+  void push( const CyclicArray<T> &a, int from, int to );
+
+    /*! The estimate of the quantile fraction(). For less than five
+        data elements the exact quantile. \c 0 if no data have been added. */
+  T quantile( void ) const;
+
+
+private:
+
+  double F;
+  long N;
+    /*! Heights of the markers. */
+  double Q[5];
+    /*! Positions of the markers. */
+  double Pos[5];
+    /*! Desired positions of the markers. */
+  double Desired[5];
+    /*! Increments of the desired positions. */
+  double Incr[5];
+
+};
+
+
+template < typename T >
+SlidingQuantile<T>::SlidingQuantile( int window, double f )
+  : F( f ),
+    Window( window > 1 ? window : 1 )
+{
+}
+
+
+template < typename T >
+void SlidingQuantile<T>::setFraction( double f )
+{
+  F = f;
+  balance();
+}
+
+
+template < typename T >
+void SlidingQuantile<T>::setWindow( int window )
+{
+  Window = window > 1 ? window : 1;
+  while ( (int)Data.size() > Window ) {
+    T x = Data.front();
+    Data.pop_front();
+    if ( ! Low.empty() && x <= *Low.rbegin() )
+      Low.erase( Low.find( x ) );
+    else
+      High.erase( High.find( x ) );
+  }
+  balance();
+}
+
+
+template < typename T >
+void SlidingQuantile<T>::clear( void )
+{
+  Data.clear();
+  Low.clear();
+  High.clear();
+}
+
+
+template < typename T >
+void SlidingQuantile<T>::push( const T &x )
+{
+  // remove oldest element:
+  if ( (int)Data.size() >= Window ) {
+    T y = Data.front();
+    Data.pop_front();
+    if ( ! Low.empty() && y <= *Low.rbegin() )
+      Low.erase( Low.find( y ) );
+    else
+      High.erase( High.find( y ) );
+  }
+
+  // add new element:
+  Data.push_back( x );
+  if ( ! Low.empty() && x <= *Low.rbegin() )
+    Low.insert( x );
+  else
+    High.insert( x );
+
+  balance();
+}
+
+
+template < typename T > template < typename ForwardIter >
+void SlidingQuantile<T>::push( ForwardIter first, ForwardIter last )
+{
+  while ( first != last ) {
+    push( *first );
+    ++first;
+  }
+}
+
+
+template < typename T >
+void SlidingQuantile<T>::push( const CyclicArray<T> &a, int from, int to )
+{
+  if ( from < a.minIndex() )
+    from = a.minIndex();
+  while ( from < to ) {
+    const T *d = 0;
+    int n = a.span( from, to-from, d );
+    if ( n <= 0 )
+      break;
+    push( d, d+n );
+    from += n;
+  }
+}
+
+
+template < typename T >
+T SlidingQuantile<T>::quantile( void ) const
+{
+  if ( Low.empty() )
+    return 0;
+  int n = Data.size();
+  double index = F * ( n - 1 );
+  double delta = index - ::floor( index );
+  T q1 = *Low.rbegin();
+  if ( High.empty() || delta <= 0.0 )
+    return q1;
+  T q2 = *High.begin();
+  return (1.0 - delta) * q1 + delta * q2;
+}
+
+
+template < typename T >
+int SlidingQuantile<T>::lowSize( void ) const
+{
+  int n = Data.size();
+  if ( n == 0 )
+    return 0;
+  double f = F < 0.0 ? 0.0 : ( F > 1.0 ? 1.0 : F );
+  return (int)::floor( f * ( n - 1 ) ) + 1;
+}
+
+
+template < typename T >
+void SlidingQuantile<T>::balance( void )
+{
+  int nl = lowSize();
+  while ( (int)Low.size() > nl ) {
+    typename multiset< T >::iterator iter = Low.end();
+    --iter;
+    High.insert( *iter );
+    Low.erase( iter );
+  }
+  while ( (int)Low.size() < nl && ! High.empty() ) {
+    typename multiset< T >::iterator iter = High.begin();
+    Low.insert( *iter );
+    High.erase( iter );
+  }
+}
+
+
+template < typename T >
+SlidingMAD<T>::SlidingMAD( int window )
+  : Median( window, 0.5 ),
+    Deviation( window, 0.5 )
+{
+}
+
+
+template < typename T >
+void SlidingMAD<T>::setWindow( int window )
+{
+  Median.setWindow( window );
+  Deviation.setWindow( window );
+}
+
+
+template < typename T >
+void SlidingMAD<T>::clear( void )
+{
+  Median.clear();
+  Deviation.clear();
+}
+
+
+template < typename T >
+void SlidingMAD<T>::push( const T &x )
+{
+  Median.push( x );
+  T d = x - Median.quantile();
+  Deviation.push( d < 0 ? -d : d );
+}
+
+
+template < typename T > template < typename ForwardIter >
+void SlidingMAD<T>::push( ForwardIter first, ForwardIter last )
+{
+  while ( first != last ) {
+    push( *first );
+    ++first;
+  }
+}
+
+
+template < typename T >
+void SlidingMAD<T>::push( const CyclicArray<T> &a, int from, int to )
+{
+  if ( from < a.minIndex() )
+    from = a.minIndex();
+  while ( from < to ) {
+    const T *d = 0;
+    int n = a.span( from, to-from, d );
+    if ( n <= 0 )
+      break;
+    push( d, d+n );
+    from += n;
+  }
+}
+
+
+template < typename T >
+P2Quantile<T>::P2Quantile( double f )
+{
+  setFraction( f );
+}
+
+
+template < typename T >
+void P2Quantile<T>::setFraction( double f )
+{
+  F = f < 0.0 ? 0.0 : ( f > 1.0 ? 1.0 : f );
+  clear();
+}
+
+
+template < typename T >
+void P2Quantile<T>::clear( void )
+{
+  N = 0;
+  for ( int k=0; k<5; k++ ) {
+    Q[k] = 0.0;
+    Pos[k] = k + 1;
+  }
+  Desired[0] = 1.0;
+  Desired[1] = 1.0 + 2.0*F;
+  Desired[2] = 1.0 + 4.0*F;
+  Desired[3] = 3.0 + 2.0*F;
+  Desired[4] = 5.0;
+  Incr[0] = 0.0;
+  Incr[1] = 0.5*F;
+  Incr[2] = F;
+  Incr[3] = 0.5*(1.0 + F);
+  Incr[4] = 1.0;
+}
+
+
+template < typename T >
+void P2Quantile<T>::push( const T &x )
+{
+  // initialization with the first five data elements:
+  if ( N < 5 ) {
+    int k = N;
+    for ( ; k > 0 && Q[k-1] > x; k-- )
+      Q[k] = Q[k-1];
+    Q[k] = x;
+    N++;
+    return;
+  }
+  N++;
+
+  // find cell of x and adjust extreme markers:
+  int k = 0;
+  if ( x < Q[0] ) {
+    Q[0] = x;
+    k = 0;
+  }
+  else if ( x >= Q[4] ) {
+    Q[4] = x;
+    k = 3;
+  }
+  else {
+    for ( k=0; k<3 && x >= Q[k+1]; k++ );
+  }
+
+  // increment positions:
+  for ( int i=k+1; i<5; i++ )
+    Pos[i] += 1.0;
+  for ( int i=0; i<5; i++ )
+    Desired[i] += Incr[i];
+
+  // adjust heights of the inner markers:
+  for ( int i=1; i<4; i++ ) {
+    double d = Desired[i] - Pos[i];
+    if ( ( d >= 1.0 && Pos[i+1] - Pos[i] > 1.0 ) ||
+	 ( d <= -1.0 && Pos[i-1] - Pos[i] < -1.0 ) ) {
+      int s = d >= 0.0 ? 1 : -1;
+      // piecewise-parabolic prediction:
+      double qp = Q[i] + s / ( Pos[i+1] - Pos[i-1] ) *
+	( ( Pos[i] - Pos[i-1] + s ) * ( Q[i+1] - Q[i] ) / ( Pos[i+1] - Pos[i] ) +
+	  ( Pos[i+1] - Pos[i] - s ) * ( Q[i] - Q[i-1] ) / ( Pos[i] - Pos[i-1] ) );
+      if ( Q[i-1] < qp && qp < Q[i+1] )
+	Q[i] = qp;
+      else {
+	// linear prediction:
+	Q[i] += s * ( Q[i+s] - Q[i] ) / ( Pos[i+s] - Pos[i] );
+      }
+      Pos[i] += s;
+    }
+  }
+}
+
+
+template < typename T > template < typename ForwardIter >
+void P2Quantile<T>::push( ForwardIter first, ForwardIter last )
+{
+  while ( first != last ) {
+    push( *first );
+    ++first;
+  }
+}
+
+
+template < typename T >
+void P2Quantile<T>::push( const CyclicArray<T> &a, int from, int to )
+{
+  if ( from < a.minIndex() )
+    from = a.minIndex();
+  while ( from < to ) {
+    const T *d = 0;
+    int n = a.span( from, to-from, d );
+    if ( n <= 0 )
+      break;
+    push( d, d+n );
+    from += n;
+  }
+}
+
+
+template < typename T >
+T P2Quantile<T>::quantile( void ) const
+{
+  if ( N == 0 )
+    return 0;
+  if ( N <= 5 ) {
+    // exact quantile of the sorted first data elements:
+    double index = F * ( N - 1 );
+    int lindex = (int)::floor( index );
+    if ( lindex >= N-1 )
+      return Q[N-1];
+    double delta = index - lindex;
+    return (1.0 - delta) * Q[lindex] + delta * Q[lindex+1];
+  }
+  return Q[2];
+}
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_SLIDINGQUANTILE_H_ */
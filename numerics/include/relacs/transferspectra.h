@@ -0,0 +1,161 @@
+/*
+  transferspectra.h
+  Transfer function and coherence estimated from running sums of spectra.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_TRANSFERSPECTRA_H_
+#define _RELACS_TRANSFERSPECTRA_H_ 1
+
+#include <relacs/array.h>
+#include <relacs/sampledata.h>
+#include <relacs/spectrum.h>
+
+namespace relacs {
+
+
+/*!
+\class TransferSpectra
+\author Jan Benda
+\version 1.0
+\brief Transfer function and coherence estimated from running sums of spectra.
+
+Pairs of input and output segments, for example the stimulus and
+the response of a single repetition, are passed to add().
+Each segment is divided into chunks as in transfer(),
+which may overlap by half and are windowed by the window function.
+The power spectra \f$ X X^* \f$ and \f$ Y Y^* \f$ of the input and output
+and the cross spectrum \f$ X^* Y \f$ of each chunk are added to running sums.
+Adding a segment therefore only costs the fourier transforms
+of its chunks, independent of how many segments have been added before.
+
+Gain, phase, and coherence are computed on demand from
+the spectra summed over all chunks of all segments.
+In addition, their standard deviations over the segments are provided,
+which are computed from the spectra of each single segment.
+
+Means are not subtracted from the data.
+*/
+
+class TransferSpectra
+{
+
+public:
+
+    /*! Constructs an empty TransferSpectra. Call init() before adding segments. */
+  TransferSpectra( void );
+    /*! Constructs a TransferSpectra with spectra of size \a np
+        for data sampled with \a stepsize. \sa init() */
+  TransferSpectra( int np, double stepsize,
+		   bool overlap=true, double (*window)( int j, int n )=bartlett );
+
+    /*! Initializes spectra of size \a np for data sampled with \a stepsize.
+        \a np is rounded up to the next power of two.
+        The data are divided into chunks of twice this size,
+	that are windowed by the \a window function and
+	may overlap by half if \a overlap is set to \c true.
+	Removes all segments.
+	\return \c 0 on success, \c -1 if \a np is too small. */
+  int init( int np, double stepsize,
+	    bool overlap=true, double (*window)( int j, int n )=bartlett );
+    /*! Removes all segments but keeps the settings. */
+  void clear( void );
+
+    /*! The number of segments added so far. */
+  int segments( void ) const { return Segments; };
+    /*! The number of data chunks of all segments added so far. */
+  int chunks( void ) const { return Chunks; };
+    /*! The size of the spectra. */
+  int size( void ) const { return NP; };
+    /*! The frequency resolution of the spectra. */
+  double deltaF( void ) const { return DeltaF; };
+
+    /*! Adds the segment of input data \a x and output data \a y.
+        \return the number of chunks used or a negative number
+	indicating an error (\c -1: not initialized,
+	\c -2: \a x and \a y differ in size). */
+  int add( const ArrayD &x, const ArrayD &y );
+
+    /*! The power spectrum of the input in \a xp,
+        normalized like the one of rPSD(). */
+  void inputSpectrum( SampleDataD &xp ) const;
+    /*! The power spectrum of the output in \a yp,
+        normalized like the one of rPSD(). */
+  void outputSpectrum( SampleDataD &yp ) const;
+    /*! The transfer function from input to output in \a h
+        as a half-complex sequence of size 2*size(), as returned by transfer(). */
+  void transfer( SampleDataD &h ) const;
+    /*! The gain of the transfer function in \a g
+        and its standard deviation over segments in \a sd, if not null. */
+  void gain( SampleDataD &g, SampleDataD *sd=0 ) const;
+    /*! The phase of the transfer function in \a p
+        and its circular standard deviation over segments in \a sd, if not null. */
+  void phase( SampleDataD &p, SampleDataD *sd=0 ) const;
+    /*! The coherence between input and output in \a c
+        and its standard deviation over segments in \a sd, if not null. */
+  void coherence( SampleDataD &c, SampleDataD *sd=0 ) const;
+    /*! The lower bound of transmitted information computed from the coherence
+        between frequencies \a f0 and \a f1. If \a f1 is negative,
+	up to the highest frequency. \sa coherenceInfo() */
+  double coherenceInfo( double f0=0.0, double f1=-1.0 ) const;
+
+
+private:
+
+  void spectra( const ArrayD &xx, const ArrayD &yy, const ArrayD &re,
+		const ArrayD &im, int k, double &g, double &p, double &c ) const;
+  void axis( SampleDataD &s ) const;
+  void sd( const ArrayD &mean, const ArrayD &sq, SampleDataD &s ) const;
+
+  int NP;
+  int NW;
+  bool Overlap;
+  double DeltaF;
+  ArrayD Window;
+  double WWN;
+
+  int Segments;
+  int Chunks;
+    /*! Spectra summed over all chunks. */
+  ArrayD XX;
+  ArrayD YY;
+  ArrayD Re;
+  ArrayD Im;
+
+    /*! Moments of gain, phase, and coherence over segments. */
+  ArrayD GMean;
+  ArrayD GSq;
+  ArrayD PCos;
+  ArrayD PSin;
+  ArrayD CMean;
+  ArrayD CSq;
+
+    /*! Workspace for a single segment. */
+  ArrayD BufferX;
+  ArrayD BufferY;
+  ArrayD SXX;
+  ArrayD SYY;
+  ArrayD SRe;
+  ArrayD SIm;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_TRANSFERSPECTRA_H_ */
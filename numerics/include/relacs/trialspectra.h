@@ -0,0 +1,195 @@
+/*
+  trialspectra.h
+  Trial-averaged spectra of event trials that are updated trial by trial.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_TRIALSPECTRA_H_
+#define _RELACS_TRIALSPECTRA_H_ 1
+
+#include <relacs/array.h>
+#include <relacs/sampledata.h>
+#include <relacs/spectrum.h>
+
+namespace relacs {
+
+
+class EventData;
+class EventList;
+
+
+/*!
+\class TrialSpectra
+\author Jan Benda
+\version 1.0
+\brief Trial-averaged spectra of event trials that are updated trial by trial.
+
+TrialSpectra computes the same spectral measures as
+EventList::spectrum(), EventList::spectra(), and EventList::coherence(),
+but each trial is processed only once when it is passed to add().
+All averages are updated in place, so adding trial N+1 costs
+the work of one trial instead of recomputing all N+1 trials.
+
+Initialize with the \a stimulus that evoked the responses to get
+stimulus-response measures (gain(), coherence(), ...),
+or with a time range only for response measures (powerSpectrum(),
+responseCoherence()).
+Each trial is converted into a firing rate with a bin width of the
+stepsize of the stimulus or the time range, the mean rate is subtracted,
+and the data are cut into chunks of twice the size of the spectra,
+which may overlap by half and are windowed by the window function.
+The windowed stimulus chunks are fourier transformed only once in init().
+
+The response-response coherence is averaged over all pairs of trials.
+Since the cross spectrum is linear in each of the trials, the sum over
+all pairs with the new trial is the product of the sum of the
+fourier transforms of all previous trials with the one of the new trial.
+*/
+
+class TrialSpectra
+{
+
+public:
+
+    /*! Constructs an empty TrialSpectra. Call init() before adding trials. */
+  TrialSpectra( void );
+    /*! Constructs a TrialSpectra for responses to \a stimulus
+        with spectra of size \a np. \sa init() */
+  TrialSpectra( const SampleDataD &stimulus, int np,
+		bool overlap=true, double (*window)( int j, int n )=bartlett );
+    /*! Constructs a TrialSpectra for responses between \a tbegin and \a tend
+        with spectra of size \a np. \sa init() */
+  TrialSpectra( double tbegin, double tend, double step, int np,
+		bool overlap=true, double (*window)( int j, int n )=bartlett );
+
+    /*! Initializes spectra of size \a np for responses to \a stimulus.
+        Only events between stimulus.rangeFront() and stimulus.rangeBack()
+	are considered. The sampling interval of the stimulus is used as
+	the bin width for discretizing the events.
+        The data chunks are windowed by the \a window function and
+	may overlap by half if \a overlap is set to \c true.
+	Removes all trials.
+	\return \c 0 on success, \c -1 if \a np is too small. */
+  int init( const SampleDataD &stimulus, int np,
+	    bool overlap=true, double (*window)( int j, int n )=bartlett );
+    /*! Initializes spectra of size \a np for responses between \a tbegin
+        and \a tend discretized with bin width \a step.
+	No stimulus-response measures are computed.
+        The data chunks are windowed by the \a window function and
+	may overlap by half if \a overlap is set to \c true.
+	Removes all trials.
+	\return \c 0 on success, \c -1 if \a np is too small. */
+  int init( double tbegin, double tend, double step, int np,
+	    bool overlap=true, double (*window)( int j, int n )=bartlett );
+    /*! Removes all trials but keeps the settings and the stimulus. */
+  void clear( void );
+
+    /*! The number of trials added so far. */
+  int trials( void ) const { return Trials; };
+    /*! The number of data chunks each trial is divided into. */
+  int chunks( void ) const { return Starts.size(); };
+    /*! The size of the spectra. */
+  int size( void ) const { return NP; };
+    /*! The frequency resolution of the spectra. */
+  double deltaF( void ) const { return DeltaF; };
+    /*! \c true if initialized with a stimulus. */
+  bool stimulus( void ) const { return ! XFFT.empty(); };
+
+    /*! Adds the single trial \a events to the averages. */
+  void add( const EventData &events );
+    /*! Adds all trials of \a events to the averages. */
+  void add( const EventList &events );
+
+    /*! The trial averaged power spectrum of the responses in \a psd. */
+  void powerSpectrum( SampleDataD &psd ) const;
+    /*! The trial averaged power spectrum of the responses in \a psd
+        and its standard deviation in \a sd. */
+  void powerSpectrum( SampleDataD &psd, SampleDataD &sd ) const;
+    /*! The power spectrum of the stimulus in \a ss. */
+  void stimulusSpectrum( SampleDataD &ss ) const;
+    /*! The trial averaged gain between stimulus and responses in \a g
+        and its standard deviation in \a sd, if not null. */
+  void gain( SampleDataD &g, SampleDataD *sd=0 ) const;
+    /*! The trial averaged magnitude squared of the cross spectrum
+        between stimulus and responses in \a cp
+	and its standard deviation in \a sd, if not null. */
+  void crossPower( SampleDataD &cp, SampleDataD *sd=0 ) const;
+    /*! The stimulus-response coherence of each trial averaged over trials
+        in \a c and its standard deviation in \a sd, if not null. */
+  void trialCoherence( SampleDataD &c, SampleDataD *sd=0 ) const;
+    /*! The stimulus-response coherence \f$\gamma^2_{SR}\f$ computed
+        from the trial averaged cross and power spectra in \a c.
+	The size of \a c is not changed and may be smaller than size(). */
+  void coherence( SampleDataD &c ) const;
+    /*! The square root of the response-response coherence
+        \f$\gamma_{RR}\f$ averaged over all pairs of trials in \a c.
+	The size of \a c is not changed and may be smaller than size(). */
+  void responseCoherence( SampleDataD &c ) const;
+
+
+private:
+
+  int initRange( const LinearRange &range, int np,
+		 bool overlap, double (*window)( int j, int n ) );
+  void initChunks( int n );
+  void update( ArrayD &mean, ArrayD &sq, int k, double x );
+  void copy( const ArrayD &a, SampleDataD &s ) const;
+  void sd( const ArrayD &mean, const ArrayD &sq, SampleDataD &s ) const;
+
+  int NP;
+  int NW;
+  bool Overlap;
+  double DeltaF;
+  LinearRange Range;
+  ArrayD Window;
+  ArrayI Starts;
+  ArrayI Lengths;
+  ArrayD NormFacs;
+
+    /*! The fourier transforms of the stimulus chunks. */
+  ArrayD XFFT;
+    /*! The power spectrum of the stimulus. */
+  ArrayD XP;
+    /*! The sum of the fourier transforms of the response chunks. */
+  ArrayD YFFTSum;
+
+  int Trials;
+  ArrayD YP;
+  ArrayD YPSq;
+  ArrayD CP;
+  ArrayD G;
+  ArrayD GSq;
+  ArrayD C;
+  ArrayD CSq;
+  ArrayD CPow;
+  ArrayD CPowSq;
+  int Pairs;
+  ArrayD RR;
+
+    /*! Workspace for a single trial. */
+  SampleDataD Rate;
+  ArrayD Buffer;
+  ArrayD TYP;
+  ArrayD TCP;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_TRIALSPECTRA_H_ */
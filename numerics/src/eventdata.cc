@@ -1847,6 +1847,66 @@ void EventData::pop( void )
 }
 
 
+int EventData::spans( const double *buffer, int first, int last,
+		      const double *&data1, int &n1,
+		      const double *&data2, int &n2 ) const
+{
+  data1 = buffer;
+  data2 = buffer;
+  n1 = 0;
+  n2 = 0;
+  if ( first < minEvent() )
+    first = minEvent();
+  if ( last > size() )
+    last = size();
+  if ( buffer == 0 || last <= first )
+    return 0;
+
+  int f = first - Index;
+  int l = last - Index;
+  if ( f >= 0 ) {
+    data1 = buffer + f;
+    n1 = l - f;
+  }
+  else if ( l <= 0 ) {
+    data1 = buffer + f + NBuffer;
+    n1 = l - f;
+  }
+  else {
+    // wrapped around the end of the cyclic buffer:
+    data1 = buffer + f + NBuffer;
+    n1 = -f;
+    data2 = buffer;
+    n2 = l;
+  }
+  return n1 + n2;
+}
+
+
+int EventData::timeSpans( int first, int last,
+			  const double *&times1, int &n1,
+			  const double *&times2, int &n2 ) const
+{
+  return spans( TimeBuffer, first, last, times1, n1, times2, n2 );
+}
+
+
+int EventData::sizeSpans( int first, int last,
+			  const double *&sizes1, int &n1,
+			  const double *&sizes2, int &n2 ) const
+{
+  return spans( SizeBuffer, first, last, sizes1, n1, sizes2, n2 );
+}
+
+
+int EventData::widthSpans( int first, int last,
+			   const double *&widths1, int &n1,
+			   const double *&widths2, int &n2 ) const
+{
+  return spans( WidthBuffer, first, last, widths1, n1, widths2, n2 );
+}
+
+
 void EventData::sum( const EventData &e, EventData &all ) const
 {
   // init all:
@@ -2283,8 +2343,11 @@ void EventData::sizeHist( double tbegin, double tend, SampleDataD &hist ) const
   double l = hist.rangeFront();
   double s = hist.stepsize();
 
-  for ( int k=n; k <= p; k++ ) {
-    int b = (int)rint( ( eventSize( k ) - l ) / s );
+  const double *v1, *v2;
+  int n1, n2;
+  sizeSpans( n, p+1, v1, n1, v2, n2 );
+  for ( int k=0; k<n1+n2; k++ ) {
+    int b = (int)rint( ( ( k < n1 ? v1[k] : v2[k-n1] ) - l ) / s );
     if ( b >= 0 && b < hist.size() )
       hist[b] += 1.0;
   }
@@ -2432,9 +2495,12 @@ void EventData::widthHist( double tbegin, double tend, SampleDataD &hist ) const
   double l = hist.rangeFront();
   double s = hist.stepsize();
 
-  for ( int k=n; k <= p; k++ ) {
-    int b = (int)rint( ( eventWidth( k ) - l ) / s );
-    if ( b >= 0  && b < hist.size() )
+  const double *v1, *v2;
+  int n1, n2;
+  widthSpans( n, p+1, v1, n1, v2, n2 );
+  for ( int k=0; k<n1+n2; k++ ) {
+    int b = (int)rint( ( ( k < n1 ? v1[k] : v2[k-n1] ) - l ) / s );
+    if ( b >= 0 && b < hist.size() )
       hist[b] += 1.0;
   }
 }
@@ -3053,10 +3119,18 @@ int EventData::addIntervals( double tbegin, double tend, ArrayD &intervals ) con
   if ( p <= n || p < 0 || tend <= tbegin )
     return 0;
 
-  intervals.reserve( intervals.size() + p-n );
-
-  for ( int k=n+1; k<=p; k++ )
-    intervals.push( (*this)[k]-(*this)[k-1] );
+  const double *t1, *t2;
+  int n1, n2;
+  timeSpans( n, p+1, t1, n1, t2, n2 );
+  int m = intervals.size();
+  intervals.resize( m + p-n );
+  double *iv = intervals.data() + m;
+  double tp = t1[0];
+  for ( int k=1; k<n1+n2; k++ ) {
+    double t = k < n1 ? t1[k] : t2[k-n1];
+    *iv++ = t - tp;
+    tp = t;
+  }
 
   return p-n;
 }
@@ -3081,17 +3155,15 @@ int EventData::addIntervals( double tbegin, double tend,
 
   intrvls.reserve( intrvls.size() + p-n );
 
-  if ( pos < 0 ) {
-    for ( int k=n+1; k<=p; k++ )
-      intrvls.push( (*this)[k-1], (*this)[k]-(*this)[k-1] );
-  }
-  else if ( pos > 0 ) {
-    for ( int k=n+1; k<=p; k++ )
-      intrvls.push( (*this)[k], (*this)[k]-(*this)[k-1] );
-  }
-  else {
-    for ( int k=n+1; k<=p; k++ )
-      intrvls.push( 0.5*((*this)[k-1]+(*this)[k]), (*this)[k]-(*this)[k-1] );
+  const double *t1, *t2;
+  int n1, n2;
+  timeSpans( n, p+1, t1, n1, t2, n2 );
+  double tp = t1[0];
+  for ( int k=1; k<n1+n2; k++ ) {
+    double t = k < n1 ? t1[k] : t2[k-n1];
+    double x = pos < 0 ? tp : ( pos > 0 ? t : 0.5*(tp+t) );
+    intrvls.push( x, t-tp );
+    tp = t;
   }
 
   return p-n;
@@ -3334,17 +3406,15 @@ int EventData::addFrequencies( double tbegin, double tend,
 
   freqs.reserve( freqs.size() + p-n );
 
-  if ( pos < 0 ) {
-    for ( int k=n+1; k<=p; k++ )
-      freqs.push( (*this)[k-1], 1.0/((*this)[k]-(*this)[k-1]) );
-  }
-  else if ( pos > 0 ) {
-    for ( int k=n+1; k<=p; k++ )
-      freqs.push( (*this)[k], 1.0/((*this)[k]-(*this)[k-1]) );
-  }
-  else {
-    for ( int k=n+1; k<=p; k++ )
-      freqs.push( 0.5*((*this)[k-1]+(*this)[k]), 1.0/((*this)[k]-(*this)[k-1]) );
+  const double *t1, *t2;
+  int n1, n2;
+  timeSpans( n, p+1, t1, n1, t2, n2 );
+  double tp = t1[0];
+  for ( int k=1; k<n1+n2; k++ ) {
+    double t = k < n1 ? t1[k] : t2[k-n1];
+    double x = pos < 0 ? tp : ( pos > 0 ? t : 0.5*(tp+t) );
+    freqs.push( x, 1.0/(t-tp) );
+    tp = t;
   }
 
   return p-n;
@@ -3420,10 +3490,16 @@ void EventData::addIntervalHistogram( double tbegin, double tend,
   if ( p <= n || p < 0 || tend <= tbegin )
     return;
   
-  for ( int k=n+1; k<=p; k++ ) {
-    int inx = hist.index( (*this)[k] - (*this)[k-1] );
+  const double *t1, *t2;
+  int n1, n2;
+  timeSpans( n, p+1, t1, n1, t2, n2 );
+  double tp = t1[0];
+  for ( int k=1; k<n1+n2; k++ ) {
+    double t = k < n1 ? t1[k] : t2[k-n1];
+    int inx = hist.index( t - tp );
     if ( inx >= 0 && inx < hist.size() )
       hist[inx]++;
+    tp = t;
   }
 }
 
@@ -3440,9 +3516,7 @@ void EventData::serialCorr( double tbegin, double tend, ArrayD &sc ) const
   }
 
   ArrayD iv;
-  iv.reserve( p-n );
-  for ( int k=n+1; k<=p; k++ )
-    iv.push( (*this)[k] - (*this)[k-1] );
+  addIntervals( tbegin, tend, iv );
 
   ::relacs::serialCorr( iv, sc );
 }
@@ -28,6 +28,7 @@
 #include <relacs/sampledata.h>
 #include <relacs/stats.h>
 #include <relacs/kernel.h>
+#include <relacs/trialspectra.h>
 #include <relacs/eventlist.h>
 
 using namespace std;
@@ -1494,30 +1495,101 @@ double EventList::vectorPhase( double tbegin, double tend,
 }
 
 
-double EventList::correlation( double tbegin, double tend, 
-			       const Kernel &kernel, double dt,
-			       double &sd ) const
-{
-  // convolve events with kernel:
-  vector< SampleDataD > s( size(), SampleDataD( tbegin, tend, dt, 0 ) );
-  int k=0;
-  for ( const_iterator i = begin(); i != end(); ++i, ++k ) {
-    (*i)->rate( s[k], kernel );
+  // Convolves each EventData of \a el with \a kernel and stores
+  // the resulting rates as the rows of the contiguous matrix \a x.
+  // The number of rows is padded with zeros to a multiple of four.
+  // Returns the number of bins of each row.
+static int rateMatrix( const EventList &el, double tbegin, double tend,
+		       const Kernel &kernel, double dt, ArrayD &x )
+{
+  SampleDataD s( tbegin, tend, dt, 0.0 );
+  int m = s.size();
+  int n = el.size() + ( 4 - el.size()%4 )%4;
+  x.clear();
+  x.resize( n*m, 0.0 );
+  for ( int i=0; i<el.size(); i++ ) {
+    el[i].rate( s, kernel );
+    copy( s.begin(), s.end(), x.begin() + i*m );
+  }
+  return m;
+}
+
+
+  // The Gram matrix g[i][j] of the dot products of all pairs of the
+  // n rows of length m of the contiguous matrix x.
+  // n needs to be a multiple of four.
+static void gramMatrix( const ArrayD &x, int n, int m, vector< ArrayD > &g )
+{
+  // number of bins processed at once such that the
+  // rows of a block of pairs stay in the cache:
+  const int nb = 256;
+  g.assign( n, ArrayD( n, 0.0 ) );
+  for ( int kb=0; kb<m; kb+=nb ) {
+    int ke = kb+nb < m ? kb+nb : m;
+    for ( int i=0; i<n; i+=4 ) {
+      const double *x0 = x.data() + i*m;
+      const double *x1 = x0 + m;
+      const double *x2 = x1 + m;
+      const double *x3 = x2 + m;
+      for ( int j=i; j<n; j+=4 ) {
+	const double *y0 = x.data() + j*m;
+	const double *y1 = y0 + m;
+	const double *y2 = y1 + m;
+	const double *y3 = y2 + m;
+	// all 16 dot products of the two blocks of four rows:
+	double s[4][4] = { { 0.0 } };
+	for ( int k=kb; k<ke; k++ ) {
+	  double a[4] = { x0[k], x1[k], x2[k], x3[k] };
+	  double b[4] = { y0[k], y1[k], y2[k], y3[k] };
+	  for ( int r=0; r<4; r++ ) {
+	    for ( int c=0; c<4; c++ )
+	      s[r][c] += a[r]*b[c];
+	  }
+	}
+	for ( int r=0; r<4; r++ ) {
+	  for ( int c=0; c<4; c++ )
+	    g[i+r][j+c] += s[r][c];
+	}
+      }
+    }
+  }
+  // lower triangle:
+  for ( int i=0; i<n; i++ ) {
+    for ( int j=0; j<i; j++ )
+      g[i][j] = g[j][i];
   }
+}
+
 
-  // pairwise correlations:
+  // Normalizes the Gram matrix \a g of the first \a n rows by its
+  // diagonal into \a corr. Returns mean and standard deviation
+  // of all pairs i < j.
+static double normalizeGram( const vector< ArrayD > &g, int n,
+			     vector< ArrayD > &corr, double &sd )
+{
+  corr.assign( n, ArrayD( n, 0.0 ) );
   vector< double > c;
-  c.reserve( s.size() * ( s.size() - 1 ) / 2 );
-  for ( unsigned int i=0; i<s.size(); i++ ) {
-    for ( unsigned int j=i+1; j<s.size(); j++ ) {
-      double rr = corrCoef( s[i], s[j] );
+  c.reserve( n * ( n - 1 ) / 2 );
+  for ( int i=0; i<n; i++ ) {
+    corr[i][i] = g[i][i] > 0.0 ? 1.0 : 0.0;
+    for ( int j=i+1; j<n; j++ ) {
+      double s = ::sqrt( g[i][i]*g[j][j] );
+      double rr = s > 0.0 ? g[i][j] / s : 0.0;
+      corr[i][j] = rr;
+      corr[j][i] = rr;
       c.push_back( rr );
     }
   }
+  return meanStdev( sd, c );
+}
+
 
-  // return mean and standard deviation:
-  double r = meanStdev( sd, c );
-  return r;
+double EventList::correlation( double tbegin, double tend, 
+			       const Kernel &kernel, double dt,
+			       double &sd ) const
+{
+  vector< ArrayD > corr;
+  return correlation( tbegin, tend, kernel, dt, corr, sd );
 }
 
 
@@ -1529,36 +1601,40 @@ double EventList::correlation( double tbegin, double tend,
 }
 
 
-double EventList::reliability( double tbegin, double tend, 
+double EventList::correlation( double tbegin, double tend,
 			       const Kernel &kernel, double dt,
-			       double &sd ) const
+			       vector< ArrayD > &corr, double &sd ) const
 {
   // convolve events with kernel:
-  vector< SampleDataD > s( size(), SampleDataD( tbegin, tend, dt, 0 ) );
-  int k=0;
-  for ( const_iterator i = begin(); i != end(); ++i, ++k ) {
-    (*i)->rate( s[k], kernel );
-  }
+  ArrayD x;
+  int m = rateMatrix( *this, tbegin, tend, kernel, dt, x );
+  int n = x.size()/( m > 0 ? m : 1 );
 
-  // magnitudes:
-  vector< double > m( size() );
-  for ( unsigned int i=0; i<s.size(); i++ ) {
-    m[i] = magnitude( s[i] );
+  // subtract the mean of each trial:
+  for ( int i=0; i<size() && m > 0; i++ ) {
+    double *xi = x.data() + i*m;
+    double a = 0.0;
+    for ( int k=0; k<m; k++ )
+      a += ( xi[k] - a )/(k+1);
+    for ( int k=0; k<m; k++ )
+      xi[k] -= a;
   }
 
-  // pairwise correlations:
-  vector< double > c;
-  c.reserve( s.size() * ( s.size() - 1 ) / 2 );
-  for ( unsigned int i=0; i<s.size(); i++ ) {
-    for ( unsigned int j=i+1; j<s.size(); j++ ) {
-      double rr = m[i] > 0.0 && m[j] > 0.0 ? dot( s[i], s[j] ) / m[i] / m[j] : 0.0;
-      c.push_back( rr );
-    }
-  }
+  // pairwise covariances:
+  vector< ArrayD > g;
+  gramMatrix( x, n, m, g );
 
-  // return mean and standard deviation:
-  double r = meanStdev( sd, c );
-  return r;
+  // correlation coefficients, their mean and standard deviation:
+  return normalizeGram( g, size(), corr, sd );
+}
+
+
+double EventList::reliability( double tbegin, double tend, 
+			       const Kernel &kernel, double dt,
+			       double &sd ) const
+{
+  vector< ArrayD > rel;
+  return reliability( tbegin, tend, kernel, dt, rel, sd );
 }
 
 
@@ -1570,35 +1646,62 @@ double EventList::reliability( double tbegin, double tend,
 }
 
 
+double EventList::reliability( double tbegin, double tend,
+			       const Kernel &kernel, double dt,
+			       vector< ArrayD > &rel, double &sd ) const
+{
+  // convolve events with kernel:
+  ArrayD x;
+  int m = rateMatrix( *this, tbegin, tend, kernel, dt, x );
+  int n = x.size()/( m > 0 ? m : 1 );
+
+  // pairwise dot products:
+  vector< ArrayD > g;
+  gramMatrix( x, n, m, g );
+
+  // normalized by the magnitudes, their mean and standard deviation:
+  return normalizeGram( g, size(), rel, sd );
+}
+
+
 void EventList::coincidenceRate( SampleDataD &rate,  SampleDataD &ratesd, 
 				 const Kernel &kernel )
 {
   rate = 0.0;
   ratesd = 0.0;
 
-  // convolve events with kernel:
-  vector< SampleDataD > s( size(), rate.range() );
-  int k=0;
-  for ( const_iterator i = begin(); i != end(); ++i, ++k ) {
-    (*i)->rate( s[k], kernel );
-  }
-
-  // pairwise products:
-  vector< ArrayD > rate12( rate.size(), ArrayD() );
-  for ( unsigned int k=0; k<rate12.size(); k++ )
-    rate12[k].reserve( s.size() * ( s.size() - 1 ) / 2 );
-  for ( unsigned int i=0; i<s.size(); i++ ) {
-    for ( unsigned int j=i+1; j<s.size(); j++ ) {
-      for ( int k=0; k<s[i].size(); k++ )
-	rate12[k].push( s[i][k] * s[j][k] );
+  // sums of the first, second, and fourth powers of the rates over trials:
+  SampleDataD s( rate.range() );
+  ArrayD s1( rate.size(), 0.0 );
+  ArrayD s2( rate.size(), 0.0 );
+  ArrayD s4( rate.size(), 0.0 );
+  for ( const_iterator i = begin(); i != end(); ++i ) {
+    (*i)->rate( s, kernel );
+    for ( int k=0; k<s.size(); k++ ) {
+      double x2 = s[k]*s[k];
+      s1[k] += s[k];
+      s2[k] += x2;
+      s4[k] += x2*x2;
     }
   }
 
+  // mean and standard deviation of the pairwise products
+  // x_i x_j, i < j, from the sums over trials:
+  double np = 0.5*size()*( size() - 1 );
   for ( int k=0; k<rate.size(); k++ ) {
-    double sd;
-    //    rate[k] = meanStdev( sd, rate12[k] );
-    //    ratesd[k] = sd;
-    rate[k] = ::sqrt( meanStdev( sd, rate12[k] ) );
+    double sd = 0.0;
+    double m = 0.0;
+    if ( np > 0.0 ) {
+      m = 0.5*( s1[k]*s1[k] - s2[k] )/np;
+      if ( m < 0.0 )
+	m = 0.0;
+      if ( np > 1.0 ) {
+	double m2 = 0.5*( s2[k]*s2[k] - s4[k] )/np;
+	double v = ( m2 - m*m )*np/( np - 1.0 );
+	sd = v > 0.0 ? ::sqrt( v ) : 0.0;
+      }
+    }
+    rate[k] = ::sqrt( m );
     ratesd[k] = 0.5*sd/rate[k];
   }
   
@@ -1768,23 +1871,9 @@ void EventList::spectrum( double tbegin, double tend, double step,
 			  SampleDataD &psd,
 			  bool overlap, double (*window)( int j, int n ) ) const
 {
-  psd = 0.0;
-  SampleDataD p( psd.size(), 0.0 );
-  SampleDataD rr( tbegin, tend, step );
-
-  int n = 0;
-  for ( int i=0; i<size(); i++ ) {
-    (*this)[i].rate( rr );
-    rr -= mean( rr );
-    rPSD( rr, p, overlap, window );
-    n++;
-    for ( int k=0; k<psd.size(); k++ )
-      psd[k] += ( p[k] - psd[k] ) / n;
-  }
-
-  // frequency axis:
-  psd.setOffset( 0.0 );
-  psd.setStepsize( p.stepsize() );
+  TrialSpectra ts( tbegin, tend, step, psd.size(), overlap, window );
+  ts.add( *this );
+  ts.powerSpectrum( psd );
 }
 
 
@@ -1792,32 +1881,9 @@ void EventList::spectrum( double tbegin, double tend, double step,
 			  SampleDataD &psd, SampleDataD &sd,
 			  bool overlap, double (*window)( int j, int n ) ) const
 {
-  SampleDataD p( psd.size(), 0.0 );
-  SampleDataD psq( psd.size(), 0.0 );
-  SampleDataD rr( tbegin, tend, step );
-
-  int n = 0;
-  for ( int i=0; i<size(); i++ ) {
-    (*this)[i].rate( rr );
-    rr -= mean( rr );
-    rPSD( rr, p, overlap, window );
-    n++;
-    for ( int k=0; k<psd.size(); k++ ) {
-      psd[k] += ( p[k] - psd[k] ) / n;
-      psq[k] += ( p[k]*p[k] - psq[k] ) / n;
-    }
-  }
-
-  // standard deviation:
-  sd.resize( psd.size() );
-  for ( int k=0; k<psd.size(); k++ )
-    sd[k] = ::sqrt( ::fabs( psq[k] - psd[k]*psd[k] ) );
-
-  // frequency axis:
-  psd.setOffset( 0.0 );
-  psd.setStepsize( p.stepsize() );
-  sd.setOffset( 0.0 );
-  sd.setStepsize( p.stepsize() );
+  TrialSpectra ts( tbegin, tend, step, psd.size(), overlap, window );
+  ts.add( *this );
+  ts.powerSpectrum( psd, sd );
 }
 
 
@@ -1828,44 +1894,13 @@ void EventList::spectra( const SampleDataD &stimulus, SampleDataD &g, SampleData
   if ( g.size() <= 0 )
     return;
 
-  c.resize( g.size() );
-  cs.resize( 2*g.size() );
-  ss.resize( g.size() );
-  rs.resize( g.size() );
-  g = 0.0;
-  c = 0.0;
-  ss = 0.0;
-  rs = 0.0;
-  cs = 0.0;
-  SampleDataD gt( g.size(), 0.0 );
-  SampleDataD ct( g.size(), 0.0 );
-  SampleDataD rst( g.size(), 0.0 );
-  SampleDataD cst( 2*g.size(), 0.0 );
-  SampleDataD rr( stimulus.range() );
-
-  int n=0;
-  for ( int i=0; i<size(); i++ ) {
-    (*this)[i].rate( rr );
-    rr -= mean( rr );
-    ::relacs::spectra( stimulus, rr, gt, ct, cst, ss, rst, overlap, window );
-    n++;
-    for ( int k=0; k<g.size(); k++ ) {
-      g[k] += ( gt[k] - g[k] ) / n;
-      c[k] += ( ct[k] - c[k] ) / n;
-      rs[k] += ( rst[k] - rs[k] ) / n;
-    }
-    for ( int k=0; k<cs.size(); k++ )
-      cs[k] += ( cst[k] - cs[k] ) / n;
-  }
-  // frequency axis:
-  g.setOffset( 0.0 );
-  g.setStepsize( gt.stepsize() );
-  c.setOffset( 0.0 );
-  c.setStepsize( ct.stepsize() );
-  cs.setOffset( 0.0 );
-  cs.setStepsize( cst.stepsize() );
-  rs.setOffset( 0.0 );
-  rs.setStepsize( rst.stepsize() );
+  TrialSpectra ts( stimulus, g.size(), overlap, window );
+  ts.add( *this );
+  ts.gain( g );
+  ts.trialCoherence( c );
+  ts.crossPower( cs );
+  ts.stimulusSpectrum( ss );
+  ts.powerSpectrum( rs );
 }
 
 
@@ -1877,79 +1912,13 @@ void EventList::spectra( const SampleDataD &stimulus, SampleDataD &g, SampleData
   if ( g.size() <= 0 )
     return;
 
-  gsd.resize( g.size() );
-  c.resize( g.size() );
-  csd.resize( g.size() );
-  cs.resize( 2*g.size() );
-  cssd.resize( 2*g.size() );
-  ss.resize( g.size() );
-  rs.resize( g.size() );
-  rssd.resize( g.size() );
-  g = 0.0;
-  gsd = 0.0;
-  c = 0.0;
-  csd = 0.0;
-  ss = 0.0;
-  rs = 0.0;
-  rssd = 0.0;
-  cs = 0.0;
-  cssd = 0.0;
-  SampleDataD gt( g.size(), 0.0 );
-  SampleDataD gtsq( g.size(), 0.0 );
-  SampleDataD ct( g.size(), 0.0 );
-  SampleDataD ctsq( g.size(), 0.0 );
-  SampleDataD rst( g.size(), 0.0 );
-  SampleDataD rstsq( g.size(), 0.0 );
-  SampleDataD cst( 2*g.size(), 0.0 );
-  SampleDataD cstsq( 2*g.size(), 0.0 );
-  SampleDataD rr( stimulus.range() );
-
-  int n=0;
-  for ( int i=0; i<size(); i++ ) {
-    (*this)[i].rate( rr );
-    rr -= mean( rr );
-    ::relacs::spectra( stimulus, rr, gt, ct, cst, ss, rst, overlap, window );
-    n++;
-    for ( int k=0; k<g.size(); k++ ) {
-      g[k] += ( gt[k] - g[k] ) / n;
-      gtsq[k] += ( gt[k]*gt[k] - gtsq[k] ) / n;
-      c[k] += ( ct[k] - c[k] ) / n;
-      ctsq[k] += ( ct[k]*ct[k] - ctsq[k] ) / n;
-      rs[k] += ( rst[k] - rs[k] ) / n;
-      rstsq[k] += ( rst[k]*rst[k] - rstsq[k] ) / n;
-    }
-    for ( int k=0; k<cs.size(); k++ ) {
-      cs[k] += ( cst[k] - cs[k] ) / n;
-      cstsq[k] += ( cst[k]*cst[k] - cstsq[k] ) / n;
-    }
-  }
-
-  // standard deviation:
-  for ( int k=0; k<g.size(); k++ ) {
-    gsd[k] = ::sqrt( ::fabs( gtsq[k] - g[k]*g[k] ) );
-    csd[k] = ::sqrt( ::fabs( ctsq[k] - c[k]*c[k] ) );
-    rssd[k] = ::sqrt( ::fabs( rstsq[k] - rs[k]*rs[k] ) );
-  }
-  for ( int k=0; k<cs.size(); k++ )
-    cssd[k] = ::sqrt( ::fabs( cstsq[k] - cs[k]*cs[k] ) );
-
-  // frequency axis:
-  g.setOffset( 0.0 );
-  g.setStepsize( gt.stepsize() );
-  gsd.setOffset( 0.0 );
-  gsd.setStepsize( gt.stepsize() );
-  c.setOffset( 0.0 );
-  c.setStepsize( ct.stepsize() );
-  csd.setOffset( 0.0 );
-  csd.setStepsize( ct.stepsize() );
-  cs.setOffset( 0.0 );
-  cs.setStepsize( cst.stepsize() );
-  cssd.setOffset( 0.0 );
-  cssd.setStepsize( cst.stepsize() );
-  rs.setOffset( 0.0 );
-  rs.setStepsize( rst.stepsize() );
-  rssd.setOffset( 0.0 );
-  rssd.setStepsize( rst.stepsize() );
+  TrialSpectra ts( stimulus, g.size(), overlap, window );
+  ts.add( *this );
+  ts.gain( g, &gsd );
+  ts.trialCoherence( c, &csd );
+  ts.crossPower( cs, &cssd );
+  ts.stimulusSpectrum( ss );
+  ts.powerSpectrum( rs, rssd );
 }
 
 
@@ -1957,28 +1926,12 @@ int EventList::coherence( const SampleDataD &stimulus, SampleDataD &c,
 			  bool overlap, double (*window)( int j, int n ) ) const
 {
   c = 0.0;
-  int nfft = nextPowerOfTwo( c.size() );
-  SampleDataD crossspec( 2*nfft, 0.0 );
-  SampleDataD signalspec( nfft, 0.0 );
-  SampleDataD responsespec( nfft, 0.0 );
-  SampleDataD cp( 2*nfft, 0.0 );
-  SampleDataD rp( nfft, 0.0 );
-  SampleDataD rr( stimulus.range() );
-
-  int n=0;
-  for ( int i=0; i<size(); i++ ) {
-    (*this)[i].rate( rr );
-    rr -= mean( rr );
-    int r = ::relacs::crossSpectra( stimulus, rr, cp, signalspec, rp, overlap, window );
-    if ( r != 0 )
-      return r;
-    n++;
-    for ( int k=0; k<cp.size(); k++ )
-      crossspec[k] += ( cp[k] - crossspec[k] ) / n;
-    for ( int k=0; k<rp.size(); k++ )
-      responsespec[k] += ( rp[k] - responsespec[k] ) / n;
-  }
-  ::relacs::coherence( crossspec, signalspec, responsespec, c );
+  TrialSpectra ts;
+  int r = ts.init( stimulus, nextPowerOfTwo( c.size() ), overlap, window );
+  if ( r != 0 )
+    return r;
+  ts.add( *this );
+  ts.coherence( c );
   return 0;
 }
 
@@ -1988,38 +1941,12 @@ int EventList::coherence( double tbegin, double tend, double step,
 			  bool overlap, double (*window)( int j, int n ) ) const
 {
   c = 0.0;
-  // convolve events with kernel:
-  vector< SampleDataD > rr( size(), SampleDataD( tbegin, tend, step, 0 ) );
-  int k=0;
-  for ( const_iterator i = begin(); i != end(); ++i, ++k ) {
-    (*i)->rate( rr[k] );
-  }
-  int nfft = nextPowerOfTwo( c.size() );
-  SampleDataD crossspec( 2*nfft, 0.0 );
-  SampleDataD responsespec( nfft, 0.0 );
-  SampleDataD cp( 2*nfft, 0.0 );
-  SampleDataD rp( nfft, 0.0 );
-  SampleDataD dp( nfft, 0.0 );
-
-  // pairwise coherence:
-  int n=0;
-  int nr=0;
-  for ( unsigned int i=0; i<rr.size(); i++ ) {
-    for ( unsigned int j=i+1; j<rr.size(); j++ ) {
-      int r = ::relacs::crossSpectra( rr[i], rr[j], cp, rp, dp, overlap, window );
-      if ( r != 0 )
-	return r;
-      n++;
-      for ( int k=0; k<cp.size(); k++ )
-	crossspec[k] += ( cp[k] - crossspec[k] ) / n;
-    }
-    nr++;
-    for ( int k=0; k<rp.size(); k++ )
-      responsespec[k] += ( rp[k] - responsespec[k] ) / nr;
-  }
-  ::relacs::coherence( crossspec, responsespec, responsespec, c );
-  for ( int k=0; k<c.size(); k++ )
-    c = ::sqrt( c[k] );
+  TrialSpectra ts;
+  int r = ts.init( tbegin, tend, step, nextPowerOfTwo( c.size() ), overlap, window );
+  if ( r != 0 )
+    return r;
+  ts.add( *this );
+  ts.responseCoherence( c );
   return 0;
 }
 
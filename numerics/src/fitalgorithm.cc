@@ -93,6 +93,102 @@ int gaussJordan( vector< ArrayD > &a, int n, ArrayD &b )
 }
 
 
+int cholesky( vector< ArrayD > &a, int n, ArrayD &b )
+{
+  // decomposition into lower triangle:
+  for ( int j=0; j<n; j++ ) {
+    double sum = a[j][j];
+    for ( int k=0; k<j; k++ )
+      sum -= a[j][k]*a[j][k];
+    if ( sum <= 0.0 )
+      return 1;    // not positive definite
+    double d = ::sqrt( sum );
+    a[j][j] = d;
+    for ( int i=j+1; i<n; i++ ) {
+      double sum = a[i][j];
+      for ( int k=0; k<j; k++ )
+	sum -= a[i][k]*a[j][k];
+      a[i][j] = sum/d;
+    }
+  }
+
+  if ( b.size() < n )
+    return 0;
+
+  // forward substitution:
+  for ( int i=0; i<n; i++ ) {
+    double sum = b[i];
+    for ( int k=0; k<i; k++ )
+      sum -= a[i][k]*b[k];
+    b[i] = sum/a[i][i];
+  }
+  // back substitution:
+  for ( int i=n-1; i>=0; i-- ) {
+    double sum = b[i];
+    for ( int k=i+1; k<n; k++ )
+      sum -= a[k][i]*b[k];
+    b[i] = sum/a[i][i];
+  }
+  return 0;
+}
+
+
+int choleskyInverse( vector< ArrayD > &a, int n )
+{
+  ArrayD emptyb( 0 );
+  int r = cholesky( a, n, emptyb );
+  if ( r )
+    return r;
+
+  // invert lower triangle in place:
+  for ( int i=0; i<n; i++ ) {
+    a[i][i] = 1.0/a[i][i];
+    for ( int j=0; j<i; j++ ) {
+      double sum = 0.0;
+      for ( int k=j; k<i; k++ )
+	sum -= a[i][k]*a[k][j];
+      a[i][j] = sum*a[i][i];
+    }
+  }
+
+  // multiply transposed inverse with inverse into upper triangle:
+  for ( int i=0; i<n; i++ ) {
+    for ( int j=i+1; j<n; j++ ) {
+      double sum = 0.0;
+      for ( int k=j; k<n; k++ )
+	sum += a[k][i]*a[k][j];
+      a[i][j] = sum;
+    }
+  }
+  for ( int i=0; i<n; i++ ) {
+    double sum = 0.0;
+    for ( int k=i; k<n; k++ )
+      sum += a[k][i]*a[k][i];
+    a[i][i] = sum;
+  }
+  for ( int i=0; i<n; i++ ) {
+    for ( int j=i+1; j<n; j++ )
+      a[j][i] = a[i][j];
+  }
+  return 0;
+}
+
+
+void FitWorkspace::resize( int n )
+{
+  if ( n == N )
+    return;
+  N = n;
+  Alpha.assign( n, ArrayD( n, 0.0 ) );
+  Covar.assign( n, ArrayD( n, 0.0 ) );
+  Beta.resize( n );
+  OneDa.resize( n );
+  Da.resize( n );
+  ATry.resize( n );
+  DyDa.resize( n );
+}
+
+
 void covarSort( vector< ArrayD > &covar, const ArrayI &paramfit, int mfit )
 {
   for ( int i=mfit; i<paramfit.size(); i++ ) {
@@ -0,0 +1,150 @@
+/*
+  prescan.cc
+  Fast block-wise scanning of data for regions without events.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+#include <relacs/prescan.h>
+
+namespace relacs {
+
+
+  // minimum and maximum of n data elements, n a multiple of four:
+static inline void blockMinMax( const float *data, int n, float &min, float &max )
+{
+#ifdef __SSE__
+  // _mm_min_ps() and _mm_max_ps() return the second operand if
+  // the first one is NaN, this way NaNs are ignored:
+  __m128 mn = _mm_set1_ps( HUGE_VALF );
+  __m128 mx = _mm_set1_ps( -HUGE_VALF );
+  for ( int k=0; k<n; k += 4 ) {
+    __m128 x = _mm_loadu_ps( data + k );
+    mn = _mm_min_ps( x, mn );
+    mx = _mm_max_ps( x, mx );
+  }
+  // horizontal minimum and maximum:
+  mn = _mm_min_ps( mn, _mm_movehl_ps( mn, mn ) );
+  mn = _mm_min_ss( mn, _mm_shuffle_ps( mn, mn, 1 ) );
+  mx = _mm_max_ps( mx, _mm_movehl_ps( mx, mx ) );
+  mx = _mm_max_ss( mx, _mm_shuffle_ps( mx, mx, 1 ) );
+  min = _mm_cvtss_f32( mn );
+  max = _mm_cvtss_f32( mx );
+#else
+  min = HUGE_VALF;
+  max = -HUGE_VALF;
+  for ( int k=0; k<n; k++ ) {
+    if ( data[k] < min )
+      min = data[k];
+    if ( data[k] > max )
+      max = data[k];
+  }
+#endif
+}
+
+
+void minMax( const float *data, int n, float &min, float &max )
+{
+  int n4 = n - n%4;
+  blockMinMax( data, n4, min, max );
+  for ( int k=n4; k<n; k++ ) {
+    if ( data[k] < min )
+      min = data[k];
+    if ( data[k] > max )
+      max = data[k];
+  }
+}
+
+
+int prescanRising( const float *data, int n, double threshold,
+		   double &maxvalue, int &maxindex )
+{
+  int k = 0;
+  for ( ; k+PrescanBlock <= n; k += PrescanBlock ) {
+    float min, max;
+    blockMinMax( data+k, PrescanBlock, min, max );
+    // largest possible maximum within the block:
+    double m = maxvalue < max ? max : maxvalue;
+    // any element falling by threshold below the maximum?
+    if ( ! ( m < min + threshold ) )
+      break;
+    if ( maxvalue < max ) {
+      for ( int j=k; j<k+PrescanBlock; j++ ) {
+	if ( data[j] == max ) {
+	  maxindex = j;
+	  maxvalue = data[j];
+	  break;
+	}
+      }
+    }
+  }
+  return k;
+}
+
+
+int prescanFalling( const float *data, int n, double threshold,
+		    double &minvalue, int &minindex )
+{
+  int k = 0;
+  for ( ; k+PrescanBlock <= n; k += PrescanBlock ) {
+    float min, max;
+    blockMinMax( data+k, PrescanBlock, min, max );
+    // smallest possible minimum within the block:
+    double m = min < minvalue ? min : minvalue;
+    // any element rising by threshold above the minimum?
+    if ( ! ( max < m + threshold ) )
+      break;
+    if ( min < minvalue ) {
+      for ( int j=k; j<k+PrescanBlock; j++ ) {
+	if ( data[j] == min ) {
+	  minindex = j;
+	  minvalue = data[j];
+	  break;
+	}
+      }
+    }
+  }
+  return k;
+}
+
+
+int prescanCrossing( const float *data, int n, double threshold, bool up )
+{
+  int k = 0;
+  // each block includes the first element of the next block:
+  for ( ; k+PrescanBlock < n; k += PrescanBlock ) {
+    float min, max;
+    minMax( data+k, PrescanBlock+1, min, max );
+    if ( up ) {
+      if ( ! ( min > threshold || max <= threshold ) )
+	break;
+    }
+    else {
+      if ( ! ( min >= threshold || max < threshold ) )
+	break;
+    }
+  }
+  return k;
+}
+
+
+}; /* namespace relacs */
+
@@ -0,0 +1,155 @@
+/*
+  resampler.cc
+  Streaming conversion of the sampling rate with a windowed-sinc filter.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <algorithm>
+#include <relacs/resampler.h>
+
+using namespace std;
+
+namespace relacs {
+
+
+Resampler::Resampler( void )
+  : InRate( 1.0 ),
+    OutRate( 1.0 ),
+    Ratio( 1.0 ),
+    Step( 1.0 ),
+    Phases( 0 ),
+    Width( 0 ),
+    Pos( 0.0 )
+{
+}
+
+
+Resampler::Resampler( double inrate, double outrate, int halfwidth, int phases )
+  : Ratio( 1.0 )
+{
+  init( inrate, outrate, halfwidth, phases );
+}
+
+
+void Resampler::init( double inrate, double outrate, int halfwidth, int phases )
+{
+  InRate = inrate;
+  OutRate = outrate;
+  Ratio = 1.0;
+  Step = InRate/OutRate;
+  Phases = phases < 1 ? 1 : phases;
+
+  // cutoff frequency relative to the Nyquist frequency of the input:
+  double fc = 1.0;
+  if ( OutRate < InRate )
+    fc = 0.9*OutRate/InRate;
+  Width = (int)::ceil( halfwidth/fc );
+  if ( Width < 1 )
+    Width = 1;
+
+  // tabulate windowed sinc for each phase:
+  int taps = 2*Width;
+  Filter.resize( (Phases+1)*taps );
+  for ( int p=0; p<=Phases; p++ ) {
+    double frac = (double)p/Phases;
+    double sum = 0.0;
+    for ( int j=0; j<taps; j++ ) {
+      double x = j - Width + 1 - frac;
+      double s = x == 0.0 ? 1.0 : ::sin( M_PI*fc*x )/( M_PI*fc*x );
+      double w = 0.0;
+      if ( ::fabs( x ) < Width )
+	w = 0.42 + 0.5*::cos( M_PI*x/Width ) + 0.08*::cos( 2.0*M_PI*x/Width );
+      Filter[p*taps+j] = s*w;
+      sum += s*w;
+    }
+    // unit gain:
+    for ( int j=0; j<taps; j++ )
+      Filter[p*taps+j] /= sum;
+  }
+
+  reset();
+}
+
+
+void Resampler::reset( void )
+{
+  Buffer.clear();
+  Buffer.resize( Width > 0 ? Width-1 : 0, 0.0f );
+  Pos = Buffer.size();
+}
+
+
+void Resampler::setRatio( double ratio )
+{
+  Ratio = ratio;
+  Step = InRate/OutRate/Ratio;
+}
+
+
+int Resampler::process( const float *in, int n, ArrayF &out )
+{
+  if ( Filter.empty() )
+    return 0;
+
+  for ( int k=0; k<n; k++ )
+    Buffer.push( in[k] );
+
+  int nout = 0;
+  int nb = Buffer.size();
+  int taps = 2*Width;
+  while ( true ) {
+    int i0 = (int)::floor( Pos );
+    if ( i0 + Width >= nb )
+      break;
+    // coefficients of the two enclosing phases:
+    double phase = ( Pos - i0 )*Phases;
+    int p = (int)phase;
+    if ( p >= Phases )
+      p = Phases - 1;
+    float w = phase - p;
+    const float *f0 = Filter.data() + p*taps;
+    const float *f1 = f0 + taps;
+    const float *x = Buffer.data() + i0 - Width + 1;
+    float y0 = 0.0f;
+    float y1 = 0.0f;
+    for ( int j=0; j<taps; j++ ) {
+      y0 += f0[j]*x[j];
+      y1 += f1[j]*x[j];
+    }
+    out.push( y0 + w*( y1 - y0 ) );
+    nout++;
+    Pos += Step;
+  }
+
+  // discard input data that are not needed anymore:
+  int d = (int)::floor( Pos ) - Width + 1;
+  if ( d > nb )
+    d = nb;
+  if ( d > 0 ) {
+    copy( Buffer.begin() + d, Buffer.end(), Buffer.begin() );
+    Buffer.resize( nb - d );
+    Pos -= d;
+  }
+
+  return nout;
+}
+
+
+}; /* namespace relacs */
+
@@ -0,0 +1,315 @@
+/*
+  transferspectra.cc
+  Transfer function and coherence estimated from running sums of spectra.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <relacs/transferspectra.h>
+
+namespace relacs {
+
+
+TransferSpectra::TransferSpectra( void )
+  : NP( 0 ),
+    NW( 0 ),
+    Overlap( true ),
+    DeltaF( 0.0 ),
+    WWN( 0.0 ),
+    Segments( 0 ),
+    Chunks( 0 )
+{
+}
+
+
+TransferSpectra::TransferSpectra( int np, double stepsize,
+				  bool overlap, double (*window)( int j, int n ) )
+{
+  init( np, stepsize, overlap, window );
+}
+
+
+int TransferSpectra::init( int np, double stepsize,
+			   bool overlap, double (*window)( int j, int n ) )
+{
+  NW = nextPowerOfTwo( 2*( np > 0 ? np : 0 ) );
+  Overlap = overlap;
+
+  int r = 0;
+  if ( NW <= 2 ) {
+    NP = 0;
+    NW = 0;
+    DeltaF = 0.0;
+    Window.clear();
+    WWN = 0.0;
+    r = -1;
+  }
+  else {
+    NP = NW/2;
+    DeltaF = 1.0/stepsize/NW;
+    Window.resize( NW );
+    WWN = 0.0;
+    for ( int k=0; k<NW; k++ ) {
+      Window[k] = window( k, NW );
+      WWN += Window[k]*Window[k];
+    }
+  }
+  BufferX.resize( NW );
+  BufferY.resize( NW );
+  SXX.resize( NP );
+  SYY.resize( NP );
+  SRe.resize( NP );
+  SIm.resize( NP );
+  clear();
+  return r;
+}
+
+
+void TransferSpectra::clear( void )
+{
+  Segments = 0;
+  Chunks = 0;
+  XX.resize( NP );
+  XX = 0.0;
+  YY.resize( NP );
+  YY = 0.0;
+  Re.resize( NP );
+  Re = 0.0;
+  Im.resize( NP );
+  Im = 0.0;
+  GMean.resize( NP );
+  GMean = 0.0;
+  GSq.resize( NP );
+  GSq = 0.0;
+  PCos.resize( NP );
+  PCos = 0.0;
+  PSin.resize( NP );
+  PSin = 0.0;
+  CMean.resize( NP );
+  CMean = 0.0;
+  CSq.resize( NP );
+  CSq = 0.0;
+}
+
+
+int TransferSpectra::add( const ArrayD &x, const ArrayD &y )
+{
+  if ( NW <= 0 )
+    return -1;
+  if ( x.size() != y.size() )
+    return -2;
+
+  SXX = 0.0;
+  SYY = 0.0;
+  SRe = 0.0;
+  SIm = 0.0;
+  double *bx = BufferX.data();
+  double *by = BufferY.data();
+
+  // same chunks as transfer():
+  int n = x.size();
+  int step = Overlap ? NW/2 : NW;
+  int c = 0;
+  for ( int start=0; start < n; start += step ) {
+    int len = n - start < NW ? n - start : NW;
+    if ( c >= 1 && len < 3*NW/4 )
+      break;
+    for ( int k=0; k<len; k++ ) {
+      bx[k] = x[start+k] * Window[k];
+      by[k] = y[start+k] * Window[k];
+    }
+    double normfac = 1.0;
+    if ( len < NW ) {
+      double wwz = 0.0;
+      for ( int k=len; k<NW; k++ ) {
+	bx[k] = 0.0;
+	by[k] = 0.0;
+	wwz += Window[k]*Window[k];
+      }
+      normfac = WWN / ( WWN - wwz );
+    }
+    rFFT( bx, bx+NW );
+    rFFT( by, by+NW );
+
+    SXX[0] += bx[0]*bx[0]*normfac;
+    SYY[0] += by[0]*by[0]*normfac;
+    SRe[0] += bx[0]*by[0]*normfac;
+    for ( int k=1; k<NP; k++ ) {
+      double xr = bx[k];
+      double xi = bx[NW-k];
+      double yr = by[k];
+      double yi = by[NW-k];
+      SXX[k] += ( xr*xr + xi*xi )*normfac;
+      SYY[k] += ( yr*yr + yi*yi )*normfac;
+      SRe[k] += ( xr*yr + xi*yi )*normfac;
+      SIm[k] += ( xr*yi - xi*yr )*normfac;
+    }
+    c++;
+    if ( Overlap && start + NW >= n )
+      break;
+  }
+  if ( c <= 0 )
+    return 0;
+
+  XX += SXX;
+  YY += SYY;
+  Re += SRe;
+  Im += SIm;
+  Chunks += c;
+  Segments++;
+
+  // moments over segments:
+  for ( int k=0; k<NP; k++ ) {
+    double g, p, coh;
+    spectra( SXX, SYY, SRe, SIm, k, g, p, coh );
+    GMean[k] += ( g - GMean[k] ) / Segments;
+    GSq[k] += ( g*g - GSq[k] ) / Segments;
+    PCos[k] += ( ::cos( p ) - PCos[k] ) / Segments;
+    PSin[k] += ( ::sin( p ) - PSin[k] ) / Segments;
+    CMean[k] += ( coh - CMean[k] ) / Segments;
+    CSq[k] += ( coh*coh - CSq[k] ) / Segments;
+  }
+
+  return c;
+}
+
+
+void TransferSpectra::spectra( const ArrayD &xx, const ArrayD &yy, const ArrayD &re,
+			       const ArrayD &im, int k, double &g, double &p, double &c ) const
+{
+  double cp = re[k]*re[k] + im[k]*im[k];
+  g = xx[k] == 0.0 ? 0.0 : ::sqrt( cp ) / xx[k];
+  p = ::atan2( im[k], re[k] );
+  c = xx[k] == 0.0 || yy[k] == 0.0 ? 0.0 : cp / ( xx[k]*yy[k] );
+}
+
+
+void TransferSpectra::axis( SampleDataD &s ) const
+{
+  s.resize( NP );
+  s = 0.0;
+  s.setOffset( 0.0 );
+  s.setStepsize( DeltaF );
+}
+
+
+void TransferSpectra::sd( const ArrayD &mean, const ArrayD &sq, SampleDataD &s ) const
+{
+  axis( s );
+  for ( int k=0; k<NP; k++ )
+    s[k] = ::sqrt( ::fabs( sq[k] - mean[k]*mean[k] ) );
+}
+
+
+void TransferSpectra::inputSpectrum( SampleDataD &xp ) const
+{
+  axis( xp );
+  if ( Chunks <= 0 )
+    return;
+  double norm = 2.0/WWN/NW/Chunks;
+  for ( int k=0; k<NP; k++ )
+    xp[k] = XX[k]*norm;
+  xp[0] *= 0.5;
+  // last element as in rPSD():
+  xp[NP-1] *= 0.25;
+}
+
+
+void TransferSpectra::outputSpectrum( SampleDataD &yp ) const
+{
+  axis( yp );
+  if ( Chunks <= 0 )
+    return;
+  double norm = 2.0/WWN/NW/Chunks;
+  for ( int k=0; k<NP; k++ )
+    yp[k] = YY[k]*norm;
+  yp[0] *= 0.5;
+  // last element as in rPSD():
+  yp[NP-1] *= 0.25;
+}
+
+
+void TransferSpectra::transfer( SampleDataD &h ) const
+{
+  h.resize( NW );
+  h = 0.0;
+  h.setOffset( 0.0 );
+  h.setStepsize( DeltaF );
+  if ( Chunks <= 0 )
+    return;
+  if ( XX[0] != 0.0 )
+    h[0] = Re[0]/XX[0];
+  for ( int k=1; k<NP; k++ ) {
+    if ( XX[k] != 0.0 ) {
+      h[k] = Re[k]/XX[k];
+      h[NW-k] = Im[k]/XX[k];
+    }
+  }
+}
+
+
+void TransferSpectra::gain( SampleDataD &g, SampleDataD *sd ) const
+{
+  axis( g );
+  double p, c;
+  for ( int k=0; k<NP && Chunks > 0; k++ )
+    spectra( XX, YY, Re, Im, k, g[k], p, c );
+  if ( sd != 0 )
+    this->sd( GMean, GSq, *sd );
+}
+
+
+void TransferSpectra::phase( SampleDataD &p, SampleDataD *sd ) const
+{
+  axis( p );
+  double g, c;
+  for ( int k=0; k<NP && Chunks > 0; k++ )
+    spectra( XX, YY, Re, Im, k, g, p[k], c );
+  if ( sd != 0 ) {
+    axis( *sd );
+    for ( int k=0; k<NP && Segments > 0; k++ ) {
+      double r = ::sqrt( PCos[k]*PCos[k] + PSin[k]*PSin[k] );
+      if ( r < 1.0e-8 )
+	r = 1.0e-8;
+      (*sd)[k] = r < 1.0 ? ::sqrt( -2.0*::log( r ) ) : 0.0;
+    }
+  }
+}
+
+
+void TransferSpectra::coherence( SampleDataD &c, SampleDataD *sd ) const
+{
+  axis( c );
+  double g, p;
+  for ( int k=0; k<NP && Chunks > 0; k++ )
+    spectra( XX, YY, Re, Im, k, g, p, c[k] );
+  if ( sd != 0 )
+    this->sd( CMean, CSq, *sd );
+}
+
+
+double TransferSpectra::coherenceInfo( double f0, double f1 ) const
+{
+  SampleDataD c;
+  coherence( c );
+  return ::relacs::coherenceInfo( c, f0, f1 );
+}
+
+
+}; /* namespace relacs */
+
@@ -0,0 +1,394 @@
+/*
+  trialspectra.cc
+  Trial-averaged spectra of event trials that are updated trial by trial.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <relacs/stats.h>
+#include <relacs/eventdata.h>
+#include <relacs/eventlist.h>
+#include <relacs/trialspectra.h>
+
+namespace relacs {
+
+
+TrialSpectra::TrialSpectra( void )
+  : NP( 0 ),
+    NW( 0 ),
+    Overlap( true ),
+    DeltaF( 0.0 ),
+    Trials( 0 ),
+    Pairs( 0 )
+{
+}
+
+
+TrialSpectra::TrialSpectra( const SampleDataD &stimulus, int np,
+			    bool overlap, double (*window)( int j, int n ) )
+{
+  init( stimulus, np, overlap, window );
+}
+
+
+TrialSpectra::TrialSpectra( double tbegin, double tend, double step, int np,
+			    bool overlap, double (*window)( int j, int n ) )
+{
+  init( tbegin, tend, step, np, overlap, window );
+}
+
+
+int TrialSpectra::init( const SampleDataD &stimulus, int np,
+			bool overlap, double (*window)( int j, int n ) )
+{
+  int r = initRange( stimulus.range(), np, overlap, window );
+  if ( r != 0 )
+    return r;
+
+  // fourier transform stimulus chunks:
+  int nc = chunks();
+  XFFT.resize( nc*NW );
+  XP.resize( NP );
+  XP = 0.0;
+  for ( int m=0; m<nc; m++ ) {
+    double *x = XFFT.data() + m*NW;
+    for ( int k=0; k<Lengths[m]; k++ )
+      x[k] = stimulus[Starts[m]+k] * Window[k];
+    for ( int k=Lengths[m]; k<NW; k++ )
+      x[k] = 0.0;
+    rFFT( x, x+NW );
+    double nf = NormFacs[m];
+    XP[0] += 0.5*x[0]*x[0]*nf;
+    for ( int k=1; k<NP; k++ )
+      XP[k] += ( x[k]*x[k] + x[NW-k]*x[NW-k] )*nf;
+  }
+  if ( nc > 0 )
+    XP /= (double)nc;
+
+  return 0;
+}
+
+
+int TrialSpectra::init( double tbegin, double tend, double step, int np,
+			bool overlap, double (*window)( int j, int n ) )
+{
+  return initRange( LinearRange( tbegin, tend, step ), np, overlap, window );
+}
+
+
+int TrialSpectra::initRange( const LinearRange &range, int np,
+			     bool overlap, double (*window)( int j, int n ) )
+{
+  NP = np > 0 ? np : 0;
+  NW = nextPowerOfTwo( 2*NP );
+  Overlap = overlap;
+  Range = range;
+  Rate = SampleDataD( Range );
+  XFFT.clear();
+  XP.clear();
+
+  int r = 0;
+  if ( NW <= 2 ) {
+    NW = 0;
+    DeltaF = 0.0;
+    Window.clear();
+    r = -1;
+  }
+  else {
+    DeltaF = 1.0/Range.stepsize()/NW;
+    Window.resize( NW );
+    for ( int k=0; k<NW; k++ )
+      Window[k] = window( k, NW );
+  }
+  initChunks( Rate.size() );
+  Buffer.resize( NW );
+  TYP.resize( NP );
+  TCP.resize( 2*NP );
+  clear();
+  return r;
+}
+
+
+void TrialSpectra::initChunks( int n )
+{
+  Starts.clear();
+  Lengths.clear();
+  NormFacs.clear();
+  if ( NW <= 0 )
+    return;
+
+  double wwn = 0.0;
+  for ( int k=0; k<NW; k++ )
+    wwn += Window[k]*Window[k];
+  double norm = 2.0/wwn/NW;
+
+  // same chunks as rPSD() and crossSpectra():
+  int step = Overlap ? NW/2 : NW;
+  for ( int start=0; start < n; start += step ) {
+    int len = n - start < NW ? n - start : NW;
+    if ( Starts.size() >= 1 && len < 3*NW/4 )
+      break;
+    double normfac = norm;
+    if ( len < NW ) {
+      double wwz = 0.0;
+      for ( int k=len; k<NW; k++ )
+	wwz += Window[k]*Window[k];
+      normfac *= wwn / ( wwn - wwz );
+    }
+    Starts.push( start );
+    Lengths.push( len );
+    NormFacs.push( normfac );
+    if ( Overlap && start + NW >= n )
+      break;
+  }
+}
+
+
+void TrialSpectra::clear( void )
+{
+  Trials = 0;
+  Pairs = 0;
+  YP.resize( NP );
+  YP = 0.0;
+  YPSq.resize( NP );
+  YPSq = 0.0;
+  CP.resize( 2*NP );
+  CP = 0.0;
+  G.resize( NP );
+  G = 0.0;
+  GSq.resize( NP );
+  GSq = 0.0;
+  C.resize( NP );
+  C = 0.0;
+  CSq.resize( NP );
+  CSq = 0.0;
+  CPow.resize( NP );
+  CPow = 0.0;
+  CPowSq.resize( NP );
+  CPowSq = 0.0;
+  RR.resize( 2*NP );
+  RR = 0.0;
+  YFFTSum.resize( chunks()*NW );
+  YFFTSum = 0.0;
+}
+
+
+void TrialSpectra::update( ArrayD &mean, ArrayD &sq, int k, double x )
+{
+  mean[k] += ( x - mean[k] ) / Trials;
+  sq[k] += ( x*x - sq[k] ) / Trials;
+}
+
+
+void TrialSpectra::add( const EventData &events )
+{
+  int nc = chunks();
+  if ( nc <= 0 )
+    return;
+
+  events.rate( Rate );
+  Rate -= mean( Rate );
+
+  TYP = 0.0;
+  TCP = 0.0;
+  double *b = Buffer.data();
+  for ( int m=0; m<nc; m++ ) {
+    for ( int k=0; k<Lengths[m]; k++ )
+      b[k] = Rate[Starts[m]+k] * Window[k];
+    for ( int k=Lengths[m]; k<NW; k++ )
+      b[k] = 0.0;
+    rFFT( b, b+NW );
+    double nf = NormFacs[m];
+
+    // power spectrum:
+    TYP[0] += 0.5*b[0]*b[0]*nf;
+    for ( int k=1; k<NP; k++ )
+      TYP[k] += ( b[k]*b[k] + b[NW-k]*b[NW-k] )*nf;
+
+    // cross spectrum with stimulus:
+    if ( ! XFFT.empty() ) {
+      const double *x = XFFT.data() + m*NW;
+      TCP[0] += 0.5*x[0]*b[0]*nf;
+      for ( int k=1; k<NP; k++ ) {
+	TCP[k] += ( x[k]*b[k] + x[NW-k]*b[NW-k] )*nf;
+	TCP[NP+k] += ( - x[k]*b[NW-k] + x[NW-k]*b[k] )*nf;
+      }
+    }
+
+    // cross spectra with all previous trials:
+    double *s = YFFTSum.data() + m*NW;
+    if ( Trials > 0 ) {
+      RR[0] += 0.5*s[0]*b[0]*nf;
+      for ( int k=1; k<NP; k++ ) {
+	RR[k] += ( s[k]*b[k] + s[NW-k]*b[NW-k] )*nf;
+	RR[NP+k] += ( - s[k]*b[NW-k] + s[NW-k]*b[k] )*nf;
+      }
+    }
+    for ( int k=0; k<NW; k++ )
+      s[k] += b[k];
+  }
+  TYP /= (double)nc;
+  TCP /= (double)nc;
+  Pairs += Trials;
+  Trials++;
+
+  bool last = ( NP == NW/2 );
+  if ( ! XFFT.empty() ) {
+    for ( int k=0; k<NP; k++ ) {
+      double cpow = TCP[k]*TCP[k] + TCP[NP+k]*TCP[NP+k];
+      double g = XP[k] == 0.0 ? 0.0 : ::sqrt( cpow ) / XP[k];
+      double c = XP[k] == 0.0 || TYP[k] == 0.0 ? 0.0 : cpow / ( XP[k]*TYP[k] );
+      if ( last && k == NP-1 )
+	cpow *= 0.25;
+      update( G, GSq, k, g );
+      update( C, CSq, k, c );
+      update( CPow, CPowSq, k, cpow );
+    }
+    if ( last )
+      TCP[NP-1] *= 0.25;
+    for ( int k=0; k<2*NP; k++ )
+      CP[k] += ( TCP[k] - CP[k] ) / Trials;
+  }
+  if ( last )
+    TYP[NP-1] *= 0.25;
+  for ( int k=0; k<NP; k++ )
+    update( YP, YPSq, k, TYP[k] );
+}
+
+
+void TrialSpectra::add( const EventList &events )
+{
+  for ( int i=0; i<events.size(); i++ )
+    add( events[i] );
+}
+
+
+void TrialSpectra::copy( const ArrayD &a, SampleDataD &s ) const
+{
+  s.resize( NP );
+  s = 0.0;
+  for ( int k=0; k<NP && k<a.size(); k++ )
+    s[k] = a[k];
+  s.setOffset( 0.0 );
+  s.setStepsize( DeltaF );
+}
+
+
+void TrialSpectra::sd( const ArrayD &mean, const ArrayD &sq, SampleDataD &s ) const
+{
+  s.resize( NP );
+  for ( int k=0; k<NP; k++ )
+    s[k] = ::sqrt( ::fabs( sq[k] - mean[k]*mean[k] ) );
+  s.setOffset( 0.0 );
+  s.setStepsize( DeltaF );
+}
+
+
+void TrialSpectra::powerSpectrum( SampleDataD &psd ) const
+{
+  copy( YP, psd );
+}
+
+
+void TrialSpectra::powerSpectrum( SampleDataD &psd, SampleDataD &sd ) const
+{
+  copy( YP, psd );
+  this->sd( YP, YPSq, sd );
+}
+
+
+void TrialSpectra::stimulusSpectrum( SampleDataD &ss ) const
+{
+  copy( XP, ss );
+  if ( NP > 0 && NP == NW/2 && ss.size() == NP )
+    ss[NP-1] *= 0.25;
+}
+
+
+void TrialSpectra::gain( SampleDataD &g, SampleDataD *sd ) const
+{
+  copy( G, g );
+  if ( sd != 0 )
+    this->sd( G, GSq, *sd );
+}
+
+
+void TrialSpectra::crossPower( SampleDataD &cp, SampleDataD *sd ) const
+{
+  copy( CPow, cp );
+  if ( sd != 0 )
+    this->sd( CPow, CPowSq, *sd );
+}
+
+
+void TrialSpectra::trialCoherence( SampleDataD &c, SampleDataD *sd ) const
+{
+  copy( C, c );
+  if ( sd != 0 )
+    this->sd( C, CSq, *sd );
+}
+
+
+void TrialSpectra::coherence( SampleDataD &c ) const
+{
+  c = 0.0;
+  c.setOffset( 0.0 );
+  c.setStepsize( DeltaF );
+  if ( Trials <= 0 || XFFT.empty() )
+    return;
+
+  // half-complex cross spectrum:
+  ArrayD cp( 2*NP, 0.0 );
+  cp[0] = CP[0];
+  for ( int k=1; k<NP; k++ ) {
+    cp[k] = CP[k];
+    cp[2*NP-k] = CP[NP+k];
+  }
+  ArrayD xp( XP );
+  if ( NP == NW/2 )
+    xp[NP-1] *= 0.25;
+  ::relacs::coherence( cp, xp, YP, c.array() );
+}
+
+
+void TrialSpectra::responseCoherence( SampleDataD &c ) const
+{
+  c = 0.0;
+  c.setOffset( 0.0 );
+  c.setStepsize( DeltaF );
+  if ( Pairs <= 0 )
+    return;
+
+  // half-complex cross spectrum averaged over pairs and chunks:
+  double n = Pairs*chunks();
+  ArrayD cp( 2*NP, 0.0 );
+  cp[0] = RR[0]/n;
+  for ( int k=1; k<NP; k++ ) {
+    cp[k] = RR[k]/n;
+    cp[2*NP-k] = RR[NP+k]/n;
+  }
+  if ( NP == NW/2 )
+    cp[NP-1] *= 0.25;
+  ::relacs::coherence( cp, YP, YP, c.array() );
+  for ( int k=0; k<c.size(); k++ )
+    c[k] = ::sqrt( c[k] );
+}
+
+
+}; /* namespace relacs */
+
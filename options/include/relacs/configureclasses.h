@@ -24,6 +24,7 @@
 
 #include <string>
 #include <vector>
+#include <relacs/strqueue.h>
 #include <relacs/configclass.h>
 using namespace std;
 
@@ -239,6 +240,30 @@ public:
         \sa save(), configure() */
   int read( void );
 
+    /*! The sections of a configuration file:
+        the identifier of each section together with its content. */
+  typedef vector< pair< string, StrQueue > > Sections;
+    /*! Parse the configuration file \a file into its \a sections
+        without passing them on to any ConfigClass instance.
+	Since no ConfigClass instances are accessed,
+	load() can be called from another thread
+	while the ConfigClass instances are still being created.
+        \param[in] file the file from which the configuration is read in.
+        \param[out] sections the sections of the configuration file.
+	\return the number of read in configuration files (0 or 1).
+        \sa read( int, Sections& ) */
+  static int load( const string &file, Sections &sections );
+    /*! Pass each of the \a sections of a configuration file
+        that were read in by load() to the corresponding ConfigClass instances
+	of the configuration group with index \a group
+	via ConfigClass::readConfig().
+	The ConfigClass instances may modify the content of the sections.
+        \param[in] group the configuration group index.
+        \param[in] sections the sections of a configuration file.
+	\return the number of sections passed on to a ConfigClass.
+        \sa load(), read( int, const string& ) */
+  int read( int group, Sections &sections );
+
     /*! Read in the configuration file of the configuration group as
         specified by config.configGroup() and the level \a level.
 	Pass the section for \a config to \a config
@@ -378,7 +403,7 @@ private:
 
     /*! Returns a string with the current time. 
         Used for log meassages by read() and save() */
-  string currentTime( void );
+  static string currentTime( void );
     /*! List of configuration file names for different
         groups and levels. */
   vector < vector < string > > ConfigFile;
@@ -21,6 +21,7 @@
 
 #include <ctime>
 #include <fstream>
+#include <map>
 #include <relacs/strqueue.h>
 #include <relacs/configureclasses.h>
 using namespace std;
@@ -163,6 +164,19 @@ void ConfigureClasses::clearConfigFiles( void )
 
 int ConfigureClasses::read( int group, const string &file )
 {
+  Sections sections;
+  if ( load( file, sections ) == 0 )
+    return 0;
+
+  read( group, sections );
+  return 1;
+}
+
+
+int ConfigureClasses::load( const string &file, Sections &sections )
+{
+  sections.clear();
+
   // open the requested configuration file:
   ifstream sf( file.c_str() );
   if ( ! sf.good() ) {
@@ -188,18 +202,11 @@ int ConfigureClasses::read( int group, const string &file )
   while ( sf.good() ) {
     string ident = line.strip().substr( 1 );
     // read in section:
-    StrQueue sq;
+    sections.push_back( make_pair( ident, StrQueue() ) );
+    StrQueue &sq = sections.back().second;
     line = "";
     sq.load( sf, "*", &line );
     sq.strip();
-    // pass this section to the corresponding ConfigClass instance:
-    for ( ConfigClassList::iterator cp = Configs.begin(); cp != Configs.end(); ++cp ) {
-      if ( (*cp)->configGroup() == group &&
-	   (*cp)->configIdent() == ident ) {
-	(*cp)->readConfig( sq );
-	break;
-      }
-    }
   }
 
   sf.close();
@@ -208,6 +215,29 @@ int ConfigureClasses::read( int group, const string &file )
 }
 
 
+int ConfigureClasses::read( int group, Sections &sections )
+{
+  // the first ConfigClass instance for each identifier:
+  map< string, ConfigClass* > configs;
+  for ( ConfigClassList::iterator cp = Configs.begin(); cp != Configs.end(); ++cp ) {
+    if ( (*cp)->configGroup() == group )
+      configs.insert( make_pair( (*cp)->configIdent(), *cp ) );
+  }
+
+  // pass each section to the corresponding ConfigClass instance:
+  int n = 0;
+  for ( Sections::iterator sp = sections.begin(); sp != sections.end(); ++sp ) {
+    map< string, ConfigClass* >::iterator cp = configs.find( sp->first );
+    if ( cp != configs.end() ) {
+      cp->second->readConfig( sp->second );
+      n++;
+    }
+  }
+
+  return n;
+}
+
+
 int ConfigureClasses::read( int group, int level )
 {
   if ( group < 0 || group >= (int)ConfigFile.size() ||
@@ -444,7 +474,8 @@ string ConfigureClasses::currentTime( void )
 {
   char s[200];
   time_t ct = time( NULL );
-  strftime( s, 200, "%H:%M:%S", localtime( &ct ) );
+  struct tm lt;
+  strftime( s, 200, "%H:%M:%S", localtime_r( &ct, &lt ) );
   return s;
 }
 
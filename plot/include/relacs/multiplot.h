@@ -137,6 +137,17 @@ public:
     /*! Draw the Plots. */
   void draw( void );
 
+    /*! If \a render is \c true, each Plot is rendered into an image
+        on a separate thread whenever draw() is called,
+	and paintEvent() only draws these images.
+	All plots share a single thread. Calling Plot::draw() of a single
+	Plot only renders this Plot.
+	\sa backgroundRendering(), Plot::setBackgroundRendering() */
+  void setBackgroundRendering( bool render=true );
+    /*! Returns \c true if the plots are rendered on a separate thread.
+        \sa setBackgroundRendering() */
+  bool backgroundRendering( void ) const;
+
     /*! To be called from a Plot to request to redraw the background. */
   void setDrawBackground( void );
 
@@ -219,6 +230,7 @@ private:
   QReadWriteLock *DRWMutex;
   QWaitCondition WaitGUI;
   QThread *GUIThread;
+  PlotRenderer *Renderer;
   bool Painting;
 
   int Columns;
@@ -29,12 +29,14 @@
 #include <deque>
 #include <map>
 #include <QWidget>
+#include <QImage>
 #include <QMutex>
 #include <QReadWriteLock>
 #include <QAction>
 #include <QMenu>
 #include <QPen>
 #include <QBrush>
+#include <QFont>
 #include <relacs/array.h>
 #include <relacs/map.h>
 #include <relacs/sampledata.h>
@@ -68,6 +70,7 @@ namespace relacs {
 
 
 class MultiPlot;
+class PlotRenderer;
 
 
 class Plot : public QWidget
@@ -75,6 +78,7 @@ class Plot : public QWidget
   Q_OBJECT
 
   friend class MultiPlot;
+  friend class PlotRenderer;
 
 public:
 
@@ -551,6 +555,20 @@ public:
         \sa setDataMutex() */
   bool noDataMutex( void ) const;
 
+    /*! If \a render is \c true, the plot is rendered into an image
+        on a separate thread whenever draw() is called.
+	The paintEvent() then only draws this image and the mouse overlay,
+	and does not block the GUI thread with drawing the data.
+	Paint events that do not follow a draw(), for example when
+	the widget is uncovered, just draw the image again.
+	For a Plot within a MultiPlot use
+	MultiPlot::setBackgroundRendering() instead.
+	\sa backgroundRendering() */
+  void setBackgroundRendering( bool render=true );
+    /*! Returns \c true if the plot is rendered on a separate thread.
+        \sa setBackgroundRendering() */
+  bool backgroundRendering( void ) const;
+
     /*! If this Plot is part of a MultiPlot, then this function specifies
         the position of the Plot within the MultiPlot.
         \param[in] x the x-coordinate of the lower-left corner
@@ -961,6 +979,27 @@ public:
 
   int plot( const SampleData<SampleDataD> &data, double xscale, int gradient=0 );
 
+    /*! Set up a scrolling waterfall surface that is built up column by column,
+        like for example a spectrogram.
+	Up to \a columns columns with \a rows z-values each are displayed.
+	The \a k-th column, counted from the oldest one,
+	covers the x-range from \a xoffset + \a k * \a xstep
+	to \a xoffset + (\a k + 1) * \a xstep,
+	and its \a j-th row covers the y-range from \a yoffset + \a j * \a ystep
+	to \a yoffset + (\a j + 1) * \a ystep.
+	The z-values are mapped onto the colors of \a gradient according to the z-range.
+	Add columns with addWaterfallColumn().
+	\return -1 if \a columns or \a rows are not positive. */
+  int setWaterfall( int columns, int rows, double xoffset, double xstep,
+		    double yoffset, double ystep, int gradient=0 );
+    /*! Append the z-values of \a column as the newest column to the waterfall surface
+        that was set up by setWaterfall(). If the waterfall surface is full,
+	the oldest column is dropped and all other columns scroll by one column.
+	Only the new column is converted into colors on the next draw(),
+	so drawing does not get slower with the number of columns.
+	\return -1 if no waterfall surface was set up. */
+  int addWaterfallColumn( const ArrayD &column );
+
 #ifdef HAVE_LIBRELACSSHAPES
     /*! Return the transformation matrix that defines the (perspective) projection
         onto the x-y plane. */
@@ -1156,6 +1195,15 @@ protected:
 
     /*! Redraws the plot widget. */
   void draw( QPaintDevice *qpm, bool drawdata );
+    /*! Renders the plot into an image.
+        This is called by the PlotRenderer from its thread.
+        \return \c false if the plot or its data could not be locked. */
+  bool render( void );
+    /*! \return \c true if the plot needs to be rendered again,
+        i.e. if its data or ranges changed since the last render().
+        If the plot or its data cannot be locked right away,
+        \c true is returned as well. */
+  bool changed( void );
     /*! Handles the resize event. */
   void resizeEvent( QResizeEvent *qre );
     /*! Paints the entire plot. */
@@ -1695,6 +1743,53 @@ private:
   };
 
 
+  class WaterfallSurfaceElement : public SurfaceElement
+  {
+    friend class Plot;
+
+  public:
+    WaterfallSurfaceElement( int columns, int rows, double xoffset, double xstep,
+			     double yoffset, double ystep );
+
+    virtual long firstX( double x1, double x2 ) const;
+    virtual long lastX( double x1, double x2 ) const;
+    virtual long firstY( double y1, double y2 ) const;
+    virtual long lastY( double y1, double y2 ) const;
+    virtual void point( long rindex, long cindex,
+			double &x1, double &y1, double &x2, double &y2,
+			double &z ) const;
+    virtual void xminmax( double &xmin, double &xmax, double ymin, double ymax ) const;
+    virtual void yminmax( double xmin, double xmax, double &ymin, double &ymax ) const;
+
+      /*! Append \a column as the newest column. */
+    void add( const ArrayD &column );
+      /*! The columns as a circular image buffer, with the colors
+	  of the columns added since the last call updated
+	  for the z-range \a zmin, \a zmax. */
+    const QImage &image( double zmin, double zmax );
+
+  protected:
+    int Columns;
+    int Rows;
+    double XOffset;
+    double XStep;
+    double YOffset;
+    double YStep;
+      /*! The z-values as a circular buffer of columns. */
+    vector< double > Z;
+      /*! Index of the oldest column in the circular buffers. */
+    int First;
+      /*! Number of columns. */
+    int Count;
+      /*! Number of newest columns that are not yet converted into colors. */
+    int Pending;
+    QImage Image;
+    double ImageZMin;
+    double ImageZMax;
+    int ImageGradient;
+  };
+
+
   SurfaceElement* SData;
   uchar* SurfaceData;
 #ifdef HAVE_LIBRELACSSHAPES
@@ -1717,10 +1812,27 @@ private:
   QMutex *DMutex;
   QReadWriteLock *DRWMutex;
   QThread *GUIThread;
-
+  PlotRenderer *Renderer;
+  bool OwnRenderer;
+  QImage RenderedImage;
+    /*! The font of the widget and its size in pixel as stored by
+        storeWidgetState() for drawing from the PlotRenderer thread. */
+  QFont PlotFont;
+  int PlotFontPixelSize;
+  int RenderedX;
+  int RenderedY;
+
+  void setRenderer( PlotRenderer *renderer );
+    /*! Stores the font and the background color of the widget,
+        so that render() does not access the widget.
+        Call this from the GUI thread with the plot locked.
+        \return \c true if the font or the background color changed. */
+  bool storeWidgetState( void );
   int addData( DataElement *d );
   int setSurface( SurfaceElement *s );
+  static const QVector<QRgb> &colorTable( int gradient );
   void drawSurface( QPainter &paint );
+  void drawWaterfall( QPainter &paint, WaterfallSurfaceElement *we );
 #ifdef HAVE_LIBRELACSSHAPES
   void drawPolygon( QPainter &paint, PolygonElement *d );
 #endif
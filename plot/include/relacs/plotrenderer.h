@@ -0,0 +1,93 @@
+/*
+  plotrenderer.h
+  Renders Plots into images on a separate thread.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_PLOTRENDERER_H_
+#define _RELACS_PLOTRENDERER_H_ 1
+
+#include <deque>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+using namespace std;
+
+namespace relacs {
+
+
+class Plot;
+
+
+/*!
+\class PlotRenderer
+\author Jan Benda
+\brief Renders Plots into images on a separate thread.
+
+Plots that are passed to render() are queued and rendered one after
+the other by calling Plot::render() from the thread of the PlotRenderer.
+A Plot that is already waiting in the queue is not queued twice.
+If Plot::render() could not obtain the locks of the plot and its data
+the Plot is queued again.
+
+A single PlotRenderer is shared by all Plots of a MultiPlot.
+\sa Plot::setBackgroundRendering(), MultiPlot::setBackgroundRendering()
+*/
+
+class PlotRenderer : public QThread
+{
+
+public:
+
+    /*! Constructs a PlotRenderer and starts its thread,
+        that waits for plots passed to render(). */
+  PlotRenderer( void );
+    /*! Stops the thread. */
+  ~PlotRenderer( void );
+
+    /*! Queue \a plot for rendering. */
+  void render( Plot *plot );
+    /*! Remove \a plot from the queue and wait until it is not rendered anymore.
+        Call this before destroying \a plot. */
+  void remove( Plot *plot );
+    /*! Stop the thread and wait for it to finish.
+        Plots passed to render() afterwards are ignored. */
+  void stop( void );
+
+
+protected:
+
+  virtual void run( void );
+
+
+private:
+
+  QMutex Mutex;
+  QWaitCondition Wake;
+  QWaitCondition Finished;
+  deque< Plot* > Queue;
+  Plot *Current;
+  bool Stop;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_PLOTRENDERER_H_ */
+
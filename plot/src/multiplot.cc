@@ -28,6 +28,7 @@
 #include <QEvent>
 #include <QMouseEvent>
 #include <relacs/str.h>
+#include <relacs/plotrenderer.h>
 #include <relacs/multiplot.h>
 
 namespace relacs {
@@ -95,6 +96,8 @@ MultiPlot::MultiPlot( QWidget *parent )
 MultiPlot::~MultiPlot( void )
 {
   clear();
+  if ( Renderer != 0 )
+    delete Renderer;
 }
 
 
@@ -111,6 +114,7 @@ void MultiPlot::construct( int plots, int columns, bool horizontal, Plot::KeepMo
 
   DMutex = 0;
   DRWMutex = 0;
+  Renderer = 0;
   Painting = false;
   
   for ( int k=0; k<plots; k++ ) {
@@ -228,6 +232,8 @@ void MultiPlot::doResize( int plots, Plot::KeepMode keep )
 	  PlotList.back()->setDataMutex( DMutex );
 	else if ( DRWMutex != 0 )
 	  PlotList.back()->setDataMutex( DRWMutex );
+	if ( Renderer != 0 )
+	  PlotList.back()->setRenderer( Renderer );
       }
       for ( unsigned int k=0; k<PlotList.size(); k++ ) {
 	PlotList[k]->resetRanges();
@@ -499,6 +505,26 @@ QSize MultiPlot::minimumSizeHint( void ) const
 
 void MultiPlot::draw( void )
 {
+  if ( Renderer != 0 ) {
+    // render only the plots whose data or ranges changed:
+    bool rendered = false;
+    for ( PlotListType::iterator p = PlotList.begin(); 
+	  p != PlotList.end(); 
+	  ++p ) {
+      if ( ! (**p).skip() && (**p).changed() ) {
+	Renderer->render( *p );
+	rendered = true;
+      }
+    }
+    // otherwise composite the rendered images:
+    if ( ! rendered ) {
+      if ( QThread::currentThread() != GUIThread )
+	QCoreApplication::postEvent( this, new MultiPlotEvent( 100 ) ); // update
+      else
+	update();
+    }
+    return;
+  }
   Painting = false;
   UpdatePlotList.clear();
   DrawData = true;
@@ -509,8 +535,57 @@ void MultiPlot::draw( void )
 }
 
 
+void MultiPlot::setBackgroundRendering( bool render )
+{
+  if ( render == ( Renderer != 0 ) )
+    return;
+  PlotRenderer *renderer = render ? new PlotRenderer : 0;
+  PMutex.lock();
+  for ( PlotListType::iterator p = PlotList.begin(); 
+	p != PlotList.end(); 
+	++p )
+    (**p).setRenderer( renderer );
+  PlotRenderer *prevrenderer = Renderer;
+  Renderer = renderer;
+  PMutex.unlock();
+  if ( prevrenderer != 0 )
+    delete prevrenderer;
+  draw();
+}
+
+
+bool MultiPlot::backgroundRendering( void ) const
+{
+  return ( Renderer != 0 );
+}
+
+
 void MultiPlot::paintEvent( QPaintEvent *qpe )
 {
+  if ( Renderer != 0 ) {
+    // only draw the images rendered by the renderer, this does not
+    // need the data.  Do not wait for the renderer, it posts an
+    // update when it finished rendering a plot:
+    if ( ! PMutex.tryLock( 5 ) )
+      return;
+    QPainter qp( this );
+    qp.eraseRect( rect() );
+    qp.end();
+    for ( PlotListType::iterator p = PlotList.begin(); 
+	  p != PlotList.end(); 
+	  ++p ) {
+      if ( ! (**p).skip() ) {
+	(**p).scale( width(), height() );
+	(**p).draw( this, DrawData );
+      }
+    }
+    UpdatePlotList.clear();
+    DrawBackground = false;
+    DrawData = false;
+    PMutex.unlock();
+    return;
+  }
+
   PMutex.lock();
   Painting = true;
   bool newlist = false;
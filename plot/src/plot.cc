@@ -22,7 +22,6 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
-#include <QBitmap>
 #include <QPainter>
 #include <QPainterPath>
 #include <QPolygon>
@@ -35,6 +34,7 @@
 #include <QActionGroup>
 #include <relacs/str.h>
 #include <relacs/multiplot.h>
+#include <relacs/plotrenderer.h>
 #include <relacs/plot.h>
 
 namespace relacs {
@@ -342,11 +342,18 @@ void Plot::construct( KeepMode keep, bool subwidget, int id, MultiPlot *mp )
 
   DMutex = 0;
   DRWMutex = 0;
+
+  Renderer = 0;
+  OwnRenderer = false;
+  RenderedX = 0;
+  RenderedY = 0;
+  storeWidgetState();
 }
 
 
 Plot::~Plot( void )
 {
+  setRenderer( 0 );
   clear();
   delete MouseZoom;
   delete MouseMove;
@@ -440,6 +447,38 @@ bool Plot::noDataMutex( void ) const
 }
 
 
+void Plot::setBackgroundRendering( bool render )
+{
+  if ( SubWidget || render == ( Renderer != 0 ) )
+    return;
+  setRenderer( render ? new PlotRenderer : 0 );
+  OwnRenderer = render;
+  draw();
+}
+
+
+bool Plot::backgroundRendering( void ) const
+{
+  return ( Renderer != 0 );
+}
+
+
+void Plot::setRenderer( PlotRenderer *renderer )
+{
+  if ( Renderer != 0 ) {
+    Renderer->remove( this );
+    if ( OwnRenderer )
+      delete Renderer;
+  }
+  PMutex.lock();
+  Renderer = renderer;
+  OwnRenderer = false;
+  RenderedImage = QImage();
+  NewData = true;
+  PMutex.unlock();
+}
+
+
 void Plot::setOrigin( double x, double y )
 {
   XOrigin = x;
@@ -1854,9 +1893,9 @@ void Plot::initTics( void )
 	}
       }
       if ( k == 1 )
-	Y2TicsMarg += 2 + (int)::ceil( fontMetrics().width( yticstr.c_str() ) * TicsLabelSize );
+	Y2TicsMarg += 2 + (int)::ceil( QFontMetrics( PlotFont ).width( yticstr.c_str() ) * TicsLabelSize );
       else
-	Y1TicsMarg += 2 + (int)::ceil( fontMetrics().width( yticstr.c_str() ) * TicsLabelSize );
+	Y1TicsMarg += 2 + (int)::ceil( QFontMetrics( PlotFont ).width( yticstr.c_str() ) * TicsLabelSize );
     }
 
     // x tic marks:
@@ -2246,6 +2285,8 @@ void Plot::drawTicMarks( QPainter &paint, int axis )
 
 void Plot::drawTicLabels( QPainter &paint, int axis )
 {
+  QFontMetrics fm( PlotFont );
+
   // x tic labels:
   if ( XTics[axis] && TicsLabelColor != Transparent ) {
     RGBColor c = color( TicsLabelColor );
@@ -2258,7 +2299,7 @@ void Plot::drawTicLabels( QPainter &paint, int axis )
       if ( ! XTicsFormat[axis].empty() ) {
 	QString xt;
 	xt.sprintf( XTicsFormat[axis].c_str(), x );
-	int w = fontMetrics().width( xt );
+	int w = fm.width( xt );
 	if ( axis == 1 )
 	  paint.drawText( xp-w/2, PlotY2-BorderStyle.width()-X2TicsLen-2, xt );
 	else
@@ -2279,7 +2320,7 @@ void Plot::drawTicLabels( QPainter &paint, int axis )
       if ( ! YTicsFormat[axis].empty() ) {
 	QString yt;
 	yt.sprintf( YTicsFormat[axis].c_str(), y );
-	int w = fontMetrics().width( yt );
+	int w = fm.width( yt );
 	int h = (int)::ceil( TicsLabelSize*FontHeight );
 	if ( axis == 1 )
 	  paint.drawText( PlotX2+BorderStyle.width()+Y2TicsLen+2, yp+h/2, yt );
@@ -2308,8 +2349,8 @@ void Plot::drawLabel( QPainter &paint, const Label &label )
     paint.save();
     paint.translate( xp, yp );
     paint.rotate( label.Angle );
-    QFont fnt( font() );
-    int newfontsize = (int)::ceil( fontInfo().pixelSize()*label.LSize );
+    QFont fnt( PlotFont );
+    int newfontsize = (int)::ceil( PlotFontPixelSize*label.LSize );
     if ( newfontsize < 5 )
       newfontsize = 5;
     fnt.setPixelSize( newfontsize );
@@ -2375,33 +2416,28 @@ void Plot::drawLabels( QPainter &paint )
 }
 
 
-void Plot::drawSurface( QPainter &paint )
+const QVector<QRgb> &Plot::colorTable( int gradient )
 {
-  if ( SData == 0 )
-    return;
+  static QMutex mutex;
+  static QVector<QRgb> colortables[BlueMagentaRedGradient+1];
 
-  // axis:
-  int xaxis = SData->XAxis;
-  int yaxis = SData->YAxis;
-    
-  // init data:
-  long fx = 0;
-  long lx = 0;
-  long fy = 0;
-  long ly = 0;
-  fx = SData->firstX( XMin[xaxis], XMax[xaxis] );
-  lx = SData->lastX( XMin[xaxis], XMax[xaxis] );
-  fy = SData->firstY( YMin[yaxis], YMax[yaxis] );
-  ly = SData->lastY( YMin[yaxis], YMax[yaxis] );
+  if ( gradient < GrayGradient || gradient > BlueMagentaRedGradient )
+    gradient = GrayGradient;
+
+  QMutexLocker locker( &mutex );
+  QVector<QRgb> &colortable = colortables[gradient];
+  if ( ! colortable.empty() )
+    return colortable;
 
   // gradient:
   vector<HSVGradientColor> hsvcolors;
-  switch ( SData->gradient() ) {
+  switch ( gradient ) {
   case BlueGreenRedGradient :
     hsvcolors.reserve( 3 );
     hsvcolors.push_back( HSVGradientColor( 240, 255, 255, 0.0 ) );
     hsvcolors.push_back( HSVGradientColor( 120, 255, 255, 0.5 ) );
     hsvcolors.push_back( HSVGradientColor( 0, 255, 255, 1.0 ) );
+    break;
   case BlackBlueGreenRedWhiteGradient :
     hsvcolors.reserve( 5 );
     hsvcolors.push_back( HSVGradientColor( 240, 255, 0, 0.0 ) );
@@ -2409,6 +2445,7 @@ void Plot::drawSurface( QPainter &paint )
     hsvcolors.push_back( HSVGradientColor( 120, 255, 255, 0.5 ) );
     hsvcolors.push_back( HSVGradientColor( 0, 255, 255, 0.95 ) );
     hsvcolors.push_back( HSVGradientColor( 0, 0, 255, 1.0 ) );
+    break;
   case BlackMagentaRedYellowWhiteGradient :
     hsvcolors.reserve( 5 );
     hsvcolors.push_back( HSVGradientColor( 300, 255, 0, 0.0 ) );
@@ -2416,27 +2453,31 @@ void Plot::drawSurface( QPainter &paint )
     hsvcolors.push_back( HSVGradientColor( 360, 255, 255, 0.5, false ) );
     hsvcolors.push_back( HSVGradientColor( 420, 255, 255, 0.95 ) );
     hsvcolors.push_back( HSVGradientColor( 420, 0, 255, 1.0 ) );
+    break;
   case BlueRedGradient :
     hsvcolors.reserve( 2 );
     hsvcolors.push_back( HSVGradientColor( 240, 255, 255, 0.0 ) );
     hsvcolors.push_back( HSVGradientColor( 360, 255, 255, 1.0, false ) );
+    break;
   case BlueMagentaRedGradient :
     hsvcolors.reserve( 2 );
     hsvcolors.push_back( HSVGradientColor( 240, 255, 255, 0.0 ) );
     hsvcolors.push_back( HSVGradientColor( 360, 255, 255, 1.0 ) );
+    break;
   case BlueRedYellowWhiteGradient :
     hsvcolors.reserve( 4 );
     hsvcolors.push_back( HSVGradientColor( 240, 255, 255, 0.0 ) );
     hsvcolors.push_back( HSVGradientColor( 360, 255, 255, 0.5, false ) );
     hsvcolors.push_back( HSVGradientColor( 420, 255, 255, 0.95 ) );
     hsvcolors.push_back( HSVGradientColor( 420, 0, 255, 1.0 ) );
+    break;
   default:
     hsvcolors.reserve( 2 );
     hsvcolors.push_back( HSVGradientColor( 0, 0, 0, 0.0 ) );
     hsvcolors.push_back( HSVGradientColor( 0, 0, 255, 1.0 ) );
   }
 
-  QVector<QRgb> colortable( 256 );
+  colortable.resize( 256 );
   int index = 0;
   int hsvinx = 0;
   for ( QVector<QRgb>::Iterator iter = colortable.begin();
@@ -2464,6 +2505,38 @@ void Plot::drawSurface( QPainter &paint )
     *iter = color.rgb();
   }
 
+  return colortable;
+}
+
+
+void Plot::drawSurface( QPainter &paint )
+{
+  if ( SData == 0 )
+    return;
+
+  WaterfallSurfaceElement *we = dynamic_cast<WaterfallSurfaceElement*>( SData );
+  if ( we != 0 ) {
+    drawWaterfall( paint, we );
+    return;
+  }
+
+  // axis:
+  int xaxis = SData->XAxis;
+  int yaxis = SData->YAxis;
+    
+  // init data:
+  long fx = 0;
+  long lx = 0;
+  long fy = 0;
+  long ly = 0;
+  fx = SData->firstX( XMin[xaxis], XMax[xaxis] );
+  lx = SData->lastX( XMin[xaxis], XMax[xaxis] );
+  fy = SData->firstY( YMin[yaxis], YMax[yaxis] );
+  ly = SData->lastY( YMin[yaxis], YMax[yaxis] );
+
+  // gradient:
+  const QVector<QRgb> &colortable = colorTable( SData->gradient() );
+
   // plot data:
   /*
   // this works for not evenly sampled surfaces (slow!):
@@ -2528,6 +2601,51 @@ void Plot::drawSurface( QPainter &paint )
 }
 
 
+void Plot::drawWaterfall( QPainter &paint, WaterfallSurfaceElement *we )
+{
+  // axis:
+  int xaxis = we->XAxis;
+  int yaxis = we->YAxis;
+
+  // range of columns and rows:
+  long fx = we->firstX( XMin[xaxis], XMax[xaxis] );
+  long lx = we->lastX( XMin[xaxis], XMax[xaxis] );
+  long fy = we->firstY( YMin[yaxis], YMax[yaxis] );
+  long ly = we->lastY( YMin[yaxis], YMax[yaxis] );
+  if ( lx <= fx || ly <= fy )
+    return;
+
+  // convert new columns:
+  const QImage &image = we->image( ZMin, ZMax );
+
+  // y-range:
+  double y1 = we->YOffset + fy*we->YStep;
+  double y2 = we->YOffset + ly*we->YStep;
+  int y1p = PlotY1 + (int)::rint( double(PlotY2-PlotY1)/(YMax[yaxis]-YMin[yaxis])*(y1-YMin[yaxis]) );
+  int y2p = PlotY1 + (int)::rint( double(PlotY2-PlotY1)/(YMax[yaxis]-YMin[yaxis])*(y2-YMin[yaxis]) );
+
+  paint.setClipping( true );
+  paint.setClipRegion( QRegion( PlotX1, PlotY2, PlotX2-PlotX1+1, PlotY1-PlotY2+1 ) );
+  // the columns are stored in a circular buffer,
+  // draw the part up to the end of the buffer and then the one from its beginning:
+  for ( long k=fx; k<lx; ) {
+    long j = ( we->First + k ) % we->Columns;
+    long n = lx - k;
+    if ( j + n > we->Columns )
+      n = we->Columns - j;
+    double x1 = we->XOffset + k*we->XStep;
+    double x2 = we->XOffset + (k+n)*we->XStep;
+    int x1p = PlotX1 + (int)::rint( double(PlotX2-PlotX1)/(XMax[xaxis]-XMin[xaxis])*(x1-XMin[xaxis]) );
+    int x2p = PlotX1 + (int)::rint( double(PlotX2-PlotX1)/(XMax[xaxis]-XMin[xaxis])*(x2-XMin[xaxis]) );
+    QRect source( j, we->Rows-ly, n, ly-fy );
+    QRect target( x1p, y2p, x2p-x1p+1, y1p-y2p+1 );
+    paint.drawImage( target, image, source );
+    k += n;
+  }
+  paint.setClipping( false );
+}
+
+
 #ifdef HAVE_LIBRELACSSHAPES
 
 void Plot::drawPolygon( QPainter &paint, PolygonElement *d )
@@ -2850,15 +2968,13 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
     if ( f >= l )
       return 0;
 
-    // single point pixmap:
+    // single point image:
     int offs = d->Point.size();
     if ( offs <= 0 )
       offs = 1;
-    QPixmap point( 2*offs, 2*offs );
+    QImage point( 2*offs, 2*offs, QImage::Format_ARGB32_Premultiplied );
+    point.fill( 0 );
     QPainter ppaint( &point );
-    QBitmap mask( 2*offs, 2*offs );
-    mask.fill( Qt::color0 );
-    QPainter mpaint( &mask );
 
     // set pen:
     if ( d->Point.color() != Transparent ) {
@@ -2866,12 +2982,10 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
       QColor qcolor( c.red(), c.green(), c.blue() );
       paint.setPen( QPen( qcolor, d->Line.width(), Qt::SolidLine ) );
       ppaint.setPen( QPen( qcolor, d->Line.width(), Qt::SolidLine ) );
-      mpaint.setPen( QPen( Qt::color1, d->Line.width(), Qt::SolidLine ) );
     }
     else {
       paint.setPen( QPen( Qt::black, 0, Qt::NoPen ) );
       ppaint.setPen( QPen( Qt::black, 0, Qt::NoPen ) );
-      mpaint.setPen( QPen( Qt::color0, 0, Qt::NoPen ) );
     }
     
     // set brush:
@@ -2880,12 +2994,10 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
       QColor qcolor( c.red(), c.green(), c.blue() );
       paint.setBrush( QBrush( qcolor ) );
       ppaint.setBrush( QBrush( qcolor ) );
-      mpaint.setBrush( QBrush( Qt::color1 ) );
     }
     else {
       paint.setBrush( QBrush( Qt::black, Qt::NoBrush ) );
       ppaint.setBrush( QBrush( Qt::black, Qt::NoBrush ) );
-      mpaint.setBrush( QBrush( Qt::color0 ) );
     }
 
     // draw Box:
@@ -2933,7 +3045,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
       case Circle: {
 	int r = (int)::rint( d->Point.size()*0.564 );
 	ppaint.drawEllipse( offs - r, offs - r, 2*r, 2*r );
-	mpaint.drawEllipse( offs - r, offs - r, 2*r, 2*r );
       }
 	break;
 
@@ -2941,8 +3052,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	int r = (int)::rint( d->Point.size()*0.564 );
 	ppaint.drawEllipse( offs - r, offs - r, 2*r, 2*r );
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawEllipse( offs - r, offs - r, 2*r, 2*r );
-	mpaint.drawPoint( offs, offs ); 
       }
 	break;
 
@@ -2954,7 +3063,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 2, offs + c, offs );
 	pa.setPoint( 3, offs, offs - c );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -2967,8 +3075,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 3, offs, offs - c );
 	ppaint.drawPolygon( pa );
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawPolygon( pa );
-	mpaint.drawPoint( offs, offs ); 
       }
 	break;
 
@@ -2976,8 +3082,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	int r = d->Point.size()/2;
 	ppaint.drawRect( offs - r, offs - r, 
 			 d->Point.size(), d->Point.size() );
-	mpaint.drawRect( offs - r, offs - r, 
-			 d->Point.size(), d->Point.size() );
       }
 	break;
 
@@ -2986,9 +3090,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	ppaint.drawRect( offs - r, offs - r, 
 			 d->Point.size(), d->Point.size() );
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawRect( offs - r, offs - r, 
-			 d->Point.size(), d->Point.size() );
-	mpaint.drawPoint( offs, offs ); 
       }
 	break;
 
@@ -3000,7 +3101,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs, offs - 2*c );
 	pa.setPoint( 2, offs + a, offs + c );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -3013,8 +3113,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 2, offs + a, offs + c );
 	ppaint.drawPolygon( pa );
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawPolygon( pa );
-	mpaint.drawPoint( offs, offs ); 
       }
 	break;
 
@@ -3026,7 +3124,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs, offs + 2*c );
 	pa.setPoint( 2, offs + a, offs - c );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -3039,8 +3136,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 2, offs + a, offs - c );
 	ppaint.drawPolygon( pa );
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawPolygon( pa );
-	mpaint.drawPoint( offs, offs ); 
       }
 	break;
 
@@ -3052,7 +3147,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs - 2*c, offs );
 	pa.setPoint( 2, offs + c, offs + a );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -3065,8 +3159,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 2, offs + c, offs + a );
 	ppaint.drawPolygon( pa );
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawPolygon( pa );
-	mpaint.drawPoint( offs, offs ); 
       }
 	break;
 
@@ -3078,7 +3170,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs + 2*c, offs );
 	pa.setPoint( 2, offs - c, offs + a );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -3091,8 +3182,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 2, offs - c, offs + a );
 	ppaint.drawPolygon( pa );
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawPolygon( pa );
-	mpaint.drawPoint( offs, offs ); 
       }
 	break;
 
@@ -3103,7 +3192,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs, offs + offs );
 	pa.setPoint( 2, offs + a, offs );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -3114,7 +3202,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs, offs - offs );
 	pa.setPoint( 2, offs + a, offs );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -3125,7 +3212,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs + offs, offs );
 	pa.setPoint( 2, offs, offs + a );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
@@ -3136,87 +3222,74 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	pa.setPoint( 1, offs - offs, offs );
 	pa.setPoint( 2, offs, offs + a );
 	ppaint.drawPolygon( pa );
-	mpaint.drawPolygon( pa );
       }
 	break;
 
       case CircleNorth: {
 	int r = (int)::rint( offs * 0.606 ); // *sqrt( 2 / pi / sqrt( 3 ) )
 	ppaint.drawPie( offs - r, offs - r, 2*r, 2*r, 16*180+1, 16*180-2 );
-	mpaint.drawPie( offs - r, offs - r, 2*r, 2*r, 16*180+1, 16*180-2 );
       }
 	break;
 
       case CircleSouth: {
 	int r = (int)::rint( offs * 0.606 ); // *sqrt( 2 / pi / sqrt( 3 ) )
 	ppaint.drawPie( offs - r, offs - r, 2*r, 2*r, 0, 16*180+1 );
-	mpaint.drawPie( offs - r, offs - r, 2*r, 2*r, 0, 16*180+1 );
       }
 	break;
 
       case CircleWest: {
 	int r = (int)::rint( offs * 0.606 ); // *sqrt( 2 / pi / sqrt( 3 ) )
 	ppaint.drawPie( offs - r, offs - r, 2*r, 2*r, -16*90, 16*180+1 );
-	mpaint.drawPie( offs - r, offs - r, 2*r, 2*r, -16*90, 16*180+1 );
       }
 	break;
 
       case CircleEast: {
 	int r = (int)::rint( offs * 0.606 ); // *sqrt( 2 / pi / sqrt( 3 ) )
 	ppaint.drawPie( offs - r, offs - r, 2*r, 2*r, 16*90, 16*180+1 );
-	mpaint.drawPie( offs - r, offs - r, 2*r, 2*r, 16*90, 16*180+1 );
       }
 	break;
 
       case SquareNorth: {
 	int r = (int)::rint( offs / sqrt( sqrt( 3.0 ) ) );
 	ppaint.drawRect( offs - r/2, offs, r, r );
-	mpaint.drawRect( offs - r/2, offs, r, r );
       }
 	break;
 
       case SquareSouth: {
 	int r = (int)::rint( offs / sqrt( sqrt( 3.0 ) ) );
 	ppaint.drawRect( offs - r/2, offs, r, -r );
-	mpaint.drawRect( offs - r/2, offs, r, -r );
       }
 	break;
 
       case SquareWest: {
 	int r = (int)::rint( offs / sqrt( sqrt( 3.0 ) ) );
 	ppaint.drawRect( offs, offs - r/2, r, r );
-	mpaint.drawRect( offs, offs - r/2, r, r );
       }
 	break;
 
       case SquareEast: {
 	int r = (int)::rint( offs / sqrt( sqrt( 3.0 ) ) );
 	ppaint.drawRect( 0, offs - r/2, r, r );
-	mpaint.drawRect( 0, offs - r/2, r, r );
       }
 	break;
 
       case Dot:
 	ppaint.drawPoint( offs, offs ); 
-	mpaint.drawPoint( offs, offs ); 
 	break;
 
       case StrokeUp:
 	ppaint.drawLine( offs, offs, offs, offs - d->Point.size() ); 
-	mpaint.drawLine( offs, offs, offs, offs - d->Point.size() ); 
 	break;
 
       case StrokeVertical: {
 	int r = d->Point.size()/2;
 	ppaint.drawLine( offs, offs - r, offs, offs + r ); 
-	mpaint.drawLine( offs, offs - r, offs, offs + r ); 
       }
 	break;
 
       case StrokeHorizontal: {
 	int r = d->Point.size()/2;
 	ppaint.drawLine( offs - r, offs, offs + r, offs ); 
-	mpaint.drawLine( offs - r, offs, offs + r, offs ); 
       }
 	break;
 
@@ -3224,8 +3297,6 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	cerr << "point type not supported!\n";
       }
       ppaint.end();
-      mpaint.end();
-      point.setMask( mask );
 
       // draw points:
       for ( long k=f; k<l; k++ ) {
@@ -3234,7 +3305,7 @@ int Plot::drawPoints( QPainter &paint, DataElement *d )
 	if ( XMin[xaxis] <= x && XMax[xaxis] >= x && YMin[yaxis] <= y && YMax[yaxis] >= y ) {
 	  int xp = PlotX1 + (int)::rint( double(PlotX2-PlotX1)/(XMax[xaxis]-XMin[xaxis])*(x-XMin[xaxis]) );
 	  int yp = PlotY1 + (int)::rint( double(PlotY2-PlotY1)/(YMax[yaxis]-YMin[yaxis])*(y-YMin[yaxis]) );
-	  paint.drawPixmap( xp-offs, yp-offs, point );
+	  paint.drawImage( xp-offs, yp-offs, point );
 	}
       }
 
@@ -3383,6 +3454,38 @@ void Plot::drawMouse( QPainter &paint )
 
 void Plot::draw( QPaintDevice *qpm, bool drawdata )
 {
+  if ( Renderer != 0 ) {
+    // only draw the image rendered by render() and the mouse overlay,
+    // this does not need the data:
+    if ( ! SubWidget ) {
+      if ( ! PMutex.tryLock( 5 ) ) {
+	// the plot is currently rendered,
+	// render() posts an update when it is done.
+	return;
+      }
+    }
+    else
+      PMutex.lock();
+    bool rerender = storeWidgetState();
+    QColor pbc = palette().color( QPalette::Window );
+    int w = ScreenX2 - ScreenX1 + 1;
+    int h = ScreenY1 - ScreenY2 + 1;
+    rerender = ( rerender || RenderedImage.isNull() ||
+		 RenderedX != ScreenX1 || RenderedY != ScreenY2 ||
+		 RenderedImage.width() != w || RenderedImage.height() != h );
+    QPainter paint( qpm );
+    if ( ! RenderedImage.isNull() )
+      paint.drawImage( RenderedX, RenderedY, RenderedImage );
+    else if ( ! SubWidget )
+      paint.fillRect( ScreenX1, ScreenY2, w, h, pbc );
+    drawMouse( paint );
+    PMutex.unlock();
+    // the size, the font, or the palette of the plot changed:
+    if ( rerender )
+      Renderer->render( this );
+    return;
+  }
+
   // the order of locking is important here!
   // if the data are not available there is no need to lock the plot.
   if ( ! SubWidget ) {
@@ -3393,10 +3496,10 @@ void Plot::draw( QPaintDevice *qpm, bool drawdata )
       return;
     }
   }
+
   PMutex.lock();
 
-  QColor pbc = palette().color( QPalette::Window );
-  Colors[WidgetBackground] = RGBColor( pbc.red(), pbc.green(), pbc.blue() );
+  storeWidgetState();
 
   init();
   initRange();
@@ -3512,8 +3615,135 @@ void Plot::draw( QPaintDevice *qpm, bool drawdata )
 }
 
 
+bool Plot::render( void )
+{
+  // the order of locking is the same as in draw( QPaintDevice*, bool )
+  // and MultiPlot::paintEvent().
+  // Do not block, since the GUI thread might wait for the renderer.
+  if ( ! tryLockData( 5 ) )
+    return false;
+  if ( SubWidget && MP != 0 && ! MP->tryLock( 5 ) ) {
+    unlockData();
+    return false;
+  }
+  if ( ! PMutex.tryLock( 5 ) ) {
+    if ( SubWidget && MP != 0 )
+      MP->unlock();
+    unlockData();
+    return false;
+  }
+
+  init();
+  initRange();
+  initTics();
+  initBorder();
+  initLines();
+
+  int w = ScreenX2 - ScreenX1 + 1;
+  int h = ScreenY1 - ScreenY2 + 1;
+  QImage image;
+  if ( w > 0 && h > 0 ) {
+    image = QImage( w, h, QImage::Format_ARGB32_Premultiplied );
+    if ( SubWidget )
+      image.fill( 0 );
+    else {
+      RGBColor c = color( WidgetBackground );
+      image.fill( qRgb( c.red(), c.green(), c.blue() ) );
+    }
+    // redraw everything:
+    NewData = true;
+    ShiftData = false;
+    QPainter paint( &image );
+    paint.setFont( PlotFont );
+    paint.translate( -ScreenX1, -ScreenY2 );
+    drawBorder( paint );
+    drawAxis( paint );
+    drawData( paint );
+    drawLabels( paint );
+  }
+
+  // remember current ranges:
+  for ( int k=0; k<MaxAxis; k++ ) {
+    XMinPrev[k] = XMin[k];
+    XMaxPrev[k] = XMax[k];
+    YMinPrev[k] = YMin[k];
+    YMaxPrev[k] = YMax[k];
+  }
+  // the image is up to date, see changed():
+  NewData = false;
+  DrawData = false;
+
+  RenderedImage = image;
+  RenderedX = ScreenX1;
+  RenderedY = ScreenY2;
+
+  PMutex.unlock();
+  if ( SubWidget && MP != 0 )
+    MP->unlock();
+  unlockData();
+
+  // request to draw the new image:
+  QObject *receiver = this;
+  if ( SubWidget && MP != 0 )
+    receiver = MP;
+  QCoreApplication::postEvent( receiver, new QEvent( QEvent::Type( QEvent::User+100 ) ) ); // update
+  return true;
+}
+
+
+bool Plot::changed( void )
+{
+  // the order of locking is the same as in render():
+  if ( ! tryLockData( 0 ) )
+    return true;
+  if ( ! PMutex.tryLock() ) {
+    unlockData();
+    return true;
+  }
+
+  bool changed = ( NewData || RenderedImage.isNull() );
+  if ( ! changed ) {
+    // init() sets NewData if the data changed:
+    init();
+    initRange();
+    changed = NewData;
+    for ( int k=0; k<MaxAxis && ! changed; k++ ) {
+      if ( XMin[k] != XMinPrev[k] || XMax[k] != XMaxPrev[k] ||
+	   YMin[k] != YMinPrev[k] || YMax[k] != YMaxPrev[k] )
+	changed = true;
+    }
+    // new data points within the ranges:
+    for ( LineDataType::iterator d = LineData.begin();
+	  d != LineData.end() && ! changed;
+	  ++d ) {
+      int xaxis = (*d)->XAxis;
+      int yaxis = (*d)->YAxis;
+      long l = (*d)->last( XMin[xaxis], YMin[yaxis], XMax[xaxis], YMax[yaxis] );
+      if ( l != (*d)->lineIndex() && l != (*d)->pointIndex() )
+	changed = true;
+    }
+  }
+
+  PMutex.unlock();
+  unlockData();
+  return changed;
+}
+
+
 void Plot::draw( void )
 {
+  if ( Renderer != 0 ) {
+    if ( changed() )
+      Renderer->render( this );
+    else {
+      // composite the rendered image:
+      if ( QThread::currentThread() != GUIThread )
+	QCoreApplication::postEvent( this, new QEvent( QEvent::Type( QEvent::User+100 ) ) ); // update
+      else
+	update();
+    }
+    return;
+  }
   if ( SubWidget ) {
     if ( MP != 0 )
       MP->draw();
@@ -3528,6 +3758,18 @@ void Plot::draw( void )
 }
 
 
+bool Plot::storeWidgetState( void )
+{
+  QColor pbc = palette().color( QPalette::Window );
+  RGBColor bc( pbc.red(), pbc.green(), pbc.blue() );
+  bool changed = ( PlotFont != font() || ! ( Colors[WidgetBackground] == bc ) );
+  PlotFont = font();
+  PlotFontPixelSize = fontInfo().pixelSize();
+  Colors[WidgetBackground] = bc;
+  return changed;
+}
+
+
 void Plot::paintEvent( QPaintEvent *qpe )
 {
   if ( !SubWidget )
@@ -5394,6 +5636,182 @@ int Plot::plot( const SampleData<SampleDataD> &data, double xscale, int gradient
 }
 
 
+Plot::WaterfallSurfaceElement::WaterfallSurfaceElement( int columns, int rows,
+							double xoffset, double xstep,
+							double yoffset, double ystep )
+  : SurfaceElement(),
+    Columns( columns ),
+    Rows( rows ),
+    XOffset( xoffset ),
+    XStep( xstep ),
+    YOffset( yoffset ),
+    YStep( ystep ),
+    Z( columns*rows, 0.0 ),
+    First( 0 ),
+    Count( 0 ),
+    Pending( 0 ),
+    ImageZMin( 0.0 ),
+    ImageZMax( 0.0 ),
+    ImageGradient( -1 )
+{
+}
+
+
+long Plot::WaterfallSurfaceElement::firstX( double x1, double x2 ) const
+{
+  long i = long( ::floor( (x1 - XOffset)/XStep ) );
+  if ( i<0 )
+    i=0;
+  if ( i > Count )
+    i = Count;
+  return i;
+}
+
+
+long Plot::WaterfallSurfaceElement::lastX( double x1, double x2 ) const
+{
+  long i = long( ::ceil( (x2 - XOffset)/XStep ) ) + 1;
+  if ( i<0 )
+    i=0;
+  if ( i > Count )
+    i = Count;
+  return i;
+}
+
+
+long Plot::WaterfallSurfaceElement::firstY( double y1, double y2 ) const
+{
+  long i = long( ::floor( (y1 - YOffset)/YStep ) );
+  if ( i<0 )
+    i=0;
+  if ( i > Rows )
+    i = Rows;
+  return i;
+}
+
+
+long Plot::WaterfallSurfaceElement::lastY( double y1, double y2 ) const
+{
+  long i = long( ::ceil( (y2 - YOffset)/YStep ) ) + 1;
+  if ( i<0 )
+    i=0;
+  if ( i > Rows )
+    i = Rows;
+  return i;
+}
+
+
+void Plot::WaterfallSurfaceElement::point( long rindex, long cindex,
+					   double &x1, double &y1, double &x2, double &y2,
+					   double &z ) const
+{
+  x1 = XOffset + rindex*XStep;
+  y1 = YOffset + cindex*YStep;
+  x2 = XOffset + (rindex+1)*XStep;
+  y2 = YOffset + (cindex+1)*YStep;
+  z = Z[ ( ( First + rindex ) % Columns )*Rows + cindex ];
+}
+
+
+void Plot::WaterfallSurfaceElement::xminmax( double &xmin, double &xmax, 
+					     double ymin, double ymax ) const
+{
+  xmin = XOffset;
+  xmax = XOffset + Columns*XStep;
+}
+
+
+void Plot::WaterfallSurfaceElement::yminmax( double xmin, double xmax, 
+					     double &ymin, double &ymax ) const
+{
+  ymin = YOffset;
+  ymax = YOffset + Rows*YStep;
+}
+
+
+void Plot::WaterfallSurfaceElement::add( const ArrayD &column )
+{
+  int j = 0;
+  if ( Count < Columns ) {
+    j = ( First + Count ) % Columns;
+    Count++;
+  }
+  else {
+    j = First;
+    First = ( First + 1 ) % Columns;
+  }
+  double *z = &Z[j*Rows];
+  int n = column.size() < Rows ? column.size() : Rows;
+  for ( int c=0; c<n; c++ )
+    z[c] = column[c];
+  for ( int c=n; c<Rows; c++ )
+    z[c] = 0.0;
+  if ( Pending < Count )
+    Pending++;
+}
+
+
+const QImage &Plot::WaterfallSurfaceElement::image( double zmin, double zmax )
+{
+  if ( Image.isNull() ) {
+    Image = QImage( Columns, Rows, QImage::Format_Indexed8 );
+    ImageGradient = -1;
+    Pending = Count;
+  }
+  if ( ImageGradient != GradientIndex ) {
+    Image.setColorTable( Plot::colorTable( GradientIndex ) );
+    ImageGradient = GradientIndex;
+  }
+  if ( zmin != ImageZMin || zmax != ImageZMax ) {
+    ImageZMin = zmin;
+    ImageZMax = zmax;
+    Pending = Count;
+  }
+
+  // convert the new columns into color indices:
+  uchar *bits = Image.bits();
+  int bpl = Image.bytesPerLine();
+  for ( int k=Count-Pending; k<Count; k++ ) {
+    int j = ( First + k ) % Columns;
+    const double *z = &Z[j*Rows];
+    for ( int c=0; c<Rows; c++ ) {
+      double zfrac = ( z[c] - zmin )/( zmax - zmin );
+      if ( zfrac < 0.0 )
+	zfrac = 0.0;
+      else if ( zfrac > 1.0 )
+	zfrac = 1.0;
+      bits[(Rows-c-1)*bpl+j] = (uchar)::round( 255*zfrac );
+    }
+  }
+  Pending = 0;
+
+  return Image;
+}
+
+
+int Plot::setWaterfall( int columns, int rows, double xoffset, double xstep,
+			double yoffset, double ystep, int gradient )
+{
+  if ( columns <= 0 || rows <= 0 )
+    return -1;
+  WaterfallSurfaceElement *WE = new WaterfallSurfaceElement( columns, rows, xoffset, xstep,
+							     yoffset, ystep );
+  WE->setGradient( gradient );
+  return setSurface( WE );
+}
+
+
+int Plot::addWaterfallColumn( const ArrayD &column )
+{
+  WaterfallSurfaceElement *WE = dynamic_cast<WaterfallSurfaceElement*>( SData );
+  if ( WE == 0 )
+    return -1;
+  WE->add( column );
+  NewData = true;
+  return 0;
+}
+
+
 #ifdef HAVE_LIBRELACSSHAPES
 
 Plot::PolygonElement::PolygonElement( const vector<double> &x, const vector<double> &y,
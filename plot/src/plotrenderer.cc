@@ -0,0 +1,108 @@
+/*
+  plotrenderer.cc
+  Renders Plots into images on a separate thread.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <relacs/plot.h>
+#include <relacs/plotrenderer.h>
+
+namespace relacs {
+
+
+PlotRenderer::PlotRenderer( void )
+  : QThread(),
+    Current( 0 ),
+    Stop( false )
+{
+  start();
+}
+
+
+PlotRenderer::~PlotRenderer( void )
+{
+  stop();
+}
+
+
+void PlotRenderer::render( Plot *plot )
+{
+  Mutex.lock();
+  if ( ! Stop && find( Queue.begin(), Queue.end(), plot ) == Queue.end() ) {
+    Queue.push_back( plot );
+    Wake.wakeAll();
+  }
+  Mutex.unlock();
+}
+
+
+void PlotRenderer::remove( Plot *plot )
+{
+  Mutex.lock();
+  while ( Current == plot )
+    Finished.wait( &Mutex );
+  Queue.erase( std::remove( Queue.begin(), Queue.end(), plot ), Queue.end() );
+  Mutex.unlock();
+}
+
+
+void PlotRenderer::stop( void )
+{
+  Mutex.lock();
+  Stop = true;
+  Queue.clear();
+  Wake.wakeAll();
+  Mutex.unlock();
+  wait();
+}
+
+
+void PlotRenderer::run( void )
+{
+  Mutex.lock();
+  while ( ! Stop ) {
+    if ( Queue.empty() ) {
+      Wake.wait( &Mutex );
+      continue;
+    }
+    Current = Queue.front();
+    Queue.pop_front();
+    Mutex.unlock();
+
+    bool rendered = Current->render();
+
+    Mutex.lock();
+    if ( ! rendered &&
+	 find( Queue.begin(), Queue.end(), Current ) == Queue.end() )
+      Queue.push_back( Current );
+    Current = 0;
+    Finished.wakeAll();
+    if ( ! rendered ) {
+      // give the threads holding the locks a chance:
+      Mutex.unlock();
+      msleep( 2 );
+      Mutex.lock();
+    }
+  }
+  Mutex.unlock();
+}
+
+
+}; /* namespace relacs */
+
@@ -23,6 +23,7 @@
 #define _RELACS_BASE_TRANSFERFUNCTION_H_ 1
 
 #include <relacs/multiplot.h>
+#include <relacs/transferspectra.h>
 #include <relacs/repro.h>
 using namespace relacs;
 
@@ -33,7 +34,7 @@ namespace base {
 \class TransferFunction
 \brief [RePro] Measures the transfer function with band-limited Gaussian white-noise stimuli.
 \author Jan Benda
-\version 1.8 (Jul 11, 2016)
+\version 1.9 (Oct 19, 2026)
 \par Screenshot
 \image html transferfunction.png
 
@@ -75,8 +76,7 @@ public:
 
 protected:
 
-  void analyze( const SampleDataF &input, const SampleDataF &output,
-		double duration, int count );
+  void analyze( const SampleDataF &input, const SampleDataF &output );
   void openTraceFile( ofstream &tf, TableKey &tracekey, const Options &header );
   void saveTrace( ofstream &tf, TableKey &tracekey, int index,
 		  const SampleDataF &input, const SampleDataF &output );
@@ -91,16 +91,15 @@ protected:
   string OutName;
   string OutUnit;
 
+  TransferSpectra Spectra;
+
   SampleDataD MeanGain;
-  SampleDataD SquareGain;
   SampleDataD StdevGain;
 
   SampleDataD MeanPhase;
-  SampleDataD SquarePhase;
   SampleDataD StdevPhase;
 
   SampleDataD MeanCoherence;
-  SampleDataD SquareCoherence;
   SampleDataD StdevCoherence;
 
   MultiPlot P;
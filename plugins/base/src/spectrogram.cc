@@ -108,12 +108,17 @@ int Spectrogram::main( void )
   //  P.setXFallBackRange( 0.0, 10.0 );
   //  P.setYFallBackRange( 0.0, 1.0 );
   P.setZRange( 0.0, 1.0 );
+  P.clear();
   P.unlock();
 
   // data:
   const InData &data = trace( intrace );
   int lastindex = data.size();
-  SampleData< SampleDataD > spectrogram( 0, 0.0, step );
+  SampleDataD spec( specsize );
+  int columns = (int)::floor( tmax/step + 1.0e-6 );
+  if ( columns < 1 )
+    columns = 1;
+  bool waterfall = false;
 
   // don't print repro message:
   noMessage();
@@ -135,8 +140,6 @@ int Spectrogram::main( void )
       for ( int k=0; k<d.size(); k++ )
 	d[k] = data[ lastindex+k ];
       d -= mean( d );
-      spectrogram.push( SampleDataD( specsize ) );
-      SampleDataD &spec = spectrogram.back();
       rPSD( d, spec, overlap, window );
       if ( powermax )
 	spec.decibel();
@@ -145,16 +148,19 @@ int Spectrogram::main( void )
       for ( int k=0; k<spec.size(); k++ )
 	spec[k] = ( spec[k] - pmin )/::fabs(pmax-pmin);
       lastindex += data.indices( step );
+      // add the new spectrum as a column to the waterfall plot:
+      P.lock();
+      if ( ! waterfall ) {
+	P.setWaterfall( columns, spec.size(), 0.0, step, spec.offset(), spec.stepsize(),
+			Plot::BlackMagentaRedYellowWhiteGradient );
+	waterfall = true;
+      }
+      P.addWaterfallColumn( spec );
+      P.unlock();
     }
-    // clip data:
-    while ( spectrogram.length() > tmax )
-      spectrogram.erase( 0 );
 
     // plot:
     P.lock();
-    P.clear();
-    //    P.plot( spectrogram, 1.0, Plot::BlackBlueGreenRedWhiteGradient );
-    P.plot( spectrogram, 1.0, Plot::BlackMagentaRedYellowWhiteGradient );
     P.draw();
     P.unlock();
   }
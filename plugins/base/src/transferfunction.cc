@@ -27,7 +27,7 @@ namespace base {
 
 
 TransferFunction::TransferFunction( void )
-  : RePro( "TransferFunction", "base", "Jan Benda", "1.8", "Jul 11, 2016" )
+  : RePro( "TransferFunction", "base", "Jan Benda", "1.9", "Oct 19, 2026" )
 {
   // options:
   newSection( "Stimulus" );
@@ -164,14 +164,12 @@ int TransferFunction::main( void )
     return Failed;
   }
 
+  Spectra.init( SpecSize/2, trace( intrace ).stepsize(), Overlap, Window );
   MeanGain.clear();
-  SquareGain.clear();
   StdevGain.clear();
   MeanPhase.clear();
-  SquarePhase.clear();
   StdevPhase.clear();
   MeanCoherence.clear();
-  SquareCoherence.clear();
   StdevCoherence.clear();
 
   // don't print repro message:
@@ -258,7 +256,7 @@ int TransferFunction::main( void )
     SampleDataF output( 0.0, signal.length(), trace( intrace ).stepsize() );
     trace( intrace ).copy( signalTime(), output );
 
-    analyze( input, output, signal.length(), count );
+    analyze( input, output );
 
     // plot gain:
     bool plotstdevs = boolean( "plotstdevs" );
@@ -329,8 +327,11 @@ int TransferFunction::main( void )
 
   }
 
-  if ( state == Completed )
+  if ( state == Completed ) {
+    header.addNumber( "CoherenceInfo", Spectra.coherenceInfo( fmin, fmax ),
+		      "bits/s", "%0.1f" );
     saveData( header );
+  }
 
   directWrite( orgdcsignal );
 
@@ -338,8 +339,7 @@ int TransferFunction::main( void )
 }
 
 
-void TransferFunction::analyze( const SampleDataF &input, const SampleDataF &output,
-				double duration, int count )
+void TransferFunction::analyze( const SampleDataF &input, const SampleDataF &output )
 {
   // de-mean:
   SampleDataD x( input );
@@ -348,49 +348,13 @@ void TransferFunction::analyze( const SampleDataF &input, const SampleDataF &out
   SampleDataD y( output );
   y -= mean( y );
 
-  // transfer fucntion:
-  SampleDataD trans( SpecSize );
-  SampleDataD cohere( SpecSize/2 );
-  transfer( x, y, trans, cohere, Overlap, Window );
-
-  // gain and phase:
-  SampleDataD gain( trans.size()/2 );
-  SampleDataD phase( trans.size()/2 );
-  hcMagnitude( trans, gain );
-  hcPhase( trans, phase );
-
-  // average:
-  if ( count <= 0 ) {
-    MeanGain = gain;
-    SquareGain = gain*gain;
-    StdevGain = gain;  // setting the right range
-    StdevGain = 0.0;
-    MeanPhase = phase;
-    SquarePhase = phase*phase;
-    StdevPhase = phase;  // setting the right range
-    StdevPhase = 0.0;
-    MeanCoherence = cohere;
-    SquareCoherence = cohere*cohere;
-    StdevCoherence = cohere;  // setting the right range
-    StdevCoherence = 0.0;
-  }
-  else {
-    for ( int k=0; k<gain.size(); k++ ) {
-      double g = gain[k];
-      MeanGain[k] += (g - MeanGain[k])/(count+1);
-      SquareGain[k] += (g*g - SquareGain[k])/(count+1);
-      StdevGain[k] = sqrt( fabs( SquareGain[k] - MeanGain[k]*MeanGain[k] ) );
-      double p = phase[k];
-      MeanPhase[k] += (p - MeanPhase[k])/(count+1);
-      SquarePhase[k] += (p*p - SquarePhase[k])/(count+1);
-      StdevPhase[k] = sqrt( fabs( SquarePhase[k] - MeanPhase[k]*MeanPhase[k] ) );
-
-      double c = cohere[k];
-      MeanCoherence[k] += (c - MeanCoherence[k])/(count+1);
-      SquareCoherence[k] += (c*c - SquareCoherence[k])/(count+1);
-      StdevCoherence[k] = sqrt( fabs( SquareCoherence[k] - MeanCoherence[k]*MeanCoherence[k] ) );
-    }
-  }
+  // add spectra of the new segment:
+  Spectra.add( x, y );
+
+  // gain, phase, and coherence from all segments:
+  Spectra.gain( MeanGain, &StdevGain );
+  Spectra.phase( MeanPhase, &StdevPhase );
+  Spectra.coherence( MeanCoherence, &StdevCoherence );
 }
 
 
@@ -0,0 +1,123 @@
+/*
+  calibration/closedlooplatency.h
+  Measures the latency of a closed loop from input via detection to output
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_CALIBRATION_CLOSEDLOOPLATENCY_H_
+#define _RELACS_CALIBRATION_CLOSEDLOOPLATENCY_H_ 1
+
+#include <relacs/array.h>
+#include <relacs/plot.h>
+#include <relacs/repro.h>
+using namespace relacs;
+
+namespace calibration {
+
+
+/*!
+\class ClosedLoopLatency
+\brief [RePro] Measures the latency of a closed loop from input via detection to output
+\author Jan Benda
+\version 1.0 (Oct 18, 2026)
+
+A trigger pulse is written to the output trace. As soon as the
+RePro detects the trigger pulse in the input trace it immediately
+writes a response pulse of twice the amplitude via directWrite().
+The trigger pulse is detected at \c threshold above the baseline,
+the response pulse at \c threshold plus \c amplitude above the baseline.
+From the times the two pulses appear in the input trace and the time
+of the detection the following latencies are computed:
+- \c input: the time from the appearance of the trigger pulse in the input
+  until the RePro sees the data (determined by the update interval
+  of the data acquisition and the processing of the data).
+- \c output: the time from the detection until the response pulse appears
+  in the input.
+- \c loop: the total time from the trigger pulse to the response pulse,
+  i.e. the latency of a closed loop.
+
+All times are measured in the time base of the input trace.
+Run this RePro for different settings of the data acquisition
+(e.g. \c updateinterval of AISim or buffer times of the DAQ boards)
+to find the settings with the lowest latency. The results of
+each run, together with the measured update interval, are appended
+to the file \c closedlooplatency.dat.
+
+\par Options
+- \c intrace=V-1: Input trace (\c string)
+- \c outtrace=V-1: Output trace (\c string)
+- \c intensity=1: Intensity for an attenuator (\c number)
+- \c amplitude=1: Amplitude of trigger pulse (\c number)
+- \c duration=2ms: Duration of pulses (\c number)
+- \c threshold=0.5: Detection threshold relative to baseline (\c number)
+- \c timeout=1000ms: Maximum time to wait for a pulse (\c number)
+- \c pause=50ms: Pause between trials (\c number)
+- \c repeats=100: Repeats (\c integer)
+
+\par Files
+\arg \c closedlooplatency.dat : summary statistics of the latencies of each run.
+
+\par Plots
+\arg Histograms of the input (green), output (blue) and loop (red) latencies.
+
+\par Requirements
+\arg The output must be connected to the input.
+In simulation mode, set the \c loopbackin and \c loopbackout options of AISim
+to the channels of the input and output trace.
+*/
+
+
+class ClosedLoopLatency : public RePro
+{
+  Q_OBJECT
+
+public:
+
+  ClosedLoopLatency( void );
+  virtual void preConfig( void );
+  virtual int main( void );
+
+
+protected:
+
+    /*! Wait until \a data contain a crossing of \a threshold
+        (upwards if \a up is \c true, otherwise downwards)
+        after index \a index, but at most until \a tmax.
+        \a index is set to the first sample beyond the crossing.
+        \return the index of the crossing, -1 on timeout,
+        or -2 if the RePro was interrupted. */
+  int waitForCrossing( const InData &data, int &index, double threshold,
+		       bool up, double tmax );
+  void plot( void );
+  void save( void );
+
+  ArrayD InputLatencies;
+  ArrayD OutputLatencies;
+  ArrayD LoopLatencies;
+  ArrayD UpdateIntervals;
+  double LastUpdate;
+  int Misses;
+
+  Plot P;
+
+};
+
+
+}; /* namespace calibration */
+
+#endif /* ! _RELACS_CALIBRATION_CLOSEDLOOPLATENCY_H_ */
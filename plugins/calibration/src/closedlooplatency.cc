@@ -0,0 +1,292 @@
+/*
+  calibration/closedlooplatency.cc
+  Measures the latency of a closed loop from input via detection to output
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+#include <relacs/stats.h>
+#include <relacs/sampledata.h>
+#include <relacs/tablekey.h>
+#include <relacs/calibration/closedlooplatency.h>
+using namespace relacs;
+
+namespace calibration {
+
+
+ClosedLoopLatency::ClosedLoopLatency( void )
+  : RePro( "ClosedLoopLatency", "calibration", "Jan Benda", "1.0", "Oct 18, 2026" )
+{
+  // add some options:
+  addSelection( "intrace", "Input trace", "V-1" );
+  addSelection( "outtrace", "Output trace", "V-1" );
+  addNumber( "intensity", "Intensity for an attenuator", 1.0, -10000.0, 10000.0, 0.1, "", "" );
+  addNumber( "amplitude", "Amplitude of trigger pulse", 1.0, 0.0, 10000.0, 0.1, "", "" );
+  addNumber( "duration", "Duration of pulses", 0.002, 0.0001, 1.0, 0.001, "sec", "ms" );
+  addNumber( "threshold", "Detection threshold relative to baseline", 0.5, 0.0, 10000.0, 0.1, "", "" );
+  addNumber( "timeout", "Maximum time to wait for a pulse", 1.0, 0.01, 100.0, 0.01, "sec", "ms" );
+  addNumber( "pause", "Pause between trials", 0.05, 0.001, 10.0, 0.001, "sec", "ms" );
+  addInteger( "repeats", "Repeats", 100, 0, 100000, 1 ).setStyle( OptWidget::SpecialInfinite );
+
+  // plot:
+  P.lock();
+  P.setXLabel( "Latency [ms]" );
+  P.setYLabel( "Count" );
+  P.unlock();
+  setWidget( &P );
+}
+
+
+void ClosedLoopLatency::preConfig( void )
+{
+  setText( "intrace", traceNames() );
+  setToDefault( "intrace" );
+  setText( "outtrace", outTraceNames() );
+  setToDefault( "outtrace" );
+}
+
+
+int ClosedLoopLatency::main( void )
+{
+  // get options:
+  int intrace = index( "intrace" );
+  int outtrace = index( "outtrace" );
+  double intensity = number( "intensity" );
+  double amplitude = number( "amplitude" );
+  double duration = number( "duration" );
+  double threshold = number( "threshold" );
+  double timeout = number( "timeout" );
+  double pause = number( "pause" );
+  int repeats = integer( "repeats" );
+
+  // don't print repro message:
+  noMessage();
+
+  // trigger and response pulse:
+  OutData trigger;
+  trigger.setTrace( outtrace );
+  trigger.pulseWave( duration, -1.0, amplitude, 0.0 );
+  trigger.setIntensity( intensity );
+  trigger.setPriority();
+  trigger.setIdent( "trigger" );
+  OutData response;
+  response.setTrace( outtrace );
+  response.pulseWave( duration, -1.0, 2.0*amplitude, 0.0 );
+  response.setIntensity( intensity );
+  response.setPriority();
+  response.setIdent( "response" );
+
+  InputLatencies.clear();
+  OutputLatencies.clear();
+  LoopLatencies.clear();
+  UpdateIntervals.clear();
+  LastUpdate = -1.0;
+  Misses = 0;
+
+  const InData &data = trace( intrace );
+  if ( sleep( pause ) )
+    return Aborted;
+
+  for ( int count=0;
+	( repeats <= 0 || count < repeats ) && softStop() == 0;
+	count++ ) {
+
+    // baseline:
+    double baseline = data.mean( currentTime() - pause, currentTime() );
+    int inx = data.size();
+
+    // trigger pulse:
+    directWrite( trigger );
+    if ( trigger.failed() ) {
+      warning( trigger.errorText() );
+      return Failed;
+    }
+
+    // detect trigger pulse:
+    int k = waitForCrossing( data, inx, baseline+threshold, true,
+			     currentTime() + timeout );
+    if ( k == -2 )
+      break;
+    double tdetect = currentTime();
+    if ( k >= 0 ) {
+      // respond as fast as possible:
+      directWrite( response );
+      if ( response.failed() ) {
+	warning( response.errorText() );
+	return Failed;
+      }
+    }
+    if ( k < 0 ) {
+      Misses++;
+      if ( Misses > 3 && Misses > count/2 ) {
+	warning( "Trigger pulse not detected in input trace <b>" + data.ident()
+		 + "</b>.<br> Check the loopback and the threshold." );
+	return Failed;
+      }
+      if ( sleep( pause ) )
+	break;
+      continue;
+    }
+    double tinput = data.pos( k );
+
+    // detect response pulse, which is higher than the trigger pulse by amplitude:
+    k = waitForCrossing( data, inx, baseline+threshold+amplitude, true,
+			 tdetect + timeout );
+    if ( k == -2 )
+      break;
+    if ( k < 0 ) {
+      Misses++;
+      if ( sleep( pause ) )
+	break;
+      continue;
+    }
+    double tresponse = data.pos( k );
+
+    InputLatencies.push( tdetect - tinput );
+    OutputLatencies.push( tresponse - tdetect );
+    LoopLatencies.push( tresponse - tinput );
+
+    if ( LoopLatencies.size() % 10 == 0 ) {
+      message( "Loop latency: mean=<b>" + Str( 1000.0*mean( LoopLatencies ), 0, 2, 'f' ) +
+	       " ms</b>, maximum=<b>" + Str( 1000.0*max( LoopLatencies ), 0, 2, 'f' ) +
+	       " ms</b>, n=<b>" + Str( LoopLatencies.size() ) + "</b>" );
+      plot();
+    }
+
+    if ( sleep( pause ) )
+      break;
+  }
+
+  if ( LoopLatencies.size() < 2 )
+    return Aborted;
+
+  plot();
+  save();
+  return Completed;
+}
+
+
+int ClosedLoopLatency::waitForCrossing( const InData &data, int &index,
+					double threshold, bool up, double tmax )
+{
+  if ( index < data.minIndex() )
+    index = data.minIndex();
+  while ( ! interrupt() ) {
+    for ( ; index < data.size(); index++ ) {
+      if ( ( up && data[index] >= threshold ) ||
+	   ( ! up && data[index] < threshold ) ) {
+	index++;
+	return index-1;
+      }
+    }
+    if ( currentTime() >= tmax )
+      return -1;
+    // wait for the next update of the data:
+    if ( getData( currentTime() + data.sampleInterval() ) < 0 )
+      return -1;
+    double ct = currentTime();
+    if ( LastUpdate >= 0.0 && ct > LastUpdate )
+      UpdateIntervals.push( ct - LastUpdate );
+    LastUpdate = ct;
+  }
+  return -2;
+}
+
+
+void ClosedLoopLatency::plot( void )
+{
+  double maxlat = max( LoopLatencies );
+  double bw = 0.02*maxlat;
+  if ( bw < 1.0e-5 )
+    bw = 1.0e-5;
+  SampleDataD ih( 0.0, maxlat+bw, bw );
+  ih.hist( InputLatencies );
+  SampleDataD oh( 0.0, maxlat+bw, bw );
+  oh.hist( OutputLatencies );
+  SampleDataD lh( 0.0, maxlat+bw, bw );
+  lh.hist( LoopLatencies );
+
+  P.lock();
+  P.clear();
+  P.setTitle( "mean loop latency=" + Str( 1000.0*mean( LoopLatencies ), 0, 2, 'f' )
+	      + "ms, n=" + Str( LoopLatencies.size() ) );
+  P.setXRange( 0.0, 1000.0*(maxlat+bw) );
+  P.plot( ih, 1000.0, Plot::Transparent, 0, Plot::Solid, Plot::Box, 0, Plot::Green, Plot::Green );
+  P.plot( oh, 1000.0, Plot::Transparent, 0, Plot::Solid, Plot::Box, 0, Plot::Blue, Plot::Blue );
+  P.plot( lh, 1000.0, Plot::Red, 2, Plot::Solid );
+  P.draw();
+  P.unlock();
+}
+
+
+void ClosedLoopLatency::save( void )
+{
+  ofstream df( addPath( "closedlooplatency.dat" ).c_str(),
+	       ofstream::out | ofstream::app );
+  if ( ! df.good() )
+    return;
+
+  ArrayD updates( UpdateIntervals );
+  sort( updates.begin(), updates.end() );
+  Options header;
+  header.addNumber( "update interval", 1000.0*( updates.empty() ? 0.0 : median( updates ) ), "ms", "%.3f" );
+  header.addNumber( "sample interval", 1000.0*trace( index( "intrace" ) ).sampleInterval(), "ms", "%.4f" );
+  header.addInteger( "misses", Misses );
+  header.save( df, "# " );
+  settings().save( df, "# ", 0, Options::FirstOnly );
+  df << '\n';
+
+  TableKey datakey;
+  datakey.addText( "latency", -6 );
+  datakey.addNumber( "n", "1", "%5.0f" );
+  datakey.addNumber( "mean", "ms", "%7.3f" );
+  datakey.addNumber( "s.d.", "ms", "%7.3f" );
+  datakey.addNumber( "min", "ms", "%7.3f" );
+  datakey.addNumber( "median", "ms", "%7.3f" );
+  datakey.addNumber( "95%", "ms", "%7.3f" );
+  datakey.addNumber( "max", "ms", "%7.3f" );
+  datakey.saveKey( df );
+
+  const ArrayD *lats[3] = { &InputLatencies, &OutputLatencies, &LoopLatencies };
+  const string names[3] = { "input", "output", "loop" };
+  for ( int k=0; k<3; k++ ) {
+    ArrayD sorted( *lats[k] );
+    sort( sorted.begin(), sorted.end() );
+    double sd = 0.0;
+    double m = meanStdev( sd, sorted );
+    datakey.save( df, names[k], 0 );
+    datakey.save( df, (double)sorted.size() );
+    datakey.save( df, 1000.0*m );
+    datakey.save( df, 1000.0*sd );
+    datakey.save( df, 1000.0*sorted.front() );
+    datakey.save( df, 1000.0*median( sorted ) );
+    datakey.save( df, 1000.0*quantile( 0.95, sorted ) );
+    datakey.save( df, 1000.0*sorted.back() );
+    df << '\n';
+  }
+  df << "\n\n";
+}
+
+
+addRePro( ClosedLoopLatency, calibration )
+
+}; /* namespace calibration */
+
+#include "moc_closedlooplatency.cc"
@@ -23,6 +23,7 @@
 #define _RELACS_CAMERA_CAMERACONTROL_H_ 1
 
 #include <relacs/misc/opencvcamera.h>
+#include <relacs/camera/framerecorder.h>
 #include <relacs/control.h>
 #include <vector>
 #include <QVBoxLayout>
@@ -40,7 +41,21 @@ namespace camera {
 \class CameraControl
 \brief [Control] Camera control plugin
 \author Fabian Sinz
-\version 1.0 (Mai 29, 2012)
+\version 1.1 (Oct 19, 2026)
+
+If \c record is set, the frames of all cameras are recorded during
+a session. The frames of each camera are written by a FrameRecorder
+into the video file \c camera-1.avi and their numbers and times
+into \c camera-1-frames.dat (with the respective camera identifier).
+The time of a frame is the time of the input traces at which the frame
+was grabbed. It is estimated by relating the clock of the
+camera's frames to the time of the most recent data of the input traces.
+
+\par Options
+- \c record=false: Record frames during a session (\c boolean)
+- \c codec=MJPG: Four-character code of the video codec (\c string)
+- \c undistort=true: Record undistorted frames of calibrated cameras (\c boolean)
+- \c queue=100: Maximum number of frames waiting to be written (\c integer)
 */
 
 
@@ -55,6 +70,7 @@ public:
   virtual void main( void );
   virtual void initDevices( void );
   virtual void clearDevices( void );
+  virtual void sessionStopped( bool saved );
   string currentCamera() const;
 
 public slots:
@@ -65,6 +81,11 @@ public slots:
 protected: 
   vector<misc::OpenCVCamera *> Cams;
   void timerEvent(QTimerEvent*); // Timer-Funktion zum Frames-auslesen und anzeigen
+    /*! Writes the frames of all cameras to files until the session is stopped.
+        \return \c true if the thread needs to be stopped. */
+  bool record( void );
+    /*! One recorder for each camera in Cams. */
+  vector<FrameRecorder *> Recorders;
   QComboBox * cameraBox;
 
 private:
@@ -0,0 +1,129 @@
+/*
+  camera/framerecorder.h
+  Writes camera frames and their time stamps to files in a separate thread
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_CAMERA_FRAMERECORDER_H_
+#define _RELACS_CAMERA_FRAMERECORDER_H_ 1
+
+#include <deque>
+#include <string>
+#include <fstream>
+#include <cv.h>
+#include <highgui.h>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+using namespace std;
+using namespace cv;
+
+namespace camera {
+
+
+/*!
+\class FrameRecorder
+\brief Writes camera frames and their time stamps to files in a separate thread
+\author Jan Benda
+
+Frames passed to push() are queued and encoded into a video file
+by a worker thread, so that grabbing frames is not delayed by
+encoding and writing them. For each frame the number of the frame
+in the video file, the number of the frame assigned by the camera,
+and the recording time of the frame is written into a text file.
+Frames are dropped if the queue already contains maxQueue() frames.
+The dropped frames are missing in the video file and in the text file.
+If the video file cannot be opened, all frames are dropped.
+*/
+
+class FrameRecorder : protected QThread
+{
+
+public:
+
+  FrameRecorder( void );
+  ~FrameRecorder( void );
+
+    /*! Opens the text file \a timesfile, writes \a header into it,
+        and starts the worker thread. The video file \a videofile
+        is opened with the size of the first frame,
+        the four-character code \a codec, and frame rate \a framerate.
+	\return \c 0 on success, \c -1 if the text file could not be opened. */
+  int open( const string &videofile, const string &timesfile,
+	    const string &codec, double framerate, const string &header="" );
+    /*! \return \c true if open() succeeded and close() was not called yet. */
+  bool isOpen( void ) const;
+    /*! Writes the remaining frames of the queue,
+        stops the worker thread, and closes the files. */
+  void close( void );
+
+    /*! Appends \a frame with number \a index grabbed at \a time
+        to the queue. Does not copy the pixel data of \a frame.
+	\return \c false if the frame was dropped. */
+  bool push( const Mat &frame, long index, double time );
+
+    /*! The maximum number of frames waiting in the queue. */
+  int maxQueue( void ) const;
+    /*! Set the maximum number of frames waiting in the queue to \a n. */
+  void setMaxQueue( int n );
+    /*! The number of frames written so far. */
+  int frames( void ) const;
+    /*! The number of frames dropped so far. */
+  int dropped( void ) const;
+
+
+protected:
+
+  virtual void run( void );
+
+
+private:
+
+  struct Frame
+  {
+    Mat Image;
+    long Index;
+    double Time;
+  };
+
+  deque< Frame > Queue;
+  int MaxQueue;
+  bool Opened;
+  bool Stop;
+  mutable QMutex Mutex;
+  QWaitCondition Wait;
+    /*! Serializes open() and close() called from different threads. */
+  QMutex OpenMutex;
+    /*! Opening the video file failed, further frames are dropped. */
+  bool WriterFailed;
+
+  string VideoFile;
+  int Codec;
+  double FrameRate;
+  VideoWriter Writer;
+  ofstream TimesFile;
+  int Frames;
+  int Dropped;
+
+};
+
+
+}; /* namespace camera */
+
+#endif /* ! _RELACS_CAMERA_FRAMERECORDER_H_ */
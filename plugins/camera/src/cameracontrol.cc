@@ -24,6 +24,7 @@
 #define IMGWIDTH  320
 #define INVFRAMERATE 30
 
+#include <sstream>
 #include <relacs/camera/cameracontrol.h>
 using namespace relacs;
 
@@ -33,10 +34,13 @@ namespace camera {
 /****************************************************************************************/
 
 CameraControl::CameraControl( void )
-  : Control( "CameraControl", "camera", "Fabian Sinz", "1.0", "Mai 29, 2012" )
+  : Control( "CameraControl", "camera", "Fabian Sinz", "1.1", "Oct 19, 2026" )
 {
   // add some options:
-  // addNumber( "duration", "Stimulus duration", 1.0, 0.001, 100000.0, 0.001, "s", "ms" );
+  addBoolean( "record", "Record frames during a session", false );
+  addText( "codec", "Four-character code of the video codec", "MJPG" );
+  addBoolean( "undistort", "Record undistorted frames of calibrated cameras", true );
+  addInteger( "queue", "Maximum number of frames waiting to be written", 100, 1, 100000 );
  
  //  camera object
   currentCam = 0;
@@ -140,6 +144,7 @@ void CameraControl::initDevices( void )
     if ( Cam != 0 ){
 
       Cams.push_back(Cam);
+      Recorders.push_back(new FrameRecorder);
 
       if (Cams.size() == 1){
 	StartButton->setDisabled(false);
@@ -156,7 +161,18 @@ void CameraControl::initDevices( void )
 
 void CameraControl::clearDevices( void )
 {
-  Cam = 0;
+  for ( unsigned int k=0; k<Recorders.size(); k++ )
+    delete Recorders[k];
+  Recorders.clear();
+  Cams.clear();
+}
+
+
+void CameraControl::sessionStopped( bool saved )
+{
+  // finish the files before they are completed or removed:
+  for ( unsigned int k=0; k<Recorders.size(); k++ )
+    Recorders[k]->close();
 }
 
 
@@ -166,6 +182,8 @@ string CameraControl::currentCamera(void) const{
 }
 
 CameraControl::~CameraControl( void ){
+  for ( unsigned int k=0; k<Recorders.size(); k++ )
+    delete Recorders[k];
 }
 
 void CameraControl::timerEvent(QTimerEvent*)
@@ -184,9 +202,105 @@ void CameraControl::timerEvent(QTimerEvent*)
 
 
 void CameraControl::main( void )
+{
+  while ( ! interrupt() ) {
+    if ( waitOnSessionStart() )
+      return;
+    if ( boolean( "record" ) && ! Cams.empty() ) {
+      if ( record() )
+	return;
+    }
+    else if ( waitOnSessionStop() )
+      return;
+  }
+}
+
+
+bool CameraControl::record( void )
 {
   // get options:
-  // double duration = number( "duration" );
+  string codec = text( "codec" );
+  bool undistort = boolean( "undistort" );
+  int maxqueue = integer( "queue" );
+
+  // open files:
+  vector<long> next( Cams.size(), 0 );
+  vector<bool> recording( Cams.size(), false );
+  for ( unsigned int k=0; k<Cams.size(); k++ ) {
+    if ( ! Cams[k]->isOpen() )
+      continue;
+    string ident = Cams[k]->deviceIdent();
+    Options header;
+    header.addText( "camera", ident );
+    header.addInteger( "framerate", Cams[k]->frameRate(), "Hz" );
+    header.addBoolean( "undistorted", undistort && Cams[k]->isCalibrated() );
+    header.addText( "video file", ident + ".avi" );
+    ostringstream hs;
+    header.save( hs, "# " );
+    hs << '\n';
+    Recorders[k]->setMaxQueue( maxqueue );
+    if ( Recorders[k]->open( addPath( ident + ".avi" ),
+			     addPath( ident + "-frames.dat" ),
+			     codec, Cams[k]->frameRate(), hs.str() ) == 0 ) {
+      addDataFile( ident + ".avi" );
+      addDataFile( ident + "-frames.dat" );
+      recording[k] = true;
+      printlog( "Recording frames of " + ident );
+    }
+    next[k] = Cams[k]->frameCount();
+  }
+
+  // The frames are stamped with a monotonic clock.
+  // The most recent data of the input traces were acquired slightly
+  // before they are available. Therefore the largest difference between
+  // the time of the input traces and the clock within a few seconds
+  // is the best estimate of the offset between the two clocks:
+  double offset = 0.0;
+  double prevmaxoffset = -MAXDOUBLE;
+  double maxoffset = -MAXDOUBLE;
+  double windowstart = -MAXDOUBLE;
+  bool stop = false;
+  while ( sessionRunning() ) {
+    if ( waitOnData() ) {
+      stop = true;
+      break;
+    }
+
+    double now = misc::VideoBuffer::clockTime();
+    if ( now - windowstart > 2.0 ) {
+      prevmaxoffset = maxoffset;
+      maxoffset = -MAXDOUBLE;
+      windowstart = now;
+    }
+    double sample = currentTimeRaw() - now;
+    if ( sample > maxoffset )
+      maxoffset = sample;
+    offset = maxoffset > prevmaxoffset ? maxoffset : prevmaxoffset;
+
+    // pass new frames to the recorders:
+    for ( unsigned int k=0; k<Cams.size(); k++ ) {
+      if ( ! Recorders[k]->isOpen() )
+	continue;
+      long count = Cams[k]->frameCount();
+      for ( ; next[k] < count; next[k]++ ) {
+	Mat frame;
+	double time = 0.0;
+	if ( Cams[k]->grabFrame( next[k], frame, time, undistort ) )
+	  Recorders[k]->push( frame, next[k], time + offset );
+      }
+    }
+  }
+
+  for ( unsigned int k=0; k<Recorders.size(); k++ ) {
+    if ( recording[k] ) {
+      Recorders[k]->close();
+      printlog( "Recorded " + Str( Recorders[k]->frames() ) + " frames of " +
+		Cams[k]->deviceIdent() + ", dropped " +
+		Str( Recorders[k]->dropped() ) + " frames" );
+    }
+  }
+
+  return stop;
 }
 
 
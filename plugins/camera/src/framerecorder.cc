@@ -0,0 +1,192 @@
+/*
+  camera/framerecorder.cc
+  Writes camera frames and their time stamps to files in a separate thread
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <relacs/str.h>
+#include <relacs/camera/framerecorder.h>
+using namespace relacs;
+
+namespace camera {
+
+
+FrameRecorder::FrameRecorder( void )
+  : MaxQueue( 100 ),
+    Opened( false ),
+    Stop( false ),
+    WriterFailed( false ),
+    Codec( 0 ),
+    FrameRate( 25.0 ),
+    Frames( 0 ),
+    Dropped( 0 )
+{
+}
+
+
+FrameRecorder::~FrameRecorder( void )
+{
+  close();
+}
+
+
+int FrameRecorder::open( const string &videofile, const string &timesfile,
+			 const string &codec, double framerate, const string &header )
+{
+  close();
+  QMutexLocker openlocker( &OpenMutex );
+
+  TimesFile.open( timesfile.c_str() );
+  if ( ! TimesFile.good() ) {
+    cerr << "FrameRecorder: can't open file " << timesfile << '\n';
+    return -1;
+  }
+  TimesFile << header;
+  TimesFile << "#Key\n";
+  TimesFile << "# frame  index    time\n";
+  TimesFile << "#                 s   \n";
+  TimesFile << "#  1       2        3 \n";
+
+  string cc = codec + "    ";
+  VideoFile = videofile;
+  Codec = CV_FOURCC( cc[0], cc[1], cc[2], cc[3] );
+  FrameRate = framerate;
+  Queue.clear();
+  Frames = 0;
+  Dropped = 0;
+  Stop = false;
+  WriterFailed = false;
+  Opened = true;
+  start();
+  return 0;
+}
+
+
+bool FrameRecorder::isOpen( void ) const
+{
+  QMutexLocker locker( &Mutex );
+  return Opened;
+}
+
+
+void FrameRecorder::close( void )
+{
+  // close() is called from the GUI thread and from the RePro thread:
+  QMutexLocker openlocker( &OpenMutex );
+  Mutex.lock();
+  if ( ! Opened ) {
+    Mutex.unlock();
+    return;
+  }
+  Opened = false;
+  Stop = true;
+  Wait.wakeAll();
+  Mutex.unlock();
+
+  wait();
+
+  if ( Writer.isOpened() )
+    Writer.release();
+  TimesFile.close();
+}
+
+
+bool FrameRecorder::push( const Mat &frame, long index, double time )
+{
+  QMutexLocker locker( &Mutex );
+  if ( ! Opened || Stop )
+    return false;
+  if ( (int)Queue.size() >= MaxQueue ) {
+    Dropped++;
+    return false;
+  }
+  Queue.push_back( Frame() );
+  Queue.back().Image = frame;
+  Queue.back().Index = index;
+  Queue.back().Time = time;
+  Wait.wakeAll();
+  return true;
+}
+
+
+int FrameRecorder::maxQueue( void ) const
+{
+  QMutexLocker locker( &Mutex );
+  return MaxQueue;
+}
+
+
+void FrameRecorder::setMaxQueue( int n )
+{
+  QMutexLocker locker( &Mutex );
+  MaxQueue = n > 1 ? n : 1;
+}
+
+
+int FrameRecorder::frames( void ) const
+{
+  QMutexLocker locker( &Mutex );
+  return Frames;
+}
+
+
+int FrameRecorder::dropped( void ) const
+{
+  QMutexLocker locker( &Mutex );
+  return Dropped;
+}
+
+
+void FrameRecorder::run( void )
+{
+  Mutex.lock();
+  while ( true ) {
+    while ( Queue.empty() && ! Stop )
+      Wait.wait( &Mutex );
+    if ( Queue.empty() )
+      break;
+    Frame frame = Queue.front();
+    Queue.pop_front();
+    int n = Frames;
+    Mutex.unlock();
+
+    // encoding and writing is done without holding the mutex:
+    if ( ! Writer.isOpened() && ! WriterFailed &&
+	 ! Writer.open( VideoFile, Codec, FrameRate, frame.Image.size(),
+			frame.Image.channels() > 1 ) ) {
+      WriterFailed = true;
+      cerr << "FrameRecorder: can't open video file " << VideoFile << '\n';
+    }
+    if ( WriterFailed ) {
+      Mutex.lock();
+      Dropped++;
+      continue;
+    }
+    Writer.write( frame.Image );
+    TimesFile << Str( n, "%7d" ) << "  " << Str( frame.Index, "%7d" )
+	      << "  " << Str( frame.Time, "%10.6f" ) << '\n';
+
+    Mutex.lock();
+    Frames++;
+  }
+  Mutex.unlock();
+}
+
+
+}; /* namespace camera */
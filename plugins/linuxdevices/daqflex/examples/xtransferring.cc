@@ -0,0 +1,342 @@
+/*
+  xtransferring.cc
+  Runs a DAQFlexCore::TransferRing against a simulated device.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <relacs/daqflex/daqflexcore.h>
+using namespace std;
+using namespace daqflex;
+
+
+/*
+  A simulated device. Submitted transfers are queued and are completed
+  in order by handleEvents(). Read transfers are filled with a running
+  byte counter, their actual lengths cycle through full, partial, and
+  empty packets. The data of write transfers are appended to Received.
+*/
+class FakeBackend : public TransferBackend
+{
+
+public:
+
+  FakeBackend( void )
+    : Submitted( 0 ), Completions( 0 ), StallAfter( -1 ),
+      Counter( 0 ), Packet( 0 ), IdleEvents( 0 ) {};
+
+  virtual libusb_device_handle *transferHandle( void ) override
+  {
+    return NULL;
+  }
+
+  virtual unsigned char transferEndpoint( bool in ) override
+  {
+    return in ? 0x81 : 0x02;
+  }
+
+  virtual int submitTransfer( libusb_transfer *transfer ) override
+  {
+    for ( unsigned int k=0; k<Queue.size(); k++ ) {
+      if ( Queue[k] == transfer ) {
+	cerr << "error: transfer submitted twice\n";
+	return LIBUSB_ERROR_BUSY;
+      }
+    }
+    Queue.push_back( transfer );
+    Cancelled.push_back( false );
+    Submitted++;
+    return LIBUSB_SUCCESS;
+  }
+
+  virtual int cancelTransfer( libusb_transfer *transfer ) override
+  {
+    for ( unsigned int k=0; k<Queue.size(); k++ ) {
+      if ( Queue[k] == transfer ) {
+	Cancelled[k] = true;
+	return LIBUSB_SUCCESS;
+      }
+    }
+    return LIBUSB_ERROR_NOT_FOUND;
+  }
+
+  virtual int handleEvents( unsigned int timeout ) override
+  {
+    // a slow device that does not complete any transfer for a while:
+    if ( IdleEvents > 0 ) {
+      IdleEvents--;
+      return LIBUSB_SUCCESS;
+    }
+    while ( ! Queue.empty() ) {
+      libusb_transfer *transfer = Queue.front();
+      bool cancelled = Cancelled.front();
+      Queue.pop_front();
+      Cancelled.pop_front();
+      if ( cancelled ) {
+	transfer->actual_length = 0;
+	transfer->status = LIBUSB_TRANSFER_CANCELLED;
+      }
+      else if ( StallAfter >= 0 && Completions >= StallAfter ) {
+	transfer->actual_length = 0;
+	transfer->status = LIBUSB_TRANSFER_STALL;
+      }
+      else if ( ( transfer->endpoint & LIBUSB_ENDPOINT_IN ) != 0 ) {
+	// full, partial, empty, and odd sized packets:
+	int n = transfer->length;
+	int status = LIBUSB_TRANSFER_COMPLETED;
+	switch ( Packet % 4 ) {
+	case 1: n = transfer->length/2; status = LIBUSB_TRANSFER_TIMED_OUT; break;
+	case 2: n = 0; status = LIBUSB_TRANSFER_TIMED_OUT; break;
+	case 3: n = 7; status = LIBUSB_TRANSFER_TIMED_OUT; break;
+	}
+	Packet++;
+	for ( int k=0; k<n; k++ )
+	  transfer->buffer[k] = (unsigned char)( Counter++ % 251 );
+	transfer->actual_length = n;
+	transfer->status = (libusb_transfer_status)status;
+      }
+      else {
+	for ( int k=0; k<transfer->length; k++ )
+	  Received.push_back( transfer->buffer[k] );
+	transfer->actual_length = transfer->length;
+	transfer->status = LIBUSB_TRANSFER_COMPLETED;
+      }
+      Completions++;
+      transfer->callback( transfer );
+    }
+    return LIBUSB_SUCCESS;
+  }
+
+    /*! Number of transfers submitted and not yet completed. */
+  int outstanding( void ) const
+  {
+    return Queue.size();
+  }
+
+  deque< libusb_transfer* > Queue;
+  deque< bool > Cancelled;
+  vector< unsigned char > Received;
+  int Submitted;
+  int Completions;
+  int StallAfter;
+  long Counter;
+  int Packet;
+  int IdleEvents;
+
+};
+
+
+int checkRead( int ntransfers, int length, int chunk )
+{
+  FakeBackend backend;
+  DAQFlexCore::TransferRing ring( &backend, true );
+
+  int ern = ring.start( ntransfers, length, 10 );
+  if ( ern != DAQFlexCore::Success ) {
+    cerr << "error: start() failed with " << ern << '\n';
+    return 1;
+  }
+  if ( backend.outstanding() != ntransfers ) {
+    cerr << "error: " << backend.outstanding() << " transfers submitted, expected "
+	 << ntransfers << '\n';
+    return 1;
+  }
+
+  int errors = 0;
+  long total = 0;
+  long nbytes = 1000*length;
+  vector< unsigned char > data( chunk );
+  while ( total < nbytes ) {
+    int transferred = 0;
+    ern = ring.read( &data[0], chunk, &transferred, 10 );
+    if ( ern != DAQFlexCore::Success ) {
+      cerr << "error: read() failed with " << ern << '\n';
+      return 1;
+    }
+    for ( int k=0; k<transferred; k++ ) {
+      if ( data[k] != (unsigned char)( ( total + k ) % 251 ) ) {
+	if ( errors < 10 )
+	  cerr << "error: byte " << total + k << " is " << (int)data[k]
+	       << ", expected " << ( total + k ) % 251 << '\n';
+	errors++;
+      }
+    }
+    total += transferred;
+    if ( backend.outstanding() > ntransfers ) {
+      cerr << "error: " << backend.outstanding() << " transfers outstanding\n";
+      return 1;
+    }
+  }
+
+  // all consumed transfers need to be resubmitted:
+  if ( backend.Submitted <= 2*ntransfers ) {
+    cerr << "error: only " << backend.Submitted << " submissions\n";
+    errors++;
+  }
+
+  ring.stop();
+  if ( backend.outstanding() != 0 ) {
+    cerr << "error: " << backend.outstanding() << " transfers left after stop()\n";
+    errors++;
+  }
+
+  cout << "read " << ntransfers << " x " << length << " bytes in chunks of "
+       << chunk << ": " << total << " bytes, " << backend.Submitted
+       << " submissions, " << errors << " errors\n";
+  return errors > 0 ? 1 : 0;
+}
+
+
+int checkWrite( int ntransfers, int length, int chunk )
+{
+  FakeBackend backend;
+  DAQFlexCore::TransferRing ring( &backend, false );
+
+  int ern = ring.start( ntransfers, length, 10 );
+  if ( ern != DAQFlexCore::Success ) {
+    cerr << "error: start() failed with " << ern << '\n';
+    return 1;
+  }
+  if ( backend.outstanding() != 0 ) {
+    cerr << "error: write transfers submitted by start()\n";
+    return 1;
+  }
+
+  int nbytes = 1000*length + 13;
+  vector< unsigned char > data( nbytes );
+  for ( int k=0; k<nbytes; k++ )
+    data[k] = (unsigned char)( k % 253 );
+
+  int total = 0;
+  while ( total < nbytes ) {
+    int n = nbytes - total;
+    if ( n > chunk )
+      n = chunk;
+    int transferred = 0;
+    ern = ring.write( &data[total], n, &transferred, 10 );
+    if ( ern != DAQFlexCore::Success ) {
+      cerr << "error: write() failed with " << ern << '\n';
+      return 1;
+    }
+    total += transferred;
+  }
+  backend.handleEvents( 0 );
+  ring.stop();
+
+  int errors = 0;
+  if ( (int)backend.Received.size() != nbytes ) {
+    cerr << "error: received " << backend.Received.size() << " bytes, expected "
+	 << nbytes << '\n';
+    errors++;
+  }
+  for ( unsigned int k=0; k<backend.Received.size() && k<data.size(); k++ ) {
+    if ( backend.Received[k] != data[k] ) {
+      if ( errors < 10 )
+	cerr << "error: byte " << k << " is " << (int)backend.Received[k]
+	     << ", expected " << (int)data[k] << '\n';
+      errors++;
+    }
+  }
+
+  cout << "wrote " << ntransfers << " x " << length << " bytes in chunks of "
+       << chunk << ": " << backend.Received.size() << " bytes, " << errors << " errors\n";
+  return errors > 0 ? 1 : 0;
+}
+
+
+int checkStall( void )
+{
+  FakeBackend backend;
+  backend.StallAfter = 37;
+  DAQFlexCore::TransferRing ring( &backend, true );
+  ring.start( 4, 512, 10 );
+
+  int ern = DAQFlexCore::Success;
+  unsigned char data[300];
+  for ( int k=0; k<1000 && ern == DAQFlexCore::Success; k++ ) {
+    int transferred = 0;
+    ern = ring.read( data, 300, &transferred, 10 );
+  }
+  ring.stop();
+
+  int errors = 0;
+  if ( ern != DAQFlexCore::ErrorLibUSBPipe ) {
+    cerr << "error: stalled transfer reported as " << ern << '\n';
+    errors++;
+  }
+  if ( backend.outstanding() != 0 ) {
+    cerr << "error: " << backend.outstanding() << " transfers left after stop()\n";
+    errors++;
+  }
+  cout << "stall after " << backend.StallAfter << " transfers: " << errors << " errors\n";
+  return errors;
+}
+
+
+int checkSlowCancel( void )
+{
+  FakeBackend backend;
+  DAQFlexCore::TransferRing ring( &backend, true );
+  ring.start( 4, 512, 10 );
+
+  unsigned char data[300];
+  int transferred = 0;
+  ring.read( data, 300, &transferred, 10 );
+  // cancelled transfers complete only after more than 100 calls of handleEvents():
+  backend.IdleEvents = 150;
+  ring.stop();
+
+  int errors = 0;
+  if ( backend.outstanding() != 0 ) {
+    cerr << "error: " << backend.outstanding() << " transfers freed while still pending\n";
+    errors++;
+  }
+  cout << "slow cancel: " << errors << " errors\n";
+  return errors;
+}
+
+
+int main( void )
+{
+  int errors = 0;
+
+  // backlog of many completed transfers read in small chunks:
+  errors += checkRead( 4, 512, 100 );
+  // chunks spanning several transfers:
+  errors += checkRead( 4, 512, 1500 );
+  // a single transfer:
+  errors += checkRead( 1, 64, 64 );
+  // many transfers, so that the queue of completed transfers wraps late:
+  errors += checkRead( 16, 256, 4096 );
+
+  errors += checkWrite( 4, 512, 100 );
+  errors += checkWrite( 4, 512, 3000 );
+  errors += checkWrite( 1, 64, 64 );
+
+  errors += checkStall();
+  errors += checkSlowCancel();
+
+  if ( errors > 0 )
+    cerr << "FAILED\n";
+  else
+    cout << "all transfer ring checks passed\n";
+
+  return errors > 0 ? 1 : 0;
+}
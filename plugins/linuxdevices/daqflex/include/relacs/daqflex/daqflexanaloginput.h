@@ -185,6 +185,11 @@ private:
   int BufferN;
     /*! The internal buffer used for getting the data from the driver. */
   char *Buffer;
+    /*! Size of a single asynchronous USB transfer in bytes,
+        0 for synchronous transfers. */
+  int TransferSize;
+    /*! Timeout of a single asynchronous USB transfer in milliseconds. */
+  unsigned int TransferTimeout;
     /*! Index to the trace in the internal buffer. */
   int TraceIndex;
 
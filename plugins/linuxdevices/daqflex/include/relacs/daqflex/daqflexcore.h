@@ -23,6 +23,9 @@
 #define _RELACS_DAQFLEX_DAQFLEXCORE_H_ 1
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
 #include <libusb-1.0/libusb.h>
 #include <relacs/device.h>
 using namespace std;
@@ -31,6 +34,43 @@ using namespace relacs;
 namespace daqflex {
 
 
+/*!
+\class TransferBackend
+\author Jan Benda
+\brief The libusb calls needed by DAQFlexCore::TransferRing
+
+DAQFlexCore implements them for the real USB device.
+Reimplement them to run a DAQFlexCore::TransferRing against a
+simulated device that produces synthetic packets
+(see examples/xtransferring.cc).
+*/
+
+class TransferBackend
+{
+
+public:
+
+  virtual ~TransferBackend( void ) {};
+
+    /*! \return the handle to the USB device the transfers are filled with. */
+  virtual libusb_device_handle *transferHandle( void ) = 0;
+    /*! \return the endpoint for reading (\a in = \c true)
+        or writing (\a in = \c false) data. */
+  virtual unsigned char transferEndpoint( bool in ) = 0;
+    /*! Submit the asynchronous \a transfer.
+        \return a libusb error code. */
+  virtual int submitTransfer( libusb_transfer *transfer ) = 0;
+    /*! Cancel the asynchronous \a transfer.
+        \return a libusb error code. */
+  virtual int cancelTransfer( libusb_transfer *transfer ) = 0;
+    /*! Handle pending libusb events, i.e. call the callbacks of completed
+        transfers, and wait at maximum \a timeout milliseconds for them.
+        \return a libusb error code. */
+  virtual int handleEvents( unsigned int timeout ) = 0;
+
+};
+
+
 /*!
 \class DAQFlexCore
 \author Jan Benda
@@ -38,6 +78,20 @@ namespace daqflex {
 \brief [Device] The DAQFlex interface over libusb
 \par Options
 - \c firmwarepath=/usr/lib/daqflex/: Path to the *.rbf firmware files
+- \c transfers=4: Number of asynchronous USB bulk transfers kept outstanding
+  for analog input and output (0: use synchronous transfers)
+
+\par Asynchronous transfers
+With \c transfers > 0 the analog input and output use a ring of
+asynchronous libusb bulk transfers (startReadTransfers(),
+readTransfers(), stopReadTransfers(), and startWriteTransfers(),
+writeTransfers(), stopWriteTransfers()). Several transfers are always
+pending, so that the USB latency does not throttle the throughput.
+The completion callbacks pass finished transfers via a lock-free queue
+to the reading or writing thread. All libusb calls of the transfer ring
+go through a TransferBackend, that DAQFlexCore implements for the
+USB device. A TransferRing can also be constructed on a simulated
+backend that produces synthetic packets.
 
 \par Supported devices: 
 In principle all DAQFlex Devices are supported. However, it might be
@@ -55,7 +109,7 @@ Therefore, the following devices should work as well:
 - USB_204
 */
 
-class DAQFlexCore : public Device
+class DAQFlexCore : public Device, public TransferBackend
 {
 
 public:
@@ -220,6 +274,50 @@ public:
   DAQFlexError writeBulkTransfer( unsigned char *data, int length, int *transferred,
 				  unsigned int timeout );
 
+    /*! \return the number of asynchronous bulk transfers to be used
+        for analog input and output as set by the \c transfers option.
+	If zero, synchronous transfers should be used. */
+  int transfers( void ) const;
+
+    /*! Allocate and submit transfers() asynchronous bulk transfers
+        of \a length bytes each for reading from the device.
+        \param[in] length number of bytes a single transfer can receive,
+	should be a multiple of inPacketSize()
+        \param[in] timeout in milliseconds after which a transfer
+	is completed with the data received so far
+        \return an eror code. */
+  DAQFlexError startReadTransfers( int length, unsigned int timeout );
+    /*! Copy data of completed asynchronous read transfers to a buffer
+        and resubmit the emptied transfers.
+        \param[in] data a buffer for the received data
+        \param[in] length number of bytes \a data can receive
+        \param[in] transferred number of bytes actually transferred
+        \param[in] timeout in milliseconds to wait for completed transfers
+	if none are available
+        \return an eror code of a failed transfer. */
+  DAQFlexError readTransfers( unsigned char *data, int length, int *transferred,
+			      unsigned int timeout );
+    /*! Cancel all pending asynchronous read transfers and free them. */
+  void stopReadTransfers( void );
+
+    /*! Allocate transfers() asynchronous bulk transfers
+        of \a length bytes each for writing to the device.
+        \param[in] length maximum number of bytes of a single transfer,
+	should be a multiple of outPacketSize()
+        \return an eror code. */
+  DAQFlexError startWriteTransfers( int length );
+    /*! Copy data into free asynchronous write transfers and submit them.
+        \param[in] data to be sent
+        \param[in] length number of bytes in \a data to be sent
+        \param[in] transferred number of bytes actually submitted
+        \param[in] timeout in milliseconds to wait for a free transfer
+	if none is available
+        \return an eror code of a failed transfer. */
+  DAQFlexError writeTransfers( unsigned char *data, int length, int *transferred,
+			       unsigned int timeout );
+    /*! Cancel all pending asynchronous write transfers and free them. */
+  void stopWriteTransfers( void );
+
     /*! Clear the reading endpoint. */
   void clearRead( void );
     /*! Clear the writing endpoint. */
@@ -244,14 +342,90 @@ public:
   using Device::unlock;
   using Device::mutex;
 
+    /*! A ring of asynchronous bulk transfers for a single endpoint.
+        All libusb calls go through a TransferBackend. */
+  class TransferRing
+  {
+
+  public:
+
+      /*! Construct a ring for reading (\a in = \c true) or writing
+          (\a in = \c false) transfers via \a backend. */
+    TransferRing( TransferBackend *backend, bool in );
+    ~TransferRing( void );
+
+      /*! Allocate \a ntransfers transfers of \a length bytes each.
+	  Read transfers are submitted right away. */
+    DAQFlexError start( int ntransfers, int length, unsigned int timeout );
+      /*! Cancel all pending transfers, wait for them, and free them.
+	  Blocks until the callbacks of all pending transfers have been called. */
+    void stop( void );
+    DAQFlexError read( unsigned char *data, int length, int *transferred,
+		       unsigned int timeout );
+    DAQFlexError write( unsigned char *data, int length, int *transferred,
+			unsigned int timeout );
+
+      /*! The completion callback of all transfers. */
+    static void LIBUSB_CALL callback( libusb_transfer *transfer );
+
+
+  private:
+
+    DAQFlexError submit( int index );
+    void complete( libusb_transfer *transfer );
+      /*! Take the index of the next completed transfer from the queue. */
+    bool pop( int &index );
+
+    TransferBackend *Backend;
+    bool In;
+    vector< libusb_transfer* > Transfers;
+      /*! Indices of completed transfers, written by the callback
+          and read by the reading or writing thread. */
+    vector< int > Completed;
+    std::atomic< int > CompletedHead;
+    std::atomic< int > CompletedTail;
+      /*! Number of submitted transfers. */
+    std::atomic< int > Pending;
+      /*! The first error of a completed transfer. */
+    std::atomic< int > Status;
+    std::atomic< bool > Stopping;
+      /*! The size of the buffer of each transfer in bytes. */
+    int Length;
+      /*! For reading: the completed transfer currently being read. */
+    int Current;
+      /*! For reading: number of bytes already read from the current transfer. */
+    int Offset;
+      /*! For writing: transfers available for new data. */
+    deque< int > Free;
+
+  };
+
   
 protected:
 
   void initOptions( void ) override;
 
+    /*! \return deviceHandle(). */
+  virtual libusb_device_handle *transferHandle( void ) override;
+    /*! \return endpointIn() or endpointOut(). */
+  virtual unsigned char transferEndpoint( bool in ) override;
+    /*! Submit the asynchronous \a transfer.
+        \return a libusb error code. */
+  virtual int submitTransfer( libusb_transfer *transfer ) override;
+    /*! Cancel the asynchronous \a transfer.
+        \return a libusb error code. */
+  virtual int cancelTransfer( libusb_transfer *transfer ) override;
+    /*! Handle pending libusb events, i.e. call the callbacks of completed
+        transfers, and wait at maximum \a timeout milliseconds for them.
+        \return a libusb error code. */
+  virtual int handleEvents( unsigned int timeout ) override;
+
   
 private:
 
+  TransferRing ReadTransfers;
+  TransferRing WriteTransfers;
+
     /*! A handle to the USB device. */
   libusb_device_handle *deviceHandle( void );
     /*! The endpoint for reading data. */
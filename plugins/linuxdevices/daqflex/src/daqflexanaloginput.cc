@@ -45,6 +45,8 @@ DAQFlexAnalogInput::DAQFlexAnalogInput( void )
   BufferSize = 0;
   BufferN = 0;
   Buffer = NULL;
+  TransferSize = 0;
+  TransferTimeout = 0;
   TraceIndex = 0;
   TotalSamples = 0;
   CurrentSamples = 0;
@@ -413,6 +415,18 @@ int DAQFlexAnalogInput::prepareRead( InList &traces )
       timeout = 0.01;
     unsigned long timeoutms = (unsigned long)::ceil( 1000.0*timeout ); 
     setReadSleep( timeoutms ); 
+    // asynchronous transfers each holding about two read intervals of data:
+    TransferSize = 0;
+    if ( DAQFlexDevice->transfers() > 0 ) {
+      int inps = DAQFlexDevice->inPacketSize();
+      TransferSize = (int)::ceil( 2.0*timeout*traces[0].sampleRate()*traces.size()*2.0/inps )*inps;
+      int maxsize = ((BufferSize/DAQFlexDevice->transfers())/inps)*inps;
+      if ( TransferSize > maxsize )
+	TransferSize = maxsize;
+      if ( TransferSize < inps )
+	TransferSize = inps;
+      TransferTimeout = 2*timeoutms;
+    }
     setSettings( traces, ReadBufferSize, BufferSize );
     Traces = &traces;
     IsPrepared = true;
@@ -436,6 +450,16 @@ int DAQFlexAnalogInput::startRead( QSemaphore *sp, QReadWriteLock *datamutex,
     return -1;
   }
 
+  // submit asynchronous transfers before the data start coming in:
+  if ( TransferSize > 0 ) {
+    int ern = DAQFlexDevice->startReadTransfers( TransferSize, TransferTimeout );
+    if ( ern != DAQFlexCore::Success ) {
+      Traces->setErrorStr( "AI startRead: failed to submit USB transfers: " +
+			   DAQFlexDevice->daqflexErrorStr( ern ) );
+      return -1;
+    }
+  }
+
   bool tookao = ( aosp != 0 && DAQFlexAO != 0 && DAQFlexAO->prepared() );
   {
     QMutexLocker corelocker( DAQFlexDevice->mutex() );
@@ -490,8 +514,13 @@ int DAQFlexAnalogInput::readData( void )
 
   // read data:
   int timeout = 1;
-  int ern = DAQFlexDevice->readBulkTransfer( (unsigned char*)(Buffer + buffern),
-					     maxn, &readn, timeout );
+  int ern = DAQFlexCore::Success;
+  if ( TransferSize > 0 )
+    ern = DAQFlexDevice->readTransfers( (unsigned char*)(Buffer + buffern),
+					maxn, &readn, timeout );
+  else
+    ern = DAQFlexDevice->readBulkTransfer( (unsigned char*)(Buffer + buffern),
+					   maxn, &readn, timeout );
 
   // store data:
   if ( readn > 0 ) {
@@ -619,6 +648,9 @@ int DAQFlexAnalogInput::stop( void )
 
   stopRead();
 
+  // the read thread is gone, cancel the pending transfers:
+  DAQFlexDevice->stopReadTransfers();
+
   lock();
   IsRunning = false;
   AboutToStop = false;
@@ -634,6 +666,8 @@ int DAQFlexAnalogInput::reset( void )
     return NotOpen;
 
   QMutexLocker ailocker( mutex() );
+  // pending transfers need to be cancelled before clearing the endpoint:
+  DAQFlexDevice->stopReadTransfers();
   {
     QMutexLocker corelocker( DAQFlexDevice->mutex() );
     int ern = DAQFlexDevice->sendControlTransfer( "AISCAN:RESET" );
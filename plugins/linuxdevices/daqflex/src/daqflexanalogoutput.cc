@@ -616,6 +616,16 @@ int DAQFlexAnalogOutput::prepareWrite( OutList &sigs )
     double timeout = 0.1*sigs[0].interval( BufferSize/2/sigs.size()-1 );
     int timeoutms = (int)::ceil( 1000.0*timeout );
     setWriteSleep( timeoutms );
+    // asynchronous transfers sharing the buffer size:
+    if ( DAQFlexDevice->transfers() > 0 ) {
+      int transfersize = ((BufferSize/DAQFlexDevice->transfers())/outps)*outps;
+      if ( transfersize < outps )
+	transfersize = outps;
+      int ern = DAQFlexDevice->startWriteTransfers( transfersize );
+      if ( ern != DAQFlexCore::Success )
+	sigs.addErrorStr( "failed to allocate USB transfers: " +
+			  DAQFlexDevice->daqflexErrorStr( ern ) );
+    }
   }
   else
     BufferSize = sigs.deviceBufferSize()*2;
@@ -736,8 +746,13 @@ int DAQFlexAnalogOutput::writeData( void )
   if ( bytesToWrite <= 0 )
     bytesToWrite = NBuffer;
   int bytesWritten = 0;
-  int ern = DAQFlexDevice->writeBulkTransfer( (unsigned char*)(Buffer), 
-					      bytesToWrite, &bytesWritten, 1 );
+  int ern = DAQFlexCore::Success;
+  if ( DAQFlexDevice->transfers() > 0 )
+    ern = DAQFlexDevice->writeTransfers( (unsigned char*)(Buffer), 
+					 bytesToWrite, &bytesWritten, 1 );
+  else
+    ern = DAQFlexDevice->writeBulkTransfer( (unsigned char*)(Buffer), 
+					    bytesToWrite, &bytesWritten, 1 );
 
   // update buffer:
   int datams = 0;
@@ -787,6 +802,9 @@ int DAQFlexAnalogOutput::stop( void )
 
   stopWrite();
 
+  // the write thread is gone, cancel the pending transfers:
+  DAQFlexDevice->stopWriteTransfers();
+
   return 0;
 }
 
@@ -794,6 +812,8 @@ int DAQFlexAnalogOutput::stop( void )
 int DAQFlexAnalogOutput::reset( void )
 {
   QMutexLocker aolocker( mutex() );
+  // pending transfers need to be cancelled before clearing the endpoint:
+  DAQFlexDevice->stopWriteTransfers();
   {
     QMutexLocker corelocker( DAQFlexDevice->mutex() );
 
@@ -23,6 +23,8 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <sys/time.h>
 #include <QMutexLocker>
 #include <relacs/daqflex/daqflexcore.h>
 using namespace std;
@@ -64,6 +66,8 @@ const string DAQFlexCore::DAQFlexErrorText[DAQFlexCore::DAQFlexErrorMax] =
 
 DAQFlexCore::DAQFlexCore( void )
   : Device( "DAQFlexCore" ),
+    ReadTransfers( this, true ),
+    WriteTransfers( this, false ),
     DeviceHandle( NULL ),
     ErrorState( Success )
 {
@@ -91,6 +95,7 @@ void DAQFlexCore::initOptions()
   addText( "serialno", "Serial number of DAQFlex device", "" );
   addInteger( "devicenum", "Take DAQFlex device number", 1 );
   addText( "firmwarepath", "Path to firmware files", "" );
+  addInteger( "transfers", "Number of asynchronous USB transfers", 4, 0, 64 );
 }
 
 int DAQFlexCore::open( const string &devicestr )
@@ -236,6 +241,8 @@ bool DAQFlexCore::isOpen( void ) const
 void DAQFlexCore::close( void )
 {
   if ( isOpen() ) {
+    ReadTransfers.stop();
+    WriteTransfers.stop();
     // free memory and devices:
     libusb_release_interface( DeviceHandle, 0 );
     libusb_close( DeviceHandle );
@@ -887,6 +894,338 @@ DAQFlexCore::DAQFlexError DAQFlexCore::writeBulkTransfer( unsigned char *data, i
 }
 
 
+int DAQFlexCore::transfers( void ) const
+{
+  return integer( "transfers", 0, 0 );
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::startReadTransfers( int length,
+							   unsigned int timeout )
+{
+  return ReadTransfers.start( transfers(), length, timeout );
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::readTransfers( unsigned char *data, int length,
+						      int *transferred,
+						      unsigned int timeout )
+{
+  return ReadTransfers.read( data, length, transferred, timeout );
+}
+
+
+void DAQFlexCore::stopReadTransfers( void )
+{
+  ReadTransfers.stop();
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::startWriteTransfers( int length )
+{
+  return WriteTransfers.start( transfers(), length, 0 );
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::writeTransfers( unsigned char *data, int length,
+						       int *transferred,
+						       unsigned int timeout )
+{
+  return WriteTransfers.write( data, length, transferred, timeout );
+}
+
+
+void DAQFlexCore::stopWriteTransfers( void )
+{
+  WriteTransfers.stop();
+}
+
+
+libusb_device_handle *DAQFlexCore::transferHandle( void )
+{
+  return deviceHandle();
+}
+
+
+unsigned char DAQFlexCore::transferEndpoint( bool in )
+{
+  return in ? endpointIn() : endpointOut();
+}
+
+
+int DAQFlexCore::submitTransfer( libusb_transfer *transfer )
+{
+  return libusb_submit_transfer( transfer );
+}
+
+
+int DAQFlexCore::cancelTransfer( libusb_transfer *transfer )
+{
+  return libusb_cancel_transfer( transfer );
+}
+
+
+int DAQFlexCore::handleEvents( unsigned int timeout )
+{
+  struct timeval tv;
+  tv.tv_sec = timeout / 1000;
+  tv.tv_usec = 1000 * ( timeout % 1000 );
+  return libusb_handle_events_timeout_completed( NULL, &tv, NULL );
+}
+
+
+DAQFlexCore::TransferRing::TransferRing( TransferBackend *backend, bool in )
+  : Backend( backend ),
+    In( in ),
+    CompletedHead( 0 ),
+    CompletedTail( 0 ),
+    Pending( 0 ),
+    Status( Success ),
+    Stopping( false ),
+    Length( 0 ),
+    Current( -1 ),
+    Offset( 0 )
+{
+}
+
+
+DAQFlexCore::TransferRing::~TransferRing( void )
+{
+  stop();
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::TransferRing::start( int ntransfers, int length,
+							    unsigned int timeout )
+{
+  stop();
+  if ( ntransfers <= 0 || length <= 0 )
+    return ErrorInvalidBufferSize;
+
+  CompletedHead = 0;
+  CompletedTail = 0;
+  Completed.resize( ntransfers+1, 0 );
+  Pending = 0;
+  Status = Success;
+  Stopping = false;
+  Current = -1;
+  Offset = 0;
+  Length = length;
+  Free.clear();
+
+  unsigned char endpoint = Backend->transferEndpoint( In );
+  for ( int k=0; k<ntransfers; k++ ) {
+    libusb_transfer *transfer = libusb_alloc_transfer( 0 );
+    if ( transfer == 0 ) {
+      stop();
+      return ErrorLibUSBNoMem;
+    }
+    unsigned char *buffer = new unsigned char[length];
+    libusb_fill_bulk_transfer( transfer, Backend->transferHandle(), endpoint,
+			       buffer, length, callback, this, timeout );
+    Transfers.push_back( transfer );
+    if ( ! In )
+      Free.push_back( k );
+  }
+
+  if ( In ) {
+    for ( int k=0; k<ntransfers; k++ ) {
+      DAQFlexError ern = submit( k );
+      if ( ern != Success ) {
+	stop();
+	return ern;
+      }
+    }
+  }
+
+  return Success;
+}
+
+
+void DAQFlexCore::TransferRing::stop( void )
+{
+  if ( Transfers.empty() )
+    return;
+
+  Stopping = true;
+  for ( unsigned int k=0; k<Transfers.size(); k++ )
+    Backend->cancelTransfer( Transfers[k] );
+  // wait for the callbacks of the cancelled transfers.
+  // A transfer must not be freed while it is in flight,
+  // since its callback would write to freed memory:
+  for ( int k=0; Pending > 0; k++ ) {
+    if ( k == 100 )
+      cerr << "DAQFlexCore::TransferRing::stop() -> still waiting for "
+	   << Pending << " pending transfers\n";
+    Backend->handleEvents( 10 );
+  }
+
+  for ( unsigned int k=0; k<Transfers.size(); k++ ) {
+    delete [] Transfers[k]->buffer;
+    libusb_free_transfer( Transfers[k] );
+  }
+  Transfers.clear();
+  Completed.clear();
+  Free.clear();
+  Current = -1;
+  Offset = 0;
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::TransferRing::read( unsigned char *data, int length,
+							   int *transferred,
+							   unsigned int timeout )
+{
+  *transferred = 0;
+  if ( Transfers.empty() )
+    return ErrorTransferFailed;
+
+  if ( Current < 0 && CompletedTail == CompletedHead )
+    Backend->handleEvents( timeout );
+
+  int n = 0;
+  while ( n < length ) {
+    if ( Current < 0 && ! pop( Current ) )
+      break;
+    libusb_transfer *transfer = Transfers[Current];
+    int m = transfer->actual_length - Offset;
+    if ( m > length - n )
+      m = length - n;
+    if ( m > 0 ) {
+      memcpy( data + n, transfer->buffer + Offset, m );
+      n += m;
+      Offset += m;
+    }
+    if ( Offset >= transfer->actual_length ) {
+      // transfer consumed, reuse it:
+      int index = Current;
+      Current = -1;
+      Offset = 0;
+      DAQFlexError ern = submit( index );
+      if ( ern != Success )
+	Status = ern;
+    }
+  }
+  *transferred = n;
+
+  return (DAQFlexError)Status.load();
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::TransferRing::write( unsigned char *data, int length,
+							    int *transferred,
+							    unsigned int timeout )
+{
+  *transferred = 0;
+  if ( Transfers.empty() )
+    return ErrorTransferFailed;
+
+  // collect completed transfers:
+  Backend->handleEvents( 0 );
+  int index = 0;
+  while ( pop( index ) )
+    Free.push_back( index );
+  if ( Free.empty() && timeout > 0 ) {
+    Backend->handleEvents( timeout );
+    while ( pop( index ) )
+      Free.push_back( index );
+  }
+
+  // fill up and submit free transfers:
+  int n = 0;
+  while ( n < length && ! Free.empty() && Status == Success ) {
+    index = Free.front();
+    Free.pop_front();
+    libusb_transfer *transfer = Transfers[index];
+    int m = length - n;
+    if ( m > Length )
+      m = Length;
+    memcpy( transfer->buffer, data + n, m );
+    transfer->length = m;
+    DAQFlexError ern = submit( index );
+    if ( ern != Success ) {
+      Free.push_front( index );
+      Status = ern;
+      break;
+    }
+    n += m;
+  }
+  *transferred = n;
+
+  return (DAQFlexError)Status.load();
+}
+
+
+DAQFlexCore::DAQFlexError DAQFlexCore::TransferRing::submit( int index )
+{
+  if ( Stopping )
+    return Success;
+  libusb_transfer *transfer = Transfers[index];
+  transfer->user_data = this;
+  Pending++;
+  int ern = Backend->submitTransfer( transfer );
+  if ( ern != 0 ) {
+    Pending--;
+    return getLibUSBError( ern );
+  }
+  return Success;
+}
+
+
+void DAQFlexCore::TransferRing::callback( libusb_transfer *transfer )
+{
+  TransferRing *ring = static_cast< TransferRing* >( transfer->user_data );
+  ring->complete( transfer );
+}
+
+
+void DAQFlexCore::TransferRing::complete( libusb_transfer *transfer )
+{
+  DAQFlexError ern = Success;
+  switch ( transfer->status ) {
+  case LIBUSB_TRANSFER_COMPLETED:
+  case LIBUSB_TRANSFER_TIMED_OUT:
+    // timed out transfers contain valid data up to actual_length.
+    break;
+  case LIBUSB_TRANSFER_CANCELLED:
+    Pending--;
+    return;
+  case LIBUSB_TRANSFER_STALL:
+    ern = ErrorLibUSBPipe; break;
+  case LIBUSB_TRANSFER_NO_DEVICE:
+    ern = ErrorLibUSBNoDevice; break;
+  case LIBUSB_TRANSFER_OVERFLOW:
+    ern = ErrorLibUSBOverflow; break;
+  default:
+    ern = ErrorTransferFailed;
+  }
+  if ( ern != Success ) {
+    int success = Success;
+    Status.compare_exchange_strong( success, ern );
+  }
+
+  // put index of transfer into queue of completed transfers:
+  int index = 0;
+  while ( index < (int)Transfers.size() && Transfers[index] != transfer )
+    index++;
+  int head = CompletedHead.load( std::memory_order_relaxed );
+  Completed[head] = index;
+  CompletedHead.store( ( head + 1 ) % Completed.size(), std::memory_order_release );
+  Pending--;
+}
+
+
+bool DAQFlexCore::TransferRing::pop( int &index )
+{
+  int tail = CompletedTail.load( std::memory_order_relaxed );
+  if ( tail == CompletedHead.load( std::memory_order_acquire ) )
+    return false;
+  index = Completed[tail];
+  CompletedTail.store( ( tail + 1 ) % Completed.size(), std::memory_order_release );
+  return true;
+}
+
+
 void DAQFlexCore::clearRead( void )
 {
   libusb_clear_halt( deviceHandle(), endpointIn() );
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
 #include <cv.h>
 #include <highgui.h>
 #include <relacs/camera.h>
@@ -43,28 +44,51 @@ namespace misc {
 
 
 
+  /*!
+    \class VideoBuffer
+    \brief Grabs frames from a camera in a separate thread.
+
+    Each frame is stored in a ring buffer of \a blen frames together
+    with the time it was grabbed. The time is measured by clockTime().
+    Frames are numbered consecutively from zero on and can be retrieved
+    by their number via getFrame() as long as they are in the buffer.
+    If \a camid is negative, synthetic frames showing a moving bar and
+    the frame number are generated instead of opening a camera.
+  */
   class VideoBuffer{
   public:
     VideoBuffer(int camid, int fraRt, int blen);
     int Start();
     int Stop();
     Mat getCurrentFrame(void);
+      /*! Copies the frame with number \a index into \a frame and its
+          time into \a time. \return \c false if the frame is not
+	  available (yet or anymore). */
+    bool getFrame(long index, Mat &frame, double &time);
+      /*! The number of frames grabbed so far. */
+    long frameCount( void ) const { return Count; };
     bool isReady( void ) const {return ready; };
+      /*! The time of a monotonic clock in seconds as used for
+          the time stamps of the frames. */
+    static double clockTime( void );
    protected:
     int CameraID;
     int BufLen;
     int FrameRate;
     Mat* buf;
+    double* times;
     int Run();
     static void * EntryPoint(void*);
     void Setup();
     void Execute();
     void Exit();
+    void synthesize( Mat &frame, long index );
     bool active, ready;
    private:
     pthread_t id;
     VideoCapture Source;
-    int currentFrame;
+    atomic<int> currentFrame;
+    atomic<long> Count;
     
   };
 
@@ -111,6 +135,15 @@ class OpenCVCamera : public Camera
   Mat grabRawFrame(void);
   Mat grabFrame(bool undistort);
   QImage grabQImage(void);
+    /*! Copies the frame with number \a index into \a frame,
+        undistorted if \a undistort is set and the camera is calibrated.
+	\a time is set to the VideoBuffer::clockTime() when the frame was grabbed.
+	\return \c false if the frame is not available. */
+  bool grabFrame(long index, Mat &frame, double &time, bool undistort=true);
+    /*! The number of frames grabbed since the camera was opened. */
+  long frameCount(void) const;
+    /*! The frame rate the camera was opened with. */
+  int frameRate(void) const { return FrameRate; };
 
 protected:
   void initOptions() override;
@@ -121,6 +154,7 @@ protected:
   string ParamFile;
   int CameraNo, FrameRate;
   VideoBuffer* VidBuf;
+    /*! Undistortion maps in fixed-point representation for remap(). */
   Mat UDMapX, UDMapY;
 
 
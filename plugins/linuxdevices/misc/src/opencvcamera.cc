@@ -25,6 +25,7 @@
 // #include <unistd.h>
 // #include <cmath>
 #include <cstdio>
+#include <ctime>
 // #include <cstring>
 #include <iostream>
 #include <relacs/misc/opencvcamera.h>
@@ -57,13 +58,21 @@ namespace misc {
   /*************************************************************************/
   VideoBuffer::VideoBuffer(int camid, int fraRt, int blen){
     currentFrame = -1;
+    Count = 0;
     CameraID = camid;
     FrameRate = fraRt;
     BufLen = blen;
     buf= new Mat[blen];
+    times = new double[blen];
     ready = false;
   }
 
+  double VideoBuffer::clockTime( void ){
+    struct timespec t;
+    clock_gettime( CLOCK_MONOTONIC, &t );
+    return t.tv_sec + 1.0e-9*t.tv_nsec;
+  }
+
   int VideoBuffer::Start(){
     struct timespec waitingTime;
     waitingTime.tv_sec = 0;
@@ -111,9 +120,21 @@ namespace misc {
     return buf[currentFrame].clone();
   }
 
+  bool VideoBuffer::getFrame(long index, Mat &frame, double &time){
+    long count = Count;
+    if ( index < 0 || index >= count || index <= count - BufLen )
+      return false;
+    int k = index % BufLen;
+    buf[k].copyTo( frame );
+    time = times[k];
+    // the frame might have been overwritten while copying:
+    return ( index > Count - BufLen );
+  }
+
   void VideoBuffer::Setup(){
     // open camera and make video stream ready
-    Source = VideoCapture(CameraID);
+    if ( CameraID >= 0 )
+      Source = VideoCapture(CameraID);
   }
 
   void VideoBuffer::Execute(){
@@ -125,12 +146,18 @@ namespace misc {
     // aquire frames and set currentFrame
   
     while (active){
-      newFrame = (currentFrame+1)%BufLen;
-      Source >> buf[newFrame ];
+      long count = Count;
+      newFrame = count%BufLen;
+      if ( CameraID < 0 )
+	synthesize( buf[newFrame], count );
+      else
+	Source >> buf[newFrame ];
+      times[newFrame] = clockTime();
       ready = true;
       // cerr << "Camera ID " << CameraID << " Frame " << currentFrame << ": " 
       // 	   << buf[currentFrame].rows << ", " << buf[currentFrame].cols << endl;
       currentFrame = newFrame;
+      Count = count + 1;
    
       nanosleep(&waitingTime,NULL);
     }
@@ -140,6 +167,17 @@ namespace misc {
   void VideoBuffer::Exit(){
     // close camera
     delete [] buf;
+    delete [] times;
+  }
+
+  void VideoBuffer::synthesize(Mat &frame, long index){
+    frame.create( 240, 320, CV_8UC3 );
+    frame.setTo( Scalar( 40, 40, 40 ) );
+    int x = (4*index) % frame.cols;
+    rectangle( frame, Point( x, 0 ), Point( x+15, frame.rows-1 ),
+	       Scalar( 255, 255, 255 ), CV_FILLED );
+    putText( frame, Str( index ), Point( 10, 30 ),
+	     FONT_HERSHEY_SIMPLEX, 1.0, Scalar( 0, 0, 255 ), 2 );
   }
 
   /*************************************************************************/
@@ -167,7 +205,7 @@ namespace misc {
   {
     Camera::initOptions();
 
-    addInteger( "device", "Camera device number", 0, 0, 1000 );
+    addInteger( "device", "Camera device number (-1: synthetic frames)", 0, -1, 1000 );
     addInteger( "framerate", "Frame rate", 20, 0, 10000 ).setUnit( "Hz" );
     addInteger( "bufferlen", "Buffer len", 1000, 0, 10000000 );
     addText( "parameters", "Parameter file", "" ).setStyle( OptWidget::BrowseExisting );
@@ -346,11 +384,10 @@ namespace misc {
     
 
 
-      UDMapX = Mat( Image.size() ,CV_32FC1, 1 );
-      UDMapY = Mat( Image.size() , CV_32FC1, 1 );
+      // fixed-point maps make remap() considerably faster:
       initUndistortRectifyMap( IntrinsicMatrix, DistortionCoeffs, 
 			       Mat::eye(3,3, CV_32F), IntrinsicMatrix, Image.size(),
-			       CV_32FC1, UDMapX, UDMapY );
+			       CV_16SC2, UDMapX, UDMapY );
 
    
     }else{
@@ -370,11 +407,11 @@ namespace misc {
   Mat OpenCVCamera::grabFrame(bool undistort){
     if (Opened){
       Mat Image = VidBuf->getCurrentFrame();
-      if (Calibrated && undistort){
-
-	Mat t = Image.clone();
-	remap( t, Image, UDMapX, UDMapY, INTER_NEAREST,BORDER_CONSTANT, 0 );
-	return Image; 
+      if (Calibrated && undistort && Image.size() == UDMapX.size()){
+	// getCurrentFrame() already returns a copy, remap into a new one:
+	Mat Undistorted;
+	remap( Image, Undistorted, UDMapX, UDMapY, INTER_NEAREST,BORDER_CONSTANT, 0 );
+	return Undistorted; 
       }
       return Image;
     }
@@ -382,6 +419,29 @@ namespace misc {
 
   }
 
+  bool OpenCVCamera::grabFrame(long index, Mat &frame, double &time, bool undistort){
+    if (!Opened)
+      return false;
+    if (Calibrated && undistort){
+      Mat Image;
+      if (!VidBuf->getFrame(index, Image, time))
+	return false;
+      if (Image.size() != UDMapX.size()){
+	frame = Image;
+	return true;
+      }
+      remap( Image, frame, UDMapX, UDMapY, INTER_NEAREST,BORDER_CONSTANT, 0 );
+      return true;
+    }
+    return VidBuf->getFrame(index, frame, time);
+  }
+
+  long OpenCVCamera::frameCount(void) const{
+    if (Opened)
+      return VidBuf->frameCount();
+    return 0;
+  }
+
   Mat OpenCVCamera::grabRawFrame(void){
     return grabFrame(false);
   }
@@ -32,6 +32,10 @@ namespace relacs {
 \class DynClampAOSim
 \author Jan Benda
 \brief Implementation of AnalogOutput simulating an analog output device supporting analog ouput.
+
+\par Options
+- \c checklookuptables=false: Measure the interpolation error and the speed
+  of the lookup tables of the model on open() and report them on cerr.
  */
 
 class DynClampAOSim: public AOSim
@@ -39,7 +39,13 @@ namespace relacs {
 
 namespace dynclampmodelsim {
 
-  void generateLookupTables( void );
+    /*! Generates all lookup tables of the model.
+        If \a check is \c true, the grid uniformity, the interpolation
+        error and the time needed for a lookup of each table are
+        measured and reported on cerr.
+        \return an error message if the model requires lookup tables
+	that are not enabled, an empty string otherwise. */
+  string generateLookupTables( bool check=false );
 
   string initStatus( vector<float> &statusInput,
 		     vector<string> &statusInputNames, vector<string> &statusInputUnits );
@@ -11,6 +11,8 @@ GlobalEField & = & Amplitude \cdot \cos(2 \pi \varphi(t)) \end{array} \f]
 - Frequency: Frequency of sine wave in Hz
 */
 
+#include "lookuptable.h"
+
 #if defined (__KERNEL__) || defined (DYNCLAMPMODEL)
 
   /*! Name, by which this model is known inside Linux: */
@@ -53,28 +55,29 @@ float paramOutput[PARAMOUTPUT_N] = { 0.0, 0.0 };
 
   /*! Variables used by the model. */
 float phase = 0.0;
+#ifdef ENABLE_LOOKUPTABLES
+struct lookupTableT cosineTable;
+#define cosine( x ) lookupLinear( &cosineTable, x )
+#endif
 
 void initModel( void )
 {
    modelName = "eod";
    phase = 0.0;
+#ifdef ENABLE_LOOKUPTABLES
+   initLookupTable( &cosineTable, lookupx[0], lookupy[0], lookupn[0] );
+#endif
 }
 
 void computeModel( void )
 {
-#ifdef ENABLE_LOOKUPTABLES
-  int k;
-#endif
-
   // phase:
   phase += paramOutput[1] * loopInterval;
   if ( phase >= 1.0 )
     phase -= 1.0;
 #ifdef ENABLE_LOOKUPTABLES
   // cosine from lookuptable:
-  k = phase*lookupn[0];
-  // eod:
-  output[0] = paramOutput[0] * lookupy[0][k];
+  output[0] = paramOutput[0] * cosine( phase );
 #else
   output[0] = paramOutput[0] * cos( 2.0*M_PI*phase );
 #endif
@@ -85,6 +88,12 @@ void computeModel( void )
 #ifndef __KERNEL__
 #ifdef ENABLE_LOOKUPTABLES
 
+/*! One period of the cosine function for the lookup table. */
+double cosineFunc( double x )
+{
+  return cos( 2.0*M_PI*x );
+}
+
 /*! This function is called from DynClampAnalogOutput in user
     space/C++ context and can be used to create some lookuptables for
     nonlinear functions to be used by computeModel(). The implementation of this
@@ -98,17 +107,9 @@ void computeModel( void )
 int generateLookupTable( int k, float **x, float **y, int *n )
 {
   if ( k == 0 ) {
-    /* Lookup-table for one period of the sine function: */
-    const int nn = 100000;
-    *n = nn;
-    *x = new float[nn];
-    *y = new float[nn];
-    for ( int j=0; j<nn; j++ ) {
-      float xx = j*1.0/nn;
-      (*x)[j] = xx;
-      (*y)[j] = sin( 2.0*M_PI*xx );
-    }
-    return 0;
+    /* Lookup-table for one period of the cosine function, linearly interpolated: */
+    *n = 4097;
+    return generateUniformLookupTable( 0.0, 1.0, cosineFunc, x, y, *n );
   }
   return -1;
 }
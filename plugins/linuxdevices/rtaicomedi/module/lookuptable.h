@@ -0,0 +1,159 @@
+/* LOOKUP TABLES ON UNIFORM GRIDS SHARED BETWEEN USER SPACE AND KERNEL SPACE */
+
+// Include this file at the top of a dynamic clamp model.
+// In kernel space and in the dynamic clamp simulation it provides
+// interpolation of lookup tables that have been generated with
+// generateLookupTable() on a uniform grid of x-values.
+// The index into the table is computed directly from the x-value,
+// no search is needed.
+//
+// In the model, initialize a struct lookupTableT for each table
+// in initModel():
+//   struct lookupTableT boltzmannTable;
+//   initLookupTable( &boltzmannTable, lookupx[0], lookupy[0], lookupn[0] );
+// and define a meaningful name for the interpolated function:
+//   #define boltzmann( x ) lookupLinear( &boltzmannTable, x )
+//
+// Define REQUIRE_LOOKUPTABLES in a model that cannot be computed
+// without lookup tables. Opening the dynamic clamp devices then fails
+// if lookup tables are not enabled (--enable-dynclamp-lookuptables).
+
+#ifndef _LOOKUPTABLE_H_
+#define _LOOKUPTABLE_H_
+
+#ifdef ENABLE_LOOKUPTABLES
+
+  /*! A lookup table on a uniform grid. */
+struct lookupTableT {
+    /*! The number of elements of the table. */
+  int n;
+    /*! The first x-value. */
+  float xmin;
+    /*! The last x-value. */
+  float xmax;
+    /*! One over the spacing of the x-values. */
+  float idx;
+    /*! The y-values. */
+  const float *y;
+};
+
+
+  /*! Initializes the lookup table \a table with the \a n values \a x
+      and \a y as generated by generateLookupTable().
+      The x-values are assumed to be uniformly spaced and increasing.
+      \return 0 on success, -1 if the table has less than two elements or
+      non-increasing x-values. The table then returns zero for all x. */
+static inline int initLookupTable( struct lookupTableT *table,
+				   const float *x, const float *y, int n )
+{
+  if ( x == 0 || y == 0 || n < 2 || x[n-1] <= x[0] ) {
+    table->n = 0;
+    table->xmin = 0.0;
+    table->xmax = 0.0;
+    table->idx = 1.0;
+    table->y = 0;
+    return -1;
+  }
+  table->n = n;
+  table->xmin = x[0];
+  table->xmax = x[n-1];
+  table->idx = (n-1)/(x[n-1]-x[0]);
+  table->y = y;
+  return 0;
+}
+
+
+  /*! Returns the y-value of the table element closest to \a x.
+      \a x is clamped to the range of the table. */
+static inline float lookupNearest( const struct lookupTableT *table, float x )
+{
+  float r;
+  if ( table->n <= 0 )
+    return 0.0;
+  if ( x <= table->xmin )
+    return table->y[0];
+  if ( x >= table->xmax )
+    return table->y[table->n-1];
+  r = (x-table->xmin)*table->idx + 0.5;
+  return table->y[(int)r];
+}
+
+
+  /*! Returns the linearly interpolated y-value of \a table at \a x.
+      \a x is clamped to the range of the table. */
+static inline float lookupLinear( const struct lookupTableT *table, float x )
+{
+  float r;
+  int k;
+  if ( table->n <= 0 )
+    return 0.0;
+  if ( x <= table->xmin )
+    return table->y[0];
+  if ( x >= table->xmax )
+    return table->y[table->n-1];
+  r = (x-table->xmin)*table->idx;
+  k = (int)r;
+  if ( k >= table->n-1 )
+    return table->y[table->n-1];
+  r -= k;
+  return table->y[k] + r*(table->y[k+1]-table->y[k]);
+}
+
+
+  /*! Returns the y-value of \a table at \a x interpolated by a
+      cubic Catmull-Rom spline through the four closest table elements.
+      \a x is clamped to the range of the table. */
+static inline float lookupCubic( const struct lookupTableT *table, float x )
+{
+  float r, y0, y1, y2, y3;
+  int k;
+  if ( table->n <= 0 )
+    return 0.0;
+  if ( x <= table->xmin )
+    return table->y[0];
+  if ( x >= table->xmax )
+    return table->y[table->n-1];
+  r = (x-table->xmin)*table->idx;
+  k = (int)r;
+  if ( k >= table->n-1 )
+    return table->y[table->n-1];
+  r -= k;
+  y1 = table->y[k];
+  y2 = table->y[k+1];
+  y0 = k > 0 ? table->y[k-1] : 2.0*y1 - y2;
+  y3 = k+2 < table->n ? table->y[k+2] : 2.0*y2 - y1;
+  return y1 + 0.5*r*( y2 - y0 + r*( 2.0*y0 - 5.0*y1 + 4.0*y2 - y3 + r*( 3.0*(y1 - y2) + y3 - y0 ) ) );
+}
+
+#endif
+
+#ifndef __KERNEL__
+#ifdef ENABLE_LOOKUPTABLES
+
+  /*! Allocates \a x and \a y arrays of size \a n with \a n uniformly
+      spaced x-values between \a xmin and \a xmax, both inclusive,
+      and y-values given by the function \a f.
+      Use this in generateLookupTable() to create tables
+      that can be used with initLookupTable().
+      \return 0 on success, -1 if \a n is less than two. */
+static inline int generateUniformLookupTable( float xmin, float xmax,
+					      double (*f)( double x ),
+					      float **x, float **y, int n )
+{
+  int j;
+  if ( n < 2 )
+    return -1;
+  *x = new float[n];
+  *y = new float[n];
+  for ( j=0; j<n; j++ ) {
+    double xx = xmin + j*(xmax-xmin)/(n-1);
+    (*x)[j] = xx;
+    (*y)[j] = f( xx );
+  }
+  return 0;
+}
+
+#endif
+#endif
+
+#endif
@@ -18,6 +18,8 @@ vgatetau \cdot \frac{dx}{dt} & = & -x + \frac{1}{1+\exp(-vgateslope \cdot (V-vga
 - vgatetau: time constant of the gating variable in ms
 */
 
+#include "lookuptable.h"
+
 #if defined (__KERNEL__) || defined (DYNCLAMPMODEL)
 
   /*! Name, by which this model is known inside Linux: */
@@ -63,9 +65,8 @@ float paramOutput[PARAMOUTPUT_N] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.1, 10.0 };
 float previnputs[MAXPREVINPUTS];
 float vgate = 0.0;
 #ifdef ENABLE_LOOKUPTABLES
-float xmin = 0.0;
-float xmax = 0.0;
-float dx = 1.0;
+struct lookupTableT boltzmannTable;
+#define boltzmann( x ) lookupLinear( &boltzmannTable, x )
 #endif
 
 void initModel( void )
@@ -79,27 +80,13 @@ void initModel( void )
 
 #ifdef ENABLE_LOOKUPTABLES
   // steady-state activation from lookuptable:
-  if ( lookupn[0] > 0 ) {
-    xmin = lookupx[0][0];
-    xmax = lookupx[0][lookupn[0]-1];
-    dx = (xmax - xmin)/lookupn[0];
-    xmax -= dx;
-  }
-  else {
-    xmin = 0.0;
-    xmax = 0.0;
-    dx = 1.0;
-  }
+  initLookupTable( &boltzmannTable, lookupx[0], lookupy[0], lookupn[0] );
 #endif
 }
 
 void computeModel( void )
 {
   int k;
-#ifdef ENABLE_LOOKUPTABLES
-  float x;
-  int j;
-#endif
 
   // leak:
   paramInput[0] = -0.001*paramOutput[0]*(input[0]-paramOutput[1]);
@@ -113,13 +100,7 @@ void computeModel( void )
     paramOutput[7] = 0.1;
 #ifdef ENABLE_LOOKUPTABLES
   // steady-state activation from lookuptable:
-  x = paramOutput[6]*(input[0]-paramOutput[5]);
-  j = 0;
-  if ( x >= xmax )
-    j = lookupn[0]-1;
-  else if ( x >= xmin )
-    j = (x-xmin)/dx;
-  vgate += loopInterval*1000.0/paramOutput[7]*(-vgate+lookupy[0][j]);
+  vgate += loopInterval*1000.0/paramOutput[7]*(-vgate+boltzmann(paramOutput[6]*(input[0]-paramOutput[5])));
 #else
   vgate += loopInterval*1000.0/paramOutput[7]*(-vgate+1.0/(1.0+exp(-paramOutput[6]*(input[0]-paramOutput[5]))));
 #endif
@@ -133,6 +114,12 @@ void computeModel( void )
 #ifndef __KERNEL__
 #ifdef ENABLE_LOOKUPTABLES
 
+/*! The Boltzmann function for the lookup table. */
+double boltzmannFunc( double x )
+{
+  return 1.0/(1.0+exp(-x));
+}
+
 /*! This function is called from DynClampAnalogOutput in user
     space/C++ context and can be used to create some lookuptables for
     nonlinear functions to be used by computeModel(). The implementation of this
@@ -146,20 +133,9 @@ void computeModel( void )
 int generateLookupTable( int k, float **x, float **y, int *n )
 {
   if ( k == 0 ) {
-    /* Lookup-table for the Boltzmann function: */
-    const int nn = 100000;
-    const float xmin = -10.0;
-    const float xmax = 10.0;
-    const float dx = xmax - xmin;
-    *n = nn;
-    *x = new float[nn];
-    *y = new float[nn];
-    for ( int j=0; j<nn; j++ ) {
-      float xx = xmin + j*dx/nn;
-      (*x)[j] = xx;
-      (*y)[j] = 1.0/(1.0+exp(-xx));
-    }
-    return 0;
+    /* Lookup-table for the Boltzmann function, linearly interpolated: */
+    *n = 2001;
+    return generateUniformLookupTable( -10.0, 10.0, boltzmannFunc, x, y, *n );
   }
   return -1;
 }
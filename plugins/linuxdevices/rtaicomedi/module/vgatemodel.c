@@ -15,6 +15,8 @@ vgatetau \cdot \frac{dx}{dt} & = & -x + \frac{1}{1+\exp(-vgateslope \cdot (V-vga
 - vgatetau: time constant of the gating variable in ms
 */
 
+#include "lookuptable.h"
+
 #if defined (__KERNEL__) || defined (DYNCLAMPMODEL)
 
   /*! Name, by which this model is known inside Linux: */
@@ -59,9 +61,8 @@ float paramOutput[PARAMOUTPUT_N] = { 10.0, 0.0, 0.0, 0.1, 10.0 };
 float meaninput = 0.0;
 float vgate = 0.0;
 #ifdef ENABLE_LOOKUPTABLES
-float xmin = 0.0;
-float xmax = 0.0;
-float dx = 1.0;
+struct lookupTableT boltzmannTable;
+#define boltzmann( x ) lookupLinear( &boltzmannTable, x )
 #endif
 
 void initModel( void )
@@ -71,39 +72,18 @@ void initModel( void )
 
 #ifdef ENABLE_LOOKUPTABLES
   // steady-state activation from lookuptable:
-  if ( lookupn[0] > 0 ) {
-    xmin = lookupx[0][0];
-    xmax = lookupx[0][lookupn[0]-1];
-    dx = (xmax - xmin)/lookupn[0];
-    xmax -= dx;
-  }
-  else {
-    xmin = 0.0;
-    xmax = 0.0;
-    dx = 1.0;
-  }
+  initLookupTable( &boltzmannTable, lookupx[0], lookupy[0], lookupn[0] );
 #endif
 }
 
 void computeModel( void )
 {
-#ifdef ENABLE_LOOKUPTABLES
-  float x;
-  int k;
-#endif
-
   // voltage gated channel:
   if ( paramOutput[4] < 0.1 )
     paramOutput[4] = 0.1;
 #ifdef ENABLE_LOOKUPTABLES
   // steady-state activation from lookuptable:
-  x = paramOutput[3]*(input[0]-paramOutput[2]);
-  k = 0;
-  if ( x >= xmax )
-    k = lookupn[0]-1;
-  else if ( x >= xmin )
-    k = (x-xmin)/dx;
-  vgate += loopInterval*1000.0/paramOutput[4]*(-vgate+lookupy[0][k]);
+  vgate += loopInterval*1000.0/paramOutput[4]*(-vgate+boltzmann(paramOutput[3]*(input[0]-paramOutput[2])));
 #else
   vgate += loopInterval*1000.0/paramOutput[4]*(-vgate+1.0/(1.0+exp(-paramOutput[3]*(input[0]-paramOutput[2]))));
 #endif
@@ -117,6 +97,12 @@ void computeModel( void )
 #ifndef __KERNEL__
 #ifdef ENABLE_LOOKUPTABLES
 
+/*! The Boltzmann function for the lookup table. */
+double boltzmannFunc( double x )
+{
+  return 1.0/(1.0+exp(-x));
+}
+
 /*! This function is called from DynClampAnalogOutput in user
     space/C++ context and can be used to create some lookuptables for
     nonlinear functions to be used by computeModel(). The implementation of this
@@ -130,20 +116,9 @@ void computeModel( void )
 int generateLookupTable( int k, float **x, float **y, int *n )
 {
   if ( k == 0 ) {
-    /* Lookup-table for the Boltzmann function: */
-    const int nn = 100000;
-    const float xmin = -10.0;
-    const float xmax = 10.0;
-    const float dx = xmax - xmin;
-    *n = nn;
-    *x = new float[nn];
-    *y = new float[nn];
-    for ( int j=0; j<nn; j++ ) {
-      float xx = xmin + j*dx/nn;
-      (*x)[j] = xx;
-      (*y)[j] = 1.0/(1.0+exp(-xx));
-    }
-    return 0;
+    /* Lookup-table for the Boltzmann function, linearly interpolated: */
+    *n = 2001;
+    return generateUniformLookupTable( -10.0, 10.0, boltzmannFunc, x, y, *n );
   }
   return -1;
 }
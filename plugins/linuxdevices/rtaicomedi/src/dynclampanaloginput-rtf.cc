@@ -242,6 +242,12 @@ int DynClampAnalogInput::open( const string &device)
 
   // compute lookup tables:
 #ifdef ENABLE_COMPUTATION
+#if defined( REQUIRE_LOOKUPTABLES ) && ! defined( ENABLE_LOOKUPTABLES )
+  setErrorStr( "dynamic clamp model requires lookup tables, but they are not enabled! Please reconfigure with --enable-dynclamp-lookuptables and recompile plugins/linuxdevices/rtaicomedi ." );
+  ::ioctl( ModuleFd, IOC_REQ_CLOSE, SubDevice );
+  ::close( ModuleFd );
+  return -1;
+#endif
 #ifdef ENABLE_LOOKUPTABLES
   for ( int k=0; ; k++ ) {
     float *x = 0;
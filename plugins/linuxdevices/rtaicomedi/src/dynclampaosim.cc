@@ -29,6 +29,7 @@ namespace relacs {
 DynClampAOSim::DynClampAOSim( void ) 
   : AOSim()
 {
+  addBoolean( "checklookuptables", "Report accuracy and speed of the lookup tables", false );
 }
 
 
@@ -40,7 +41,11 @@ DynClampAOSim::~DynClampAOSim( void )
 int DynClampAOSim::open( const string &device )
 {
   AOSim::open( device );
-  dynclampmodelsim::generateLookupTables();
+  string error = dynclampmodelsim::generateLookupTables( boolean( "checklookuptables" ) );
+  if ( ! error.empty() ) {
+    setErrorStr( error );
+    return -1;
+  }
   setDeviceName( "Dynamic Clamp AO Simulation" );
   // publish information about the analog input device:
   setInfo();
@@ -58,7 +63,11 @@ int DynClampAOSim::open( const string &device )
 int DynClampAOSim::open( Device &device )
 {
   AOSim::open( device );
-  dynclampmodelsim::generateLookupTables();
+  string error = dynclampmodelsim::generateLookupTables( boolean( "checklookuptables" ) );
+  if ( ! error.empty() ) {
+    setErrorStr( error );
+    return -1;
+  }
   setDeviceName( "Dynamic Clamp AO Simulation" );
   setInfo();
   return 0;
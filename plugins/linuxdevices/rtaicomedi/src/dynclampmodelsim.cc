@@ -20,6 +20,8 @@
 */
 
 #include <math.h>
+#include <time.h>
+#include <iostream>
 #include <relacs/parameter.h>
 #include <relacs/rtaicomedi/moduledef.h>
 #include <relacs/rtaicomedi/dynclampmodelsim.h>
@@ -42,25 +44,88 @@ float* lookupx[MAXLOOKUPTABLES];
 float* lookupy[MAXLOOKUPTABLES];
 #endif
 
+#include "../module/lookuptable.h"
 #define DYNCLAMPMODEL
 #include "../module/model.c"
 #undef DYNCLAMPMODEL
 
+#ifdef ENABLE_LOOKUPTABLES
+
+  /*! Checks the uniform grid of lookup table \a k and reports its
+      interpolation error and the time needed for a lookup on cerr. */
+void checkLookupTable( int k )
+{
+  const float *x = lookupx[k];
+  const float *y = lookupy[k];
+  int n = lookupn[k];
+  if ( x == 0 || y == 0 || n < 2 ) {
+    cerr << "lookup table " << k << ": empty\n";
+    return;
+  }
+
+  // uniform grid:
+  double dx = ( x[n-1] - x[0] )/( n-1 );
+  double maxdev = 0.0;
+  for ( int j=0; j<n; j++ ) {
+    double dev = ::fabs( x[j] - x[0] - j*dx );
+    if ( dev > maxdev )
+      maxdev = dev;
+  }
+  if ( maxdev > 0.01*dx )
+    cerr << "lookup table " << k << ": x-values are not uniformly spaced, deviation "
+	 << maxdev/dx << " of grid spacing\n";
+
+  // interpolation error at the midpoints between grid points,
+  // estimated from the difference between linear and cubic interpolation:
+  struct lookupTableT table;
+  initLookupTable( &table, x, y, n );
+  double maxerr = 0.0;
+  for ( int j=0; j<n-1; j++ ) {
+    float xx = x[j] + 0.5*dx;
+    double err = ::fabs( lookupLinear( &table, xx ) - lookupCubic( &table, xx ) );
+    if ( err > maxerr )
+      maxerr = err;
+  }
+
+  // speed:
+  const int m = 1000000;
+  volatile float sum = 0.0;
+  timespec t0, t1;
+  clock_gettime( CLOCK_MONOTONIC, &t0 );
+  for ( int j=0; j<m; j++ )
+    sum += lookupLinear( &table, x[0] + (x[n-1]-x[0])*( j%1009 )/1008.0 );
+  clock_gettime( CLOCK_MONOTONIC, &t1 );
+  double ns = ( ( t1.tv_sec - t0.tv_sec )*1.0e9 + ( t1.tv_nsec - t0.tv_nsec ) )/m;
+
+  cerr << "lookup table " << k << ": " << n << " elements from " << x[0]
+       << " to " << x[n-1] << ", linear interpolation error " << maxerr
+       << ", " << ns << "ns per lookup\n";
+}
+
+#endif
+
 #endif
 
-void generateLookupTables( void )
+
+string generateLookupTables( bool check )
 {
 #ifdef ENABLE_COMPUTATION
+#if defined( REQUIRE_LOOKUPTABLES ) && ! defined( ENABLE_LOOKUPTABLES )
+  return "dynamic clamp model requires lookup tables, but they are not enabled";
+#endif
 #ifdef ENABLE_LOOKUPTABLES
-  for ( int k=0; ; k++ ) {
+  for ( int k=0; k<MAXLOOKUPTABLES; k++ ) {
     lookupx[k] = 0;
     lookupy[k] = 0;
     lookupn[k] = 0;
     if ( generateLookupTable( k, &lookupx[k], &lookupy[k], &lookupn[k] ) < 0 ) 
       break;
+    if ( check )
+      checkLookupTable( k );
   }
 #endif
 #endif
+  return "";
 }
 
 
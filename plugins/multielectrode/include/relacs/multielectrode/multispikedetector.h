@@ -0,0 +1,164 @@
+/*
+  multielectrode/multispikedetector.h
+  Joint spike detection on many electrodes of a tetrode or multielectrode array
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_MULTIELECTRODE_MULTISPIKEDETECTOR_H_
+#define _RELACS_MULTIELECTRODE_MULTISPIKEDETECTOR_H_ 1
+
+#include <vector>
+#include <relacs/array.h>
+#include <relacs/optwidget.h>
+#include <relacs/filter.h>
+using namespace std;
+using namespace relacs;
+
+namespace multielectrode {
+
+
+/*!
+\class MultiSpikeDetector
+\brief [Detector] Joint spike detection on many electrodes of a tetrode or multielectrode array
+\author Jan Benda
+\version 1.0 (Oct 18, 2026)
+
+All input traces are processed together in blocks of BlockSize
+samples. For each block a single pass over the contiguous data of
+each electrode computes the extreme values and the noise level.
+Only blocks where at least one electrode exceeds its threshold
+are scanned sample by sample.
+
+Each electrode has its own threshold that is \c threshfac times
+the standard deviation of the noise, but at least \c minthresh.
+Baseline and noise are estimated from blocks without threshold
+crossings with the time constant \c noisetime.
+
+A threshold crossing on any electrode opens a window of \c window
+duration, within which the largest deviation from the baseline
+across all electrodes is the spike. The spike is added to the
+events of the electrode with the largest deviation (the peak channel),
+with the deviation as its size and the width at half of the size as its width.
+No further spike is detected on any electrode within \c deadtime after a spike.
+
+All input traces need to have the same sampling rate.
+
+\par Options
+- \c Detector
+    - \c threshfac=5: Threshold factor relative to noise standard deviation (\c number)
+    - \c minthresh=0.01mV: Minimum threshold (\c number)
+    - \c noisetime=1sec: Time constant for noise estimate (\c number)
+    - \c detectpeaks=false: Detect peaks (or troughs if unchecked) (\c boolean)
+    - \c window=0.5ms: Window for the spatial-temporal peak (\c number)
+    - \c deadtime=1ms: Dead time across all electrodes (\c number)
+- \c Indicators
+    - \c rate=0Hz: Total rate of all electrodes (\c number)
+    - \c size=0mV: Mean spike size (\c number)
+    - \c noise=0mV: Mean noise standard deviation (\c number)
+*/
+
+
+class MultiSpikeDetector : public Filter
+{
+  Q_OBJECT
+
+public:
+
+  MultiSpikeDetector( const string &ident="", int mode=0 );
+  virtual int init( const InList &data, EventList &outevents,
+		    const EventList &other, const EventData &stimuli );
+  virtual void readConfig( StrQueue &sq );
+  virtual void notify( void );
+  virtual int adjust( const InList &data );
+  virtual int autoConfigure( const InList &data, double tbegin, double tend );
+    /*! Detect spikes jointly in all traces of the analog data \a data. */
+  virtual int detect( const InList &data, EventList &outevents,
+		      const EventList &other, const EventData &stimuli );
+
+
+public slots:
+
+  void autoConfigure( void );
+
+
+protected:
+
+    /*! Extreme values \a min and \a max, \a sum and sum of squares
+        \a sumsq of the \a n data elements of \a data starting at \a index. */
+  void blockStats( const InData &data, int index, int n,
+		   float &min, float &max, double &sum, double &sumsq ) const;
+    /*! Width of the spike at index \a index of \a data
+        at half of its size \a size, searching up to index \a end. */
+  double spikeWidth( const InData &data, int index, int end,
+		     double baseline, double size ) const;
+    /*! Update the threshold of electrode \a c from its noise level. */
+  void setThreshold( int c );
+
+    /*! The number of samples that are processed at once. */
+  static const int BlockSize = 64;
+
+    /*! Threshold in multiples of the noise standard deviation. */
+  double ThreshFac;
+    /*! Minimum threshold. */
+  double MinThresh;
+    /*! Time constant for the noise estimate in seconds. */
+  double NoiseTime;
+    /*! Detect peaks (true) or troughs (false ). */
+  bool DetectPeaks;
+    /*! Window for the spatial-temporal peak in seconds. */
+  double Window;
+    /*! Dead time in seconds. */
+  double DeadTime;
+    /*! Unit of the input traces. */
+  string Unit;
+
+    /*! The baseline of each electrode. */
+  ArrayD Baseline;
+    /*! The noise variance of each electrode. */
+  ArrayD Variance;
+    /*! The detection threshold of each electrode. */
+  ArrayD Threshold;
+    /*! Electrodes that cross their threshold within the current block. */
+  vector< bool > Active;
+    /*! True if baseline and noise have been estimated. */
+  bool NoiseInit;
+
+    /*! Index of the next sample to be analyzed. */
+  int Index;
+    /*! True while searching the peak of a spike. */
+  bool Pending;
+    /*! Index of the end of the peak window. */
+  int PeakEnd;
+    /*! Index of the largest deviation within the peak window. */
+  int PeakIndex;
+    /*! Electrode of the largest deviation within the peak window. */
+  int PeakChannel;
+    /*! The largest deviation within the peak window. */
+  double PeakSize;
+    /*! No spikes are detected before this index. */
+  int DeadEnd;
+
+  const InList *Data;
+  OptWidget SDW;
+
+};
+
+
+}; /* namespace multielectrode */
+
+#endif /* ! _RELACS_MULTIELECTRODE_MULTISPIKEDETECTOR_H_ */
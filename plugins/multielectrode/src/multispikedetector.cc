@@ -0,0 +1,382 @@
+/*
+  multielectrode/multispikedetector.cc
+  Joint spike detection on many electrodes of a tetrode or multielectrode array
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <relacs/multielectrode/multispikedetector.h>
+using namespace relacs;
+
+namespace multielectrode {
+
+
+MultiSpikeDetector::MultiSpikeDetector( const string &ident, int mode )
+  : Filter( ident, mode, MultipleAnalogDetector, 0,
+	    "MultiSpikeDetector", "multielectrode",
+	    "Jan Benda", "1.0", "Oct 18, 2026" )
+{
+  // parameter:
+  ThreshFac = 5.0;
+  MinThresh = 0.01;
+  NoiseTime = 1.0;
+  DetectPeaks = false;
+  Window = 0.0005;
+  DeadTime = 0.001;
+  Unit = "mV";
+  NoiseInit = false;
+  Index = 0;
+  Pending = false;
+  PeakEnd = 0;
+  PeakIndex = 0;
+  PeakChannel = 0;
+  PeakSize = 0.0;
+  DeadEnd = 0;
+  Data = 0;
+
+  // options:
+  int strongstyle = OptWidget::ValueLarge + OptWidget::ValueBold + OptWidget::ValueGreen + OptWidget::ValueBackBlack;
+  newSection( "Detector", 8 );
+  addNumber( "threshfac", "Threshold factor relative to noise standard deviation", ThreshFac, 0.5, 100.0, 0.5, "", "", "%.1f", 2+8 );
+  addNumber( "minthresh", "Minimum threshold", MinThresh, 0.0, 10000.0, 0.001, Unit, Unit, "%.3f", 0+8 );
+  addNumber( "noisetime", "Time constant for noise estimate", NoiseTime, 0.01, 1000.0, 0.1, "sec", "sec", "%.2f", 0+8 );
+  addBoolean( "detectpeaks", "Detect peaks (or troughs if unchecked)", DetectPeaks, 8 );
+  addNumber( "window", "Window for the spatial-temporal peak", Window, 0.0, 0.01, 0.0001, "sec", "ms", "%.1f", 0+8 );
+  addNumber( "deadtime", "Dead time across all electrodes", DeadTime, 0.0, 0.1, 0.0001, "sec", "ms", "%.1f", 0+8 );
+  newSection( "Indicators", 4 );
+  addNumber( "rate", "Total rate of all electrodes", 0.0, 0.0, 1000000.0, 0.1, "Hz", "Hz", "%.0f", 0+4 );
+  addNumber( "size", "Mean spike size", 0.0, 0.0, 10000.0, 0.1, Unit, Unit, "%.3f", 2+4, strongstyle );
+  addNumber( "noise", "Mean noise standard deviation", 0.0, 0.0, 10000.0, 0.1, Unit, Unit, "%.3f", 0+4 );
+
+  setDialogSelectMask( 8 );
+  setConfigSelectMask( -8 );
+
+  // main layout:
+  QVBoxLayout *vbox = new QVBoxLayout;
+  vbox->setContentsMargins( 0, 0, 0, 0 );
+  vbox->setSpacing( 0 );
+  setLayout( vbox );
+
+  // parameter widgets:
+  SDW.assign( ((Options*)this), 2, 4, true, 0, mutex() );
+  SDW.setMargins( 4, 2, 4, 0 );
+  SDW.setVerticalSpacing( 1 );
+  vbox->addWidget( &SDW );
+
+  QHBoxLayout *hbox = new QHBoxLayout;
+  vbox->addLayout( hbox );
+  hbox->addWidget( new QLabel( "" ) );
+
+  // dialog button:
+  QPushButton *pb = new QPushButton( "Dialog" );
+  hbox->addWidget( pb );
+  connect( pb, SIGNAL( clicked( void ) ), this, SLOT( dialog( void ) ) );
+  connect( pb, SIGNAL( clicked( void ) ), this, SLOT( removeFocus( void ) ) );
+  hbox->addWidget( new QLabel( "" ) );
+
+  // auto configure button:
+  pb = new QPushButton( "Auto" );
+  hbox->addWidget( pb );
+  connect( pb, SIGNAL( clicked( void ) ), this, SLOT( autoConfigure( void ) ) );
+  connect( pb, SIGNAL( clicked( void ) ), this, SLOT( removeFocus( void ) ) );
+  hbox->addWidget( new QLabel( "" ) );
+}
+
+
+int MultiSpikeDetector::init( const InList &data, EventList &outevents,
+			      const EventList &other, const EventData &stimuli )
+{
+  Data = &data;
+  if ( data.size() > 0 )
+    Unit = data[0].unit();
+  setOutUnit( "minthresh", Unit );
+  setOutUnit( "size", Unit );
+  setOutUnit( "noise", Unit );
+  setNotify();
+  notify();
+  for ( int k=0; k<outevents.size(); k++ ) {
+    outevents[k].setSizeScale( 1.0 );
+    outevents[k].setSizeUnit( Unit );
+    outevents[k].setSizeFormat( "%5.3f" );
+    outevents[k].setWidthScale( 1000.0 );
+    outevents[k].setWidthUnit( "ms" );
+    outevents[k].setWidthFormat( "%4.2f" );
+  }
+  Baseline = ArrayD( data.size(), 0.0 );
+  Variance = ArrayD( data.size(), 0.0 );
+  Threshold = ArrayD( data.size(), MinThresh );
+  Active.assign( data.size(), false );
+  NoiseInit = false;
+  Index = 0;
+  for ( int c=0; c<data.size(); c++ ) {
+    if ( c == 0 || data[c].size() < Index )
+      Index = data[c].size();
+  }
+  Pending = false;
+  DeadEnd = Index;
+  SDW.updateSettings();
+  SDW.updateValues();
+  return 0;
+}
+
+
+void MultiSpikeDetector::readConfig( StrQueue &sq )
+{
+  unsetNotify(); // we have no unit of the input traces yet!
+  Options::read( sq, 0, ":" );
+}
+
+
+void MultiSpikeDetector::notify( void )
+{
+  ThreshFac = number( "threshfac" );
+  MinThresh = number( "minthresh", Unit );
+  NoiseTime = number( "noisetime" );
+  DetectPeaks = boolean( "detectpeaks" );
+  Window = number( "window" );
+  DeadTime = number( "deadtime" );
+  for ( int c=0; c<Threshold.size(); c++ )
+    setThreshold( c );
+  SDW.updateValues( OptWidget::changedFlag() );
+}
+
+
+int MultiSpikeDetector::adjust( const InList &data )
+{
+  // the gain changed, estimate the noise anew:
+  NoiseInit = false;
+  return 0;
+}
+
+
+void MultiSpikeDetector::autoConfigure( void )
+{
+  if ( Data == 0 || Data->empty() )
+    return;
+  lock();
+  double tend = (*Data)[0].currentTime();
+  double tbegin = tend - NoiseTime;
+  if ( tbegin < (*Data)[0].minTime() )
+    tbegin = (*Data)[0].minTime();
+  autoConfigure( *Data, tbegin, tend );
+  unlock();
+}
+
+
+int MultiSpikeDetector::autoConfigure( const InList &data,
+				       double tbegin, double tend )
+{
+  if ( Baseline.size() != data.size() )
+    return 0;
+  for ( int c=0; c<data.size(); c++ ) {
+    Baseline[c] = data[c].mean( tbegin, tend );
+    double sd = data[c].stdev( tbegin, tend );
+    Variance[c] = sd*sd;
+    setThreshold( c );
+  }
+  NoiseInit = true;
+  return 0;
+}
+
+
+void MultiSpikeDetector::setThreshold( int c )
+{
+  Threshold[c] = ThreshFac * ::sqrt( Variance[c] );
+  if ( Threshold[c] < MinThresh )
+    Threshold[c] = MinThresh;
+}
+
+
+void MultiSpikeDetector::blockStats( const InData &data, int index, int n,
+				     float &min, float &max,
+				     double &sum, double &sumsq ) const
+{
+  min = HUGE_VALF;
+  max = -HUGE_VALF;
+  sum = 0.0;
+  sumsq = 0.0;
+  // at most two contiguous pieces in the cyclic buffer:
+  while ( n > 0 ) {
+    const float *d = 0;
+    int m = data.span( index, n, d );
+    if ( m <= 0 )
+      break;
+    for ( int k=0; k<m; k++ ) {
+      float x = d[k];
+      if ( x < min )
+	min = x;
+      if ( x > max )
+	max = x;
+      sum += x;
+      sumsq += x*x;
+    }
+    index += m;
+    n -= m;
+  }
+}
+
+
+double MultiSpikeDetector::spikeWidth( const InData &data, int index, int end,
+				       double baseline, double size ) const
+{
+  double sign = DetectPeaks ? 1.0 : -1.0;
+  double thresh = 0.5*size;
+  int n = data.indices( Window );
+  int left = index;
+  for ( ; left > data.minIndex() && left > index - n; left-- ) {
+    if ( sign*( data[left-1] - baseline ) <= thresh )
+      break;
+  }
+  int right = index;
+  for ( ; right+1 < end && right < index + n; right++ ) {
+    if ( sign*( data[right+1] - baseline ) <= thresh )
+      break;
+  }
+  return data.interval( right - left + 1 );
+}
+
+
+int MultiSpikeDetector::detect( const InList &data, EventList &outevents,
+				const EventList &other, const EventData &stimuli )
+{
+  int nc = data.size();
+  if ( nc == 0 || Threshold.size() != nc )
+    return 0;
+
+  // common range of all traces:
+  int end = data[0].size();
+  for ( int c=0; c<nc; c++ ) {
+    if ( data[c].size() < end )
+      end = data[c].size();
+    if ( Index < data[c].minIndex() )
+      Index = data[c].minIndex();
+  }
+
+  double sign = DetectPeaks ? 1.0 : -1.0;
+  int windowindices = data[0].indices( Window );
+  int deadindices = data[0].indices( DeadTime );
+  double weight = data[0].interval( BlockSize ) / NoiseTime;
+  if ( weight > 1.0 )
+    weight = 1.0;
+
+  // complete blocks only, the rest is analyzed next time:
+  while ( Index + BlockSize <= end ) {
+    int n = BlockSize;
+
+    // one pass over the block of each electrode:
+    bool active = Pending;
+    for ( int c=0; c<nc; c++ ) {
+      float min, max;
+      double sum, sumsq;
+      blockStats( data[c], Index, n, min, max, sum, sumsq );
+      // mean squared deviation from the baseline:
+      double m = sum/n;
+      if ( ! NoiseInit )
+	Baseline[c] = m;
+      double var = sumsq/n - 2.0*Baseline[c]*m + Baseline[c]*Baseline[c];
+      if ( ! NoiseInit ) {
+	Variance[c] = var;
+	setThreshold( c );
+      }
+      double ext = DetectPeaks ? max - Baseline[c] : Baseline[c] - min;
+      Active[c] = ( ext > Threshold[c] );
+      if ( Active[c] )
+	active = true;
+      else if ( NoiseInit ) {
+	Baseline[c] += weight*( m - Baseline[c] );
+	Variance[c] += weight*( var - Variance[c] );
+	setThreshold( c );
+      }
+    }
+    NoiseInit = true;
+
+    // spatial-temporal peaks:
+    if ( active ) {
+      for ( int k=Index; k<Index+n; k++ ) {
+	if ( ! Pending && k < DeadEnd )
+	  continue;
+	for ( int c=0; c<nc; c++ ) {
+	  if ( ! Active[c] )
+	    continue;
+	  double d = sign*( data[c][k] - Baseline[c] );
+	  if ( Pending ) {
+	    if ( d > PeakSize ) {
+	      PeakSize = d;
+	      PeakIndex = k;
+	      PeakChannel = c;
+	    }
+	  }
+	  else if ( d > Threshold[c] && d > PeakSize ) {
+	    PeakSize = d;
+	    PeakIndex = k;
+	    PeakChannel = c;
+	  }
+	}
+	if ( ! Pending && PeakSize > 0.0 ) {
+	  Pending = true;
+	  PeakEnd = k + windowindices;
+	}
+	if ( Pending && k >= PeakEnd ) {
+	  const InData &pd = data[PeakChannel];
+	  double width = spikeWidth( pd, PeakIndex, end,
+				     Baseline[PeakChannel], PeakSize );
+	  outevents[PeakChannel].push( pd.pos( PeakIndex ), PeakSize, width );
+	  Pending = false;
+	  PeakSize = 0.0;
+	  DeadEnd = PeakIndex + deadindices;
+	}
+      }
+    }
+
+    Index += n;
+  }
+
+  // indicators:
+  double rate = 0.0;
+  double size = 0.0;
+  int ns = 0;
+  for ( int c=0; c<nc; c++ ) {
+    rate += outevents[c].meanRate();
+    if ( outevents[c].size() > 0 ) {
+      size += outevents[c].meanSize();
+      ns++;
+    }
+  }
+  double noise = 0.0;
+  for ( int c=0; c<nc; c++ )
+    noise += ::sqrt( Variance[c] );
+  unsetNotify();
+  setNumber( "rate", rate );
+  setNumber( "size", ns > 0 ? size/ns : 0.0, Unit );
+  setNumber( "noise", noise/nc, Unit );
+  setNotify();
+  SDW.updateValues( OptWidget::changedFlag() );
+
+  return 0;
+}
+
+
+addDetector( MultiSpikeDetector, multielectrode );
+
+}; /* namespace multielectrode */
+
+#include "moc_multispikedetector.cc"
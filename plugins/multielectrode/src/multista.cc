@@ -19,6 +19,7 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <relacs/stats.h>
 #include <relacs/multielectrode/multista.h>
 using namespace relacs;
@@ -38,6 +39,7 @@ MultiSTA::MultiSTA( void )
   addBoolean( "plotsnippets", "Plot the individual snippets", true );
 
   // plot:
+  P.setBackgroundRendering();
   setWidget( &P );
 }
 
@@ -125,9 +127,16 @@ void MultiSTA::analyze( const InData &intrace, double interval )
     for ( int i=n; i<=p; i++ ) {
       STAs[k].Snippets.push_back( SampleDataF( STAs[k].Average.range(), 0.0 ) );
       SampleDataF &snippet = STAs[k].Snippets.back();
-      // copy data from trace into snippet:
-      for ( int j=0; j<snippet.size(); j++ )
-	snippet[j] = intrace[ intrace.index( spikes[i] + snippet.pos( j ) ) ];
+      // copy data from trace into snippet, in contiguous pieces of the cyclic buffer:
+      int inx = intrace.index( spikes[i] + snippet.rangeFront() );
+      for ( int j=0; j<snippet.size(); ) {
+	const float *d = 0;
+	int m = intrace.span( inx+j, snippet.size()-j, d );
+	if ( m <= 0 )
+	  break;
+	copy( d, d+m, snippet.begin()+j );
+	j += m;
+      }
     }
 
     // compute the average (from numerics/include/relacs/stats.h):
@@ -55,10 +55,14 @@ public:
   //PNSubtraction( void );
   virtual int main( void );
 
-  SampleDataD PN_sub( OutData signal, Options &opts, double &holdingpotential, double &pause, double &mintime, double &maxtime, double &t0);
+  SampleDataD PN_sub( const OutData &stimulus, Options &opts, double &holdingpotential, double &pause, double &mintime, double &maxtime, double &t0);
 
 private:
-  ArrayD dxdt( const ArrayD &x, const double &dt );
+  OutData &qualityControlSignal( double holdingpotential, double stepduration,
+				 double pulseduration, double f0, double f1,
+				 double samplerate );
+  void addTrace( const InData &data, double time, SampleDataD &trace );
+  void dxdt( const ArrayD &x, double dt, ArrayD &dx, int kernelsize=1 );
   ArrayD pcsFitLeak( double stepduration );
   void pcsFitCapacitiveCurrents( ArrayD &params, double &stepduration );
   void pcsFitAllParams( ArrayD &param, double &stepduration );
@@ -82,6 +86,25 @@ private:
   ArrayD I;
   ArrayD dI;
 
+    // buffers reused from sweep to sweep:
+  OutData TraceSignal;
+  OutData PNSignal;
+  SampleDataD PNTrace;
+  ArrayD Smoothed;
+  ArrayD DPotential;
+  ArrayD D2Potential;
+  ArrayD DCurrent;
+
+    // the chirp of the quality control and its parameters:
+  OutData QCSignal;
+  Options QCDescription;
+  double QCHoldingPotential = 0.0;
+  double QCStepDuration = 0.0;
+  double QCPulseDuration = 0.0;
+  double QCF0 = 0.0;
+  double QCF1 = 0.0;
+  double QCSampleRate = 0.0;
+
 
 
   template < typename ForwardIterX, typename ForwardIterY,
@@ -20,6 +20,7 @@
 */
 
 #include <relacs/fitalgorithm.h>
+#include <relacs/marquardtfitloop.h>
 #include <relacs/voltageclamp/activation.h>
 #include <relacs/voltageclamp/pnsubtraction.h>
 #include <relacs/ephys/amplifiercontrol.h>
@@ -119,6 +120,13 @@ int Activation::main( void )
 	( repeats <= 0 || Count < repeats ) && softStop() == 0;
 	Count++ ) {
 
+    // data sets for fitting tau, fitted after the sweep:
+    std::vector< std::vector<double> > fitx;
+    std::vector< std::vector<double> > fity;
+    std::vector< ArrayD > fiterror;
+    std::vector< ArrayD > fitparams;
+    std::vector< int > fitsteps;
+
     int i = -1;
     for ( int step=mintest;  step<=maxtest; step+=teststep) {
       i += 1;
@@ -211,20 +219,11 @@ int Activation::main( void )
       param[0] = 1.5*currenttrace[index];
       param[1] = -1.0;
       param[2] = currenttrace[currenttrace.size()-1];
-      ArrayD error( currenttrace.size(), 1.0 );
-      ArrayD uncertainty( 3, 0.0 );
-      ArrayI paramfit( 3, 1 );
-      double chisq = 0.0;
-
-      int z = marquardtFit( x, y, error, expFuncDerivs, param, paramfit, uncertainty, chisq );
-      if (z == 0) {
-        tau[i] = -param[1];
-      };
-
-      std::vector <double> expfit(x.size());
-      for (unsigned k=0; k<x.size(); k++) {
-        expfit[k] = expFunc( x[k], param );
-      };
+      fitx.push_back( x );
+      fity.push_back( y );
+      fiterror.push_back( ArrayD( currenttrace.size(), 1.0 ) );
+      fitparams.push_back( param );
+      fitsteps.push_back( i );
 
       // plot
       P.lock();
@@ -232,7 +231,6 @@ int Activation::main( void )
       P[0].plot( currenttrace, 1000.0, Plot::Yellow, 2, Plot::Solid );
       P[0].plotPoint( currenttrace.pos(index)*1000.0, Plot::First, absmax, Plot::First, 0, Plot::Circle, 5, Plot::Pixel,
                       Plot::Magenta, Plot::Magenta );
-      P[0].plot( x, expfit, Plot::Green, 2, Plot::Solid);
 
 
       // IV
@@ -249,6 +247,31 @@ int Activation::main( void )
       P.unlock();
     }
 
+  // fit tau to all decaying activation curves of this sweep in parallel:
+  ArrayI paramfit( 3, 1 );
+  std::vector< ArrayD > fituncert;
+  ArrayD fitchisq;
+  ArrayI fitresults;
+  MarquardtFitLoop< std::vector<double>, std::vector<double>, ArrayD,
+		    double( double, const ArrayD&, ArrayD& ) >
+    fitloop( fitx, fity, fiterror, expFuncDerivs, fitparams, paramfit,
+	     fituncert, fitchisq, fitresults, threadPool().threads()+1 );
+  if ( parallelFor( 0, fitx.size(), fitloop ) ) {
+    P.lock();
+    for ( unsigned k=0; k<fitx.size(); k++ ) {
+      if ( fitresults[k] == 0 ) {
+        tau[fitsteps[k]] = -fitparams[k][1];
+      };
+      std::vector <double> expfit(fitx[k].size());
+      for (unsigned j=0; j<fitx[k].size(); j++) {
+        expfit[j] = expFunc( fitx[k][j], fitparams[k] );
+      };
+      P[0].plot( fitx[k], expfit, Plot::Green, 2, Plot::Solid);
+    }
+    P.draw();
+    P.unlock();
+  }
+
   double p_rev = pRev(IV);
   for ( unsigned i=0; i<potential.size(); i++) {
     g_act[i] = -IV[i]/(p_rev-potential[i]);
@@ -73,9 +73,9 @@ int PNSubtraction::main( void )
   return Completed;
 }
 
-SampleDataD PNSubtraction::PN_sub( OutData signal, Options &opts, double &holdingpotential, double &pause, double &mintime, double &maxtime, double &t0) {
+SampleDataD PNSubtraction::PN_sub( const OutData &stimulus, Options &opts, double &holdingpotential, double &pause, double &mintime, double &maxtime, double &t0) {
   int pn = number( "pn" );
-  double samplerate = signal.sampleRate();
+  double samplerate = stimulus.sampleRate();
 
   bool qualitycontrol = boolean( "qualitycontrol" );
   double pulseduration = number( "pulseduration" );
@@ -97,6 +97,9 @@ SampleDataD PNSubtraction::PN_sub( OutData signal, Options &opts, double &holdin
   Parameter &qc1 = opts.addBoolean( "qualitycontrol", qualitycontrol );
   Parameter &rid = opts.addText( "TraceId", randomId );
 
+  // reuse the buffer of the previous sweep:
+  OutData &signal = TraceSignal;
+  signal = stimulus;
   signal.setMutable( pn1 );
   signal.setMutable( qc1 );
   signal.setMutable( rid );
@@ -105,33 +108,32 @@ SampleDataD PNSubtraction::PN_sub( OutData signal, Options &opts, double &holdin
   // don't print repro message:
   noMessage();
 
-  SampleDataD pn_trace(mintime, signal.rangeBack(), 1 / samplerate);
+  const InData &currentdata = trace( CurrentTrace[0] );
+  PNTrace.resize( mintime, maxtime, currentdata.stepsize() );
+  PNTrace = 0.0;
   if ( pn != 0 ) {
     // give pn stimulus
-    OutData pn_signal = signal;
-    pn_signal.setTrace(PotentialOutput[0]);
-    pn_signal = holdingpotential + (signal - holdingpotential) / pn;
-    pn_signal.description().setType("stimulus/PNSubtraction");
+    PNSignal = signal;
+    PNSignal.setTrace(PotentialOutput[0]);
+    for ( int k=0; k<PNSignal.size(); k++ )
+      PNSignal[k] = holdingpotential + (signal[k] - holdingpotential) / pn;
+    PNSignal.description().setType("stimulus/PNSubtraction");
 
     for (int i = 0; i < ::abs(pn); i++) {
-      write(pn_signal);
-      if (signal.error())
-        return false;
+      write(PNSignal);
+      if (PNSignal.error())
+        return SampleDataD();
       sleep(pause);
 
       if (interrupt()) {
         break;
       };
 
-      SampleDataD currenttrace(mintime, maxtime, trace(CurrentTrace[0]).stepsize(), 0.0);
-      trace(CurrentTrace[0]).copy(signalTime(), currenttrace);
-
-      pn_trace += currenttrace;
+      addTrace( currentdata, signalTime(), PNTrace );
     };
-//  pn_trace -= pn_trace.mean(signalTime() + t0 - 0.001, signalTime() + t0);
 
     if (interrupt()) {
-      return pn_trace;
+      return PNTrace;
     };
   };
   
@@ -225,42 +227,9 @@ SampleDataD PNSubtraction::PN_sub( OutData signal, Options &opts, double &holdin
 
 
   if ( qualitycontrol ) {
-    OutData qc_signal1;
-    qc_signal1.setTrace( PotentialOutput[0] );
-    qc_signal1.constWave( stepduration, -1.0, -100 );
-
-    OutData qc_signal2;
-    qc_signal2.setTrace( PotentialOutput[0] );
-    qc_signal2.constWave( stepduration, -1.0, -170 );
-    
-    OutData qc_signal3;
-    qc_signal3.setTrace( PotentialOutput[0] );
-    qc_signal3.constWave( stepduration, -1.0, holdingpotential-20.0 );
-
-    OutData qc_signal4;
-    qc_signal4.setTrace( PotentialOutput[0] );
-    qc_signal4.sweepWave( pulseduration, -1.0, f0, f1, 20.0, 0.0 );
-
-    double beta = pulseduration / log(f1 / f0);
-    for ( int i=0; i<pulseduration/samplerate; i++ ) {
-      double a1 = f1/f0;
-      double a2 = i/samplerate/pulseduration;
-      qc_signal4[i] = sin(2 * 3.14159265358979323846 * beta * f0 * (std::pow(a1, a2) - 1.0))*20.0;
-    }
-    qc_signal4 += holdingpotential - 20.0;
-//    qc_signal4 = qc_signal4 + holdingpotential - 20;
-
-    OutData qc_signal5;
-    qc_signal5.setTrace( PotentialOutput[0] );
-    qc_signal5.constWave( 0.010, -1.0, holdingpotential );
-
-    qc_signal1.append( qc_signal2 );
-    qc_signal1.append( qc_signal3 );
-    qc_signal1.append( qc_signal4 );
-    qc_signal1.append( qc_signal5 );
-
-    qc_signal1.description().setType( "stimulus/QualityControl" );
-    Options opts_qc = qc_signal1.description();
+    OutData &qc_signal1 = qualityControlSignal( holdingpotential, stepduration,
+						 pulseduration, f0, f1, samplerate );
+    Options opts_qc = QCDescription;
     Parameter &qc_rid = opts_qc.addText( "TraceId", randomId );
     Parameter &qc_f0 = opts_qc.addNumber( "f1", f0 );
     Parameter &qc_f1 = opts_qc.addNumber( "f0", f1 );
@@ -305,10 +274,10 @@ SampleDataD PNSubtraction::PN_sub( OutData signal, Options &opts, double &holdin
   if ( qualitycontrol ) {
     dt = PCS_currenttrace.stepsize();
     Vp = PCS_potentialtrace.array();
-    dVp = dxdt( Vp, dt );
-    d2Vp = dxdt( dVp, dt );
+    dxdt( Vp, dt, dVp );
+    dxdt( dVp, dt, d2Vp );
     I = PCS_currenttrace.array();
-    dI = dxdt( I, dt );
+    dxdt( I, dt, dI );
 
     ArrayD param = pcsFitLeak( stepduration );
     pcsFitCapacitiveCurrents( param, stepduration );
@@ -327,64 +296,142 @@ SampleDataD PNSubtraction::PN_sub( OutData signal, Options &opts, double &holdin
     EL = e / b;
     cerr << "gL=" << gL << ", Rs=" << Rs << ", Cm=" << Cm << ", Cp=" << Cp << ", EL=" << EL << "\n";
 
-    ArrayD dpotential_p = dxdt( potentialtrace, dt );
-    ArrayD d2potential_p = dxdt( dpotential_p, dt );
-    ArrayD dcurrent = dxdt( currenttrace, dt );
-    currenttrace = currenttrace + a*dcurrent - b*potentialtrace - c*dpotential_p - d*d2potential_p + e;
+    dxdt( potentialtrace.array(), dt, DPotential );
+    dxdt( DPotential, dt, D2Potential );
+    dxdt( currenttrace.array(), dt, DCurrent );
+    int n = currenttrace.size() < potentialtrace.size() ? currenttrace.size() : potentialtrace.size();
+    currenttrace.resize( n );
+    for ( int k=0; k<n; k++ )
+      currenttrace[k] += a*DCurrent[k] - b*potentialtrace[k] - c*DPotential[k] - d*D2Potential[k] + e;
   }
   else if ( pn != 0 )
   {
-    currenttrace -= pn / ::abs(pn) * pn_trace;// - currenttrace.mean(signalTime() + t0 - 0.001, signalTime() + t0);
-    currenttrace -= currenttrace.mean(-samplerate / 500, 0);
+    // subtract the p/n traces at the same times as the current trace:
+    SampleDataD subtracted( mintime, maxtime, currenttrace.stepsize(), 0.0 );
+    int offs = currenttrace.index( mintime );
+    double sign = pn > 0 ? 1.0 : -1.0;
+    for ( int k=0; k<subtracted.size() && offs+k<currenttrace.size(); k++ )
+      subtracted[k] = currenttrace[offs+k] - sign * PNTrace[k];
+    subtracted -= subtracted.mean(-samplerate / 500, 0);
+    return subtracted;
   };
   return currenttrace;
 };
 
 
-//ArrayD PNSubtraction::dxdt( const ArrayD &x, const double &dt ) {
-//  ArrayD dx( x.size() );
-//  for ( int i = 1; i<(x.size()-1); i++ ) {
-//    dx[i] = (x[i + 1] - x[i - 1]) / (2 * dt);
-//  }
-//  dx[0] = 2 * dx[1] - dx[2];
-//  dx[x.size() - 1] = 2 * dx[x.size() - 2] - dx[x.size() - 3];
-//  return dx;
-//}
+OutData &PNSubtraction::qualityControlSignal( double holdingpotential, double stepduration,
+						double pulseduration, double f0, double f1,
+						double samplerate )
+{
+  // the chirp only changes with its parameters:
+  if ( ! QCSignal.empty() && QCSignal.trace() == PotentialOutput[0] &&
+       holdingpotential == QCHoldingPotential && stepduration == QCStepDuration &&
+       pulseduration == QCPulseDuration && f0 == QCF0 && f1 == QCF1 &&
+       samplerate == QCSampleRate )
+    return QCSignal;
+
+  OutData &qc_signal1 = QCSignal;
+  qc_signal1.clear();
+  qc_signal1.setTrace( PotentialOutput[0] );
+  qc_signal1.constWave( stepduration, -1.0, -100 );
+
+  OutData qc_signal2;
+  qc_signal2.setTrace( PotentialOutput[0] );
+  qc_signal2.constWave( stepduration, -1.0, -170 );
+    
+  OutData qc_signal3;
+  qc_signal3.setTrace( PotentialOutput[0] );
+  qc_signal3.constWave( stepduration, -1.0, holdingpotential-20.0 );
+
+  OutData qc_signal4;
+  qc_signal4.setTrace( PotentialOutput[0] );
+  qc_signal4.sweepWave( pulseduration, -1.0, f0, f1, 20.0, 0.0 );
+
+  double beta = pulseduration / log(f1 / f0);
+  for ( int i=0; i<pulseduration/samplerate; i++ ) {
+    double a1 = f1/f0;
+    double a2 = i/samplerate/pulseduration;
+    qc_signal4[i] = sin(2 * 3.14159265358979323846 * beta * f0 * (std::pow(a1, a2) - 1.0))*20.0;
+  }
+  qc_signal4 += holdingpotential - 20.0;
+
+  OutData qc_signal5;
+  qc_signal5.setTrace( PotentialOutput[0] );
+  qc_signal5.constWave( 0.010, -1.0, holdingpotential );
+
+  qc_signal1.append( qc_signal2 );
+  qc_signal1.append( qc_signal3 );
+  qc_signal1.append( qc_signal4 );
+  qc_signal1.append( qc_signal5 );
+
+  qc_signal1.description().setType( "stimulus/QualityControl" );
+  QCDescription = qc_signal1.description();
+
+  QCHoldingPotential = holdingpotential;
+  QCStepDuration = stepduration;
+  QCPulseDuration = pulseduration;
+  QCF0 = f0;
+  QCF1 = f1;
+  QCSampleRate = samplerate;
+  return QCSignal;
+}
+
+
+void PNSubtraction::addTrace( const InData &data, double time, SampleDataD &trace )
+{
+  // directly from the ring buffer, without copying into a temporary trace:
+  int inx = data.index( time + trace.rangeFront() );
+  if ( inx < data.minIndex() )
+    return;
+  int n = data.size() - inx;
+  if ( n > trace.size() )
+    n = trace.size();
+  for ( int k=0; k<n; k++ )
+    trace[k] += data[inx+k];
+}
 
 
-ArrayD PNSubtraction::dxdt( const ArrayD &x, const double &dt ) {
-  double kernelsize = 1;//number( "PCS_derivativekernelwidth");
-  ArrayD x2( x.size() );
-  ArrayD dx( x.size() );
+void PNSubtraction::dxdt( const ArrayD &x, double dt, ArrayD &dx, int kernelsize )
+{
+  int n = x.size();
+  dx.resize( n );
+  if ( n < 3 ) {
+    dx = 0.0;
+    return;
+  }
 
-  // convolve x with ArrayD (kernelsize, 1/kernelsize)
-  if ( kernelsize > 1.0 ) {
-    int khalf = floor(kernelsize / 2.0);
-    for ( int i = khalf; i < (x.size() - khalf); i++ ) {
+  // smooth x with a running average of width kernelsize:
+  const ArrayD *xs = &x;
+  if ( kernelsize > 1 ) {
+    int khalf = kernelsize / 2;
+    Smoothed.resize( n );
+    Smoothed = 0.0;
+    if ( n > 2*khalf + 2 ) {
       double s = 0.0;
-      for ( int j = (i-khalf); j < (i+khalf); j++ ) {
-        s += x[j];
+      for ( int j=0; j<2*khalf; j++ )
+	s += x[j];
+      for ( int i=khalf; i<n-khalf; i++ ) {
+	Smoothed[i] = s/kernelsize;
+	s += x[i+khalf] - x[i-khalf];
+      }
+      for ( int i=0; i<khalf; i++ ) {
+	int firstidx = khalf - i - 1;
+	int lastidx = n - khalf + i;
+	Smoothed[firstidx] = 2*Smoothed[firstidx+1] - Smoothed[firstidx+2];
+	Smoothed[lastidx] =  2*Smoothed[lastidx -1] - Smoothed[lastidx -2];
       }
-      x2[i] = s/kernelsize;
-    }
-    for ( int i = 0; i < khalf; i++ ) {
-      int firstidx = khalf - i - 1;
-      int lastidx = x2.size() - khalf + i;
-      x2[firstidx] = 2*x2[firstidx+1] - x2[firstidx+2];
-      x2[lastidx] =  2*x2[lastidx -1] - x2[lastidx -2];
     }
+    xs = &Smoothed;
   }
-  else {
-    x2 = x;
-  }
+
   // derive smoothed trace
-  for ( int i = 1; i<(x.size()-1); i++ ) {
-    dx[i] = (x2[i + 1] - x2[i - 1]) / (2 * dt);
-  }
+  const ArrayD &x2 = *xs;
+  double f = 1.0 / (2 * dt);
+  for ( int i = 1; i<n-1; i++ )
+    dx[i] = (x2[i + 1] - x2[i - 1]) * f;
   dx[0] = 2 * dx[1] - dx[2];
-  dx[x.size() - 1] = 2 * dx[x.size() - 2] - dx[x.size() - 3];
-  return dx;
-};
+  dx[n - 1] = 2 * dx[n - 2] - dx[n - 3];
+}
 
 
 double PNSubtraction::passiveMembraneFuncDerivs( double t, const ArrayD &p, ArrayD &dfdp ) {
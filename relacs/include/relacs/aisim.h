@@ -35,6 +35,11 @@ namespace relacs {
 \par Options:
 - \c gainblacklist: List of daq board gains that should not be used. Each gain is identified by its
   maximal range value in volts.
+- \c updateinterval: Interval in seconds between updates of the simulated data
+  (default 10ms). Determines the minimum latency of a closed loop.
+- \c loopbackin: Analog input channel to which the signal of the analog output channel
+  \c loopbackout is added, simulating a loopback cable (-1: no loopback).
+- \c loopbackout: Analog output channel that is fed back to analog input channel \c loopbackin.
 */
 
 
@@ -25,7 +25,11 @@
 #ifdef HAVE_LIBPORTAUDIO
 #include <portaudio.h>
 #endif
+#include <atomic>
+#include <vector>
 #include <QMutex>
+#include <relacs/array.h>
+#include <relacs/resampler.h>
 #include <relacs/inlist.h>
 #include <relacs/configdialog.h>
 
@@ -38,6 +42,32 @@ namespace relacs {
 \class AudioMonitor
 \author Jan Benda
 \brief Plays recordings on speakers using portaudio library.
+
+The data thread calls updateDerivedTraces() after each update of
+the input traces. The new data of the traces selected by the \c left
+and \c right options are high-pass filtered, scaled by \c gain,
+mixed into the two stereo channels, resampled to the audio sampling
+rate by a windowed-sinc Resampler, and written into a lock-free
+ring buffer. The PortAudio callback only reads audio frames from this ring
+and applies fading when muting or unmuting. It takes no locks and does not
+access the input traces, so the data thread and the audio output
+cannot block each other. On devices with a single output channel,
+all selected traces are mixed into this channel.
+
+The resampling ratio is adjusted slightly to keep the fill level
+of the ring constant, which compensates the drift between the clocks
+of the data acquisition and the sound card.
+
+\par Options
+- \c device: Audio device
+- \c enable=true: Enable audio monitor (\c boolean)
+- \c mute=false: Mute audio monitor (\c boolean)
+- \c gain=1: Gain factor (\c number)
+- \c audiorate=44.1kHz: Audio sampling rate
+- \c left: Traces played on the left channel, separated by comma
+  (\c string, the first input trace if empty)
+- \c right: Traces played on the right channel, separated by comma
+  (\c string, the same as \c left if empty)
 */
 
 class AudioMonitor : public ConfigDialog
@@ -65,15 +95,60 @@ public:
 
   void assignTraces( const InList &il, deque<InList*> &data );
   void assignTraces( void );
+    /*! Updates the traces and writes their new data into the ring buffer
+        of the audio output. Called from the data thread. */
   void updateDerivedTraces( void );
 
 
 protected:
-	
+
+    /*! A ring buffer of interleaved audio frames
+        for a single producer and a single consumer thread.
+	push() and pop() are lock-free. */
+  class FrameRing
+  {
+
+  public:
+
+    FrameRing( void );
+      /*! Allocates space for at least \a frames frames of \a channels
+          channels and discards all frames.
+	  Must not be called while the producer or the consumer is active. */
+    void reset( int frames, int channels );
+      /*! The number of frames that can be stored. */
+    int capacity( void ) const { return Capacity; };
+      /*! The number of frames available to the consumer. */
+    int fill( void ) const;
+      /*! Writes at most \a n frames from \a frames into the ring.
+          \return the number of written frames. Producer only. */
+    int push( const float *frames, int n );
+      /*! Reads at most \a n frames from the ring into \a frames.
+          \return the number of read frames. Consumer only. */
+    int pop( float *frames, int n );
+      /*! Discards at most \a n frames. Consumer only. */
+    int skip( int n );
+
+  private:
+
+    ArrayF Buffer;
+    int Capacity;
+    int Channels;
+    atomic< unsigned int > Head;
+    atomic< unsigned int > Tail;
+
+  };
+
+    /*! Set the traces to be played on each channel from the
+        \c left and \c right options and restart reading the traces. */
+  void resolveTraces( void );
+    /*! Processes the new data of the traces and writes them into Ring. */
+  void fillRing( void );
+
 #ifdef HAVE_LIBPORTAUDIO
     /*! This function will be called by the PortAudio engine when audio is needed.
         It may called at interrupt level on some machines so don't do anything
-	that could mess up the system like calling malloc() or free(). */
+	that could mess up the system like calling malloc() or free()
+	or locking a mutex. */
   static int audioCallback( const void *input, void *output,
 			    unsigned long framesperbuffer,
 			    const PaStreamCallbackTimeInfo* timeinfo,
@@ -84,21 +159,43 @@ protected:
 
   bool Initialized;
   bool Running;
+  bool Playing;
   int AudioDevice;
 
   InList Data;
-  int Trace;
-  float Gain;
-  float Mute;
-  float PrevMute;
+  Str LeftTraces;
+  Str RightTraces;
+    /*! The indices of the traces for each audio channel. */
+  vector< int > Traces[2];
+    /*! The index of the next data element to be played for each trace. */
+  vector< int > ReadIndex;
+    /*! The running mean of each trace. */
+  vector< float > TraceMean;
+    /*! The high-pass filtered and scaled new data of each trace. */
+  vector< ArrayF > TraceData;
+  ArrayF Mix[2];
+  ArrayF Out[2];
+  ArrayF Frames;
+  Resampler Resamplers[2];
+  double Ratio;
+  double UpdateFrames;
+
+  FrameRing Ring;
+  int Channels;
+  int FramesPerBuffer;
+  atomic< int > MaxFill;
+
+  atomic< float > Gain;
+  atomic< float > Mute;
   int MuteCount;
   mutable QMutex Mutex;
 
   double AudioRate;
-  double RateFac;
-  int DataIndex;
-  float DataMean;
-  float LastOut;
+
+    /*! The current mute factor, used by the audio callback only. */
+  float CurrentMute;
+    /*! The last output frame, used by the audio callback only. */
+  float LastFrame[2];
 };
 
 
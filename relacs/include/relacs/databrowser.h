@@ -106,10 +106,13 @@ public:
   bool canFetchMore( const QModelIndex &parent ) const;
   void fetchMore( const QModelIndex &parent );
   void beginAddChild( DataIndex::DataItem *parent );
+  void beginAddChildren( DataIndex::DataItem *parent, int n );
   void endAddChild( DataIndex::DataItem *parent );
   void endAddChild( void );
   void beginPopChild( DataIndex::DataItem *parent );
   void endPopChild( DataIndex::DataItem *parent );
+    /*! Remove all recording sessions from the DataIndex. */
+  void clear( void );
 
 
 public slots:
@@ -118,6 +121,12 @@ public slots:
   void setDescription( const QModelIndex &currrent, const QModelIndex &previous );
 
 
+protected:
+
+    /*! Adds the recording sessions of a DataIndexEvent to the DataIndex. */
+  virtual void customEvent( QEvent *qce );
+
+
 private slots:
 
   void displayIndex( const QModelIndex &index );
@@ -23,9 +23,13 @@
 #define _RELACS_DATAINDEX_H_ 1
 
 #include <deque>
+#include <set>
 #include <string>
 #include <QTreeView>
 #include <QAbstractItemModel>
+#include <QThread>
+#include <QMutex>
+#include <QEvent>
 #include <relacs/outdatainfo.h>
 #include <relacs/options.h>
 using namespace std;
@@ -37,6 +41,7 @@ namespace relacs {
   class DataOverviewModel;
   class DataDescriptionModel;
   class DataBrowser;
+  class DataIndexScanner;
 
 
 /*!
@@ -45,6 +50,14 @@ namespace relacs {
 \author Jan Benda
 
 This is the data model used by the DataBrowser class.
+
+The recording sessions found in a data root directory are cached in
+the index file IndexFile within that directory. Each line of this file
+describes a single recording session (see SessionInfo). loadDirectory()
+returns immediately and a DataIndexScanner fills in the sessions from
+the index file and parses only recording sessions that are not yet
+indexed in the background. Completed recording sessions are appended to
+the index file by endSession().
 */
 
 
@@ -87,6 +100,7 @@ public:
     void addChild( const string &name, const Options &data,
 		   const deque<int> &traceindex, const deque<int> &eventsindex,
 		   double time );
+    void addChildren( const deque<DataItem> &children );
     void loadCell( void );
     int level( void ) const;
     void setName( const string &name );
@@ -116,6 +130,46 @@ public:
   };
 
 
+    /*! Summary of a single recording session as it is stored
+        in the index file. */
+  class SessionInfo
+  {
+
+  public:
+
+    SessionInfo( void );
+      /*! Read the summary from the stimulus file \a file
+          of a recording session.
+	  \return \c true on success. */
+    bool read( const string &file );
+      /*! Set the summary from a single line \a line of the index file.
+	  \return \c true on success. */
+    bool load( const string &line );
+      /*! \return the summary as a single line for the index file
+          (without newline). */
+    string save( void ) const;
+      /*! \return \c true if the stimulus file of the session still
+          exists in the data root \a path with the size and
+          modification time it had when the summary was read. */
+    bool valid( const string &path ) const;
+
+      /*! The name of the session directory relative to the data root. */
+    string Dir;
+      /*! The name of the stimulus file within the session directory. */
+    string File;
+      /*! The size of the stimulus file in bytes. */
+    long long Size;
+      /*! The modification time of the stimulus file in seconds since the epoch. */
+    long long Modified;
+      /*! The number of recorded traces. */
+    int Traces;
+      /*! The number of recorded event lists. */
+    int Events;
+      /*! The meta data of the recording session. */
+    Options Data;
+  };
+
+
   DataIndex( void );
   ~DataIndex( void );
 
@@ -125,8 +179,29 @@ public:
 		    const deque<int> &eventsindex, double time );
   void addRepro( const Options &repro );
   void addSession( const string &path, const Options &data, int ntraces, int nevents );
+    /*! End the currently running recording session. If \a saved,
+        the session is appended to the index file of the data root. */
   void endSession( bool saved );
+    /*! Set the data root to \a dir and start the background scanner
+        that loads the recording sessions of \a dir into the index. */
   void loadDirectory( const string &dir );
+    /*! Add the recording sessions \a sessions found in the data root
+        \a path to the index.
+        Called from the DataOverviewModel with the sessions
+        delivered by the DataIndexScanner. */
+  void addSessions( const string &path, const deque<SessionInfo> &sessions );
+    /*! \return \c true if the session directory \a dir of the current data root
+        is already in the index file or is the currently running recording session.
+	Otherwise \a dir is marked as indexed and \c false is returned. */
+  bool indexed( const string &dir );
+    /*! Append \a session to the index file of the data root \a path. */
+  void appendIndex( const string &path, const SessionInfo &session );
+    /*! Rewrite the index file of the data root \a path
+        without the sessions that are no longer valid
+        and without duplicate sessions. */
+  void compactIndex( const string &path );
+    /*! The name of the index file in each data root. */
+  static const string IndexFile;
 
     /*! \return \c true if no recording session is in the DataIndex. */
   bool empty( void ) const;
@@ -146,15 +221,91 @@ public:
 
 private:
 
+    /*! Write the comment lines describing the columns of the index file to \a str. */
+  static void writeIndexHeader( ostream &str );
+
   DataItem Cells;
   bool Session;
 
+    /*! Session directories that are in the index file or are currently recorded. */
+  set<string> Indexed;
+    /*! Directory of the currently running recording session. */
+  string SessionDir;
+    /*! Protects Indexed, SessionDir, and the index file. */
+  QMutex IndexMutex;
+  DataIndexScanner *Scanner;
+
   DataOverviewModel *OverviewModel;
   DataDescriptionModel *DescriptionModel;
 
 };
 
 
+/*!
+\class DataIndexScanner
+\brief Loads recording sessions of a data root into a DataIndex in the background.
+\author Jan Benda
+
+First all sessions from the index file of the data root are delivered
+to the DataOverviewModel. Sessions whose stimulus file was removed or
+modified since it was indexed are dropped and the index file is compacted.
+Then the data root is scanned for session
+directories that are not in the index file. Only their stimulus files are parsed
+and appended to the index file. The sessions are posted as
+DataIndexEvent to the DataOverviewModel, which adds them
+to the DataIndex in the GUI thread.
+*/
+
+class DataIndexScanner : public QThread
+{
+
+public:
+
+  DataIndexScanner( DataIndex *data, QObject *receiver );
+    /*! Start scanning the data root \a path. */
+  void start( const string &path );
+    /*! Request the scanner to stop and wait for it. */
+  void stop( void );
+  virtual void run( void );
+
+
+private:
+
+  bool interrupted( void );
+  void post( deque<DataIndex::SessionInfo> &sessions );
+
+  DataIndex *DI;
+  QObject *Receiver;
+  string Path;
+  bool Interrupt;
+  QMutex InterruptMutex;
+
+};
+
+
+/*!
+\class DataIndexEvent
+\brief Delivers recording sessions from the DataIndexScanner to the DataOverviewModel.
+\author Jan Benda
+*/
+
+class DataIndexEvent : public QEvent
+{
+
+public:
+
+  DataIndexEvent( const string &path, const deque<DataIndex::SessionInfo> &sessions )
+    : QEvent( Type( User+1 ) ),
+      Path( path ),
+      Sessions( sessions )
+  {
+  }
+
+  string Path;
+  deque<DataIndex::SessionInfo> Sessions;
+};
+
+
 }; /* namespace relacs */
 
 #endif /* ! _RELACS_DATAINDEX_H_ */
@@ -22,8 +22,11 @@
 #ifndef _RELACS_DATATHREADS_H_
 #define _RELACS_DATATHREADS_H_ 1
 
+#include <string>
+#include <vector>
 #include <QThread>
 #include <QMutex>
+#include <relacs/configureclasses.h>
 
 using namespace std;
 
@@ -81,6 +84,46 @@ private:
 };
 
 
+/*! 
+\class ConfigThread
+\brief Thread for reading in configuration files in the background.
+\author Jan Benda
+
+The configuration files are parsed by ConfigureClasses::load()
+while the main thread is busy with loading and creating the plugins.
+The parsed sections are passed on to the ConfigClass instances
+on the main thread by calling ConfigureClasses::read( int, Sections& ).
+*/
+
+class ConfigThread : public QThread
+{
+
+public:
+
+  ConfigThread( void );
+    /*! Waits for the thread to finish. */
+  ~ConfigThread( void );
+    /*! Start parsing the configuration files \a files. */
+  void start( const vector< string > &files );
+  virtual void run( void );
+    /*! Wait for the thread to finish and pass the sections of all files
+        to the ConfigClass instances of group \a group of \a cfg.
+	\return the number of read in configuration files.
+	The parsed sections are cleared afterwards. */
+  int read( ConfigureClasses &cfg, int group );
+    /*! \c true if start() was called and read() was not called yet. */
+  bool pending( void ) const;
+
+
+private:
+
+  vector< string > Files;
+  vector< ConfigureClasses::Sections > Sections;
+  vector< int > Loaded;
+
+};
+
+
 }; /* namespace relacs */
 
 #endif /* ! _RELACS_DATATHREADS_H_ */
@@ -37,6 +37,7 @@ namespace relacs {
 
 
 class FilterData;
+class LatencyHistogram;
 class RePros;
 class Session;
 class Filter;
@@ -268,6 +269,7 @@ class FilterData : public QObject
   int LineWidth;
   bool Init;
   Options* GeneralOptions;
+  LatencyHistogram *Latency;
 
 
 public slots:
@@ -0,0 +1,188 @@
+/*
+  latencymonitor.h
+  Lock-free latency histograms for the stages of the data processing loop.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_LATENCYMONITOR_H_
+#define _RELACS_LATENCYMONITOR_H_ 1
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <iostream>
+#include <QMutex>
+
+using namespace std;
+
+namespace relacs {
+
+
+/*!
+\class LatencyHistogram
+\author Jan Benda
+\brief Lock-free histogram of processing times.
+
+The histogram has logarithmically spaced bins with four bins per
+octave, covering one microsecond up to about 16 seconds.  record()
+only increments a few atomic counters and can therefore be called
+from the data acquisition thread while the GUI thread reads out the
+statistics via count(), mean(), max(), and quantile().  The statistics
+read by the GUI thread are not a consistent snapshot, but close enough
+for monitoring purposes.
+*/
+
+class LatencyHistogram
+{
+
+public:
+
+    /*! Number of bins per octave. */
+  static const int BinsPerOctave = 4;
+    /*! Number of bins. */
+  static const int NBins = 24*BinsPerOctave;
+
+    /*! Construct an empty histogram with name \a name. */
+  LatencyHistogram( const string &name );
+
+    /*! The name of the processing stage. */
+  string name( void ) const;
+
+    /*! Add a processing time of \a us microseconds. */
+  void record( long us );
+    /*! Clear the histogram. */
+  void reset( void );
+
+    /*! The number of recorded processing times. */
+  long count( void ) const;
+    /*! The mean processing time in microseconds. */
+  double mean( void ) const;
+    /*! The maximum processing time in microseconds. */
+  long max( void ) const;
+    /*! The \a p-quantile (0 <= p <= 1) of the processing times in
+        microseconds, estimated from the center of the bin
+        containing the quantile. */
+  double quantile( double p ) const;
+
+    /*! The number of processing times recorded into bin \a bin. */
+  long binCount( int bin ) const;
+    /*! The lower edge of bin \a bin in microseconds. */
+  static double binLower( int bin );
+
+
+private:
+
+  static int bin( long us );
+
+  string Name;
+  atomic<long> Bins[NBins];
+  atomic<long> Count;
+  atomic<long> Sum;
+  atomic<long> Max;
+
+};
+
+
+/*!
+\class LatencyTimer
+\author Jan Benda
+\brief Measures elapsed time on a monotonic clock in microseconds.
+*/
+
+class LatencyTimer
+{
+
+public:
+
+    /*! Construct and start the timer. */
+  LatencyTimer( void )
+    : Start( chrono::steady_clock::now() ) {};
+
+    /*! Restart the timer. */
+  void start( void )
+    { Start = chrono::steady_clock::now(); };
+    /*! \return the time in microseconds elapsed since
+        the timer was started. */
+  long elapsed( void ) const
+    { return chrono::duration_cast<chrono::microseconds>( chrono::steady_clock::now() - Start ).count(); };
+    /*! \return the time in microseconds elapsed since the timer was
+        started and restart the timer. */
+  long restart( void )
+    { chrono::steady_clock::time_point now = chrono::steady_clock::now();
+      long us = chrono::duration_cast<chrono::microseconds>( now - Start ).count();
+      Start = now;
+      return us; };
+
+
+private:
+
+  chrono::steady_clock::time_point Start;
+
+};
+
+
+/*!
+\class LatencyMonitor
+\author Jan Benda
+\brief A collection of LatencyHistogram for the stages of the data processing loop.
+
+Histograms are created by stage() on first use and are never
+deleted before the LatencyMonitor itself, so the returned pointer
+can be cached and used for recording without any locking.
+*/
+
+class LatencyMonitor
+{
+
+public:
+
+  LatencyMonitor( void );
+  ~LatencyMonitor( void );
+
+    /*! \return the histogram for the processing stage named \a name.
+        If there is no such histogram yet, a new one is created. */
+  LatencyHistogram *stage( const string &name );
+    /*! The number of processing stages. */
+  int size( void ) const;
+
+    /*! Clear all histograms. */
+  void reset( void );
+
+    /*! Write a summary table of all processing stages as HTML to \a str. */
+  void html( ostream &str ) const;
+    /*! Write the summary table and the histograms of all
+        processing stages to \a str. */
+  void save( ostream &str ) const;
+    /*! Write the summary table and the histograms of all
+        processing stages to file \a file. */
+  void save( const string &file ) const;
+
+
+private:
+
+  deque< LatencyHistogram* > Stages;
+  mutable QMutex Mutex;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_LATENCYMONITOR_H_ */
+
@@ -0,0 +1,174 @@
+/*
+  marquardtfitloop.h
+  Fits many data sets in parallel on the ThreadPool.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_MARQUARDTFITLOOP_H_
+#define _RELACS_MARQUARDTFITLOOP_H_ 1
+
+#include <vector>
+#include <QMutex>
+#include <relacs/array.h>
+#include <relacs/fitalgorithm.h>
+#include <relacs/threadpool.h>
+using namespace std;
+
+namespace relacs {
+
+
+/*!
+\class MarquardtFitLoop
+\author Jan Benda
+\brief Fits many data sets in parallel on the ThreadPool.
+
+The constructor takes the same arguments as marquardtFits() and
+preallocates one FitWorkspace for each of the \a workers threads that
+run the loop concurrently. These are at most the threadPool().threads()
+workers plus the thread waiting in RELACSPlugin::parallelFor(). Pass
+the loop to RELACSPlugin::parallelFor() for the indices 0 to the
+number of data sets:
+\code
+MarquardtFitLoop< vector<double>, vector<double>, ArrayD, double( double, const ArrayD&, ArrayD& ) >
+  loop( x, y, s, expFuncDerivs, params, paramfit, uncert, chisq, results,
+        threadPool().threads()+1 );
+if ( ! parallelFor( 0, x.size(), loop ) )
+  return Aborted;
+\endcode
+Afterwards, \a params, \a uncert, \a chisq, and \a results contain
+the results of each fit as returned by marquardtFits().
+
+The fit function is called concurrently and therefore must not
+modify any shared data.
+*/
+
+template < typename ContainerX, typename ContainerY,
+  typename ContainerS, typename FitFunc >
+class MarquardtFitLoop : public ThreadPool::Loop
+{
+
+public:
+
+    /*! Prepare fitting \a f to each of the data sets \a x[i], \a y[i],
+        \a s[i] with one FitWorkspace for each of \a workers threads.
+        \a uncert, \a chisq, and \a results are resized to the number
+        of data sets. See marquardtFits() for the other arguments.
+        All the arguments must exist as long as the loop is used. */
+  MarquardtFitLoop( const vector< ContainerX > &x, const vector< ContainerY > &y,
+		    const vector< ContainerS > &s,
+		    FitFunc &f, vector< ArrayD > &params, const ArrayI &paramfit,
+		    vector< ArrayD > &uncert, ArrayD &chisq, ArrayI &results,
+		    int workers, double chieps=0.0005, int maxiter=300 );
+
+    /*! Fit the data sets \a first to \a last (exclusively).
+        Returns early if \a group has been canceled. */
+  virtual void run( int first, int last, const ThreadPool::Group &group );
+
+
+private:
+
+  const vector< ContainerX > &X;
+  const vector< ContainerY > &Y;
+  const vector< ContainerS > &S;
+  FitFunc &F;
+  vector< ArrayD > &Params;
+  const ArrayI &ParamFit;
+  vector< ArrayD > &Uncert;
+  ArrayD &ChiSq;
+  ArrayI &Results;
+  double ChiEps;
+  int MaxIter;
+
+    /*! One workspace for each worker. */
+  vector< FitWorkspace > Workspaces;
+    /*! The workspaces that are currently not used by any worker. */
+  vector< FitWorkspace* > Free;
+  QMutex Mutex;
+
+};
+
+
+template < typename ContainerX, typename ContainerY,
+  typename ContainerS, typename FitFunc >
+MarquardtFitLoop< ContainerX, ContainerY, ContainerS, FitFunc >::MarquardtFitLoop(
+		    const vector< ContainerX > &x, const vector< ContainerY > &y,
+		    const vector< ContainerS > &s,
+		    FitFunc &f, vector< ArrayD > &params, const ArrayI &paramfit,
+		    vector< ArrayD > &uncert, ArrayD &chisq, ArrayI &results,
+		    int workers, double chieps, int maxiter )
+  : X( x ),
+    Y( y ),
+    S( s ),
+    F( f ),
+    Params( params ),
+    ParamFit( paramfit ),
+    Uncert( uncert ),
+    ChiSq( chisq ),
+    Results( results ),
+    ChiEps( chieps ),
+    MaxIter( maxiter )
+{
+  Uncert.resize( X.size() );
+  ChiSq.resize( X.size() );
+  Results.resize( X.size() );
+  if ( workers < 1 )
+    workers = 1;
+  Workspaces.resize( workers );
+  Free.reserve( workers );
+  for ( int k=0; k<workers; k++ ) {
+    Workspaces[k].resize( ParamFit.size() );
+    Free.push_back( &Workspaces[k] );
+  }
+}
+
+
+template < typename ContainerX, typename ContainerY,
+  typename ContainerS, typename FitFunc >
+void MarquardtFitLoop< ContainerX, ContainerY, ContainerS, FitFunc >::run(
+		    int first, int last, const ThreadPool::Group &group )
+{
+  // take a workspace from the free ones:
+  FitWorkspace *ws = 0;
+  Mutex.lock();
+  if ( ! Free.empty() ) {
+    ws = Free.back();
+    Free.pop_back();
+  }
+  Mutex.unlock();
+  // more concurrent chunks than workers:
+  FitWorkspace extraws;
+  if ( ws == 0 ) {
+    extraws.resize( ParamFit.size() );
+    ws = &extraws;
+  }
+
+  for ( int k=first; k<last && ! group.canceled(); k++ )
+    marquardtFits( X, Y, S, F, Params, ParamFit, Uncert, ChiSq, Results,
+		   k, k+1, *ws, ChiEps, MaxIter );
+
+  if ( ws != &extraws ) {
+    Mutex.lock();
+    Free.push_back( ws );
+    Mutex.unlock();
+  }
+}
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_MARQUARDTFITLOOP_H_ */
@@ -0,0 +1,134 @@
+/*
+  memorybudget.h
+  Sizes the ring buffers of the acquired traces and events within a total memory budget.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_MEMORYBUDGET_H_
+#define _RELACS_MEMORYBUDGET_H_ 1
+
+#include <deque>
+#include <string>
+#include <iostream>
+#include <relacs/indata.h>
+#include <relacs/eventdata.h>
+
+using namespace std;
+
+namespace relacs {
+
+
+/*!
+\class MemoryBudget
+\author Jan Benda
+\brief Sizes the ring buffers of the acquired traces and events within a total memory budget.
+
+The ring buffers of the InData and EventData are first allocated from
+their own settings, e.g. the \c inputtracecapacity of the input traces
+or the buffer size of a detector. Add all of them with add() to the
+MemoryBudget and call fit() to shrink them such that together they do
+not need more memory than a given budget.
+
+Each buffer is assigned a priority. The buffers with the lowest
+priority are shrunk first, down to the minimum time of data they have
+to hold. Only if this is not sufficient the buffers of the next higher
+priority are shrunk. Buffers of the same priority are shrunk such that
+they hold the same time of data.
+
+The time covered by an InData buffer is given by its sampling
+interval. For an EventData the time per event is estimated from the
+time its full buffer is expected to cover as passed to add().
+
+lock() locks all buffers into RAM, such that the read thread never has
+to wait for a page fault. On request the kernel is advised to back
+large buffers by transparent huge pages.
+*/
+
+class MemoryBudget
+{
+
+public:
+
+    /*! Constructs an empty MemoryBudget. */
+  MemoryBudget( void );
+    /*! Unlocks all buffers. */
+  ~MemoryBudget( void );
+
+    /*! Add the ring buffer of \a trace with priority \a priority. */
+  void add( InData *trace, int priority );
+    /*! Add the ring buffers of \a events with priority \a priority.
+        \a buffertime is the time in seconds the current capacity
+        of \a events is expected to cover. */
+  void add( EventData *events, double buffertime, int priority );
+    /*! Unlock all buffers and remove them from the MemoryBudget. */
+  void clear( void );
+    /*! The number of buffers. */
+  int size( void ) const;
+
+    /*! The memory in bytes occupied by buffer \a index. */
+  long long bytes( int index ) const;
+    /*! The memory in bytes occupied by all buffers. */
+  long long bytes( void ) const;
+    /*! The time in seconds covered by buffer \a index. */
+  double time( int index ) const;
+
+    /*! Shrink the buffers such that their total memory does not exceed
+        \a budget bytes. No buffer is shrunk below \a mintime seconds.
+        A \a budget of zero or less does not limit the memory.
+        \return a warning if the budget could not be met. */
+  string fit( long long budget, double mintime );
+    /*! Lock all buffers into RAM. If \a hugepages is \c true, the
+        kernel is advised to use huge pages for large buffers before.
+        \return a warning if locking failed. */
+  string lock( bool hugepages );
+    /*! Unlock all buffers that have been locked by lock(). */
+  void unlock( void );
+
+    /*! Write a table of all buffers and their sizes as HTML to \a str. */
+  void html( ostream &str ) const;
+
+
+private:
+
+  struct Buffer
+  {
+    InData *Trace;
+    EventData *Events;
+    double DeltaT;
+    int Priority;
+    int Requested;
+    bool Locked;
+  };
+
+  int capacity( const Buffer &b ) const;
+  int elementSize( const Buffer &b ) const;
+  int writeBufferCapacity( const Buffer &b ) const;
+  void resize( Buffer &b, int n );
+  string ident( const Buffer &b ) const;
+
+  deque< Buffer > Buffers;
+  long long Budget;
+  double MinTime;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_MEMORYBUDGET_H_ */
+
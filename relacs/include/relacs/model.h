@@ -131,6 +131,10 @@ public:
   bool isRunning( void ) const;
 
     /*! Push the value \a val of trace \a trace to the data buffer.
+        If \a trace is the loopback input channel of the simulated
+        analog input device (option \c loopbackin of AISim),
+        the current signal of the loopback output channel
+        (option \c loopbackout) is added to \a val.
         \sa main(), next() */
   void push( int trace, float val );
     /*! Tell relacs that one cycle of model calculations is finished
@@ -238,6 +242,8 @@ private:
   deque< OutTrace > Signals;
   vector< int > SignalChannels;
   vector< float > SignalValues;
+  int LoopbackTrace;
+  int LoopbackChannel;
   QMutex SignalMutex;
   QSemaphore SignalsWait;
 
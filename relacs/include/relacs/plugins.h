@@ -340,6 +340,12 @@ public:
         \sa classErrors(), libraryErrors() */ 
   static void clearClassErrors( void );
 
+    /*! \return a report on the \a n libraries that took longest to be loaded
+        and on the \a n plugins that took longest to be created,
+	one library or plugin per line with the times in milliseconds.
+        \sa open(), create() */
+  static string timingReport( int n=5 );
+
     /*! Writes the content of the library file list and the plugin list
         to \a str. */
   friend ostream &operator<< ( ostream &str, const Plugins &plugins );
@@ -372,6 +378,8 @@ private:
     int UseCount;
       /*! The function to create the plugin. */
     PluginCreator Create;
+      /*! The total time in milliseconds spent in creating instances of the plugin. */
+    int CreateTime;
   };
 
   typedef vector< PluginInfo > PluginsType;
@@ -388,6 +396,8 @@ private:
     void *Lib;
       /*! ID of the library. */
     int FileID;
+      /*! Time in milliseconds it took to load the library. */
+    int LoadTime;
   };
 
   typedef vector< FileInfo > FilesType;
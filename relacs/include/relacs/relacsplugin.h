@@ -36,6 +36,7 @@
 #include <relacs/metadata.h>
 #include <relacs/plugins.h>
 #include <relacs/configdialog.h>
+#include <relacs/threadpool.h>
 
 namespace relacs {
 
@@ -647,6 +648,11 @@ int MyPlugin::main( void )
     /*! Returns \a file added to the base path for the current session.
         \sa path(), defaultPath() */
   string addPath( const string &file ) const;
+    /*! Adds \a file, that was written into path(), to the files
+        of the recording listed in the metadata.
+	The file is removed if the session is not saved.
+        \sa addPath() */
+  void addDataFile( const string &file );
 
     /*! The default path where data are stored if no session is running.
         \sa path(), addDefaultPath() */
@@ -931,6 +937,38 @@ protected:
         \sa setWaitMouseCursor() */
   void restoreMouseCursor( void );
 
+    /*! The pool of worker threads shared by all plugins. */
+  ThreadPool &threadPool( void );
+    /*! Execute \a task on the threadPool() as one of the tasks of this plugin.
+        The plugin keeps ownership of \a task.
+        \a task and all the data it accesses must exist until waitTasks()
+        returned. In particular, RePro::main() has to call waitTasks()
+        before returning, also when it returns because of interrupt(),
+        if \a task lives on its stack.
+        \sa waitTasks(), cancelTasks(), parallelFor() */
+  void submitTask( ThreadPool::Task *task );
+    /*! Wait until all tasks of this plugin submitted by submitTask()
+        are finished.
+        \return \c false if the tasks have been canceled.
+        \sa cancelTasks() */
+  bool waitTasks( void );
+    /*! Cancel all tasks of this plugin. Tasks that have not been started
+        are not executed anymore, running tasks should check
+        ThreadPool::Task::canceled(). For a RePro this is done
+        whenever the RePro is interrupted.
+        The tasks stay canceled until resetTasks() is called.
+        \sa resetTasks() */
+  void cancelTasks( void );
+    /*! Clear the canceled state of the tasks of this plugin.
+        For a RePro this is done right before RePro::main() is executed.
+        \sa cancelTasks() */
+  void resetTasks( void );
+    /*! Call \a loop for the indices \a first to \a last (exclusively),
+        e.g. trials or channels, on the threadPool() in chunks of at least
+        \a grain indices and wait for all of them to be finished.
+        \return \c false if the tasks have been canceled. */
+  bool parallelFor( int first, int last, ThreadPool::Loop &loop, int grain=1 );
+
 
 public:
 
@@ -988,6 +1026,9 @@ private:
 
   Options Settings;
 
+    /*! The tasks submitted to the ThreadPool. */
+  ThreadPool::Group Tasks;
+
   bool GlobalKeyEvents;
   QWidget *Widget;
 
@@ -40,6 +40,10 @@
 #include <relacs/settings.h>
 #include <relacs/metadata.h>
 #include <relacs/datathreads.h>
+#include <relacs/latencymonitor.h>
+#include <relacs/memorybudget.h>
+#include <relacs/threadpool.h>
+#include <relacs/updatecontroller.h>
 #include <relacs/plottrace.h>
 #include <relacs/relacsplugin.h>
 
@@ -84,6 +88,14 @@ The data are acquired from the DAQ boards in the ReadLoop. On request
 via function updateData() the data are filtered and
 events are detected.
 
+The filters and detectors work on IData and EData without holding any
+lock that is needed by the other threads. Only after all traces and
+events have been updated, their new sizes and times are published to
+PData and PEvents while DerivedDataMutex is locked for writing. The
+plugins' traces and events are assigned to the published lists. They
+get consistent views of the data via getData(), which locks
+DerivedDataMutex for reading only while copying from PData and PEvents.
+
 A RePro is stoppped with the stopRePro() function and a new RePro is
 started with startRePro().
 */
@@ -307,6 +319,11 @@ public slots:
     /*! Displays RELACS help. */
   void help( void );
 
+    /*! Displays the processing latencies of the data acquisition loop. */
+  void latencies( void );
+    /*! Displays the memory used by the buffers of traces and events. */
+  void memory( void );
+
 
     /*! After a signal is written to the daq-board for output
         the function write( OData &OD ) emits this signal.
@@ -358,11 +375,19 @@ private:
 
   void setupInTraces( void );
   void setupOutTraces( void );
+  void setupMemoryBudget( void );
 
     /*! Contains the UpateDataThread loop, continuously updates and 
         processes data. */    
   void run( void );
 
+    /*! Add the time elapsed since the previous stage of the startup
+        as \a stage to the startup report. */
+  void startupTime( const string &stage );
+    /*! Read the plugin configuration files, possibly already parsed
+        by PluginConfig. */
+  void readPluginConfig( void );
+
     /*! Restore showing all widgets. */
   void showFull( void );
     /*! Restore widget ordering. */
@@ -413,19 +438,50 @@ private:
   InList IData;  // Buffers point to IRawData but is in sync with filtered traces and events
   EventList ERawData;
   EventList EData;  // Buffers point to ED but is in sync with filtered traces and events
+  InList PData;  // Buffers point to IData, published after each complete update of IData
+  EventList PEvents;  // Buffers point to EData, published after each complete update of EData
   deque<InList*> UpdateRawData;
   deque<EventList*> UpdateRawEvents;
 
   ReadThread ReadLoop;
   WriteThread WriteLoop;
+    /*! Parses the plugin configuration files while the plugins are loaded. */
+  ConfigThread PluginConfig;
+
+    /*! Measures the total time of the startup. */
+  QTime StartupTime;
+    /*! Measures the time of each stage of the startup. */
+  QTime StartupStageTime;
+    /*! The times of the stages of the startup. */
+  string StartupReport;
 
   bool DataRun;
   QMutex DataRunLock;
-    /*! Controls the derived data of the primary input data buffer. */
+    /*! Controls the published data PData and PEvents. */
   QReadWriteLock DerivedDataMutex;
   bool WriteFlag;
   QTime DataTime;
 
+    /*! Processing latencies of the stages in updateData(). */
+  LatencyMonitor LM;
+  LatencyHistogram *RawLatency;
+  LatencyHistogram *FilterLatency;
+  LatencyHistogram *AudioLatency;
+  LatencyHistogram *PublishLatency;
+  LatencyHistogram *SaveLatency;
+  LatencyHistogram *AcquisitionLatency;
+  LatencyHistogram *UpdateInterval;
+    /*! Adapts the interval of updateData() to the processing load. */
+  UpdateController UC;
+
+    /*! Sizes the buffers of the traces and events. */
+  MemoryBudget MB;
+
+    /*! Worker threads for the plugins. */
+  ThreadPool TP;
+    /*! Microseconds the ReadLoop sleeps after updateData(). */
+  long UpdateSleep;
+
   // Research Program = RePros:
   RePro *CurrentRePro;      // always the current program
   bool ReProRunning;
@@ -121,6 +121,10 @@ public:
   string addPath( const string &file ) const;
     /*! Stores \a file in the list of files of the currently running RePro. */
   void storeFile( const string &file ) const;
+    /*! Adds \a file, written by some plugin into path(),
+        to the files of the recording in the metadata.
+	The file is removed if the session is not saved. */
+  void addDataFile( const string &file );
 
     /*! \return the template for the base path where data are to stored.
         \sa setPathTemplate(), path() */
@@ -0,0 +1,204 @@
+/*
+  threadpool.h
+  A fixed number of worker threads executing tasks for the plugins.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_THREADPOOL_H_
+#define _RELACS_THREADPOOL_H_ 1
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+using namespace std;
+
+namespace relacs {
+
+
+/*!
+\class ThreadPool
+\author Jan Benda
+\brief A fixed number of worker threads executing tasks for the plugins.
+
+Computations that can be split into independent parts, like the
+analysis of many trials or channels, are implemented as a Task and
+passed to submit(). Each worker thread has its own queue of tasks.
+Submitted tasks are distributed over these queues. A worker that has
+run out of tasks takes tasks from the other queues. wait() blocks
+until all tasks of a Group are finished and meanwhile executes
+queued tasks itself.
+
+parallelFor() splits a range of indices into chunks that are
+processed by a Loop in parallel.
+
+The tasks of a Group can be canceled by Group::cancel(). Tasks that
+have not been started yet are then not executed anymore. Running
+tasks should check Task::canceled() regularly and return early.
+
+The worker threads run with low priority and there are at most as
+many of them as there are processors minus two, such that they do not
+compete with the threads reading and writing data. The workers are
+started with the first submitted task.
+
+Tasks are executed without holding any lock. They must not lock
+the mutex of the plugin that submitted them, since the plugin
+might hold it while waiting for the tasks.
+*/
+
+class ThreadPool
+{
+
+public:
+
+  class Group;
+
+    /*! A piece of work to be executed by the ThreadPool.
+        Implement run(). The ThreadPool does not take ownership
+        of the Task. */
+  class Task
+  {
+  public:
+    Task( void );
+    virtual ~Task( void );
+      /*! Reimplement this function with the work to be done. */
+    virtual void run( void ) = 0;
+      /*! \c true if the Group of this task has been canceled. */
+    bool canceled( void ) const;
+  private:
+    friend class ThreadPool;
+    Group *TaskGroup;
+    bool Delete;
+  };
+
+    /*! A set of tasks that can be waited for and be canceled together. */
+  class Group
+  {
+  public:
+    Group( void );
+      /*! The number of submitted tasks that have not been finished yet. */
+    int pending( void ) const;
+      /*! Do not execute the pending tasks and set canceled(). */
+    void cancel( void );
+      /*! \c true if cancel() has been called since the last reset(). */
+    bool canceled( void ) const;
+      /*! Clear the canceled() flag. */
+    void reset( void );
+  private:
+    friend class ThreadPool;
+    void finished( void );
+    atomic<int> Pending;
+    atomic<bool> Canceled;
+    QMutex Mutex;
+    QWaitCondition Finished;
+  };
+
+    /*! The body of a parallel for-loop. */
+  class Loop
+  {
+  public:
+    virtual ~Loop( void );
+      /*! Reimplement this function to process the indices
+          \a first (inclusively) to \a last (exclusively).
+	  This function is called concurrently for different ranges. */
+    virtual void run( int first, int last, const Group &group ) = 0;
+  };
+
+    /*! Construct a ThreadPool with defaultThreads() worker threads. */
+  ThreadPool( void );
+    /*! Cancels all tasks and stops the worker threads. */
+  ~ThreadPool( void );
+
+    /*! The number of processors minus the two for reading and writing data,
+        but at least one. */
+  static int defaultThreads( void );
+    /*! The number of worker threads. */
+  int threads( void ) const;
+    /*! Set the number of worker threads to \a n.
+        For \a n less than one or larger than defaultThreads(),
+        defaultThreads() is used.
+        Queued tasks are preserved. */
+  void setThreads( int n );
+
+    /*! Queue \a task for execution as part of \a group. */
+  void submit( Task *task, Group &group );
+    /*! Wait until all tasks of \a group are finished.
+        Meanwhile, execute queued tasks.
+        \return \c false if \a group was canceled. */
+  bool wait( Group &group );
+    /*! Call \a loop for the indices \a first to \a last (exclusively)
+        split into chunks of at least \a grain indices in parallel and
+        wait for all of them to be finished.
+        \return \c false if \a group was canceled. */
+  bool parallelFor( int first, int last, Loop &loop, Group &group, int grain=1 );
+
+
+private:
+
+  class Worker : public QThread
+  {
+  public:
+    Worker( ThreadPool *pool, int index );
+  protected:
+    virtual void run( void );
+  private:
+    ThreadPool *Pool;
+    int Index;
+  };
+
+  class LoopTask : public Task
+  {
+  public:
+    LoopTask( Loop *loop, int first, int last );
+    virtual void run( void );
+  private:
+    Loop *L;
+    int First;
+    int Last;
+  };
+
+  void work( int index );
+  Task *take( int index );
+  void execute( Task *task );
+  void start( void );
+  void stop( void );
+
+    /*! Protects the list of workers. */
+  mutable QMutex WorkersMutex;
+  deque< Worker* > Workers;
+  int NThreads;
+
+    /*! The queues of tasks, one for each worker. */
+  vector< deque< Task* > > Queues;
+  vector< QMutex* > QueueMutexes;
+  atomic<int> Queued;
+  atomic<unsigned int> Next;
+  atomic<bool> Stop;
+
+  QMutex WakeMutex;
+  QWaitCondition Wake;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_THREADPOOL_H_ */
+
@@ -0,0 +1,132 @@
+/*
+  updatecontroller.h
+  Adapts the interval of the data acquisition loop to the processing load.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RELACS_UPDATECONTROLLER_H_
+#define _RELACS_UPDATECONTROLLER_H_ 1
+
+#include <atomic>
+#include <iostream>
+#include <relacs/latencymonitor.h>
+
+using namespace std;
+
+namespace relacs {
+
+
+/*!
+\class UpdateController
+\author Jan Benda
+\brief Adapts the interval of the data acquisition loop to the processing load.
+
+The data acquisition loop processes all data that arrived since the
+previous update. The fewer updates, the larger the batches of data
+and the smaller the overhead per sample, but the longer the latency
+of the data available to the plugins.
+
+After each update the read thread passes the time it took to process
+the data to update(). The UpdateController measures the time between
+successive updates and keeps a running average of the load, i.e. the
+fraction of this time spent for processing. If the load exceeds
+maxLoad(), the update interval is increased such that more data are
+processed in one batch. If the load drops below minLoad(), the
+interval is decreased again to reduce latency. The interval is always
+kept between the limits set by setLimits(). With the lower limit set
+to zero the loop processes data as soon as the analog input signals
+new data.
+
+update() returns the time the read thread should sleep before waiting
+for new data. update() must be called from a single thread only. All
+other functions can be called from any thread.
+*/
+
+class UpdateController
+{
+
+public:
+
+    /*! Construct an UpdateController with limits of the update
+        interval of 0 and 50 milliseconds. */
+  UpdateController( void );
+
+    /*! Set the minimum and maximum update interval
+        to \a minus and \a maxus microseconds. */
+  void setLimits( long minus, long maxus );
+    /*! The minimum update interval in microseconds. */
+  long minInterval( void ) const;
+    /*! The maximum update interval in microseconds. */
+  long maxInterval( void ) const;
+
+    /*! The load above which the update interval is increased. */
+  static const double MaxLoad;
+    /*! The load below which the update interval is decreased. */
+  static const double MinLoad;
+
+    /*! Restart the measurement of the update interval.
+        Call this whenever the data acquisition loop is started. */
+  void reset( void );
+    /*! Report that the last update took \a processingus microseconds
+        and adapt the update interval accordingly.
+	\return the time in microseconds the read thread
+	should sleep before waiting for new data. */
+  long update( long processingus );
+
+    /*! The time in microseconds between the last two calls of update().
+        Zero for the first update after reset(). */
+  long period( void ) const;
+    /*! The current target update interval in microseconds. */
+  long interval( void ) const;
+    /*! The current average processing load. */
+  double load( void ) const;
+    /*! The number of updates. */
+  long updates( void ) const;
+    /*! How often the update interval was increased. */
+  long increases( void ) const;
+    /*! How often the update interval was decreased. */
+  long decreases( void ) const;
+
+    /*! Write the state of the controller as HTML to \a str. */
+  void html( ostream &str ) const;
+
+
+private:
+
+  atomic<long> MinInterval;
+  atomic<long> MaxInterval;
+  atomic<long> Interval;
+  atomic<long> LastPeriod;
+    /*! The load in parts per million. */
+  atomic<long> Load;
+  atomic<long> Updates;
+  atomic<long> Increases;
+  atomic<long> Decreases;
+
+  LatencyTimer Period;
+  bool Started;
+  double AverageLoad;
+  int Hold;
+
+};
+
+
+}; /* namespace relacs */
+
+#endif /* ! _RELACS_UPDATECONTROLLER_H_ */
+
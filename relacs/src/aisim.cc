@@ -61,6 +61,9 @@ void AISim::initOptions()
   AnalogInput::initOptions();
 
   addNumber("gainblacklist", "dummy description", 0);
+  addNumber( "updateinterval", "Interval between updates of the simulated data", 0.01, 0.0001, 1.0, 0.001, "s", "ms" );
+  addInteger( "loopbackin", "Analog input channel receiving the loopback signal", -1, -1, 31 );
+  addInteger( "loopbackout", "Analog output channel fed back to the loopback input channel", -1, -1, 31 );
 }
 
 int AISim::open( const string &device )
@@ -1,3 +1,6 @@
+#include <cmath>
+#include <algorithm>
+#include <relacs/strqueue.h>
 #include <relacs/relacsplugin.h>
 #include <relacs/audiomonitor.h>
 
@@ -9,17 +12,21 @@ AudioMonitor::AudioMonitor( void )
   : ConfigDialog( "AudioMonitor", RELACSPlugin::Core, "AudioMonitor" ),
     Initialized( false ),
     Running( false ),
+    Playing( false ),
     AudioDevice( -1 ),
-    Gain( 1.0 ),
-    Mute( 1.0 ),
-    PrevMute( 0.0 ),
+    Ratio( 1.0 ),
+    UpdateFrames( 0.0 ),
+    Channels( 2 ),
+    FramesPerBuffer( 256 ),
+    MaxFill( 0 ),
+    Gain( 1.0f ),
+    Mute( 1.0f ),
     MuteCount( 0 ),
     AudioRate( 44100.0 ),
-    RateFac( 1.0 ),
-    DataIndex( -1 ),
-    DataMean( 0.0f ),
-    LastOut( 0.0f )
+    CurrentMute( 0.0f )
 {
+  LastFrame[0] = 0.0f;
+  LastFrame[1] = 0.0f;
   setDate( "" );
   setDialogHelp( false );
 
@@ -48,6 +55,8 @@ AudioMonitor::AudioMonitor( void )
   addBoolean( "mute", "Mute audio monitor", false );
   addNumber( "gain", "Gain factor", 1.0, 0.0, 10000.0, 0.1 );
   addSelection( "audiorate", "Audio sampling rate", "44.1|8|16|22.05|44.1|48|96" ).setUnit( "kHz" );
+  addText( "left", "Traces on left channel", "" );
+  addText( "right", "Traces on right channel", "" );
 }
 
 
@@ -63,7 +72,6 @@ void AudioMonitor::notify( void )
   Str audiodevs = text( "device" );
   int audiodevice = (int)::round( audiodevs.number( -1.0 ) );
   Gain = number( "gain" );
-  PrevMute = Mute;
   Mute = boolean( "mute" ) ? 0.0f : 1.0f;
   if ( Mute > 0.1 )
     MuteCount = 0;
@@ -73,6 +81,14 @@ void AudioMonitor::notify( void )
   bool initialized = Initialized;
   Str ars = text( "audiorate" );
   double audiorate = 1000.0* ars.number( 44.1 );
+  Str left = text( "left" );
+  Str right = text( "right" );
+  if ( left != LeftTraces || right != RightTraces ) {
+    LeftTraces = left;
+    RightTraces = right;
+    if ( Playing )
+      resolveTraces();
+  }
   Mutex.unlock();
   if ( enable ) {
     if ( initialized &&
@@ -157,13 +173,6 @@ void AudioMonitor::start( void )
     return;
 
   int nbuffer = 256;
-  Trace = 0;
-  RateFac = 1.0;
-  DataIndex = -1;
-  DataMean = 0.0;
-  LastOut = 0.0f;
-  if ( Mute < 0.1 )
-    PrevMute = 0.0;
 
 #ifdef HAVE_LIBPORTAUDIO
 
@@ -173,16 +182,15 @@ void AudioMonitor::start( void )
     audiodev = Pa_GetDeviceCount()-1;
   if ( audiodev < 0 )
     audiodev = Pa_GetDefaultOutputDevice();
-  PaStreamParameters params;
-  params.channelCount = 1;
-  params.device = audiodev;
-  params.hostApiSpecificStreamInfo = NULL;
-  params.sampleFormat = paFloat32;
   const PaDeviceInfo *di = Pa_GetDeviceInfo( audiodev );
   if ( di == NULL ) {
     Stream = 0;
     return;
   }
+  PaStreamParameters params;
+  params.channelCount = di->maxOutputChannels < 2 ? 1 : 2;
+  params.device = audiodev;
+  params.sampleFormat = paFloat32;
   params.suggestedLatency = di->defaultHighOutputLatency;
   params.hostApiSpecificStreamInfo = NULL;
   PaError err = Pa_IsFormatSupported( NULL, &params, AudioRate );
@@ -212,6 +220,20 @@ void AudioMonitor::start( void )
     return;
   }
 
+  // reset ring buffer and resampling:
+  Mutex.lock();
+  Channels = params.channelCount;
+  FramesPerBuffer = nbuffer;
+  Ring.reset( (int)AudioRate, Channels );
+  MaxFill = Ring.capacity();
+  Ratio = 1.0;
+  UpdateFrames = 0.0;
+  resolveTraces();
+  CurrentMute = 0.0f;
+  LastFrame[0] = 0.0f;
+  LastFrame[1] = 0.0f;
+  Mutex.unlock();
+
   // start stream:
   err = Pa_StartStream( Stream );
   if ( err != paNoError ) {
@@ -219,13 +241,13 @@ void AudioMonitor::start( void )
     return;
   }
   else
-    cerr << "Started audio stream at " << AudioRate << " Hz\n";
-#endif
+    cerr << "Started audio stream at " << AudioRate << " Hz on "
+	 << Channels << " channels\n";
 
-  RateFac = 1.0;
-  DataIndex = -1;
-  if ( Data[Trace].size() > 0 )
-    DataMean = Data[Trace].back();
+  Mutex.lock();
+  Playing = true;
+  Mutex.unlock();
+#endif
 }
 
 
@@ -248,6 +270,7 @@ void AudioMonitor::stop( void )
   if ( run ) {
     Mutex.lock();
     Running = false;
+    Playing = false;
     Mutex.unlock();
 #ifdef HAVE_LIBPORTAUDIO
     PaError err = Pa_StopStream( Stream );
@@ -273,7 +296,6 @@ void AudioMonitor::mute( void )
   Mutex.lock();
   if ( Mute > 0.0 )
     MuteCount = 0;
-  PrevMute = Mute;
   Mute = 0.0f;
   MuteCount++;
   bool cn = unsetNotify();
@@ -289,7 +311,6 @@ void AudioMonitor::unmute( void )
   MuteCount--;
   if ( MuteCount <= 0 ) {
     MuteCount = 0;
-    PrevMute = Mute;
     Mute = 1.0f;
     bool cn = unsetNotify();
     setBoolean( "mute", false );
@@ -317,70 +338,294 @@ int AudioMonitor::audioCallback( const void *input, void *output,
 {
   AudioMonitor *data = (AudioMonitor*)userdata;
   float *out = (float*)output;
-  data->Mutex.lock();
-  const InData &trace = data->Data[data->Trace];
-  float fac = data->Gain / trace.maxValue();
-  double rate = data->RateFac/trace.stepsize();
-  double audiorate = data->AudioRate;
-  int datasize = trace.size();
-  int dataminsize = trace.minIndex();
-  int dataindex = data->DataIndex;
-  int index = dataindex;
-  float audiofilter = 1.0/data->AudioRate/0.1; // dt/tau = 1.0/AudioRate/tau -> tau = 0.1sec
-  float mute = data->PrevMute;
-  float muteincr = (data->Mute - data->PrevMute)/(float)framesperbuffer;
-
-  // init index into trace:
-  if ( dataindex < 0 ) {
-    dataindex = datasize - trace.indices( framesperbuffer/audiorate );
-    if ( dataindex < dataminsize )
-      dataindex = dataminsize;
-  }
+  int nc = data->Channels;
+  int nf = (int)framesperbuffer;
 
-  //  cerr << datasize - dataindex << '\n';
+  // drop frames if we are too far behind:
+  int maxfill = data->MaxFill;
+  int fill = data->Ring.fill();
+  if ( fill > maxfill )
+    data->Ring.skip( fill - maxfill/2 );
 
   // write out data:
-  unsigned long i=0;
-  for ( ; i<framesperbuffer; i++ ) {
-    double time = i/audiorate;
-    int indices = ::floor(time*rate);
-    index = dataindex + indices;
-    if ( index+1 >= datasize )
-      break;
-    // linear interpolation:
-    double m = (trace[index+1]-trace[index])*rate;
-    data->LastOut = (m*(time-indices/rate)+trace[index])*fac;
-    // subtract mean:
-    mute += muteincr;
-    data->DataMean += ( data->LastOut - data->DataMean )*audiofilter;
-    *out++ = mute * (data->LastOut - data->DataMean);
+  int n = data->Ring.pop( out, nf );
+  if ( n > 0 ) {
+    for ( int c=0; c<nc; c++ )
+      data->LastFrame[c] = out[(n-1)*nc+c];
   }
-  data->DataIndex = index+1;
 
-  // fill up the audio buffer:
-  if ( i<framesperbuffer ) {
-    // cerr << "AUDIOMONITOR FILL " << framesperbuffer - i << '\n';
-    for ( ; i<framesperbuffer; i++ ) {
-      mute += muteincr;
-      data->DataMean += ( data->LastOut - data->DataMean )*audiofilter;
-      *out++ = mute * (data->LastOut - data->DataMean);
+  // fill up the audio buffer with the decaying last frame:
+  for ( int i=n; i<nf; i++ ) {
+    for ( int c=0; c<nc; c++ ) {
+      data->LastFrame[c] *= 0.995f;
+      out[i*nc+c] = data->LastFrame[c];
     }
-    data->RateFac -= 0.001;
-  }
-  else if ( datasize - dataindex > 2*(long)framesperbuffer ) {
-    data->RateFac += 0.001;
-    // cerr << "RATEFC = " << data->RateFac << '\n';
   }
 
-  data->PrevMute = data->Mute;
+  // fade in and out:
+  float mute = data->CurrentMute;
+  float targetmute = data->Mute;
+  if ( mute != 1.0f || targetmute != 1.0f ) {
+    float muteincr = ( targetmute - mute )/nf;
+    for ( int i=0; i<nf; i++ ) {
+      mute += muteincr;
+      for ( int c=0; c<nc; c++ )
+	out[i*nc+c] *= mute;
+    }
+  }
+  data->CurrentMute = targetmute;
 
-  data->Mutex.unlock();
   return paContinue;
 }
 
 #endif
 
 
+AudioMonitor::FrameRing::FrameRing( void )
+  : Capacity( 0 ),
+    Channels( 1 ),
+    Head( 0 ),
+    Tail( 0 )
+{
+}
+
+
+void AudioMonitor::FrameRing::reset( int frames, int channels )
+{
+  Capacity = 1;
+  while ( Capacity < frames )
+    Capacity *= 2;
+  Channels = channels;
+  Buffer.resize( Capacity*Channels, 0.0f );
+  Head = 0;
+  Tail = 0;
+}
+
+
+int AudioMonitor::FrameRing::fill( void ) const
+{
+  unsigned int t = Tail.load( memory_order_acquire );
+  unsigned int h = Head.load( memory_order_acquire );
+  return (int)( h - t );
+}
+
+
+int AudioMonitor::FrameRing::push( const float *frames, int n )
+{
+  unsigned int h = Head.load( memory_order_relaxed );
+  unsigned int t = Tail.load( memory_order_acquire );
+  int m = Capacity - (int)( h - t );
+  if ( m > n )
+    m = n;
+  if ( m <= 0 )
+    return 0;
+  int i = h & ( Capacity - 1 );
+  int m1 = Capacity - i;
+  if ( m1 > m )
+    m1 = m;
+  copy( frames, frames + m1*Channels, Buffer.begin() + i*Channels );
+  copy( frames + m1*Channels, frames + m*Channels, Buffer.begin() );
+  Head.store( h + m, memory_order_release );
+  return m;
+}
+
+
+int AudioMonitor::FrameRing::pop( float *frames, int n )
+{
+  unsigned int t = Tail.load( memory_order_relaxed );
+  unsigned int h = Head.load( memory_order_acquire );
+  int m = (int)( h - t );
+  if ( m > n )
+    m = n;
+  if ( m <= 0 )
+    return 0;
+  int i = t & ( Capacity - 1 );
+  int m1 = Capacity - i;
+  if ( m1 > m )
+    m1 = m;
+  copy( Buffer.begin() + i*Channels, Buffer.begin() + (i+m1)*Channels, frames );
+  copy( Buffer.begin(), Buffer.begin() + (m-m1)*Channels, frames + m1*Channels );
+  Tail.store( t + m, memory_order_release );
+  return m;
+}
+
+
+int AudioMonitor::FrameRing::skip( int n )
+{
+  unsigned int t = Tail.load( memory_order_relaxed );
+  unsigned int h = Head.load( memory_order_acquire );
+  int m = (int)( h - t );
+  if ( m > n )
+    m = n;
+  if ( m <= 0 )
+    return 0;
+  Tail.store( t + m, memory_order_release );
+  return m;
+}
+
+
+void AudioMonitor::resolveTraces( void )
+{
+  Traces[0].clear();
+  Traces[1].clear();
+  ReadIndex.assign( Data.size(), -1 );
+  TraceMean.assign( Data.size(), 0.0f );
+  TraceData.resize( Data.size() );
+  if ( Data.empty() )
+    return;
+
+  Str names[2] = { LeftTraces, RightTraces };
+  for ( int c=0; c<2; c++ ) {
+    StrQueue sq( names[c], "," );
+    for ( int k=0; k<sq.size(); k++ ) {
+      Str name = sq[k].stripped();
+      if ( name.empty() )
+	continue;
+      int inx = Data.index( name );
+      if ( inx < 0 ) {
+	cerr << "AudioMonitor: unknown input trace \"" << name << "\"\n";
+	continue;
+      }
+      if ( find( Traces[c].begin(), Traces[c].end(), inx ) == Traces[c].end() )
+	Traces[c].push_back( inx );
+    }
+  }
+  if ( Traces[0].empty() )
+    Traces[0].push_back( 0 );
+  if ( Traces[1].empty() )
+    Traces[1] = Traces[0];
+
+  // mono output plays all traces:
+  if ( Channels < 2 ) {
+    for ( unsigned int k=0; k<Traces[1].size(); k++ ) {
+      if ( find( Traces[0].begin(), Traces[0].end(), Traces[1][k] ) == Traces[0].end() )
+	Traces[0].push_back( Traces[1][k] );
+    }
+    Traces[1].clear();
+  }
+
+  // all traces need the same sampling rate:
+  double rate = Data[Traces[0][0]].sampleRate();
+  for ( int c=0; c<2; c++ ) {
+    for ( unsigned int k=0; k<Traces[c].size(); ) {
+      if ( ::fabs( Data[Traces[c][k]].sampleRate() - rate ) > 1e-6*rate ) {
+	cerr << "AudioMonitor: input trace \"" << Data[Traces[c][k]].ident()
+	     << "\" has a different sampling rate than \""
+	     << Data[Traces[0][0]].ident() << "\"\n";
+	Traces[c].erase( Traces[c].begin() + k );
+      }
+      else
+	k++;
+    }
+  }
+
+  for ( int c=0; c<2; c++ ) {
+    Resamplers[c].init( rate, AudioRate );
+    Resamplers[c].setRatio( Ratio );
+  }
+}
+
+
+void AudioMonitor::fillRing( void )
+{
+  if ( Traces[0].empty() )
+    return;
+
+  // number of new data elements common to all traces:
+  int n = -1;
+  for ( int c=0; c<Channels; c++ ) {
+    for ( unsigned int k=0; k<Traces[c].size(); k++ ) {
+      int inx = Traces[c][k];
+      const InData &trace = Data[inx];
+      if ( ReadIndex[inx] < 0 ) {
+	ReadIndex[inx] = trace.size();
+	TraceMean[inx] = trace.size() > 0 ? trace.back() : 0.0f;
+      }
+      if ( ReadIndex[inx] < trace.minIndex() )
+	ReadIndex[inx] = trace.minIndex();
+      int m = trace.size() - ReadIndex[inx];
+      if ( n < 0 || m < n )
+	n = m;
+    }
+  }
+  if ( n <= 0 )
+    return;
+
+  // high-pass filter and scale new data of each trace:
+  float gain = Gain;
+  float tfac = 1.0/0.1/Data[Traces[0][0]].sampleRate(); // dt/tau -> tau = 0.1sec
+  for ( int c=0; c<Channels; c++ ) {
+    for ( unsigned int k=0; k<Traces[c].size(); k++ ) {
+      int inx = Traces[c][k];
+      if ( c > 0 &&
+	   find( Traces[0].begin(), Traces[0].end(), inx ) != Traces[0].end() )
+	continue;
+      const InData &trace = Data[inx];
+      float fac = gain/trace.maxValue();
+      float mean = TraceMean[inx];
+      ArrayF &td = TraceData[inx];
+      td.resize( n );
+      for ( int j=0; j<n; ) {
+	const float *d = 0;
+	int m = trace.span( ReadIndex[inx]+j, n-j, d );
+	if ( m <= 0 )
+	  break;
+	for ( int i=0; i<m; i++ ) {
+	  mean += ( d[i] - mean )*tfac;
+	  td[j+i] = ( d[i] - mean )*fac;
+	}
+	j += m;
+      }
+      TraceMean[inx] = mean;
+      ReadIndex[inx] += n;
+    }
+  }
+
+  // mix and resample each channel:
+  int nf = -1;
+  for ( int c=0; c<Channels; c++ ) {
+    Mix[c].clear();
+    Mix[c].resize( n, 0.0f );
+    float w = Traces[c].empty() ? 0.0f : 1.0f/Traces[c].size();
+    for ( unsigned int k=0; k<Traces[c].size(); k++ ) {
+      const ArrayF &td = TraceData[Traces[c][k]];
+      for ( int i=0; i<n; i++ )
+	Mix[c][i] += w*td[i];
+    }
+    Out[c].clear();
+    int m = Resamplers[c].process( Mix[c].data(), n, Out[c] );
+    if ( nf < 0 || m < nf )
+      nf = m;
+  }
+  if ( nf <= 0 )
+    return;
+
+  // interleave:
+  Frames.resize( nf*Channels );
+  for ( int c=0; c<Channels; c++ ) {
+    for ( int i=0; i<nf; i++ )
+      Frames[i*Channels+c] = Out[c][i];
+  }
+
+  // adjust resampling ratio to the fill level of the ring buffer:
+  int target = 2*FramesPerBuffer;
+  double r = 1.0 - 0.01*( Ring.fill() - target )/target;
+  if ( r < 0.99 )
+    r = 0.99;
+  else if ( r > 1.01 )
+    r = 1.01;
+  Ratio += 0.05*( r - Ratio );
+  for ( int c=0; c<Channels; c++ )
+    Resamplers[c].setRatio( Ratio );
+
+  Ring.push( Frames.data(), nf );
+
+  UpdateFrames += 0.1*( nf - UpdateFrames );
+  int maxfill = (int)( 4.0*( target + UpdateFrames ) );
+  MaxFill = maxfill < Ring.capacity() ? maxfill : Ring.capacity();
+}
+
+
 void AudioMonitor::assignTraces( const InList &il, deque<InList*> &data )
 {
   Data.assign( &il );
@@ -397,5 +642,9 @@ void AudioMonitor::assignTraces( void )
 void AudioMonitor::updateDerivedTraces( void )
 {
   Data.updateDerived();
+  Mutex.lock();
+  if ( Playing )
+    fillRing();
+  Mutex.unlock();
 }
 
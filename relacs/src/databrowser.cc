@@ -255,6 +255,17 @@ void DataOverviewModel::beginAddChild( DataIndex::DataItem *parent )
 }
 
 
+void DataOverviewModel::beginAddChildren( DataIndex::DataItem *parent, int n )
+{
+  DataIndex::DataItem *parentitem = parent->parent();
+  if ( parentitem == 0 )
+    beginInsertRows( QModelIndex(), parent->size(), parent->size()+n-1 );
+  else
+    beginInsertRows( createIndex( parentitem->index( parent ), 0, parent ),
+		     parent->size(), parent->size()+n-1 );
+}
+
+
 void DataOverviewModel::endAddChild( DataIndex::DataItem *parent )
 {
   endInsertRows();
@@ -310,6 +321,23 @@ void DataOverviewModel::endPopChild( DataIndex::DataItem *parent )
 }
 
 
+void DataOverviewModel::clear( void )
+{
+  beginResetModel();
+  Data->cells()->clear();
+  endResetModel();
+}
+
+
+void DataOverviewModel::customEvent( QEvent *qce )
+{
+  if ( qce->type() == QEvent::User+1 ) {
+    DataIndexEvent *de = dynamic_cast<DataIndexEvent*>( qce );
+    Data->addSessions( de->Path, de->Sessions );
+  }
+}
+
+
 void DataOverviewModel::setDescription( const QModelIndex &index )
 {
   if ( ! index.isValid() )
@@ -19,10 +19,16 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <QDir>
+#include <QDateTime>
+#include <QFileInfo>
 #include <QStringList>
+#include <QCoreApplication>
+#include <QMutexLocker>
 #include <relacs/datafile.h>
 #include <relacs/dataindex.h>
 #include <relacs/databrowser.h>
@@ -245,6 +251,16 @@ void DataIndex::DataItem::addChild( const string &name, const Options &data,
 }
 
 
+void DataIndex::DataItem::addChildren( const deque<DataItem> &children )
+{
+  if ( children.empty() )
+    return;
+  OverviewModel->beginAddChildren( this, children.size() );
+  Children.insert( Children.end(), children.begin(), children.end() );
+  OverviewModel->endAddChild();
+}
+
+
 void DataIndex::DataItem::loadCell( void )
 {
   if ( level() != 1 )
@@ -449,9 +465,93 @@ void DataIndex::DataItem::print( void )
 }
 
 
+DataIndex::SessionInfo::SessionInfo( void )
+  : Dir( "" ),
+    File( "" ),
+    Size( 0 ),
+    Modified( 0 ),
+    Traces( 0 ),
+    Events( 0 )
+{
+}
+
+
+bool DataIndex::SessionInfo::read( const string &file )
+{
+  DataFile sf( file );
+  if ( ! sf.good() )
+    return false;
+  sf.read( 1 );
+  Str fs( file );
+  Dir = fs.dir().preventedSlash().notdir();
+  File = fs.notdir();
+  QFileInfo fi( file.c_str() );
+  Size = fi.size();
+  Modified = fi.lastModified().toTime_t();
+  // number of traces:
+  int k1 = sf.key().column( "traces>" );
+  Traces = 0;
+  for ( int k=k1; sf.key().sectionName( k, 2 ) == "traces"; k++ )
+    Traces++;
+  // number of events:
+  k1 = sf.key().column( "events>" );
+  Events = 0;
+  for ( int k=k1; sf.key().sectionName( k, 2 ) == "events"; k++ ) {
+    if ( sf.key().sectionName( k, 0 ) == "index" )
+      Events++;
+  }
+  Data = sf.metaDataOptions( sf.levels()>0 ? sf.levels()-1 : 0 );
+  return true;
+}
+
+
+bool DataIndex::SessionInfo::load( const string &line )
+{
+  // dir, file, size, modification time, traces, events,
+  // and meta data are separated by tabs:
+  string::size_type p[6];
+  string::size_type s = 0;
+  for ( int k=0; k<6; k++ ) {
+    p[k] = line.find( '\t', s );
+    if ( p[k] == string::npos )
+      return false;
+    s = p[k] + 1;
+  }
+  Dir = line.substr( 0, p[0] );
+  File = line.substr( p[0]+1, p[1]-p[0]-1 );
+  Size = atoll( line.substr( p[1]+1, p[2]-p[1]-1 ).c_str() );
+  Modified = atoll( line.substr( p[2]+1, p[3]-p[2]-1 ).c_str() );
+  Traces = Str( line.substr( p[3]+1, p[4]-p[3]-1 ) ).number( 0 );
+  Events = Str( line.substr( p[4]+1, p[5]-p[4]-1 ) ).number( 0 );
+  Data.clear();
+  Data.load( Str( line.substr( p[5]+1 ) ) );
+  return ( ! Dir.empty() && ! File.empty() );
+}
+
+
+string DataIndex::SessionInfo::save( void ) const
+{
+  return Dir + '\t' + File + '\t' + Str( Size ) + '\t' + Str( Modified )
+    + '\t' + Str( Traces ) + '\t' + Str( Events ) + '\t' + Data.save();
+}
+
+
+bool DataIndex::SessionInfo::valid( const string &path ) const
+{
+  // a missing session directory implies a missing stimulus file:
+  QFileInfo fi( ( path + "/" + Dir + "/" + File ).c_str() );
+  return ( fi.exists() && fi.size() == Size &&
+	   (long long)fi.lastModified().toTime_t() == Modified );
+}
+
+
+const string DataIndex::IndexFile = "relacs-index.dat";
+
+
 DataIndex::DataIndex( void )
   : Cells( "Data" ),
-    Session ( false )
+    Session ( false ),
+    SessionDir( "" )
 {
   OverviewModel = new DataOverviewModel( 0 );
   OverviewModel->setDataIndex( this );
@@ -459,11 +559,15 @@ DataIndex::DataIndex( void )
 
   DescriptionModel = new DataDescriptionModel( 0 );
   DescriptionModel->setOptions( 0 );
+
+  Scanner = new DataIndexScanner( this, OverviewModel );
 }
 
 
 DataIndex::~DataIndex( void )
 {
+  Scanner->stop();
+  delete Scanner;
   Cells.clear();
   delete OverviewModel;
   delete DescriptionModel;
@@ -493,15 +597,38 @@ void DataIndex::addSession( const string &path, const Options &data, int ntraces
 {
   Cells.addChild( path, data, ntraces, nevents );
   Session = true;
+  {
+    // the scanner should not index the running session:
+    QMutexLocker locker( &IndexMutex );
+    SessionDir = Str( path ).dir().preventedSlash().notdir();
+    Indexed.insert( SessionDir );
+  }
   print();
 }
 
 
 void DataIndex::endSession( bool saved )
 {
-  if ( Session && ! saved ) {
-    descriptionModel()->setOptions( 0 );
-    Cells.pop();
+  if ( Session ) {
+    string file = Cells.back().name();
+    if ( saved ) {
+      // add session to index file, if it is located in the data root:
+      QFileInfo fi( file.c_str() );
+      QDir sdir = fi.absoluteDir();
+      QDir rdir( Cells.name().c_str() );
+      SessionInfo si;
+      if ( sdir.cdUp() && sdir == rdir && si.read( file ) )
+	appendIndex( Cells.name(), si );
+    }
+    else {
+      descriptionModel()->setOptions( 0 );
+      Cells.pop();
+      // a deleted session must not be in the index:
+      QMutexLocker locker( &IndexMutex );
+      Indexed.erase( SessionDir );
+    }
+    QMutexLocker locker( &IndexMutex );
+    SessionDir = "";
   }
   Session = false;
   print();
@@ -510,56 +637,98 @@ void DataIndex::endSession( bool saved )
 
 void DataIndex::loadDirectory( const string &path )
 {
-  QDir hdir( path.c_str() );
+  Scanner->stop();
+  {
+    QMutexLocker locker( &IndexMutex );
+    Indexed.clear();
+    if ( ! SessionDir.empty() )
+      Indexed.insert( SessionDir );
+  }
+  if ( ! Session )
+    OverviewModel->clear();
+  Cells.setName( path );
+  Scanner->start( path );
+}
 
-  if ( hdir.exists() ) {
 
-    QStringList list = hdir.entryList( QDir::Dirs, QDir::Name );
-    bool first = true;
+void DataIndex::addSessions( const string &path,
+			     const deque<SessionInfo> &sessions )
+{
+  // sessions from a previous data root:
+  if ( path != Cells.name() )
+    return;
 
-    for ( int i=0; i < list.size(); ++i ) {
+  deque<DataItem> cells;
+  for ( unsigned int k=0; k<sessions.size(); k++ ) {
+    string file = path + "/" + sessions[k].Dir + "/" + sessions[k].File;
+    cells.push_back( DataItem( file, sessions[k].Data,
+			       sessions[k].Traces, sessions[k].Events,
+			       Cells.level()+1, &Cells ) );
+  }
+  Cells.addChildren( cells );
+  print();
+}
 
-      string file = path+"/"+list[i].toStdString()+"/stimuli.dat";
-      if ( ! hdir.exists( file.c_str() ) ) {
-	file = path+"/"+list[i].toStdString()+"/trigger.dat";
-	if ( ! hdir.exists( file.c_str() ) )
-	  file = "";
-      }
 
-      if ( ! file.empty() ) {
-	// clear cells:
-	if ( first ) {
-	  Cells.clear();
-	  first = false;
-	}
-	// load data:
-	DataFile sf( file );
-	sf.read( 1 );
-	// number of traces:
-	int k1 = sf.key().column( "traces>" );
-	int ntraces = 0;
-	for ( int k=k1; sf.key().sectionName( k, 2 ) == "traces"; k++ )
-	  ntraces++;
-	// number of events:
-	k1 = sf.key().column( "events>" );
-	int nevents = 0;
-	for ( int k=k1; sf.key().sectionName( k, 2 ) == "events"; k++ ) {
-	  if ( sf.key().sectionName( k, 0 ) == "index" )
-	    nevents++;
-	}
-	// add cell:
-	Cells.addChild( file,
-			sf.metaDataOptions( sf.levels()>0 ? sf.levels()-1 : 0 ),
-			ntraces, nevents );
-      }
+bool DataIndex::indexed( const string &dir )
+{
+  QMutexLocker locker( &IndexMutex );
+  return ! Indexed.insert( dir ).second;
+}
 
-    }
 
-    Cells.setName( path );
+void DataIndex::appendIndex( const string &path, const SessionInfo &session )
+{
+  QMutexLocker locker( &IndexMutex );
+  Indexed.insert( session.Dir );
+  string file = path + "/" + IndexFile;
+  bool header = ! QFileInfo( file.c_str() ).exists();
+  ofstream df( file.c_str(), ofstream::out | ofstream::app );
+  if ( ! df.good() )
+    return;
+  if ( header )
+    writeIndexHeader( df );
+  df << session.save() << '\n';
+}
+
 
+void DataIndex::compactIndex( const string &path )
+{
+  QMutexLocker locker( &IndexMutex );
+  string file = path + "/" + IndexFile;
+  ifstream sf( file.c_str() );
+  if ( ! sf.good() )
+    return;
+  deque<string> lines;
+  set<string> dirs;
+  string line;
+  while ( getline( sf, line ) ) {
+    if ( line.empty() || line[0] == '#' )
+      continue;
+    SessionInfo si;
+    if ( si.load( line ) && si.valid( path ) && dirs.insert( si.Dir ).second )
+      lines.push_back( line );
   }
-  print();
+  sf.close();
+
+  // write to a temporary file and replace the index file by it:
+  string tmpfile = file + ".tmp";
+  ofstream df( tmpfile.c_str() );
+  if ( ! df.good() )
+    return;
+  writeIndexHeader( df );
+  for ( unsigned int k=0; k<lines.size(); k++ )
+    df << lines[k] << '\n';
+  df.close();
+  if ( df.fail() || ::rename( tmpfile.c_str(), file.c_str() ) != 0 )
+    ::remove( tmpfile.c_str() );
+}
 
+
+void DataIndex::writeIndexHeader( ostream &str )
+{
+  str << "# RELACS index of recording sessions:\n";
+  str << "# directory, stimulus file, size, modification time, traces, events, and meta data separated by tabs\n";
 }
 
 
@@ -609,6 +778,107 @@ void DataIndex::setDescriptionView( QTreeView *view )
 }
 
 
+DataIndexScanner::DataIndexScanner( DataIndex *data, QObject *receiver )
+  : DI( data ),
+    Receiver( receiver ),
+    Path( "" ),
+    Interrupt( false )
+{
+}
+
+
+void DataIndexScanner::start( const string &path )
+{
+  Path = path;
+  InterruptMutex.lock();
+  Interrupt = false;
+  InterruptMutex.unlock();
+  QThread::start( LowPriority );
+}
+
+
+void DataIndexScanner::stop( void )
+{
+  InterruptMutex.lock();
+  Interrupt = true;
+  InterruptMutex.unlock();
+  wait();
+}
+
+
+bool DataIndexScanner::interrupted( void )
+{
+  QMutexLocker locker( &InterruptMutex );
+  return Interrupt;
+}
+
+
+void DataIndexScanner::post( deque<DataIndex::SessionInfo> &sessions )
+{
+  QCoreApplication::postEvent( Receiver, new DataIndexEvent( Path, sessions ) );
+  sessions.clear();
+}
+
+
+void DataIndexScanner::run( void )
+{
+  QDir hdir( Path.c_str() );
+  if ( ! hdir.exists() )
+    return;
+
+  // read index file:
+  deque<DataIndex::SessionInfo> sessions;
+  string indexfile = Path + "/" + DataIndex::IndexFile;
+  ifstream sf( indexfile.c_str() );
+  string line;
+  int dropped = 0;
+  while ( getline( sf, line ) ) {
+    if ( line.empty() || line[0] == '#' )
+      continue;
+    DataIndex::SessionInfo si;
+    // removed or modified sessions are parsed again below:
+    if ( ! si.load( line ) || ! si.valid( Path ) ) {
+      dropped++;
+      continue;
+    }
+    if ( ! DI->indexed( si.Dir ) )
+      sessions.push_back( si );
+  }
+  sf.close();
+  if ( ! sessions.empty() )
+    post( sessions );
+  if ( dropped > 0 )
+    DI->compactIndex( Path );
+  if ( interrupted() )
+    return;
+
+  // parse sessions that are not in the index file:
+  deque<DataIndex::SessionInfo> newsessions;
+  QStringList list = hdir.entryList( QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name );
+  for ( int i=0; i < list.size() && ! interrupted(); ++i ) {
+    string dir = list[i].toStdString();
+    string file = Path + "/" + dir + "/stimuli.dat";
+    if ( ! hdir.exists( file.c_str() ) ) {
+      file = Path + "/" + dir + "/trigger.dat";
+      if ( ! hdir.exists( file.c_str() ) )
+	continue;
+    }
+    if ( DI->indexed( dir ) )
+      continue;
+    DataIndex::SessionInfo si;
+    if ( ! si.read( file ) )
+      continue;
+    DI->appendIndex( Path, si );
+    newsessions.push_back( si );
+    // deliver sessions in small chunks:
+    if ( newsessions.size() >= 20 )
+      post( newsessions );
+  }
+  if ( ! newsessions.empty() )
+    post( newsessions );
+}
+
+
 }; /* namespace relacs */
 
 
@@ -43,12 +43,16 @@ void ReadThread::run( void )
 {
   int r = 0;
   bool startam = true;
+  RW->UC.reset();
   do {
     r = RW->updateData();
     if ( startam ) {
       RW->AM->start();
       startam = false;
     }
+    // let more data accumulate:
+    if ( r > 0 && RW->UpdateSleep > 0 )
+      usleep( RW->UpdateSleep );
   } while ( r > 0 );
   RW->AM->stop();
 }
@@ -86,6 +90,59 @@ bool WriteThread::failed( void ) const
 }
 
 
+ConfigThread::ConfigThread( void )
+{
+}
+
+
+ConfigThread::~ConfigThread( void )
+{
+  wait();
+}
+
+
+void ConfigThread::start( const vector< string > &files )
+{
+  wait();
+  Files = files;
+  Sections.clear();
+  Loaded.clear();
+  QThread::start();
+}
+
+
+void ConfigThread::run( void )
+{
+  Sections.resize( Files.size() );
+  Loaded.resize( Files.size() );
+  for ( unsigned int k=0; k<Files.size(); k++ )
+    Loaded[k] = ConfigureClasses::load( Files[k], Sections[k] );
+}
+
+
+int ConfigThread::read( ConfigureClasses &cfg, int group )
+{
+  wait();
+  int r = 0;
+  for ( unsigned int k=0; k<Sections.size(); k++ ) {
+    if ( Loaded[k] > 0 ) {
+      cfg.read( group, Sections[k] );
+      r++;
+    }
+  }
+  Files.clear();
+  Sections.clear();
+  Loaded.clear();
+  return r;
+}
+
+
+bool ConfigThread::pending( void ) const
+{
+  return ! Files.empty();
+}
+
+
 }; /* namespace relacs */
 
 
@@ -26,6 +26,7 @@
 #include <relacs/filter.h>
 #include <relacs/session.h>
 #include <relacs/savefiles.h>
+#include <relacs/latencymonitor.h>
 #include <relacs/relacsdevices.h>
 #include <relacs/relacswidget.h>
 #include <relacs/filterdetectors.h>
@@ -968,6 +969,8 @@ string FilterDetectors::filter( double signaltime )
   // filter and detect events:
   for ( FilterList::iterator d = FL.begin(); d != FL.end(); ++d ) {
 
+    LatencyTimer timer;
+
     if ( signaltime >= 0.0 ) {
       (*d)->OutEvents.setSignalTime( signaltime );
       (*d)->OutTraces.setSignalTime( signaltime );
@@ -1084,6 +1087,10 @@ string FilterDetectors::filter( double signaltime )
     
     (*d)->FilterDetector->unlock();
 
+    if ( (*d)->Latency == 0 )
+      (*d)->Latency = RW->LM.stage( ident );
+    (*d)->Latency->record( timer.elapsed() );
+
   }
 
   return warning;  
@@ -1403,7 +1410,7 @@ FilterData::FilterData( Filter *filter,
     InTraces(), InEvents(), OutTraces(), OutEvents(), OtherEvents(),
     NBuffer( n ), SizeBuffer( size ), WidthBuffer( width ),
     PanelTrace( panel ), LineWidth( linewidth ), Init( true ),
-    GeneralOptions(generalOptions)
+    GeneralOptions(generalOptions), Latency( 0 )
 {
   FilterDetector = filter;
   NOut = filter->outTraces();
@@ -1419,7 +1426,7 @@ FilterData::FilterData( const FilterData &fd )
     NBuffer( fd.NBuffer ), SizeBuffer( fd.SizeBuffer ),
     WidthBuffer( fd.WidthBuffer ),
     PanelTrace( fd.PanelTrace ), LineWidth( fd.LineWidth ), Init( fd.Init ),
-    GeneralOptions(fd.GeneralOptions)
+    GeneralOptions(fd.GeneralOptions), Latency( fd.Latency )
 {
   FilterDetector = fd.FilterDetector;
   Out = fd.Out;
@@ -0,0 +1,232 @@
+/*
+  latencymonitor.cc
+  Lock-free latency histograms for the stages of the data processing loop.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <QMutexLocker>
+#include <relacs/latencymonitor.h>
+
+namespace relacs {
+
+
+LatencyHistogram::LatencyHistogram( const string &name )
+  : Name( name )
+{
+  reset();
+}
+
+
+string LatencyHistogram::name( void ) const
+{
+  return Name;
+}
+
+
+int LatencyHistogram::bin( long us )
+{
+  if ( us <= 1 )
+    return 0;
+  int b = (int)::floor( BinsPerOctave*::log2( (double)us ) );
+  return b < NBins ? b : NBins-1;
+}
+
+
+void LatencyHistogram::record( long us )
+{
+  if ( us < 0 )
+    us = 0;
+  Bins[bin( us )].fetch_add( 1, memory_order_relaxed );
+  Sum.fetch_add( us, memory_order_relaxed );
+  Count.fetch_add( 1, memory_order_relaxed );
+  long m = Max.load( memory_order_relaxed );
+  while ( us > m && ! Max.compare_exchange_weak( m, us, memory_order_relaxed ) );
+}
+
+
+void LatencyHistogram::reset( void )
+{
+  for ( int k=0; k<NBins; k++ )
+    Bins[k].store( 0, memory_order_relaxed );
+  Count.store( 0, memory_order_relaxed );
+  Sum.store( 0, memory_order_relaxed );
+  Max.store( 0, memory_order_relaxed );
+}
+
+
+long LatencyHistogram::count( void ) const
+{
+  return Count.load( memory_order_relaxed );
+}
+
+
+double LatencyHistogram::mean( void ) const
+{
+  long n = Count.load( memory_order_relaxed );
+  return n > 0 ? (double)Sum.load( memory_order_relaxed )/(double)n : 0.0;
+}
+
+
+long LatencyHistogram::max( void ) const
+{
+  return Max.load( memory_order_relaxed );
+}
+
+
+double LatencyHistogram::quantile( double p ) const
+{
+  long counts[NBins];
+  long n = 0;
+  for ( int k=0; k<NBins; k++ ) {
+    counts[k] = Bins[k].load( memory_order_relaxed );
+    n += counts[k];
+  }
+  if ( n <= 0 )
+    return 0.0;
+  long target = (long)::ceil( p*n );
+  if ( target < 1 )
+    target = 1;
+  long sum = 0;
+  for ( int k=0; k<NBins; k++ ) {
+    sum += counts[k];
+    if ( sum >= target ) {
+      if ( k == 0 )
+	return 1.0;
+      double q = ::sqrt( binLower( k ) * binLower( k+1 ) );
+      double m = Max.load( memory_order_relaxed );
+      return q < m ? q : m;
+    }
+  }
+  return Max.load( memory_order_relaxed );
+}
+
+
+long LatencyHistogram::binCount( int bin ) const
+{
+  return Bins[bin].load( memory_order_relaxed );
+}
+
+
+double LatencyHistogram::binLower( int bin )
+{
+  return ::exp2( (double)bin/BinsPerOctave );
+}
+
+
+LatencyMonitor::LatencyMonitor( void )
+{
+}
+
+
+LatencyMonitor::~LatencyMonitor( void )
+{
+  for ( unsigned int k=0; k<Stages.size(); k++ )
+    delete Stages[k];
+  Stages.clear();
+}
+
+
+LatencyHistogram *LatencyMonitor::stage( const string &name )
+{
+  QMutexLocker locker( &Mutex );
+  for ( unsigned int k=0; k<Stages.size(); k++ ) {
+    if ( Stages[k]->name() == name )
+      return Stages[k];
+  }
+  Stages.push_back( new LatencyHistogram( name ) );
+  return Stages.back();
+}
+
+
+int LatencyMonitor::size( void ) const
+{
+  QMutexLocker locker( &Mutex );
+  return Stages.size();
+}
+
+
+void LatencyMonitor::reset( void )
+{
+  QMutexLocker locker( &Mutex );
+  for ( unsigned int k=0; k<Stages.size(); k++ )
+    Stages[k]->reset();
+}
+
+
+void LatencyMonitor::html( ostream &str ) const
+{
+  QMutexLocker locker( &Mutex );
+  str << "<table>\n";
+  str << "<tr><th align=left>Stage</th><th>n</th><th>mean</th>"
+      << "<th>median</th><th>95%</th><th>99%</th><th>max</th></tr>\n";
+  str << fixed << setprecision( 0 );
+  for ( unsigned int k=0; k<Stages.size(); k++ ) {
+    const LatencyHistogram *h = Stages[k];
+    str << "<tr><td>" << h->name() << "</td>"
+	<< "<td align=right>" << h->count() << "</td>"
+	<< "<td align=right>" << h->mean() << "&micro;s</td>"
+	<< "<td align=right>" << h->quantile( 0.5 ) << "&micro;s</td>"
+	<< "<td align=right>" << h->quantile( 0.95 ) << "&micro;s</td>"
+	<< "<td align=right>" << h->quantile( 0.99 ) << "&micro;s</td>"
+	<< "<td align=right>" << h->max() << "&micro;s</td></tr>\n";
+  }
+  str << "</table>\n";
+}
+
+
+void LatencyMonitor::save( ostream &str ) const
+{
+  QMutexLocker locker( &Mutex );
+  str << "# processing latencies in microseconds\n";
+  str << "#Key\n";
+  str << "# stage\tn\tmean\tmedian\t95%\t99%\tmax\n";
+  str << fixed << setprecision( 1 );
+  for ( unsigned int k=0; k<Stages.size(); k++ ) {
+    const LatencyHistogram *h = Stages[k];
+    str << "  " << h->name() << '\t' << h->count() << '\t' << h->mean()
+	<< '\t' << h->quantile( 0.5 ) << '\t' << h->quantile( 0.95 )
+	<< '\t' << h->quantile( 0.99 ) << '\t' << h->max() << '\n';
+  }
+  for ( unsigned int k=0; k<Stages.size(); k++ ) {
+    const LatencyHistogram *h = Stages[k];
+    str << "\n\n";
+    str << "# stage: " << h->name() << '\n';
+    str << "#Key\n";
+    str << "# bin\tcount\n";
+    str << "# us\tn\n";
+    for ( int b=0; b<LatencyHistogram::NBins; b++ ) {
+      if ( h->binCount( b ) > 0 )
+	str << "  " << LatencyHistogram::binLower( b ) << '\t' << h->binCount( b ) << '\n';
+    }
+  }
+}
+
+
+void LatencyMonitor::save( const string &file ) const
+{
+  ofstream df( file.c_str() );
+  if ( df.good() )
+    save( df );
+}
+
+
+}; /* namespace relacs */
+
@@ -0,0 +1,391 @@
+/*
+  memorybudget.cc
+  Sizes the ring buffers of the acquired traces and events within a total memory budget.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <vector>
+#include <relacs/str.h>
+#include <relacs/memorybudget.h>
+
+namespace relacs {
+
+
+  /*! Buffers smaller than this number of bytes are not backed by huge pages. */
+static const size_t HugePageSize = 2*1024*1024;
+
+
+  /*! Advise the kernel to use transparent huge pages for the
+      page-aligned part of the \a n bytes at \a p. */
+static void adviseHugePages( const void *p, size_t n )
+{
+#ifdef MADV_HUGEPAGE
+  if ( p == 0 || n < 2*HugePageSize )
+    return;
+  size_t start = ( (size_t)p + HugePageSize - 1 ) & ~( HugePageSize - 1 );
+  size_t end = ( (size_t)p + n ) & ~( HugePageSize - 1 );
+  if ( end > start )
+    madvise( (void *)start, end - start, MADV_HUGEPAGE );
+#endif
+}
+
+
+  /*! Lock the \a n bytes at \a p into RAM.
+      \return 0 on success or the error code. */
+static int lockRange( const void *p, size_t n, bool hugepages )
+{
+  if ( p == 0 || n == 0 )
+    return 0;
+  if ( hugepages )
+    adviseHugePages( p, n );
+  return mlock( p, n ) == 0 ? 0 : errno;
+}
+
+
+static void unlockRange( const void *p, size_t n )
+{
+  if ( p != 0 && n > 0 )
+    munlock( p, n );
+}
+
+
+MemoryBudget::MemoryBudget( void )
+  : Budget( 0 ),
+    MinTime( 0.0 )
+{
+}
+
+
+MemoryBudget::~MemoryBudget( void )
+{
+  unlock();
+}
+
+
+void MemoryBudget::add( InData *trace, int priority )
+{
+  Buffer b;
+  b.Trace = trace;
+  b.Events = 0;
+  b.DeltaT = trace->sampleInterval();
+  b.Priority = priority;
+  b.Requested = trace->capacity();
+  b.Locked = false;
+  Buffers.push_back( b );
+}
+
+
+void MemoryBudget::add( EventData *events, double buffertime, int priority )
+{
+  Buffer b;
+  b.Trace = 0;
+  b.Events = events;
+  b.Priority = priority;
+  b.Requested = events->capacity();
+  // mean time per event:
+  b.DeltaT = b.Requested > 0 ? buffertime/b.Requested : 0.0;
+  b.Locked = false;
+  Buffers.push_back( b );
+}
+
+
+void MemoryBudget::clear( void )
+{
+  unlock();
+  Buffers.clear();
+  Budget = 0;
+  MinTime = 0.0;
+}
+
+
+int MemoryBudget::size( void ) const
+{
+  return Buffers.size();
+}
+
+
+int MemoryBudget::capacity( const Buffer &b ) const
+{
+  return b.Trace != 0 ? b.Trace->capacity() : b.Events->capacity();
+}
+
+
+int MemoryBudget::elementSize( const Buffer &b ) const
+{
+  if ( b.Trace != 0 )
+    return sizeof( float );
+  int n = 1;
+  if ( b.Events->useSizeBuffer() )
+    n++;
+  if ( b.Events->useWidthBuffer() )
+    n++;
+  return n*sizeof( double );
+}
+
+
+int MemoryBudget::writeBufferCapacity( const Buffer &b ) const
+{
+  return b.Trace != 0 ? b.Trace->writeBufferCapacity() : b.Events->writeBufferCapacity();
+}
+
+
+string MemoryBudget::ident( const Buffer &b ) const
+{
+  return b.Trace != 0 ? b.Trace->ident() : b.Events->ident();
+}
+
+
+long long MemoryBudget::bytes( int index ) const
+{
+  const Buffer &b = Buffers[index];
+  return (long long)capacity( b ) * elementSize( b );
+}
+
+
+long long MemoryBudget::bytes( void ) const
+{
+  long long n = 0;
+  for ( unsigned int k=0; k<Buffers.size(); k++ )
+    n += bytes( k );
+  return n;
+}
+
+
+double MemoryBudget::time( int index ) const
+{
+  const Buffer &b = Buffers[index];
+  return ( capacity( b ) - writeBufferCapacity( b ) )*b.DeltaT;
+}
+
+
+void MemoryBudget::resize( Buffer &b, int n )
+{
+  if ( n == capacity( b ) )
+    return;
+  if ( b.Locked ) {
+    if ( b.Trace != 0 )
+      unlockRange( b.Trace->buffer(), (size_t)capacity( b )*sizeof( float ) );
+    else {
+      size_t nb = (size_t)capacity( b )*sizeof( double );
+      unlockRange( b.Events->data(), nb );
+      if ( b.Events->useSizeBuffer() )
+	unlockRange( b.Events->sizeData(), nb );
+      if ( b.Events->useWidthBuffer() )
+	unlockRange( b.Events->widthData(), nb );
+    }
+    b.Locked = false;
+  }
+  int nw = writeBufferCapacity( b );
+  if ( b.Trace != 0 ) {
+    b.Trace->free( n );
+    b.Trace->setWriteBufferCapacity( nw );
+  }
+  else {
+    // the write buffer of events is a fraction of the capacity:
+    nw = (int)( (long long)nw*n/capacity( b ) );
+    b.Events->free( n );
+    b.Events->setWriteBufferCapacity( nw );
+  }
+}
+
+
+string MemoryBudget::fit( long long budget, double mintime )
+{
+  Budget = budget;
+  MinTime = mintime;
+  long long total = bytes();
+  if ( budget <= 0 || total <= budget )
+    return "";
+
+  // minimum and maximum capacities:
+  vector< int > minn( Buffers.size(), 0 );
+  vector< int > maxn( Buffers.size(), 0 );
+  int minprio = 0;
+  int maxprio = 0;
+  for ( unsigned int k=0; k<Buffers.size(); k++ ) {
+    const Buffer &b = Buffers[k];
+    maxn[k] = capacity( b );
+    if ( b.Trace != 0 )
+      minn[k] = writeBufferCapacity( b ) + (int)::ceil( mintime/b.DeltaT );
+    else {
+      double f = maxn[k] > 0 ? double( writeBufferCapacity( b ) )/maxn[k] : 0.0;
+      minn[k] = f < 1.0 && b.DeltaT > 0.0 ?
+	(int)::ceil( mintime/b.DeltaT/( 1.0 - f ) ) : maxn[k];
+    }
+    if ( minn[k] > maxn[k] )
+      minn[k] = maxn[k];
+    if ( k == 0 || b.Priority < minprio )
+      minprio = b.Priority;
+    if ( k == 0 || b.Priority > maxprio )
+      maxprio = b.Priority;
+  }
+
+  // shrink the buffers starting with the lowest priority:
+  for ( int p=minprio; p<=maxprio && total > budget; p++ ) {
+    long long level = 0;
+    long long levelmin = 0;
+    double maxtime = 0.0;
+    for ( unsigned int k=0; k<Buffers.size(); k++ ) {
+      const Buffer &b = Buffers[k];
+      if ( b.Priority != p )
+	continue;
+      level += bytes( k );
+      levelmin += (long long)minn[k] * elementSize( b );
+      double t = maxn[k]*b.DeltaT;
+      if ( t > maxtime )
+	maxtime = t;
+    }
+    if ( level == levelmin )
+      continue;
+    long long target = level - ( total - budget );
+    // common maximum time of all buffers of this priority:
+    double t = 0.0;
+    if ( target > levelmin ) {
+      double t0 = 0.0;
+      double t1 = maxtime;
+      for ( int i=0; i<50; i++ ) {
+	t = 0.5*( t0 + t1 );
+	long long n = 0;
+	for ( unsigned int k=0; k<Buffers.size(); k++ ) {
+	  const Buffer &b = Buffers[k];
+	  if ( b.Priority != p )
+	    continue;
+	  int c = (int)::floor( t/b.DeltaT );
+	  if ( c < minn[k] )
+	    c = minn[k];
+	  if ( c > maxn[k] )
+	    c = maxn[k];
+	  n += (long long)c * elementSize( b );
+	}
+	if ( n > target )
+	  t1 = t;
+	else
+	  t0 = t;
+      }
+      t = t0;
+    }
+    for ( unsigned int k=0; k<Buffers.size(); k++ ) {
+      Buffer &b = Buffers[k];
+      if ( b.Priority != p )
+	continue;
+      int c = (int)::floor( t/b.DeltaT );
+      if ( c < minn[k] )
+	c = minn[k];
+      if ( c > maxn[k] )
+	c = maxn[k];
+      resize( b, c );
+    }
+    total = bytes();
+  }
+
+  if ( total > budget )
+    return "The data buffers need at least " + Str( 1.0e-6*total, 0, 0, 'f' )
+      + "MB for " + Str( mintime, 0, 1, 'f' ) + "s of data, which exceeds the memory budget of "
+      + Str( 1.0e-6*budget, 0, 0, 'f' ) + "MB.";
+  return "";
+}
+
+
+string MemoryBudget::lock( bool hugepages )
+{
+  int error = 0;
+  for ( unsigned int k=0; k<Buffers.size(); k++ ) {
+    Buffer &b = Buffers[k];
+    if ( b.Locked )
+      continue;
+    int r = 0;
+    if ( b.Trace != 0 )
+      r = lockRange( b.Trace->buffer(), (size_t)capacity( b )*sizeof( float ), hugepages );
+    else {
+      size_t nb = (size_t)capacity( b )*sizeof( double );
+      r = lockRange( b.Events->data(), nb, hugepages );
+      if ( r == 0 && b.Events->useSizeBuffer() )
+	r = lockRange( b.Events->sizeData(), nb, hugepages );
+      if ( r == 0 && b.Events->useWidthBuffer() )
+	r = lockRange( b.Events->widthData(), nb, hugepages );
+    }
+    if ( r == 0 )
+      b.Locked = true;
+    else if ( error == 0 )
+      error = r;
+  }
+  if ( error != 0 )
+    return "Failed to lock data buffers into RAM: " + string( strerror( error ) )
+      + ". Increase the limit for locked memory (ulimit -l).";
+  return "";
+}
+
+
+void MemoryBudget::unlock( void )
+{
+  for ( unsigned int k=0; k<Buffers.size(); k++ ) {
+    Buffer &b = Buffers[k];
+    if ( ! b.Locked )
+      continue;
+    if ( b.Trace != 0 )
+      unlockRange( b.Trace->buffer(), (size_t)capacity( b )*sizeof( float ) );
+    else {
+      size_t nb = (size_t)capacity( b )*sizeof( double );
+      unlockRange( b.Events->data(), nb );
+      if ( b.Events->useSizeBuffer() )
+	unlockRange( b.Events->sizeData(), nb );
+      if ( b.Events->useWidthBuffer() )
+	unlockRange( b.Events->widthData(), nb );
+    }
+    b.Locked = false;
+  }
+}
+
+
+void MemoryBudget::html( ostream &str ) const
+{
+  str << "<table>\n";
+  str << "<tr><th align=left>Buffer</th><th>priority</th><th>time</th>"
+      << "<th>requested</th><th>memory</th><th>locked</th></tr>\n";
+  str << fixed;
+  for ( unsigned int k=0; k<Buffers.size(); k++ ) {
+    const Buffer &b = Buffers[k];
+    str << "<tr><td>" << ident( b ) << "</td>"
+	<< "<td align=right>" << b.Priority << "</td>"
+	<< "<td align=right>" << ( b.Trace != 0 ? "" : "~" )
+	<< setprecision( 1 ) << time( k ) << "s</td>"
+	<< "<td align=right>" << setprecision( 1 )
+	<< 1.0e-6*b.Requested*elementSize( b ) << "MB</td>"
+	<< "<td align=right>" << 1.0e-6*bytes( k ) << "MB</td>"
+	<< "<td align=center>" << ( b.Locked ? "yes" : "no" ) << "</td></tr>\n";
+  }
+  str << "<tr><td><b>Total</b></td><td></td><td></td><td></td>"
+      << "<td align=right><b>" << setprecision( 1 ) << 1.0e-6*bytes()
+      << "MB</b></td><td></td></tr>\n";
+  str << "</table>\n";
+  if ( Budget > 0 )
+    str << "<p>Memory budget: " << setprecision( 0 ) << 1.0e-6*Budget
+	<< "MB, at least " << setprecision( 1 ) << MinTime << "s per buffer.</p>\n";
+  else
+    str << "<p>No memory budget.</p>\n";
+}
+
+
+}; /* namespace relacs */
+
@@ -36,6 +36,8 @@ Model::Model( const string &name, const string &pluginset,
     Signals( 0 ),
     SignalChannels( 0 ),
     SignalValues( 0 ),
+    LoopbackTrace( -1 ),
+    LoopbackChannel( -1 ),
     SignalMutex(),
     InterruptLock()
 {
@@ -89,6 +91,16 @@ double Model::load( void ) const
 
 void Model::push( int trace, float val )
 {
+  if ( trace == LoopbackTrace ) {
+    SignalMutex.lock();
+    for ( unsigned int k=0; k<SignalChannels.size(); k++ ) {
+      if ( SignalChannels[k] == LoopbackChannel ) {
+	val += signal( Data[trace].currentTime(), k );
+	break;
+      }
+    }
+    SignalMutex.unlock();
+  }
   Data[trace].push( val );
 }
 
@@ -222,7 +234,25 @@ void Model::start( InList &data, AnalogInput *aidevice,
   AIDevice = aidevice;
   InterruptModel = false;
   AveragedLoad = 0;
-  MaxPush = deltat( 0 ) > 0.0 ? (int)::ceil( 0.01 / deltat( 0 ) ) : 100;
+  double updateinterval = 0.01;
+  LoopbackTrace = -1;
+  LoopbackChannel = -1;
+  if ( aidevice != 0 ) {
+    updateinterval = aidevice->number( "updateinterval", 0.01 );
+    int loopbackin = aidevice->integer( "loopbackin", "", -1 );
+    LoopbackChannel = aidevice->integer( "loopbackout", "", -1 );
+    for ( int k=0; k<Data.size() && loopbackin >= 0; k++ ) {
+      if ( Data[k].rawChannel() && Data[k].channel() == loopbackin ) {
+	LoopbackTrace = k;
+	break;
+      }
+    }
+    if ( LoopbackChannel < 0 )
+      LoopbackTrace = -1;
+  }
+  if ( updateinterval <= 0.0 )
+    updateinterval = 0.01;
+  MaxPush = deltat( 0 ) > 0.0 ? (int)::ceil( updateinterval / deltat( 0 ) ) : 100;
   MaxPushTime = MaxPush * deltat( 0 );
   PushCount = 0;
   Signals.clear();
@@ -19,12 +19,14 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <cstdlib>
 #include <dlfcn.h>
 #include <fstream>
 #include <iostream>
 #include <QDir>
 #include <QFileInfo>
+#include <QTime>
 #include <relacs/str.h>
 #include <relacs/plugins.h>
 using namespace std;
@@ -66,7 +68,10 @@ int Plugins::open( const string &file )
 
   // load plugin file:
   CurrentFileID = newFileID();
+  QTime loadtime;
+  loadtime.start();
   void *dlib = dlopen( file.c_str(), RTLD_NOW | RTLD_GLOBAL );
+  int ms = loadtime.elapsed();
 
   // check success:
   if ( dlib == 0 ) {
@@ -82,9 +87,11 @@ int Plugins::open( const string &file )
   if ( index < Files.size() && Files[index].File == file ) {
     Files[index].Lib = dlib;
     Files[index].FileID = CurrentFileID;
+    Files[index].LoadTime = ms;
   }
   else {
     Files.push_back( FileInfo( file, dlib, CurrentFileID ) );
+    Files.back().LoadTime = ms;
   }
 
   return CurrentFileID;
@@ -110,7 +117,10 @@ int Plugins::open( int id )
 
   // load plugin file:
   CurrentFileID = newFileID();
+  QTime loadtime;
+  loadtime.start();
   void *dlib = dlopen( file.c_str(), RTLD_NOW | RTLD_GLOBAL );
+  int ms = loadtime.elapsed();
 
   // check success:
   if ( dlib == 0 ) {
@@ -125,6 +135,7 @@ int Plugins::open( int id )
   // success!
   Files[index].Lib = dlib;
   Files[index].FileID = CurrentFileID;
+  Files[index].LoadTime = ms;
 
   return CurrentFileID;
 }
@@ -350,7 +361,10 @@ int Plugins::reopen( const string &file )
   
   // load plugin file:
   CurrentFileID = newFileID();
+  QTime loadtime;
+  loadtime.start();
   void *dlib = dlopen( file.c_str(), RTLD_NOW | RTLD_GLOBAL );
+  int ms = loadtime.elapsed();
 
   // check success:
   if ( dlib == 0 ) {
@@ -364,6 +378,7 @@ int Plugins::reopen( const string &file )
 
   // memorize plugin file:
   Files.push_back( FileInfo( file, dlib, CurrentFileID ) );
+  Files.back().LoadTime = ms;
   return CurrentFileID;
 }
 
@@ -394,7 +409,10 @@ int Plugins::reopen( int id )
   
   // load plugin file:
   CurrentFileID = newFileID();
+  QTime loadtime;
+  loadtime.start();
   void *dlib = dlopen( file.c_str(), RTLD_NOW | RTLD_GLOBAL );
+  int ms = loadtime.elapsed();
 
   // check success:
   if ( dlib == 0 ) {
@@ -408,6 +426,7 @@ int Plugins::reopen( int id )
 
   // memorize plugin file:
   Files.push_back( FileInfo( file, dlib, CurrentFileID ) );
+  Files.back().LoadTime = ms;
   return CurrentFileID;
 }
 
@@ -524,7 +543,10 @@ int Plugins::fileID( const string &plugin )
 void *Plugins::create( int index )
 {
   if ( index >= 0 && index < (int)Plugs.size() ) {
+    QTime createtime;
+    createtime.start();
     void *m = Plugs[index].Create();
+    Plugs[index].CreateTime += createtime.elapsed();
     if ( m != 0 )
       Plugs[index].UseCount++;
     return m;
@@ -596,6 +618,28 @@ void Plugins::clearClassErrors( void )
 }
 
 
+string Plugins::timingReport( int n )
+{
+  vector< pair< int, string > > files;
+  for ( unsigned int k=0; k<Files.size(); k++ )
+    files.push_back( make_pair( Files[k].LoadTime, Files[k].File ) );
+  sort( files.rbegin(), files.rend() );
+  vector< pair< int, string > > plugs;
+  for ( unsigned int k=0; k<Plugs.size(); k++ )
+    plugs.push_back( make_pair( Plugs[k].CreateTime, Plugs[k].Ident ) );
+  sort( plugs.rbegin(), plugs.rend() );
+
+  string s = "";
+  for ( int k=0; k<n && k<(int)files.size(); k++ )
+    s += "loading " + files[k].second + ": " + Str( files[k].first ) + "ms\n";
+  for ( int k=0; k<n && k<(int)plugs.size(); k++ )
+    s += "creating " + plugs[k].second + ": " + Str( plugs[k].first ) + "ms\n";
+  if ( ! s.empty() )
+    s.erase( s.size()-1 );
+  return s;
+}
+
+
 void Plugins::add( const string &ident, int type, PluginCreator create,
 		   const string &version )
 {
@@ -670,6 +714,7 @@ Plugins::PluginInfo::PluginInfo( const string &ident, int type,
   FileID = fileid;
   UseCount = 0;
   Create = create;
+  CreateTime = 0;
 }
 
 
@@ -678,6 +723,7 @@ Plugins::FileInfo::FileInfo( const string &file, void *lib, int fileid )
   File = file;
   Lib = lib;
   FileID = fileid;
+  LoadTime = 0;
 }
 
 
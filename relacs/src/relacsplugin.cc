@@ -67,6 +67,8 @@ const int RELACSPlugin::Plugins = 1;
 
 RELACSPlugin::~RELACSPlugin( void )
 {
+  cancelTasks();
+  waitTasks();
   if ( Widget != 0 )
     delete Widget;
 }
@@ -701,6 +703,12 @@ string RELACSPlugin::addPath( const string &file ) const
 }
 
 
+void RELACSPlugin::addDataFile( const string &file )
+{
+  RW->SF->addDataFile( file );
+}
+
+
 string RELACSPlugin::addDefaultPath( const string &file ) const
 {
   return RW->SF->addDefaultPath( file );
@@ -1450,6 +1458,45 @@ void RELACSPlugin::restoreMouseCursor( void )
 }
 
 
+ThreadPool &RELACSPlugin::threadPool( void )
+{
+  return RW->TP;
+}
+
+
+void RELACSPlugin::submitTask( ThreadPool::Task *task )
+{
+  RW->TP.submit( task, Tasks );
+}
+
+
+bool RELACSPlugin::waitTasks( void )
+{
+  if ( Tasks.pending() == 0 )
+    return ! Tasks.canceled();
+  return RW->TP.wait( Tasks );
+}
+
+
+void RELACSPlugin::cancelTasks( void )
+{
+  Tasks.cancel();
+}
+
+
+void RELACSPlugin::resetTasks( void )
+{
+  Tasks.reset();
+}
+
+
+bool RELACSPlugin::parallelFor( int first, int last, ThreadPool::Loop &loop,
+				int grain )
+{
+  return RW->TP.parallelFor( first, last, loop, Tasks, grain );
+}
+
+
 void RELACSPlugin::saveDoxygenOptions( void )
 {
   cout << "\n";
@@ -24,6 +24,7 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <QLabel>
 #include <QMenuBar>
 #include <QStatusBar>
@@ -106,6 +107,14 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
     WriteLoop( this ),
     DataRun( false ),
     WriteFlag( false ),
+    RawLatency( LM.stage( "Raw data update" ) ),
+    FilterLatency( LM.stage( "Filters and detectors" ) ),
+    AudioLatency( LM.stage( "Audio monitor" ) ),
+    PublishLatency( LM.stage( "Publish data" ) ),
+    SaveLatency( LM.stage( "Save traces" ) ),
+    AcquisitionLatency( LM.stage( "Acquisition to detection" ) ),
+    UpdateInterval( LM.stage( "Update interval" ) ),
+    UpdateSleep( 0 ),
     LogFile( 0 ),
     IsFullScreen( false ),
     IsMaximized( false ),
@@ -115,6 +124,8 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
     Doxydoc(doxydoc)
 {
   printlog( "This is RELACS, version " + string( RELACSVERSION ) + ", compiled at " + string( __DATE__ ) );
+  StartupTime.start();
+  StartupStageTime.start();
 
   // setup configuration files:
   CFG.clearGroups();
@@ -202,6 +213,13 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
     ::exit( 1 ); // do we need that?
   }
   CFG.configure( RELACSPlugin::Core );
+  startupTime( "core configuration" );
+
+  // parse the plugin configuration files while the plugins are loaded:
+  vector< string > pluginconfigs;
+  for ( int l=0; ! CFG.configFile( RELACSPlugin::Plugins, l ).empty(); l++ )
+    pluginconfigs.push_back( CFG.configFile( RELACSPlugin::Plugins, l ) );
+  PluginConfig.start( pluginconfigs );
 
   // loading plugins:
   Plugins::add( "AISim[relacs]", RELACSPlugin::AnalogInputId, createAISim, VERSION );
@@ -215,6 +233,7 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
       Plugins::openPath( pluginlib, pluginrelative, pluginhomes );
     }
   }
+  startupTime( "loading plugin libraries" );
 
   if ( Plugins::empty() ) {
     printlog(  "! error: No valid plugins found. Exit now." );
@@ -278,6 +297,7 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
   // session, control tabwidget:
   CW = new ControlTabs( this );
   CW->createControls();
+  startupTime( "creating controls" );
 
   // model plugin:
   MD = 0;
@@ -307,6 +327,7 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
     printlog( "! error: " + fdw.erasedMarkup() );
     MessageBox::error( "RELACS Error !", fdw, this );
   }
+  startupTime( "creating model and filters" );
 
   // setup RePros:
   ReProRunning = false;
@@ -321,6 +342,7 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
   connect( RP, SIGNAL( startRePro( RePro*, int, bool ) ),
 	   this, SLOT( startRePro( RePro*, int, bool ) ) );
   CurrentRePro = 0;
+  startupTime( "creating RePros" );
 
   // setup PlotTrace:
   PT = new PlotTrace( this );
@@ -382,6 +404,8 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
 				    (QWidget*)this, SLOT( muteAudioMonitor() ),
 				    Qt::Key_M );
   filemenu->addAction( "&Audio monitor...", AM, SLOT( dialog() ) );
+  filemenu->addAction( "&Latencies...", (QWidget*)this, SLOT( latencies() ) );
+  filemenu->addAction( "&Memory...", (QWidget*)this, SLOT( memory() ) );
   filemenu->addAction( "&Quit", (QWidget*)this, SLOT( quit() ), Qt::ALT + Qt::Key_Q );
 
   // plugins:
@@ -412,6 +436,7 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
   MC->load();
   MC->check();
   MC->create();
+  startupTime( "loading macros" );
   connect( RP, SIGNAL( noMacro( RePro* ) ),
 	   MC, SLOT( noMacro( RePro* ) ) );
   connect( RP, SIGNAL( reloadRePro( const string& ) ),
@@ -473,6 +498,7 @@ RELACSWidget::RELACSWidget( const string &pluginrelative,
   setFocusPolicy( Qt::StrongFocus );
   window()->setFocus();
   KeyTime = new KeyTimeOut( window() );
+  startupTime( "setting up widgets" );
 
 }
 
@@ -512,6 +538,21 @@ void RELACSWidget::printlog( const string &message ) const
 }
 
 
+void RELACSWidget::startupTime( const string &stage )
+{
+  StartupReport += stage + ": " + Str( StartupStageTime.restart() ) + "ms\n";
+}
+
+
+void RELACSWidget::readPluginConfig( void )
+{
+  if ( PluginConfig.pending() )
+    PluginConfig.read( CFG, RELACSPlugin::Plugins );
+  else
+    CFG.read( RELACSPlugin::Plugins );
+}
+
+
 void RELACSWidget::init ( void )
 {
   MC->warning();
@@ -527,6 +568,11 @@ void RELACSWidget::init ( void )
     startFirstAcquisition( false );
   else if ( simulation() )
     startFirstAcquisition( true );
+
+  startupTime( "starting acquisition" );
+  printlog( "Startup took " + Str( StartupTime.elapsed() ) + "ms:\n" +
+	    StartupReport + Plugins::timingReport() );
+  StartupReport.clear();
 }
 
 
@@ -874,6 +920,51 @@ void RELACSWidget::setupOutTraces( void )
 }
 
 
+void RELACSWidget::setupMemoryBudget( void )
+{
+  MB.clear();
+  // the event buffers are expected to cover the same time
+  // as the buffers of the input traces:
+  double buffertime = IRawData[0].capacity()*IRawData[0].sampleInterval();
+  // raw traces and events are kept longest, derived traces are shrunk first:
+  for ( int k=0; k<IRawData.size(); k++ )
+    MB.add( &IRawData[k], 2 );
+  for ( int k=0; k<ERawData.size(); k++ )
+    MB.add( &ERawData[k], buffertime, 2 );
+  for ( int k=ERawData.size(); k<EData.size(); k++ )
+    MB.add( &EData[k], buffertime, 1 );
+  for ( int k=IRawData.size(); k<IData.size(); k++ )
+    MB.add( &IData[k], 0 );
+
+  SS.lock();
+  long long budget = (long long)( 1.0e6*SS.number( "memorybudget", 0.0 ) );
+  double mintime = SS.number( "minbuffertime", 10.0 );
+  bool lock = SS.boolean( "lockmemory", false );
+  bool hugepages = SS.boolean( "hugepages", false );
+  SS.unlock();
+
+  string ws = MB.fit( budget, mintime );
+  if ( ! ws.empty() ) {
+    printlog( "! warning: " + ws );
+    MessageBox::warning( "RELACS Warning !", ws, true, 0.0, this );
+  }
+  // the derived data share the buffers of the raw data:
+  for ( int k=0; k<IRawData.size(); k++ )
+    IData[k].assign( &IRawData[k] );
+  for ( int k=0; k<ERawData.size(); k++ )
+    EData[k].assign( &ERawData[k] );
+
+  if ( lock ) {
+    ws = MB.lock( hugepages );
+    if ( ! ws.empty() ) {
+      printlog( "! warning: " + ws );
+      MessageBox::warning( "RELACS Warning !", ws, true, 0.0, this );
+    }
+  }
+  printlog( "Data buffers use " + Str( 1.0e-6*MB.bytes(), 0, 0, 'f' ) + "MB of memory" );
+}
+
+
 ///// Data thread ///////////////////////////////////////////////////////////
 
 int RELACSWidget::getData( InList &data, EventList &events, double &signaltime,
@@ -884,7 +975,7 @@ int RELACSWidget::getData( InList &data, EventList &events, double &signaltime,
   if ( mintracetime > 0.0 ) {
     // do wee need to wait for a new signal?
     if ( prevsignal >= -1.0 ) {
-      while ( IData.success() &&
+      while ( PData.success() &&
 	      SignalTime <= prevsignal+1.0e-8 &&
 	      AQ->isReadRunning() ) { 
 	UpdateDataWait.wait( &DerivedDataMutex );
@@ -898,13 +989,13 @@ int RELACSWidget::getData( InList &data, EventList &events, double &signaltime,
     }
     
     // do we need to wait for more data?
-    while ( IData.success() &&
-	    IData.currentTimeRaw() < mintracetime+1.0e-8 &&
+    while ( PData.success() &&
+	    PData.currentTimeRaw() < mintracetime+1.0e-8 &&
 	    AQ->isReadRunning() && WriteFlag ) {
       UpdateDataWait.wait( &DerivedDataMutex );
     }
     
-    interrupted = ( IData.currentTimeRaw() < mintracetime || mintracetime == 0.0 );
+    interrupted = ( PData.currentTimeRaw() < mintracetime || mintracetime == 0.0 );
   }
 
   // update data:
@@ -912,7 +1003,7 @@ int RELACSWidget::getData( InList &data, EventList &events, double &signaltime,
   data.update();
   events.update();
   // check data:
-  bool error = IData.failed();
+  bool error = PData.failed();
   DerivedDataMutex.unlock();
   return error ? -1 : ( interrupted ? 0 : 1 );
 }
@@ -922,6 +1013,7 @@ int RELACSWidget::updateData( void )
 // called continuously from ReadThread::run()
 {
   double signaltime = -1.0;
+  UpdateSleep = 0;
   int r = AQ->waitForData( signaltime );
   if ( r < 0 ) {
     // error handling:
@@ -958,27 +1050,48 @@ int RELACSWidget::updateData( void )
     }
   }
   else if ( r > 0 ) {
-    // update derived data:
-    DerivedDataMutex.lockForWrite();
-    if ( signaltime >= 0.0 )
-      SignalTime = signaltime;
+    LatencyTimer total;
+    LatencyTimer timer;
+    // update derived data (only used by this thread):
     AQ->lockRead();
     for ( deque<InList*>::iterator dp = UpdateRawData.begin(); dp != UpdateRawData.end(); ++dp )
       (*dp)->updateRaw();
     for ( deque<EventList*>::iterator ep = UpdateRawEvents.begin(); ep != UpdateRawEvents.end(); ++ep )
       (*ep)->updateRaw();
     AQ->unlockRead();
+    RawLatency->record( timer.restart() );
     Str fdw = FD->filter( signaltime );
     if ( !fdw.empty() )
       printlog( "! error: " + fdw.erasedMarkup() );
+    FilterLatency->record( timer.restart() );
     AM->updateDerivedTraces(); // XXX is this really good?
+    AudioLatency->record( timer.restart() );
+
+    // publish the new data:
+    DerivedDataMutex.lockForWrite();
+    if ( signaltime >= 0.0 )
+      SignalTime = signaltime;
+    PData.update();
+    PEvents.update();
     DerivedDataMutex.unlock();
+    PublishLatency->record( timer.restart() );
+    // data and detected events are now available to the plugins,
+    // time since the most recent sample was acquired:
+    long latency = chrono::duration_cast< chrono::microseconds >
+      ( chrono::steady_clock::now() - AQ->dataClock() ).count();
+    AcquisitionLatency->record( latency > 0 ? latency : 0 );
 
     // save data:
     SF->saveTraces();
+    SaveLatency->record( timer.restart() );
 
     // notify other plugins about available data:
     UpdateDataWait.wakeAll();
+
+    // batch more data if processing takes too long:
+    UpdateSleep = UC.update( total.elapsed() );
+    if ( UC.period() > 0 )
+      UpdateInterval->record( UC.period() );
   }
   DataRunLock.lock();
   bool dr = DataRun;
@@ -1350,6 +1463,8 @@ void RELACSWidget::startSession( bool startmacro )
     CFG.save( RELACSPlugin::Plugins, SF->addPath( "relacsplugins.cfg" ) );
   if ( SS.boolean( "saveattenuators" ) )
     ATI->save( SF->path() );
+  if ( SS.boolean( "savelatencies" ) )
+    LM.reset();
   if ( SS.boolean( "saverelacslog" ) ) {
     LogFile = new ofstream( SF->addPath( "relacs.log" ).c_str() );
     if ( ! LogFile->good() ) {
@@ -1404,8 +1519,14 @@ void RELACSWidget::resumeSession( void )
   CW->sessionStopped( saved );
   RP->sessionStopped( saved );
 
-  if ( saved )
+  if ( saved ) {
+    SS.lock();
+    bool savelatencies = SS.boolean( "savelatencies" );
+    SS.unlock();
+    if ( savelatencies )
+      LM.save( SF->addPath( "latencies.dat" ) );
     SF->completeFiles();
+  }
   else
     SF->deleteFiles();
 
@@ -1696,10 +1817,13 @@ void RELACSWidget::clearActivity( void )
 {
   CFG.save();
   clearHardware();
+  MB.clear();
   IRawData.clearBuffer();
   IData.clear();
+  PData.clear();
   ERawData.clear();
   EData.clear();
+  PEvents.clear();
   SimLabel->hide();
   MTDT.clear();
 }
@@ -1773,6 +1897,7 @@ void RELACSWidget::startFirstAcquisition( bool simulation )
     startIdle();
     return;
   }
+  setupMemoryBudget();
 
   // files:
   SF->setPath( SF->defaultPath() );
@@ -1783,14 +1908,18 @@ void RELACSWidget::startFirstAcquisition( bool simulation )
   UpdateRawData.push_back( &IData );
   UpdateRawEvents.push_back( &EData );
 
+  // published traces and events for all other threads:
+  PData.assign( &IData );
+  PEvents.assign( &EData );
+
   FD->setTracesEvents( IData, EData );
   SF->setTracesEvents( IData, EData );
   AM->assignTraces( IData, UpdateRawData ); // XXX is this really good in this way???
-  CW->assignTracesEvents( IData, EData );
-  PT->assignTracesEvents( IData, EData );
-  RP->assignTracesEvents( IData, EData );
+  CW->assignTracesEvents( PData, PEvents );
+  PT->assignTracesEvents( PData, PEvents );
+  RP->assignTracesEvents( PData, PEvents );
   if ( simulation ) {
-    MD->assignTracesEvents( IData, EData );
+    MD->assignTracesEvents( PData, PEvents );
     MD->addTracesEvents( UpdateRawData, UpdateRawEvents ); // XXX is this ever used?
   }
 
@@ -1807,7 +1936,7 @@ void RELACSWidget::startFirstAcquisition( bool simulation )
   CFG.preConfigure( RELACSPlugin::Plugins );
   // XXX before configuring, something like AQ->init would be nice
   // in order to set the IRawData gain factors.
-  CFG.read( RELACSPlugin::Plugins );
+  readPluginConfig();
   CFG.configure( RELACSPlugin::Plugins );
 
   // device menu:
@@ -1880,6 +2009,7 @@ void RELACSWidget::startFirstAcquisition( bool simulation )
   ReadLoop.start();
 
   IData.assign();
+  PData.assign();
   PT->assignTracesEvents();
   CW->assignTracesEvents();
   RP->assignTracesEvents();
@@ -1909,7 +2039,7 @@ void RELACSWidget::startIdle( void )
 {
   MTDT.clear();
   CFG.preConfigure( RELACSPlugin::Plugins );
-  CFG.read( RELACSPlugin::Plugins );
+  readPluginConfig();
   CFG.configure( RELACSPlugin::Plugins );
   CW->initDevices();
 
@@ -2273,6 +2403,46 @@ void RELACSWidget::helpClosed( int r )
 }
 
 
+void RELACSWidget::latencies( void )
+{
+  ostringstream ss;
+  ss << "<p>Processing times of the stages of the data acquisition loop,\n"
+     << "starting from the availability of new data.</p>\n";
+  LM.html( ss );
+  ss << "<p>The interval between updates is adapted to the processing load.\n"
+     << "Data arriving in between are processed in one batch.</p>\n";
+  UC.html( ss );
+
+  OptDialog od( true, this );
+  od.setCaption( "RELACS Latencies" );
+  QLabel *ll = new QLabel( ss.str().c_str(), this );
+  ll->setTextFormat( Qt::RichText );
+  od.addWidget( ll );
+  od.addButton( "&Reset", OptDialog::NoAction, 2 );
+  od.addButton( "&Close" );
+  if ( od.exec() == 2 )
+    LM.reset();
+}
+
+
+void RELACSWidget::memory( void )
+{
+  ostringstream ss;
+  ss << "<p>Memory used by the ring buffers of the traces and events.\n"
+     << "Buffers with the lowest priority are shrunk first\n"
+     << "to meet the memory budget.</p>\n";
+  MB.html( ss );
+
+  OptDialog od( true, this );
+  od.setCaption( "RELACS Memory" );
+  QLabel *ll = new QLabel( ss.str().c_str(), this );
+  ll->setTextFormat( Qt::RichText );
+  od.addWidget( ll );
+  od.addButton( "&Close" );
+  od.exec();
+}
+
+
 KeyTimeOut::KeyTimeOut( QWidget *tlw )
   : TimerId( 0 ),
     TopLevelWidget( tlw ),
@@ -117,6 +117,7 @@ void RePro::run( void )
   InterruptLock.lock();
   Interrupt = 0;
   InterruptLock.unlock();
+  resetTasks();
   GrabKeysBaseSize = GrabKeys.size();
   enable();
   getData();
@@ -125,6 +126,10 @@ void RePro::run( void )
 
   // run RePro:
   LastState = main();
+  // the stack of main() is already gone, so main() needs to wait for
+  // the tasks on its stack itself. Here we only wait for tasks that
+  // are members of the RePro:
+  waitTasks();
 
   // update statistics:
   if ( LastState == Completed )
@@ -197,6 +202,7 @@ void RePro::requestStop( void )
     // tell the RePro to interrupt:
     Interrupt = 2;
     InterruptLock.unlock();
+    cancelTasks();
     
     // wake up the RePro from sleeping:
     SleepWait.wakeAll();
@@ -223,6 +223,13 @@ void SaveFiles::storeFile( const string &file ) const
 }
 
 
+void SaveFiles::addDataFile( const string &file )
+{
+  QMutexLocker locker( &SaveMutex );
+  addFile( file );
+}
+
+
 string SaveFiles::pathTemplate( void ) const
 {
   QMutexLocker locker( &SaveMutex );
@@ -71,6 +71,7 @@ Settings::Settings( RELACSWidget* rw )
   addBoolean( "saverelacsplugins", "Save configuration of RELACS-plugins to session", true );
   addBoolean( "saverelacslog", "Save log of RELACS to session", true );
   addBoolean( "saveattenuators", "Save calibration files for attenuators to session", true );
+  addBoolean( "savelatencies", "Save processing latencies of data acquisition to session", false );
   newSection( "Date/time formats" );
   addText( "elapsedformat", "Format for elapsed time", "%02H:%02M" );
   addText( "sessiontimeformat", "Format for session runtime", "%Hh%02Mmin%02Ssec" );
@@ -79,6 +80,13 @@ Settings::Settings( RELACSWidget* rw )
   addText( "printcommand", "Command to be executed for printing traces", "" );
   newSection( "Data acquisition" );
   addNumber( "processinterval", "Interval for periodic processing of data", 0.10, 0.001, 1000.0, 0.001, "seconds", "ms" );
+  addNumber( "minupdateinterval", "Minimum interval for updating acquired data", 0.0, 0.0, 1.0, 0.001, "seconds", "ms" );
+  addNumber( "maxupdateinterval", "Maximum interval for updating acquired data", 0.05, 0.0, 1.0, 0.001, "seconds", "ms" );
+  addNumber( "memorybudget", "Maximum memory for buffering traces and events (0: no limit)", 0.0, 0.0, 1000000.0, 10.0, "MB" );
+  addNumber( "minbuffertime", "Minimum time each buffer has to hold", 10.0, 0.0, 100000.0, 1.0, "seconds" );
+  addBoolean( "lockmemory", "Lock buffers into RAM", false );
+  addBoolean( "hugepages", "Use huge pages for large buffers", false ).setActivation( "lockmemory", "true" );
+  addInteger( "analysisthreads", "Number of threads for analysis in plugins (0: number of processors minus two, which is also the maximum)", 0, 0, 256 );
   addNumber( "aitimeout", "Minimum time that has to pass between analog input errors", 10.0, 0.0, 100000.0, 1.0, "seconds" );
 
   addDialogStyle( OptWidget::Bold );
@@ -119,6 +127,10 @@ void Settings::notify( void )
 #endif
   }
 
+  RW->TP.setThreads( integer( "analysisthreads" ) );
+  RW->UC.setLimits( (long)( 1.0e6*number( "minupdateinterval" ) ),
+		    (long)( 1.0e6*number( "maxupdateinterval" ) ) );
+
   Str rp = text( "repropath" );
   rp.provideSlash();
   setenv( "RELACSREPROPATH", rp.c_str(), 1 );
@@ -0,0 +1,335 @@
+/*
+  threadpool.cc
+  A fixed number of worker threads executing tasks for the plugins.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <relacs/threadpool.h>
+
+namespace relacs {
+
+
+ThreadPool::Task::Task( void )
+  : TaskGroup( 0 ),
+    Delete( false )
+{
+}
+
+
+ThreadPool::Task::~Task( void )
+{
+}
+
+
+bool ThreadPool::Task::canceled( void ) const
+{
+  return ( TaskGroup != 0 && TaskGroup->canceled() );
+}
+
+
+ThreadPool::Group::Group( void )
+  : Pending( 0 ),
+    Canceled( false )
+{
+}
+
+
+int ThreadPool::Group::pending( void ) const
+{
+  return Pending;
+}
+
+
+void ThreadPool::Group::cancel( void )
+{
+  Canceled = true;
+}
+
+
+bool ThreadPool::Group::canceled( void ) const
+{
+  return Canceled;
+}
+
+
+void ThreadPool::Group::reset( void )
+{
+  Canceled = false;
+}
+
+
+void ThreadPool::Group::finished( void )
+{
+  Mutex.lock();
+  Pending--;
+  if ( Pending <= 0 )
+    Finished.wakeAll();
+  Mutex.unlock();
+}
+
+
+ThreadPool::Loop::~Loop( void )
+{
+}
+
+
+ThreadPool::Worker::Worker( ThreadPool *pool, int index )
+  : Pool( pool ),
+    Index( index )
+{
+}
+
+
+void ThreadPool::Worker::run( void )
+{
+  Pool->work( Index );
+}
+
+
+ThreadPool::LoopTask::LoopTask( Loop *loop, int first, int last )
+  : L( loop ),
+    First( first ),
+    Last( last )
+{
+}
+
+
+void ThreadPool::LoopTask::run( void )
+{
+  L->run( First, Last, *TaskGroup );
+}
+
+
+ThreadPool::ThreadPool( void )
+  : NThreads( defaultThreads() ),
+    Queued( 0 ),
+    Next( 0 ),
+    Stop( false )
+{
+  int nq = QThread::idealThreadCount();
+  if ( nq < 1 )
+    nq = 1;
+  Queues.resize( nq );
+  for ( int k=0; k<nq; k++ )
+    QueueMutexes.push_back( new QMutex );
+}
+
+
+ThreadPool::~ThreadPool( void )
+{
+  WorkersMutex.lock();
+  stop();
+  WorkersMutex.unlock();
+  // release the tasks that have not been executed:
+  for ( unsigned int q=0; q<Queues.size(); q++ ) {
+    while ( ! Queues[q].empty() ) {
+      Task *task = Queues[q].front();
+      Queues[q].pop_front();
+      Group *group = task->TaskGroup;
+      group->cancel();
+      if ( task->Delete )
+	delete task;
+      group->finished();
+    }
+    delete QueueMutexes[q];
+  }
+}
+
+
+int ThreadPool::defaultThreads( void )
+{
+  int n = QThread::idealThreadCount() - 2;
+  return n < 1 ? 1 : n;
+}
+
+
+int ThreadPool::threads( void ) const
+{
+  QMutexLocker locker( &WorkersMutex );
+  return NThreads;
+}
+
+
+void ThreadPool::setThreads( int n )
+{
+  // never more workers than processors left by the data threads:
+  if ( n < 1 || n > defaultThreads() )
+    n = defaultThreads();
+  WorkersMutex.lock();
+  if ( n != NThreads ) {
+    NThreads = n;
+    if ( ! Workers.empty() ) {
+      stop();
+      start();
+    }
+  }
+  WorkersMutex.unlock();
+}
+
+
+void ThreadPool::submit( Task *task, Group &group )
+{
+  WorkersMutex.lock();
+  if ( Workers.empty() )
+    start();
+  WorkersMutex.unlock();
+
+  task->TaskGroup = &group;
+  group.Pending++;
+  int q = Next++ % Queues.size();
+  QueueMutexes[q]->lock();
+  Queues[q].push_back( task );
+  QueueMutexes[q]->unlock();
+  Queued++;
+
+  WakeMutex.lock();
+  Wake.wakeOne();
+  WakeMutex.unlock();
+}
+
+
+bool ThreadPool::wait( Group &group )
+{
+  for ( ; ; ) {
+    if ( group.Pending > 0 ) {
+      // help with the queued tasks:
+      Task *task = take( Next % Queues.size() );
+      if ( task != 0 ) {
+	execute( task );
+	continue;
+      }
+    }
+    // finished() must have released the mutex before group goes out of scope:
+    group.Mutex.lock();
+    bool done = ( group.Pending <= 0 );
+    if ( ! done )
+      group.Finished.wait( &group.Mutex, 10 );
+    group.Mutex.unlock();
+    if ( done )
+      break;
+  }
+  return ! group.canceled();
+}
+
+
+bool ThreadPool::parallelFor( int first, int last, Loop &loop,
+			      Group &group, int grain )
+{
+  int n = last - first;
+  if ( n <= 0 )
+    return ! group.canceled();
+  if ( grain < 1 )
+    grain = 1;
+  // a few chunks per thread balance the load:
+  int chunks = 4*threads();
+  if ( chunks > n/grain )
+    chunks = n/grain;
+  if ( chunks < 1 )
+    chunks = 1;
+  for ( int k=0; k<chunks; k++ ) {
+    LoopTask *task = new LoopTask( &loop, first + (long)n*k/chunks,
+				   first + (long)n*(k+1)/chunks );
+    task->Delete = true;
+    submit( task, group );
+  }
+  return wait( group );
+}
+
+
+void ThreadPool::work( int index )
+{
+  while ( ! Stop ) {
+    Task *task = take( index );
+    if ( task != 0 ) {
+      execute( task );
+      continue;
+    }
+    WakeMutex.lock();
+    if ( Queued <= 0 && ! Stop )
+      Wake.wait( &WakeMutex, 100 );
+    WakeMutex.unlock();
+  }
+}
+
+
+ThreadPool::Task *ThreadPool::take( int index )
+{
+  int nq = Queues.size();
+  int q = index % nq;
+  Task *task = 0;
+  // own queue first:
+  QueueMutexes[q]->lock();
+  if ( ! Queues[q].empty() ) {
+    task = Queues[q].front();
+    Queues[q].pop_front();
+  }
+  QueueMutexes[q]->unlock();
+  // steal from the other queues:
+  for ( int k=1; task == 0 && k<nq; k++ ) {
+    int s = ( q + k ) % nq;
+    QueueMutexes[s]->lock();
+    if ( ! Queues[s].empty() ) {
+      task = Queues[s].back();
+      Queues[s].pop_back();
+    }
+    QueueMutexes[s]->unlock();
+  }
+  if ( task != 0 )
+    Queued--;
+  return task;
+}
+
+
+void ThreadPool::execute( Task *task )
+{
+  Group *group = task->TaskGroup;
+  if ( ! group->canceled() )
+    task->run();
+  if ( task->Delete )
+    delete task;
+  group->finished();
+}
+
+
+void ThreadPool::start( void )
+{
+  Stop = false;
+  for ( int k=0; k<NThreads; k++ ) {
+    Workers.push_back( new Worker( this, k ) );
+    Workers.back()->start( QThread::LowPriority );
+  }
+}
+
+
+void ThreadPool::stop( void )
+{
+  Stop = true;
+  WakeMutex.lock();
+  Wake.wakeAll();
+  WakeMutex.unlock();
+  for ( unsigned int k=0; k<Workers.size(); k++ ) {
+    Workers[k]->wait();
+    delete Workers[k];
+  }
+  Workers.clear();
+  Stop = false;
+}
+
+
+}; /* namespace relacs */
+
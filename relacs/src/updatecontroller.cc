@@ -0,0 +1,194 @@
+/*
+  updatecontroller.cc
+  Adapts the interval of the data acquisition loop to the processing load.
+
+  RELACS - Relaxed ELectrophysiological data Acquisition, Control, and Stimulation
+  Copyright (C) 2002-2015 Jan Benda <jan.benda@uni-tuebingen.de>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  RELACS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iomanip>
+#include <relacs/updatecontroller.h>
+
+namespace relacs {
+
+
+const double UpdateController::MaxLoad = 0.5;
+const double UpdateController::MinLoad = 0.2;
+
+  /*! Weight of a new load measurement in the running average. */
+static const double LoadWeight = 0.2;
+  /*! Number of updates the running average needs to settle
+      after a change of the update interval. */
+static const int HoldUpdates = 5;
+  /*! Update intervals below this number of microseconds are set to zero. */
+static const long SnapInterval = 500;
+
+
+UpdateController::UpdateController( void )
+  : MinInterval( 0 ),
+    MaxInterval( 50000 ),
+    Interval( 0 ),
+    LastPeriod( 0 ),
+    Load( 0 ),
+    Updates( 0 ),
+    Increases( 0 ),
+    Decreases( 0 ),
+    Started( false ),
+    AverageLoad( 0.0 ),
+    Hold( 0 )
+{
+}
+
+
+void UpdateController::setLimits( long minus, long maxus )
+{
+  if ( minus < 0 )
+    minus = 0;
+  if ( maxus < minus )
+    maxus = minus;
+  MinInterval = minus;
+  MaxInterval = maxus;
+}
+
+
+long UpdateController::minInterval( void ) const
+{
+  return MinInterval;
+}
+
+
+long UpdateController::maxInterval( void ) const
+{
+  return MaxInterval;
+}
+
+
+void UpdateController::reset( void )
+{
+  Started = false;
+  Hold = 0;
+}
+
+
+long UpdateController::update( long processingus )
+{
+  Updates++;
+  long minint = MinInterval;
+  long maxint = MaxInterval;
+  long interval = Interval;
+
+  long period = Period.restart();
+  LastPeriod = Started ? period : 0;
+  if ( Started && period > 0 ) {
+    double l = double( processingus )/double( period );
+    if ( l > 1.0 )
+      l = 1.0;
+    AverageLoad += LoadWeight*( l - AverageLoad );
+    Load = long( 1.0e6*AverageLoad );
+    if ( Hold > 0 )
+      Hold--;
+    else if ( AverageLoad > MaxLoad && interval < maxint ) {
+      // batch more data:
+      long ni = 3*interval/2;
+      if ( ni < 2*processingus )
+	ni = 2*processingus;
+      if ( ni < SnapInterval )
+	ni = SnapInterval;
+      interval = ni < maxint ? ni : maxint;
+      Increases++;
+      Hold = HoldUpdates;
+    }
+    else if ( AverageLoad < MinLoad && interval > minint ) {
+      // reduce latency:
+      long ni = 4*interval/5;
+      if ( ni < SnapInterval )
+	ni = 0;
+      interval = ni > minint ? ni : minint;
+      Decreases++;
+      Hold = HoldUpdates;
+    }
+  }
+  Started = true;
+
+  // the limits might have been changed:
+  if ( interval < minint )
+    interval = minint;
+  if ( interval > maxint )
+    interval = maxint;
+  Interval = interval;
+
+  long sleep = interval - processingus;
+  return sleep > 0 ? sleep : 0;
+}
+
+
+long UpdateController::period( void ) const
+{
+  return LastPeriod;
+}
+
+
+long UpdateController::interval( void ) const
+{
+  return Interval;
+}
+
+
+double UpdateController::load( void ) const
+{
+  return 1.0e-6*Load;
+}
+
+
+long UpdateController::updates( void ) const
+{
+  return Updates;
+}
+
+
+long UpdateController::increases( void ) const
+{
+  return Increases;
+}
+
+
+long UpdateController::decreases( void ) const
+{
+  return Decreases;
+}
+
+
+void UpdateController::html( ostream &str ) const
+{
+  str << "<table>\n";
+  str << fixed << setprecision( 0 );
+  str << "<tr><td>Update interval</td><td align=right>" << interval()
+      << "&micro;s</td><td>(" << minInterval() << "&micro;s - "
+      << maxInterval() << "&micro;s)</td></tr>\n";
+  str << "<tr><td>Processing load</td><td align=right>" << 100.0*load()
+      << "%</td><td>(" << 100.0*MinLoad << "% - " << 100.0*MaxLoad
+      << "%)</td></tr>\n";
+  str << "<tr><td>Updates</td><td align=right>" << updates() << "</td></tr>\n";
+  str << "<tr><td>Interval increased</td><td align=right>" << increases()
+      << "</td></tr>\n";
+  str << "<tr><td>Interval decreased</td><td align=right>" << decreases()
+      << "</td></tr>\n";
+  str << "</table>\n";
+}
+
+
+}; /* namespace relacs */
+